@@ -0,0 +1,178 @@
+//! @file parse.cpp
+//! @brief A libFuzzer target which fails on slow inputs as well as crashing ones.
+//!
+//! Each input is parsed as a PE by every parser in the library: the headers and section table, address
+//! translation of every section and data directory, the checksum, exports, imports, mapping,
+//! relocation and TLS, the metadata record, and the streaming parser. Invalid inputs are expected and
+//! their exceptions ignored, but an input which takes too long or touches too much is reported as a
+//! crash, so the fuzzer minimizes and keeps it like any other finding.
+//!
+//! The parse runs under a ParseBudget, so the walkers stop an input as soon as it passes the limits,
+//! and the whole parse is timed as well to catch slow paths the walkers don't charge. When the library
+//! is built with `YAPP_INSTRUMENT`, address translations are limited too, which catches quadratic
+//! translation loops that are individually cheap.
+//!
+//! Build with the `YAPP_BUILD_FUZZERS` CMake option under clang, then seed from the test corpus:
+//!
+//! ```
+//! mkdir findings && ./yapp_fuzz_parse -max_len=65536 findings ../test/corpus
+//! ```
+//!
+//! The limits are read from the environment:
+//!
+//! - `YAPP_FUZZ_TIMEOUT_MS`: the time a single input may take, 100 by default.
+//! - `YAPP_FUZZ_MAX_BYTES`: the bytes the walkers may touch, 64 MiB by default.
+//! - `YAPP_FUZZ_MAX_TRANSLATIONS`: the address translations a single input may make, 1048576 by default.
+//!
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <yapp.hpp>
+
+using namespace yapp;
+
+namespace
+{
+   using Clock = std::chrono::steady_clock;
+
+   /// Larger images aren't mapped, which keeps a fuzzer's memory limit from tripping on the allocation.
+   const std::size_t MaxMappedSize = 0x4000000;
+
+   std::chrono::milliseconds timeout(100);
+   std::size_t max_bytes = 0x4000000;
+   std::uint64_t max_translations = 0x100000;
+
+   std::size_t
+   environment
+   (const char *name, std::size_t fallback)
+   {
+      auto value = std::getenv(name);
+      if (value == nullptr || *value == 0) { return fallback; }
+
+      return static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+   }
+
+   [[noreturn]] void
+   fail
+   (const std::string &reason, std::size_t size)
+   {
+      std::cerr << "yapp_fuzz_parse: " << reason << " on an input of " << size << " bytes" << std::endl;
+      std::abort();
+   }
+
+   /// Run one parser, ignoring the exceptions invalid input is expected to raise.
+   template <typename Stage>
+   void
+   stage
+   (Stage run)
+   {
+      try { run(); }
+      catch (BudgetExceededException &) { throw; }
+      catch (Exception &) {}
+   }
+
+   void
+   parse
+   (const std::uint8_t *data, std::size_t size)
+   {
+      auto pe = PE(size, PE::ImageType::DISK);
+      std::memcpy(pe.ptr(), data, size);
+
+      stage([&] () {
+         (void)pe.valid_dos_header();
+         (void)pe.valid_nt_headers();
+
+         auto section_table = pe.section_table();
+
+         for (std::size_t i=0; i<section_table.size(); ++i)
+         {
+            auto &section = section_table.get(i);
+            stage([&] () { (void)pe.rva_to_offset(RVA(section.VirtualAddress)); });
+            stage([&] () { (void)pe.offset_to_rva(Offset(section.PointerToRawData)); });
+         }
+      });
+
+      stage([&] () {
+         auto data_directory = pe.data_directory();
+
+         for (std::size_t i=0; i<data_directory.size(); ++i)
+         {
+            stage([&] () { (void)pe.directory_file_range(i); });
+            stage([&] () { (void)pe.rva_to_offset(RVA(data_directory.get(i).VirtualAddress)); });
+         }
+      });
+
+      stage([&] () { (void)pe.calculate_checksum(); });
+      stage([&] () { (void)pe.entrypoint(); });
+      stage([&] () { (void)pe.data_directory().directory<headers::ExportDirectory>(pe); });
+      stage([&] () { (void)ExportIndex(pe); });
+      stage([&] () { (void)ImportResolver::ImportList(pe); });
+      stage([&] () { (void)MetadataView::Build(pe); });
+
+      stage([&] () {
+         auto loader = Loader(pe, MaxMappedSize);
+         stage([&] () { (void)loader.tls(); });
+         stage([&] () { (void)loader.entrypoints(); });
+         stage([&] () { (void)loader.relocate(pe.image_base() + 0x10000); });
+      });
+
+      stage([&] () {
+         auto handler = StreamParser::Handler();
+         auto parser = StreamParser(handler);
+
+         for (std::size_t i=0; i<headers::raw::IMAGE_NUMBEROF_DIRECTORY_ENTRIES; ++i)
+            parser.add_directory(i);
+
+         parser.feed(data, size);
+         parser.finish();
+      });
+   }
+}
+
+extern "C" int
+LLVMFuzzerInitialize
+(int *argc, char ***argv)
+{
+   timeout = std::chrono::milliseconds(environment("YAPP_FUZZ_TIMEOUT_MS", timeout.count()));
+   max_bytes = environment("YAPP_FUZZ_MAX_BYTES", max_bytes);
+   max_translations = environment("YAPP_FUZZ_MAX_TRANSLATIONS", max_translations);
+
+   return 0;
+}
+
+extern "C" int
+LLVMFuzzerTestOneInput
+(const std::uint8_t *data, std::size_t size)
+{
+   if (size == 0) { return 0; }
+
+   auto budget = ParseBudget().timeout(timeout).max_bytes(max_bytes);
+   auto before = Instrumentation::Take();
+   auto start = Clock::now();
+
+   try {
+      ParseBudget::Scope scope(budget);
+      parse(data, size);
+   }
+   catch (BudgetExceededException &exception) {
+      fail(exception.what(), size);
+   }
+   catch (Exception &) {}
+
+   auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+
+   if (elapsed > timeout)
+      fail("parsing took " + std::to_string(elapsed.count()) + "ms", size);
+
+   if (Instrumentation::Enabled)
+   {
+      auto translations = (Instrumentation::Take() - before).counter(Instrumentation::ADDRESS_TRANSLATIONS);
+
+      if (translations > max_translations)
+         fail(std::to_string(translations) + " address translations", size);
+   }
+
+   return 0;
+}
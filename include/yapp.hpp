@@ -17,6 +17,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <typeinfo>
 #include <type_traits>
 #include <utility>
@@ -28,9 +29,33 @@
 #endif
 
 /* local includes */
+#include <yapp/instrument.hpp>
 #include <yapp/exception.hpp>
+#include <yapp/span.hpp>
+#include <yapp/encoding.hpp>
+#include <yapp/digest.hpp>
 #include <yapp/memory.hpp>
 #include <yapp/address.hpp>
 #include <yapp/arch_container.hpp>
 #include <yapp/headers.hpp>
 #include <yapp/pe.hpp>
+#include <yapp/coff.hpp>
+#include <yapp/image_writer.hpp>
+#include <yapp/piece_table.hpp>
+#include <yapp/patch_overlay.hpp>
+#include <yapp/section_layout.hpp>
+#include <yapp/forwarder.hpp>
+#include <yapp/export_index.hpp>
+#include <yapp/export_cache.hpp>
+#include <yapp/import_resolver.hpp>
+#include <yapp/loader.hpp>
+#include <yapp/metadata_cache.hpp>
+#include <yapp/columnar.hpp>
+#include <yapp/read_queue.hpp>
+#include <yapp/ingest.hpp>
+#include <yapp/parse_server.hpp>
+#include <yapp/stream_parser.hpp>
+#include <yapp/archive.hpp>
+#include <yapp/lib_archive.hpp>
+#include <yapp/parse_budget.hpp>
+#include <yapp/async_parse.hpp>
@@ -0,0 +1,188 @@
+//! @file archive.hpp
+//! @brief Reading PE files straight out of ZIP and gzip containers.
+//!
+//! Samples are usually shared zipped, encrypted with the password "infected", or gzipped. Rather than
+//! extract them to disk and load them again, the archive readers inflate an entry directly into an
+//! image allocated at the size the archive declares for it, or feed the inflated bytes to a
+//! StreamParser as they're produced, so the whole file never has to be held at once.
+//!
+//! The declared size is only allocated once it's been checked against the compressed size, since
+//! DEFLATE can't expand data more than about a thousandfold, and against a limit the caller picks.
+//!
+//! Stored and deflated entries are supported, along with traditional PKWARE encryption. AES
+//! encryption, ZIP64 and multi-disk archives are not. The archive itself is read into memory whole,
+//! since its central directory is at the end.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+#include <yapp/pe.hpp>
+#include <yapp/stream_parser.hpp>
+
+namespace yapp
+{
+   /// @brief A ZIP archive of samples.
+   ///
+   class ZipArchive
+   {
+   public:
+      /// @brief The password samples are conventionally encrypted with.
+      ///
+      static const char *DefaultPassword;
+
+      /// @brief The default limit on the size of an extracted entry.
+      ///
+      static const std::size_t DefaultMaxSize = 0x10000000;
+
+      enum Method
+      {
+         STORED = 0,
+         DEFLATED = 8,
+      };
+
+      /// @brief An entry of the archive's central directory.
+      ///
+      struct Entry
+      {
+         std::string name;
+         std::uint16_t flags;
+         std::uint16_t method;
+         std::uint16_t time;
+         std::uint16_t date;
+         std::uint32_t crc;
+         std::uint32_t compressed_size;
+         std::uint32_t size;
+         std::uint32_t header_offset;
+
+         inline bool encrypted() const { return (this->flags & 1) != 0; }
+         inline bool is_directory() const { return !this->name.empty() && this->name.back() == '/'; }
+      };
+
+      /// @brief Receives each entry extracted by for_each, or the exception that extracting it threw.
+      ///
+      using Callback = std::function<void(const Entry &entry, PE &pe, std::exception_ptr error)>;
+
+   protected:
+      Memory<std::uint8_t> data;
+      std::string password;
+      std::vector<Entry> _entries;
+
+      void parse_directory();
+      void read_payload(const Entry &entry, const std::function<void(const std::uint8_t *, std::size_t)> &consume) const;
+
+   public:
+      /// @brief Read the archive from the file at *filename*, using *password* for encrypted entries.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw InvalidArchiveException
+      /// @throw UnsupportedArchiveException
+      ///
+      ZipArchive(const std::string &filename, const std::string &password=DefaultPassword);
+
+      /// @brief Read the archive held in *data*, using *password* for encrypted entries.
+      ///
+      /// @throw InvalidArchiveException
+      /// @throw UnsupportedArchiveException
+      ///
+      ZipArchive(const Memory<std::uint8_t> &data, const std::string &password=DefaultPassword);
+
+      inline const std::vector<Entry> &entries() const { return this->_entries; }
+
+      /// @brief Find the entry with the given *name*.
+      ///
+      std::optional<Entry> find(const std::string &name) const;
+
+      /// @brief Inflate the given *entry* into an image of the entry's declared size, which may be at
+      /// most *max_size* bytes.
+      ///
+      /// @throw InvalidArchiveException if the declared size is more than the compressed data can hold
+      /// @throw ArchiveEntryTooLargeException
+      /// @throw UnsupportedArchiveException
+      /// @throw ArchivePasswordException
+      /// @throw ArchiveChecksumException
+      ///
+      PE extract(const Entry &entry, std::size_t max_size=ZipArchive::DefaultMaxSize) const;
+
+      /// @brief Inflate the given *entry* into *parser*, without holding the whole entry at once.
+      ///
+      /// The parser is finished once the entry is, so its handler's on_end is called before this returns.
+      ///
+      /// @throw InvalidArchiveException
+      /// @throw UnsupportedArchiveException
+      /// @throw ArchivePasswordException
+      /// @throw ArchiveChecksumException
+      /// @throw TruncatedStreamException
+      ///
+      void stream(const Entry &entry, StreamParser &parser) const;
+
+      /// @brief Extract every file entry on a pool of *threads* threads, handing each to *callback*.
+      ///
+      /// Entries arrive in completion order, and the callback runs on the worker threads, so it must be
+      /// safe to call concurrently. An entry which fails to extract is passed with an empty image and
+      /// the exception it threw. Every thread may hold an entry of up to *max_size* bytes at once.
+      ///
+      void for_each(Callback callback, std::size_t threads=4, std::size_t max_size=ZipArchive::DefaultMaxSize) const;
+   };
+
+   /// @brief A gzip-compressed sample.
+   ///
+   class GzipFile
+   {
+   protected:
+      Memory<std::uint8_t> data;
+      std::string _name;
+      std::size_t payload_offset;
+
+      void parse_header();
+
+   public:
+      /// @brief Read the compressed file at *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw InvalidArchiveException
+      /// @throw UnsupportedArchiveException
+      ///
+      GzipFile(const std::string &filename);
+
+      /// @brief Read the compressed file held in *data*.
+      ///
+      /// @throw InvalidArchiveException
+      /// @throw UnsupportedArchiveException
+      ///
+      GzipFile(const Memory<std::uint8_t> &data);
+
+      /// @brief Get the original filename stored in the header, if any.
+      ///
+      inline const std::string &name() const { return this->_name; }
+
+      /// @brief Get the uncompressed size recorded in the trailer, modulo 2^32.
+      ///
+      std::size_t declared_size() const;
+
+      /// @brief Inflate the file into an image of its declared size, which may be at most *max_size* bytes.
+      ///
+      /// @throw InvalidArchiveException if the declared size is more than the compressed data can hold
+      /// @throw ArchiveEntryTooLargeException
+      /// @throw ArchiveChecksumException
+      ///
+      PE extract(std::size_t max_size=ZipArchive::DefaultMaxSize) const;
+
+      /// @brief Inflate the file into *parser*, without holding the whole file at once.
+      ///
+      /// @throw InvalidArchiveException
+      /// @throw ArchiveChecksumException
+      /// @throw TruncatedStreamException
+      ///
+      void stream(StreamParser &parser) const;
+   };
+}
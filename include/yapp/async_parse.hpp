@@ -0,0 +1,473 @@
+//! @file async_parse.hpp
+//! @brief Interleaving the parsing of many lazily loaded files on a single thread.
+//!
+//! When an image is loaded on demand, every step of parsing it can stall on I/O: the headers say where
+//! the directories are, the directories say where the thunks and names are, and each of those has to
+//! be read before the next step can start. Blocking on each read in turn leaves the disk idle between
+//! steps. An AsyncParser instead runs an event loop over a ReadQueue. Each file is opened as a
+//! LazyImage, a buffer the size of the file which is filled a page at a time as ranges are asked for,
+//! and each parse suspends whenever it needs bytes which aren't loaded yet, so one thread keeps hundreds
+//! of files in flight and resumes whichever one's bytes arrive first.
+//!
+//! Parses are written against one of two interfaces. The callback interface works everywhere: each
+//! operation takes a continuation which is called on the loop's thread once the operation completes.
+//!
+//! ```cpp
+//! parser.directory(image, IMAGE_DIRECTORY_ENTRY_EXPORT, [] (PE &pe, std::exception_ptr error) {
+//!    if (!error) { auto exports = pe.data_directory().directory<ExportDirectory>(pe); }
+//! });
+//! parser.run();
+//! ```
+//!
+//! When compiled as C++20, the same operations can also be awaited from a coroutine returning Task:
+//!
+//! ```cpp
+//! Task<void> scan(AsyncParser &parser, LazyImage &image) {
+//!    auto exports = co_await parser.directory<ExportDirectory>(image);
+//!    auto imports = co_await parser.imports(image);
+//! }
+//!
+//! parser.spawn(scan(parser, parser.open(filename)));
+//! parser.run();
+//! ```
+//!
+//! Every parse runs on the loop's thread, so a ParseBudget::Scope around run would charge all of them
+//! to one budget. To budget each file on its own, give its image a budget with LazyImage::set_budget.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/import_resolver.hpp>
+#include <yapp/parse_budget.hpp>
+#include <yapp/pe.hpp>
+#include <yapp/read_queue.hpp>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define YAPP_COROUTINES
+#endif
+
+namespace yapp
+{
+   class AsyncParser;
+
+   /// @brief A file whose bytes are read only as they're asked for.
+   ///
+   /// The image spans the whole file from the start, but only the pages which have been loaded hold the
+   /// file's data; everything else is zero. Images are owned by the parser which opened them.
+   ///
+   class LazyImage
+   {
+      friend class AsyncParser;
+
+   public:
+      /// @brief The granularity at which the file is read.
+      ///
+      static const std::size_t PageSize = 0x1000;
+
+      /// @brief Called once a load completes, with the exception which failed it, if any.
+      ///
+      using Continuation = std::function<void(std::exception_ptr error)>;
+
+   protected:
+      enum PageState
+      {
+         MISSING = 0,
+         LOADING = 1,
+         LOADED = 2,
+      };
+
+      struct Waiter
+      {
+         std::size_t first_page;
+         std::size_t last_page;
+         Continuation continuation;
+      };
+
+      AsyncParser *parser;
+      std::string _filename;
+#ifndef YAPP_WIN32
+      int fd;
+#endif
+      std::size_t _size;
+      std::vector<std::uint8_t> buffer;
+      std::vector<std::uint8_t> pages;
+      std::list<Waiter> waiters;
+      std::list<FileRead> reads;
+      std::exception_ptr _error;
+      std::size_t _bytes_loaded;
+      ParseBudget *_budget;
+
+      bool pages_loaded(std::size_t first_page, std::size_t last_page) const;
+      void complete(FileRead *read);
+
+   public:
+      /// @brief Open the file at *filename* for loading through *parser*.
+      ///
+      /// @throw OpenFileFailureException
+      ///
+      LazyImage(AsyncParser &parser, const std::string &filename);
+      LazyImage(const LazyImage &) = delete;
+      ~LazyImage();
+
+      inline const std::string &filename() const { return this->_filename; }
+      inline std::size_t size() const { return this->_size; }
+      inline const std::uint8_t *data() const { return this->buffer.data(); }
+
+      /// @brief Get the error which failed a read of this file, if any; once set, every load fails with it.
+      ///
+      inline std::exception_ptr error() const { return this->_error; }
+
+      /// @brief Get the number of bytes read into the image so far.
+      ///
+      inline std::size_t bytes_loaded() const { return this->_bytes_loaded; }
+
+      /// @brief Charge the parsing of this image to *budget*, or stop charging it if *budget* is null.
+      ///
+      /// The budget is installed around every continuation of a load of this image, so it covers the walks
+      /// AsyncParser runs for the image, the callback they finish with and any coroutine a load resumes,
+      /// in place of whatever budget is installed around run. It applies to loads started after it's set,
+      /// which it must outlive.
+      ///
+      inline void set_budget(ParseBudget *budget) { this->_budget = budget; }
+      inline ParseBudget *budget() const { return this->_budget; }
+
+      /// @brief Check whether the range of *size* bytes at *offset* is loaded, clipped to the file.
+      ///
+      bool loaded(std::size_t offset, std::size_t size) const;
+
+      /// @brief Get a PE view of the image.
+      ///
+      /// The view doesn't own the bytes, so it must not outlive the image.
+      ///
+      PE image();
+
+      /// @brief Load the range of *size* bytes at *offset*, clipped to the file, then call *continuation*.
+      ///
+      /// The continuation always runs from the parser's loop, never from within this call, even when
+      /// the range is already loaded.
+      ///
+      void load(std::size_t offset, std::size_t size, Continuation continuation);
+
+#ifdef YAPP_COROUTINES
+      /// @brief Suspends a coroutine until a range of the image is loaded.
+      ///
+      class LoadAwaiter
+      {
+         LazyImage &image;
+         std::size_t offset;
+         std::size_t size;
+         std::exception_ptr error;
+
+      public:
+         LoadAwaiter(LazyImage &image, std::size_t offset, std::size_t size) : image(image), offset(offset), size(size) {}
+
+         bool await_ready() const { return !this->image._error && this->image.loaded(this->offset, this->size); }
+         void await_suspend(std::coroutine_handle<> handle) {
+            this->image.load(this->offset, this->size, [this, handle] (std::exception_ptr error) {
+               this->error = error;
+               handle.resume();
+            });
+         }
+         void await_resume() {
+            if (this->error) { std::rethrow_exception(this->error); }
+            if (this->image._error) { std::rethrow_exception(this->image._error); }
+         }
+      };
+
+      /// @brief Await the loading of the range of *size* bytes at *offset*, clipped to the file.
+      ///
+      /// @throw ReadFailureException
+      ///
+      inline LoadAwaiter load(std::size_t offset, std::size_t size) { return LoadAwaiter(*this, offset, size); }
+#endif
+   };
+
+#ifdef YAPP_COROUTINES
+   template <typename T>
+   class Task;
+
+   namespace detail
+   {
+      template <typename T>
+      struct TaskPromiseBase
+      {
+         std::exception_ptr error;
+         std::coroutine_handle<> continuation;
+
+         /// Resume whichever coroutine awaited this one, if any.
+         struct FinalAwaiter
+         {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+               auto continuation = handle.promise().continuation;
+               return (continuation) ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+         };
+
+         std::suspend_always initial_suspend() noexcept { return {}; }
+         FinalAwaiter final_suspend() noexcept { return {}; }
+         void unhandled_exception() { this->error = std::current_exception(); }
+      };
+
+      template <typename T>
+      struct TaskPromise : public TaskPromiseBase<T>
+      {
+         std::optional<T> value;
+
+         Task<T> get_return_object();
+         void return_value(T value) { this->value.emplace(std::move(value)); }
+
+         T result() {
+            if (this->error) { std::rethrow_exception(this->error); }
+            return std::move(*this->value);
+         }
+      };
+
+      template <>
+      struct TaskPromise<void> : public TaskPromiseBase<void>
+      {
+         Task<void> get_return_object();
+         void return_void() {}
+
+         void result() {
+            if (this->error) { std::rethrow_exception(this->error); }
+         }
+      };
+   }
+
+   /// @brief A lazily started coroutine producing a *T*.
+   ///
+   /// A task doesn't run until it's awaited or handed to AsyncParser::spawn, and it rethrows any
+   /// exception it exits with to whoever awaits it.
+   ///
+   template <typename T>
+   class Task
+   {
+   public:
+      using promise_type = detail::TaskPromise<T>;
+      using Handle = std::coroutine_handle<promise_type>;
+
+   protected:
+      Handle handle;
+
+   public:
+      explicit Task(Handle handle) : handle(handle) {}
+      Task(const Task &) = delete;
+      Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+      ~Task() { if (this->handle) { this->handle.destroy(); } }
+
+      inline bool done() const { return !this->handle || this->handle.done(); }
+
+      /// @brief Run the task until its first suspension.
+      ///
+      void start() { this->handle.resume(); }
+
+      /// @brief Get the finished task's result.
+      ///
+      decltype(auto) result() { return this->handle.promise().result(); }
+
+      bool await_ready() const noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+         this->handle.promise().continuation = awaiting;
+         return this->handle;
+      }
+      decltype(auto) await_resume() { return this->handle.promise().result(); }
+   };
+
+   template <typename T>
+   Task<T>
+   detail::TaskPromise<T>::get_return_object
+   ()
+   {
+      return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+   }
+
+   inline Task<void>
+   detail::TaskPromise<void>::get_return_object
+   ()
+   {
+      return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+   }
+#endif
+
+   /// @brief Interleaves the parsing of many lazily loaded files on the calling thread.
+   ///
+   /// Every continuation and coroutine runs on the thread calling run, so parses need no locking.
+   ///
+   class AsyncParser
+   {
+      friend class LazyImage;
+
+   public:
+      using Backend = ReadQueue::Backend;
+
+      /// @brief Called with the image once an operation has loaded what it needs, or with an empty image
+      /// and the exception it failed with.
+      ///
+      using Callback = std::function<void(PE &pe, std::exception_ptr error)>;
+
+      /// @brief Called with the imports of an image, or with none and the exception they failed with.
+      ///
+      using ImportsCallback = std::function<void(std::vector<Import> &imports, std::exception_ptr error)>;
+
+   protected:
+      std::unique_ptr<ReadQueue> queue;
+      std::list<LazyImage> images;
+      std::deque<FileRead *> pending;
+      std::deque<std::function<void()>> ready;
+      std::size_t in_flight;
+      std::size_t _reads;
+      std::size_t _bytes_read;
+#ifdef YAPP_COROUTINES
+      std::list<Task<void>> tasks;
+      std::exception_ptr task_error;
+#endif
+
+      void submit(FileRead *read);
+
+   public:
+      /// @brief Create a parser which keeps up to *depth* reads in flight, using the given *backend*.
+      ///
+      /// The thread pool backend uses *threads* threads.
+      ///
+      /// @throw UnsupportedBackendException
+      ///
+      AsyncParser(std::size_t depth=64, Backend backend=Backend::AUTO, std::size_t threads=4);
+      AsyncParser(const AsyncParser &) = delete;
+      ~AsyncParser();
+
+      inline Backend backend() const { return this->queue->backend(); }
+
+      /// @brief Get the number of reads issued so far.
+      ///
+      inline std::size_t reads() const { return this->_reads; }
+
+      /// @brief Get the number of bytes read so far.
+      ///
+      inline std::size_t bytes_read() const { return this->_bytes_read; }
+
+      /// @brief Open the file at *filename* as a lazily loaded image owned by this parser.
+      ///
+      /// Nothing is read until something is loaded.
+      ///
+      /// @throw OpenFileFailureException
+      ///
+      LazyImage &open(const std::string &filename);
+
+      /// @brief Free the given *image*, which must have no loads outstanding.
+      ///
+      void close(LazyImage &image);
+
+      /// @brief Run *task* from the loop.
+      ///
+      void post(std::function<void()> task);
+
+      /// @brief Run the loop until no continuation is ready and no read is in flight.
+      ///
+      /// @throw ReadFailureException
+      ///
+      void run();
+
+      /// @brief Load every header of the *image*, then validate them and call *then*.
+      ///
+      void headers(LazyImage &image, Callback then);
+
+      /// @brief Load the headers and the data directory with the given *index* of the *image*, then call
+      /// *then*.
+      ///
+      /// Only the range named by the directory entry is loaded, not data the directory points to
+      /// elsewhere. An absent directory isn't an error; the image just has no directory to read.
+      ///
+      void directory(LazyImage &image, std::size_t index, Callback then);
+
+      /// @brief Load everything the import directory of the *image* refers to, then list its imports.
+      ///
+      /// The descriptors are loaded first, then the sections holding the names and thunk arrays they
+      /// point to, then the sections holding the names the thunks point to.
+      ///
+      void imports(LazyImage &image, ImportsCallback then);
+
+#ifdef YAPP_COROUTINES
+      /// @brief Adapts a callback operation into an awaitable.
+      ///
+      template <typename T>
+      class Operation
+      {
+      public:
+         using Start = std::function<void(std::function<void(T &, std::exception_ptr)>)>;
+
+      protected:
+         Start start;
+         std::optional<T> value;
+         std::exception_ptr error;
+
+      public:
+         Operation(Start start) : start(std::move(start)) {}
+
+         bool await_ready() const noexcept { return false; }
+         void await_suspend(std::coroutine_handle<> handle) {
+            this->start([this, handle] (T &value, std::exception_ptr error) {
+               if (error) { this->error = error; }
+               else { this->value.emplace(std::move(value)); }
+
+               handle.resume();
+            });
+         }
+         T await_resume() {
+            if (this->error) { std::rethrow_exception(this->error); }
+            return std::move(*this->value);
+         }
+      };
+
+      /// @brief Run *task* from the loop; run rethrows the first exception a spawned task exits with.
+      ///
+      void spawn(Task<void> task);
+
+      /// @brief Await the headers of the *image*.
+      ///
+      Operation<PE> headers(LazyImage &image) {
+         return Operation<PE>([this, &image] (auto then) { this->headers(image, then); });
+      }
+
+      /// @brief Await the headers and the data directory with the given *index* of the *image*.
+      ///
+      Operation<PE> directory(LazyImage &image, std::size_t index) {
+         return Operation<PE>([this, &image, index] (auto then) { this->directory(image, index, then); });
+      }
+
+      /// @brief Await the data directory of type *T* of the *image*.
+      ///
+      /// @throw DirectoryUnavailableException
+      ///
+      template <typename T>
+      Task<T> directory(LazyImage &image) {
+         auto pe = co_await this->directory(image, T::DirectoryIndex);
+         co_return pe.data_directory().template directory<T>(pe);
+      }
+
+      /// @brief Await the imports of the *image*.
+      ///
+      Operation<std::vector<Import>> imports(LazyImage &image) {
+         return Operation<std::vector<Import>>([this, &image] (auto then) { this->imports(image, then); });
+      }
+#endif
+   };
+}
@@ -0,0 +1,209 @@
+//! @file coff.hpp
+//! @brief Parsing bare COFF object files, as compilers emit them.
+//!
+//! An object file is the part of a PE file that comes after the NT signature: an IMAGE_FILE_HEADER,
+//! the section table, each section's raw data and relocations, and a symbol table followed by a string
+//! table. There's no DOS header, so *PE* can't open one. *COFFObject* reads the same headers with the
+//! same wrapper types, and reads nothing until it's asked: the relocations, symbol table and string
+//! table are found from the file header on each access, and names are views straight into the file.
+//!
+//! ```cpp
+//! COFFObject object(std::string("module.obj"));
+//!
+//! object.for_each_symbol([&] (std::size_t index, const headers::raw::IMAGE_SYMBOL &symbol, std::string_view name) {
+//!    if (symbol.StorageClass == headers::raw::IMAGE_SYM_CLASS_EXTERNAL) { index_symbol(name); }
+//! });
+//! ```
+//!
+//! Names stay valid as long as the memory the object views does. Anonymous objects, which is what
+//! short import headers and `/bigobj` objects are, aren't supported.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+#include <yapp/span.hpp>
+#include <yapp/headers.hpp>
+#include <yapp/address.hpp>
+
+namespace yapp
+{
+   class COFFObject : public Memory<std::uint8_t>
+   {
+   public:
+      COFFObject() : Memory() {}
+      COFFObject(const std::string &filename) : Memory(filename) {}
+      COFFObject(const Memory &memory) : Memory(memory) {}
+
+      headers::FileHeader file_header() {
+         return this->cast_ptr<headers::FileHeader::BaseType>(0);
+      }
+
+      const headers::FileHeader file_header() const {
+         return this->cast_ptr<headers::FileHeader::BaseType>(0);
+      }
+
+      /// @brief Get the file header, checking that this isn't an anonymous object.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      const headers::FileHeader valid_file_header() const {
+         const auto header = this->file_header();
+
+         if (header->Machine == headers::raw::IMAGE_FILE_MACHINE_UNKNOWN && header->NumberOfSections == 0xFFFF)
+            throw InvalidObjectException(0);
+
+         return header;
+      }
+
+      std::uint16_t machine() const {
+         return this->valid_file_header()->Machine;
+      }
+
+      Offset section_table_offset() const {
+         auto header = this->valid_file_header();
+
+         return static_cast<std::uint32_t>(sizeof(headers::FileHeader::BaseType) + header->SizeOfOptionalHeader);
+      }
+
+      headers::SectionTable section_table() {
+         auto offset = this->section_table_offset();
+         auto number_of_sections = this->valid_file_header()->NumberOfSections;
+
+         // throw an exception if this goes out of range
+         this->throw_if_out_of_bounds<headers::SectionTable::BaseType>(*offset, number_of_sections);
+         return headers::SectionTable(this->cast_ptr<headers::SectionTable::BaseType>(*offset), number_of_sections);
+      }
+
+      const headers::SectionTable section_table() const {
+         auto offset = this->section_table_offset();
+         auto number_of_sections = this->valid_file_header()->NumberOfSections;
+
+         // throw an exception if this goes out of range
+         this->throw_if_out_of_bounds<headers::SectionTable::BaseType>(*offset, number_of_sections);
+         return headers::SectionTable(this->cast_ptr<headers::SectionTable::BaseType>(*offset), number_of_sections);
+      }
+
+      /// @brief Get the raw data of *section*, which is empty for uninitialized data.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      Memory<std::uint8_t> section_data(const headers::SectionHeader &section) {
+         if (section->SizeOfRawData == 0) { return Memory<std::uint8_t>(); }
+
+         return this->subsection(section->PointerToRawData, section->SizeOfRawData);
+      }
+
+      /// @brief Get the raw data of *section*, which is empty for uninitialized data.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      const Memory<std::uint8_t> section_data(const headers::SectionHeader &section) const {
+         if (section->SizeOfRawData == 0) { return Memory<std::uint8_t>(); }
+
+         return this->subsection(section->PointerToRawData, section->SizeOfRawData);
+      }
+
+      /// @brief Get the relocations of *section*, including the extended count of sections with more
+      /// than 65535 of them.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      const Memory<headers::raw::IMAGE_RELOCATION> relocations(const headers::SectionHeader &section) const;
+
+      /// @brief Get the symbol table, which is empty if the object has none.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      headers::SymbolTable symbol_table() {
+         auto header = this->valid_file_header();
+         if (header->PointerToSymbolTable == 0 || header->NumberOfSymbols == 0) { return headers::SymbolTable(); }
+
+         this->throw_if_out_of_bounds<headers::SymbolTable::BaseType>(header->PointerToSymbolTable, header->NumberOfSymbols);
+         return headers::SymbolTable(this->cast_ptr<headers::SymbolTable::BaseType>(header->PointerToSymbolTable), header->NumberOfSymbols);
+      }
+
+      /// @brief Get the symbol table, which is empty if the object has none.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      const headers::SymbolTable symbol_table() const {
+         auto header = this->valid_file_header();
+         if (header->PointerToSymbolTable == 0 || header->NumberOfSymbols == 0) { return headers::SymbolTable(); }
+
+         this->throw_if_out_of_bounds<headers::SymbolTable::BaseType>(header->PointerToSymbolTable, header->NumberOfSymbols);
+         return headers::SymbolTable(this->cast_ptr<headers::SymbolTable::BaseType>(header->PointerToSymbolTable), header->NumberOfSymbols);
+      }
+
+      /// @brief Get the string table which follows the symbol table, its leading size included, since
+      /// string table offsets count it.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      Span<const char> string_table() const;
+
+      /// @brief Get the null-terminated string at *offset* into the string table.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      std::string_view string_at(std::uint32_t offset) const;
+
+      /// @brief Get the name of *symbol*, from the record itself or from the string table.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      std::string_view symbol_name(const headers::raw::IMAGE_SYMBOL &symbol) const;
+
+      std::string_view symbol_name(const headers::Symbol &symbol) const { return this->symbol_name(*symbol.ptr()); }
+
+      /// @brief Get the name of *section*, following `/` names into the string table.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      std::string_view section_name(const headers::SectionHeader &section) const;
+
+      /// @brief Call *visitor* with each symbol of the object, skipping auxiliary records, as
+      /// `visitor(std::size_t index, const headers::raw::IMAGE_SYMBOL &, std::string_view name)`.
+      ///
+      /// The symbol and string tables are located once for the whole walk, and no symbol is copied or
+      /// wrapped, so this is the way to index many objects.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      template <typename Visitor>
+      void for_each_symbol(Visitor &&visitor) const {
+         const auto table = this->symbol_table();
+         if (table.size() == 0) { return; }
+
+         auto strings = this->string_table();
+         auto symbols = table.ptr();
+
+         for (std::size_t index=0; index<table.size(); index += 1 + symbols[index].NumberOfAuxSymbols)
+            visitor(index, symbols[index], COFFObject::SymbolName(symbols[index], strings));
+      }
+
+      /// @brief Get the index of the first symbol named *name*.
+      ///
+      /// @throw InvalidObjectException
+      /// @throw OutOfBoundsException
+      ///
+      std::optional<std::size_t> find_symbol(std::string_view name) const;
+
+   protected:
+      static std::string_view StringAt(Span<const char> strings, std::uint32_t offset);
+      static std::string_view SymbolName(const headers::raw::IMAGE_SYMBOL &symbol, Span<const char> strings);
+   };
+}
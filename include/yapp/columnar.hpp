@@ -0,0 +1,220 @@
+//! @file columnar.hpp
+//! @brief A columnar exporter of header and section fields for corpus-wide analytics.
+//!
+//! Fleet-wide queries usually look at a handful of fields -- machine, timestamp, section names --
+//! across millions of images. Storing those as one column per field keeps each column's values
+//! together, so a query only reads the columns it touches and the values compress well. The corpus
+//! exporter gathers the fields of many images into three tables: one row per image, one row per
+//! section and one row per imported module. Header fields are taken straight from the structures in
+//! `raw.hpp` by offset and size, and strings which repeat across the corpus, section names and module
+//! names, are dictionary encoded.
+//!
+//! The file format is self-describing: a magic, then each table with its name, row count and columns,
+//! and each column with its name, type, dictionary if any, and values. All integers are little-endian.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/span.hpp>
+#include <yapp/headers/fields.hpp>
+
+namespace yapp
+{
+   class PE;
+
+   /// @brief A table of named, typed columns of equal length.
+   ///
+   class ColumnTable
+   {
+   public:
+      enum ColumnType
+      {
+         UINT8 = 0,
+         UINT16 = 1,
+         UINT32 = 2,
+         UINT64 = 3,
+         FLOAT64 = 4,
+         /// @brief A string column, stored as codes into a dictionary of its distinct values.
+         DICTIONARY = 5,
+      };
+
+      /// @brief A single column of the table.
+      ///
+      /// Values are stored in their encoded, little-endian form. Dictionary columns store a 32-bit code
+      /// per row, indexing *dictionary*.
+      ///
+      struct Column
+      {
+         std::string name;
+         ColumnType type;
+         std::vector<std::uint8_t> data;
+         std::vector<std::string> dictionary;
+         std::map<std::string, std::uint32_t> codes;
+      };
+
+      /// @brief Get the width of a single value of the given column *type*, in bytes.
+      ///
+      static std::size_t Width(ColumnType type);
+
+   protected:
+      std::string _name;
+      std::vector<Column> _columns;
+      std::size_t _rows;
+
+   public:
+      ColumnTable(const std::string &name=std::string());
+
+      inline const std::string &name() const { return this->_name; }
+      inline std::size_t rows() const { return this->_rows; }
+      inline const std::vector<Column> &columns() const { return this->_columns; }
+
+      /// @brief Add a column of the given *name* and *type*, returning its index.
+      ///
+      /// Columns can only be added to an empty table.
+      ///
+      /// @throw IncompleteRowException
+      ///
+      std::size_t add_column(const std::string &name, ColumnType type);
+
+      /// @brief Add a column for every field in the given field table, naming each after its field with
+      /// *prefix* in front, and return the index of the first.
+      ///
+      /// Integer fields get the narrowest integer column holding them and byte strings get dictionary
+      /// columns. Arrays and nested structures are flattened into a column per element, named like
+      /// `DataDirectory[1].Size`.
+      ///
+      /// @throw IncompleteRowException
+      ///
+      std::size_t add_fields(Span<const headers::Field> fields, const std::string &prefix=std::string());
+
+      /// @brief Add a column for every field of the raw structure *T*.
+      ///
+      /// @throw IncompleteRowException
+      ///
+      template <typename T>
+      std::size_t add_fields(const std::string &prefix=std::string()) {
+         return this->add_fields(headers::Fields<T>::Table(), prefix);
+      }
+
+      /// @brief Find the index of the column with the given *name*.
+      ///
+      /// @throw ColumnNotFoundException
+      ///
+      std::size_t column_index(const std::string &name) const;
+
+      /// @brief Append an integer *value* to the given integer *column*, truncating it to the column's width.
+      ///
+      void append(std::size_t column, std::uint64_t value);
+
+      /// @brief Append a floating point *value* to the given float *column*.
+      ///
+      void append(std::size_t column, double value);
+
+      /// @brief Append a string *value* to the given dictionary *column*.
+      ///
+      void append(std::size_t column, const std::string &value);
+
+      /// @brief Append the fields of the structure at *data* to the columns added for its field table,
+      /// starting at *column*, and return the column after the last one appended.
+      ///
+      std::size_t append_fields(std::size_t column, Span<const headers::Field> fields, const std::uint8_t *data);
+
+      /// @brief Append the fields of a raw *structure* to the columns added for it with *add_fields*.
+      ///
+      template <typename T>
+      std::size_t append_fields(std::size_t column, const T &structure) {
+         return this->append_fields(column, headers::Fields<T>::Table(), reinterpret_cast<const std::uint8_t *>(&structure));
+      }
+
+      /// @brief Mark the current row as complete.
+      ///
+      /// Every column must have had exactly one value appended since the previous row.
+      ///
+      /// @throw IncompleteRowException
+      ///
+      void end_row();
+
+      /// @brief Get the integer value of the given *column* at the given *row*.
+      ///
+      std::uint64_t integer(std::size_t column, std::size_t row) const;
+
+      /// @brief Get the floating point value of the given *column* at the given *row*.
+      ///
+      double number(std::size_t column, std::size_t row) const;
+
+      /// @brief Get the string value of the given dictionary *column* at the given *row*.
+      ///
+      const std::string &string(std::size_t column, std::size_t row) const;
+
+      /// @brief Write the table to the given *stream*.
+      ///
+      void write(std::ostream &stream) const;
+
+      /// @brief Read a table from the given *stream*.
+      ///
+      /// @throw InvalidColumnarFileException
+      ///
+      static ColumnTable Read(std::istream &stream);
+   };
+
+   /// @brief Gathers header, section and import fields of many images into columnar tables.
+   ///
+   class CorpusExporter
+   {
+   public:
+      static const char Magic[8];
+
+   protected:
+      ColumnTable _images;
+      ColumnTable _sections;
+      ColumnTable _imports;
+
+   public:
+      CorpusExporter();
+
+      /// @brief The table with one row per image.
+      ///
+      inline const ColumnTable &images() const { return this->_images; }
+
+      /// @brief The table with one row per section, linked to its image by the *image* column.
+      ///
+      inline const ColumnTable &sections() const { return this->_sections; }
+
+      /// @brief The table with one row per imported module, linked to its image by the *image* column.
+      ///
+      inline const ColumnTable &imports() const { return this->_imports; }
+
+      /// @brief Add the fields of the given *pe* image, naming its row *name*.
+      ///
+      /// Every field is read before any table is touched, so an image which fails to parse leaves the
+      /// tables as they were.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      void add(const PE &pe, const std::string &name);
+
+      /// @brief Write the tables to the given *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void write(const std::string &filename) const;
+
+      /// @brief Read the tables of the columnar file at the given *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw InvalidColumnarFileException
+      ///
+      static std::vector<ColumnTable> Read(const std::string &filename);
+   };
+}
@@ -0,0 +1,62 @@
+//! @file digest.hpp
+//! @brief A self-contained SHA-256 for keying caches by file content.
+//!
+//! Content-keyed caches can't trust a fast non-cryptographic hash: anyone who can put a file in front
+//! of the parser can craft a second file with the same 64-bit FNV-1a hash and be served the first file's
+//! cached results. Sha256 gives those caches a collision-resistant key without pulling in a crypto
+//! library. Data can be hashed in one call or fed incrementally:
+//!
+//! ```cpp
+//! auto digest = Sha256::Hash(Span<const std::uint8_t>(pe.ptr(), pe.size()));
+//! auto name = Hex::ToString(digest);
+//! ```
+//!
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <yapp/span.hpp>
+
+namespace yapp
+{
+   /// @brief The SHA-256 hash function, as specified by FIPS 180-4.
+   ///
+   class Sha256
+   {
+   public:
+      static const std::size_t Size = 32;
+      using Digest = std::array<std::uint8_t, Sha256::Size>;
+
+   protected:
+      std::uint32_t state[8];
+      std::uint8_t block[64];
+      std::size_t buffered;
+      std::uint64_t length;
+
+      void compress(const std::uint8_t *data);
+
+   public:
+      Sha256();
+
+      /// @brief Hash *data* in one call.
+      ///
+      static Digest Hash(Span<const std::uint8_t> data);
+
+      /// @brief Feed *data* into the hash.
+      ///
+      void update(Span<const std::uint8_t> data);
+
+      /// @brief Pad the message and return its digest.
+      ///
+      /// The hash can't be updated afterward without being reset.
+      ///
+      Digest finish();
+
+      /// @brief Start a new message.
+      ///
+      void reset();
+   };
+}
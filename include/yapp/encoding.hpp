@@ -0,0 +1,110 @@
+//! @file encoding.hpp
+//! @brief Hex and base64 encoders and decoders which write into caller-provided buffers.
+//!
+//! Reports embed a hex digest and base64 snippets for every file, so encoding has to cost next to
+//! nothing. The encoders and decoders here write into a buffer the caller sizes with *EncodedSize* or
+//! *DecodedSize*, so a caller encoding many values can reuse one buffer and never allocate:
+//!
+//! ```cpp
+//! char digest[Hex::EncodedSize(32)];
+//! Hex::Encode(Span<const std::uint8_t>(hash, 32), digest);
+//! ```
+//!
+//! On x86 the hex kernels use SSE2, which every x86-64 compiler enables, and the base64 kernels use
+//! SSSE3 when the compiler is allowed to (e.g., `-mssse3` or `-march=native`). Everything else falls
+//! back to table-driven code, which is also used for the tails the vector kernels leave behind.
+//!
+//! Base64 uses the standard alphabet with `=` padding. Decoding is strict: hex must have an even number
+//! of digits, base64 must come in padded groups of four, and whitespace is rejected.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/span.hpp>
+
+namespace yapp
+{
+   /// @brief Hexadecimal encoding, two digits per byte, most significant digit first.
+   ///
+   class Hex
+   {
+   public:
+      static constexpr std::size_t EncodedSize(std::size_t size) { return size * 2; }
+
+      /// @brief Get the number of bytes *size* hex digits decode to.
+      ///
+      static constexpr std::size_t DecodedSize(std::size_t size) { return size / 2; }
+
+      /// @brief Encode *input* into *output*, returning the number of characters written.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      static std::size_t Encode(Span<const std::uint8_t> input, Span<char> output, bool uppercase=false);
+
+      /// @brief Decode the digits in *input* into *output*, returning the number of bytes written.
+      ///
+      /// Digits may be either case.
+      ///
+      /// @throw InvalidEncodingException
+      /// @throw OutOfBoundsException
+      ///
+      static std::size_t Decode(Span<const char> input, Span<std::uint8_t> output);
+
+      /// @brief Encode *input* into a new string.
+      ///
+      static std::string ToString(Span<const std::uint8_t> input, bool uppercase=false);
+
+      /// @brief Decode *input* into a new vector.
+      ///
+      /// @throw InvalidEncodingException
+      ///
+      static std::vector<std::uint8_t> ToBytes(Span<const char> input);
+   };
+
+   /// @brief Base64 encoding with the standard alphabet and padding.
+   ///
+   class Base64
+   {
+   public:
+      static constexpr std::size_t EncodedSize(std::size_t size) { return (size + 2) / 3 * 4; }
+
+      /// @brief Get the most bytes *size* base64 characters can decode to.
+      ///
+      /// Padding makes the exact size up to two less; see the overload taking the input itself.
+      ///
+      static constexpr std::size_t DecodedSize(std::size_t size) { return size / 4 * 3; }
+
+      /// @brief Get the exact number of bytes the base64 *input* decodes to.
+      ///
+      static std::size_t DecodedSize(Span<const char> input);
+
+      /// @brief Encode *input* into *output*, returning the number of characters written.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      static std::size_t Encode(Span<const std::uint8_t> input, Span<char> output);
+
+      /// @brief Decode the base64 *input* into *output*, returning the number of bytes written.
+      ///
+      /// @throw InvalidEncodingException
+      /// @throw OutOfBoundsException
+      ///
+      static std::size_t Decode(Span<const char> input, Span<std::uint8_t> output);
+
+      /// @brief Encode *input* into a new string.
+      ///
+      static std::string ToString(Span<const std::uint8_t> input);
+
+      /// @brief Decode *input* into a new vector.
+      ///
+      /// @throw InvalidEncodingException
+      ///
+      static std::vector<std::uint8_t> ToBytes(Span<const char> input);
+   };
+}
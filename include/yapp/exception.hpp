@@ -4,6 +4,7 @@
 #pragma once
 
 #include <yapp/platform.hpp>
+#include <yapp/instrument.hpp>
 
 #include <cstdint>
 #include <cstddef>
@@ -41,6 +42,8 @@ namespace yapp
       std::size_t offset, size;
 
       OutOfBoundsException(std::size_t offset, std::size_t size) : offset(offset), size(size), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
          stream << "Slice offset out-of-bounds: got offset " << offset << ", but size is " << size << ".";
 
@@ -55,6 +58,8 @@ namespace yapp
    {
    public:
       AlignmentException() : Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
          stream << "Types " << typeid(T).name()
                 << " (size " << sizeof(T)
@@ -65,6 +70,8 @@ namespace yapp
          this->error = stream.str();
       }
       AlignmentException(std::size_t bytes) : Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
          stream << "Byte offset " << bytes
                 << " did not align with " << typeid(T).name()
@@ -89,6 +96,8 @@ namespace yapp
       std::vector<U> data;
       
       InsufficientDataException(std::vector<U> &data) : data(data), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          auto expected = sizeof(T) / sizeof(U);
          std::stringstream stream;
 
@@ -105,7 +114,7 @@ namespace yapp
    class NullPointerException : public Exception
    {
    public:
-      NullPointerException() : Exception("Encountered an unexpected null pointer.") {}
+      NullPointerException() : Exception("Encountered an unexpected null pointer.") { YAPP_COUNT_EXCEPTION(); }
    };
 
    /// @brief Thrown when search terms contain all wildcards.
@@ -113,7 +122,7 @@ namespace yapp
    class SearchTooBroadException : public Exception
    {
    public:
-      SearchTooBroadException() : Exception("The given search term was too broad; search terms cannot be all wildcards.") {}
+      SearchTooBroadException() : Exception("The given search term was too broad; search terms cannot be all wildcards.") { YAPP_COUNT_EXCEPTION(); }
     };
 
    /// @brief Thrown when a header allocation is insufficient compared to the header.
@@ -128,6 +137,8 @@ namespace yapp
            needed(needed),
            Exception()
       {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "The allocation size was insufficient: got " << this->attempted
@@ -142,7 +153,7 @@ namespace yapp
    class NotAllocatedException : public Exception
    {
    public:
-      NotAllocatedException() : Exception("The memory object is not allocated.") {}
+      NotAllocatedException() : Exception("The memory object is not allocated.") { YAPP_COUNT_EXCEPTION(); }
    };
 
    /// @brief Thrown when a memory allocator returns a bad pointer.
@@ -150,7 +161,7 @@ namespace yapp
    class BadAllocationException : public Exception
    {
    public:
-      BadAllocationException() : Exception("The allocator returned an invalid allocation.") {}
+      BadAllocationException() : Exception("The allocator returned an invalid allocation.") { YAPP_COUNT_EXCEPTION(); }
    };
 
    /// @brief Thrown when the parsed DOS signature for the PE file is invalid.
@@ -161,6 +172,8 @@ namespace yapp
       std::uint16_t bad_sig;
       
       InvalidDOSSignatureException(std::uint16_t bad_sig) : bad_sig(bad_sig), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "Invalid DOS signature: the signature " << std::hex << std::showbase << this->bad_sig
@@ -178,6 +191,8 @@ namespace yapp
       std::uint32_t bad_sig;
       
       InvalidNTSignatureException(std::uint32_t bad_sig) : bad_sig(bad_sig), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "Invalid NT signature: the signature " << std::hex << std::showbase << this->bad_sig
@@ -198,6 +213,8 @@ namespace yapp
       UnexpectedOptionalMagicException(std::uint16_t bad_sig, std::uint16_t expected_sig)
          : bad_sig(bad_sig), expected_sig(expected_sig), Exception()
       {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "Unexpected optional magic: the magic value was  " << std::hex << std::showbase << this->bad_sig
@@ -208,6 +225,8 @@ namespace yapp
       UnexpectedOptionalMagicException(std::uint16_t bad_sig)
          : bad_sig(bad_sig), expected_sig(0), Exception()
       {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "Unexpected optional magic: the magic value was  " << std::hex << std::showbase << this->bad_sig
@@ -221,7 +240,7 @@ namespace yapp
    class SectionNotFoundException : public Exception
    {
    public:
-      SectionNotFoundException() : Exception("The section could not be found with the given parameter.") {}
+      SectionNotFoundException() : Exception("The section could not be found with the given parameter.") { YAPP_COUNT_EXCEPTION(); }
    };
 
    class Offset;
@@ -257,13 +276,13 @@ namespace yapp
    class SectionTableOverflowException : public Exception
    {
    public:
-      SectionTableOverflowException() : Exception("Operation would overflow the section table.") {}
+      SectionTableOverflowException() : Exception("Operation would overflow the section table.") { YAPP_COUNT_EXCEPTION(); }
    };
 
    class UnsupportedArchitectureException : public Exception
    {
    public:
-      UnsupportedArchitectureException() : Exception("The architecture of this PE file is unsupported.") {}
+      UnsupportedArchitectureException() : Exception("The architecture of this PE file is unsupported.") { YAPP_COUNT_EXCEPTION(); }
    };
 
    class OpenFileFailureException : public Exception
@@ -272,6 +291,8 @@ namespace yapp
       std::string filename;
 
       OpenFileFailureException(const std::string &filename) : filename(filename), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "Failed to open file \"" << filename << "\".";
@@ -280,12 +301,52 @@ namespace yapp
       }
    };
 
+   class WriteFailureException : public Exception
+   {
+   public:
+      std::string filename;
+
+      WriteFailureException(const std::string &filename) : filename(filename), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Failed to write file \"" << filename << "\".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class ReadFailureException : public Exception
+   {
+   public:
+      std::string filename;
+
+      ReadFailureException(const std::string &filename) : filename(filename), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Failed to read file \"" << filename << "\".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class NoSourceFileException : public Exception
+   {
+   public:
+      NoSourceFileException() : Exception("The operation requires a source file, but none was given.") { YAPP_COUNT_EXCEPTION(); }
+   };
+
    class DirectoryUnavailableException : public Exception
    {
    public:
       std::size_t index;
 
       DirectoryUnavailableException(std::size_t index) : index(index), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << "Directory index " << index << " is either null or invalid.";
@@ -301,6 +362,8 @@ namespace yapp
       std::size_t size;
 
       InvalidPointerException(const void *ptr, std::size_t size) : ptr(ptr), size(size), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          std::stringstream stream;
 
          stream << std::hex << std::showbase << "The given pointer " << std::uintptr_t(ptr)
@@ -311,6 +374,375 @@ namespace yapp
       }
    };
 
+   class UnsupportedImageTypeException : public Exception
+   {
+   public:
+      UnsupportedImageTypeException() : Exception("The operation is not supported for this image type.") { YAPP_COUNT_EXCEPTION(); }
+   };
+
+   class SectionOverlapException : public Exception
+   {
+   public:
+      std::size_t index;
+
+      SectionOverlapException(std::size_t index) : index(index), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Section " << index << " overlaps the virtual range of the section before it.";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidDiffException : public Exception
+   {
+   public:
+      std::size_t offset;
+
+      InvalidDiffException(std::size_t offset) : offset(offset), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The patch diff is malformed at offset " << offset << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidRelocationException : public Exception
+   {
+   public:
+      std::uint32_t rva;
+
+      InvalidRelocationException(std::uint32_t rva) : rva(rva), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << std::hex << std::showbase << "The base relocation block at RVA " << rva << " is malformed.";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidMetadataException : public Exception
+   {
+   public:
+      std::size_t offset;
+
+      InvalidMetadataException(std::size_t offset) : offset(offset), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The metadata record is malformed at offset " << offset << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class ColumnNotFoundException : public Exception
+   {
+   public:
+      std::string name;
+
+      ColumnNotFoundException(const std::string &name) : name(name), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The table has no column named \"" << name << "\".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class IncompleteRowException : public Exception
+   {
+   public:
+      std::size_t column;
+
+      IncompleteRowException(std::size_t column) : column(column), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Column " << column << " does not have exactly one value for every row.";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidColumnarFileException : public Exception
+   {
+   public:
+      std::size_t offset;
+
+      InvalidColumnarFileException(std::size_t offset) : offset(offset), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The columnar file is malformed at offset " << offset << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class UnsupportedBackendException : public Exception
+   {
+   public:
+      UnsupportedBackendException() : Exception("The requested I/O backend is not available on this host.") { YAPP_COUNT_EXCEPTION(); }
+   };
+
+   class ParseRequestException : public Exception
+   {
+   public:
+      ParseRequestException(const std::string &message) : Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The parse server failed the request: " << message;
+
+         this->error = stream.str();
+      }
+   };
+
+   class TruncatedStreamException : public Exception
+   {
+   public:
+      std::size_t size, needed;
+
+      TruncatedStreamException(std::size_t size, std::size_t needed) : size(size), needed(needed), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The stream ended after " << size << " bytes, but its headers need " << needed << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidArchiveException : public Exception
+   {
+   public:
+      std::size_t offset;
+
+      InvalidArchiveException(std::size_t offset) : offset(offset), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Invalid archive data at offset " << offset << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class UnsupportedArchiveException : public Exception
+   {
+   public:
+      std::string feature;
+
+      UnsupportedArchiveException(const std::string &feature) : feature(feature), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Unsupported archive feature: " << feature << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class ArchivePasswordException : public Exception
+   {
+   public:
+      std::string name;
+
+      ArchivePasswordException(const std::string &name) : name(name), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Wrong password for archive entry \"" << name << "\".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class ArchiveChecksumException : public Exception
+   {
+   public:
+      std::string name;
+
+      ArchiveChecksumException(const std::string &name) : name(name), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Checksum mismatch in archive entry \"" << name << "\".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class ArchiveEntryTooLargeException : public Exception
+   {
+   public:
+      std::string name;
+      std::size_t size, limit;
+
+      ArchiveEntryTooLargeException(const std::string &name, std::size_t size, std::size_t limit)
+         : name(name), size(size), limit(limit), Exception()
+      {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Archive entry \"" << name << "\" declares " << size << " bytes, past the limit of " << limit << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   /// @brief Thrown when parsing runs past a ParseBudget.
+   ///
+   class BudgetExceededException : public Exception
+   {
+   public:
+      enum Limit
+      {
+         DEADLINE = 0,
+         BYTES = 1,
+         ELEMENTS = 2,
+      };
+
+      enum Structure
+      {
+         IMPORT_DESCRIPTORS = 0,
+         IMPORT_THUNKS,
+         EXPORT_FUNCTIONS,
+         EXPORT_NAMES,
+         RELOCATION_BLOCKS,
+         RELOCATIONS,
+         TLS_CALLBACKS,
+         STRINGS,
+         RESOURCES,
+         STRUCTURE_COUNT,
+      };
+
+      Limit limit;
+      Structure structure;
+
+      BudgetExceededException(Limit limit, Structure structure) : limit(limit), structure(structure), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         static const char *names[STRUCTURE_COUNT] = {
+            "import descriptors", "import thunks", "export functions", "export names",
+            "relocation blocks", "relocations", "TLS callbacks", "strings", "resources"
+         };
+
+         std::stringstream stream;
+
+         stream << "Parse budget exceeded while walking " << names[structure] << ": ";
+
+         switch (limit)
+         {
+         case DEADLINE: stream << "the deadline passed."; break;
+         case BYTES: stream << "too many bytes touched."; break;
+         case ELEMENTS: stream << "too many elements."; break;
+         }
+
+         this->error = stream.str();
+      }
+   };
+
+   class FieldNotFoundException : public Exception
+   {
+   public:
+      std::string name;
+
+      FieldNotFoundException(const std::string &name) : name(name), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The structure has no field named \"" << name << "\".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidEncodingException : public Exception
+   {
+   public:
+      std::size_t offset;
+
+      InvalidEncodingException(std::size_t offset) : offset(offset), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Invalid encoded data at offset " << offset << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class InvalidObjectException : public Exception
+   {
+   public:
+      std::size_t offset;
+
+      InvalidObjectException(std::size_t offset) : offset(offset), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "Invalid COFF object data at offset " << offset << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class OversizedHeadersException : public Exception
+   {
+   public:
+      std::size_t extent, limit;
+
+      OversizedHeadersException(std::size_t extent, std::size_t limit) : extent(extent), limit(limit), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The headers claim to run for " << extent << " bytes, past the limit of " << limit << ".";
+
+         this->error = stream.str();
+      }
+   };
+
+   class OversizedImageException : public Exception
+   {
+   public:
+      std::size_t size, limit;
+
+      OversizedImageException(std::size_t size, std::size_t limit) : size(size), limit(limit), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
+         std::stringstream stream;
+
+         stream << "The image claims to map to " << size << " bytes, past the limit of " << limit << ".";
+
+         this->error = stream.str();
+      }
+   };
+
 #ifdef YAPP_WIN32
    #include <windows.h>
    /// @brief Only on Windows. Thrown when `GetLastError()` returns a nonzero result.
@@ -323,6 +755,8 @@ namespace yapp
       DWORD code;
 
       Win32Exception(DWORD code) : code(code), Exception() {
+         YAPP_COUNT_EXCEPTION();
+
          LPSTR buffer = nullptr;
          std::stringstream stream;
 
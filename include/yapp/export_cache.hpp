@@ -0,0 +1,143 @@
+//! @file export_cache.hpp
+//! @brief A process-wide cache of export indices shared between analyses.
+//!
+//! The same few system modules show up in nearly every import table, so long-running workers end
+//! up indexing kernel32, ntdll and friends thousands of times. The export cache keeps the indices
+//! it has built, keyed by module identity, and hands out shared references to them. Indices are
+//! immutable, so any number of threads can use a cached index at once; the least recently used
+//! indices are dropped from the cache once it grows past its memory budget, and are freed once
+//! the last analysis holding them lets go.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <yapp/export_index.hpp>
+
+namespace yapp
+{
+   class PE;
+
+   /// @brief A thread-safe, memory-bounded LRU cache of export indices.
+   ///
+   class ExportIndexCache
+   {
+   public:
+      /// @brief The default memory budget of a cache, in bytes.
+      ///
+      static const std::size_t DefaultBudget = 64 * 1024 * 1024;
+
+      /// @brief The identity of a module in the cache.
+      ///
+      /// Modules are identified either by their lowercase name, file header timestamp and *SizeOfImage*,
+      /// or by a hash of their contents, in which case the other fields are zero.
+      ///
+      struct Key
+      {
+         std::string module;
+         std::uint32_t timestamp;
+         std::uint32_t image_size;
+         std::uint64_t hash;
+
+         bool operator<(const Key &other) const {
+            return std::tie(this->module, this->timestamp, this->image_size, this->hash)
+               < std::tie(other.module, other.timestamp, other.image_size, other.hash);
+         }
+         bool operator==(const Key &other) const {
+            return std::tie(this->module, this->timestamp, this->image_size, this->hash)
+               == std::tie(other.module, other.timestamp, other.image_size, other.hash);
+         }
+      };
+
+   private:
+      struct Entry
+      {
+         Key key;
+         std::shared_ptr<const ExportIndex> index;
+         std::size_t size;
+      };
+
+      std::list<Entry> entries;
+      std::map<Key, std::list<Entry>::iterator> lookup;
+      std::size_t _budget;
+      std::size_t _usage;
+      std::size_t _hits;
+      std::size_t _misses;
+      mutable std::mutex mutex;
+
+      static std::unique_ptr<ExportIndexCache> Instance;
+      static std::once_flag InstanceFlag;
+
+      void evict();
+
+   public:
+      /// @brief Create a cache with the given memory *budget* in bytes.
+      ///
+      ExportIndexCache(std::size_t budget=ExportIndexCache::DefaultBudget);
+
+      /// @brief Get the process-wide cache.
+      ///
+      static ExportIndexCache &GetInstance();
+
+      /// @brief Get the identity key of the given *pe* image by its *module* name and headers.
+      ///
+      static Key IdentityKey(const PE &pe, const std::string &module);
+
+      /// @brief Get the identity key of the given *pe* image by a hash of its contents.
+      ///
+      static Key ContentKey(const PE &pe);
+
+      /// @brief Get the memory budget of the cache.
+      ///
+      std::size_t budget() const;
+
+      /// @brief Set the memory *budget* of the cache, evicting indices if the cache is now over budget.
+      ///
+      void set_budget(std::size_t budget);
+
+      /// @brief Get the estimated memory used by the cached indices.
+      ///
+      std::size_t usage() const;
+
+      /// @brief Get the number of cached indices.
+      ///
+      std::size_t size() const;
+
+      /// @brief Get the number of lookups which found a cached index.
+      ///
+      std::size_t hits() const;
+
+      /// @brief Get the number of lookups which didn't find a cached index.
+      ///
+      std::size_t misses() const;
+
+      /// @brief Find the index with the given *key*, returning null if it isn't cached.
+      ///
+      std::shared_ptr<const ExportIndex> find(const Key &key);
+
+      /// @brief Cache the given *index* under the given *key*, returning the index the cache holds.
+      ///
+      /// If another index was cached under the key in the meantime, that index is returned instead, so
+      /// that every caller shares the same one.
+      ///
+      std::shared_ptr<const ExportIndex> insert(const Key &key, std::shared_ptr<const ExportIndex> index);
+
+      /// @brief Get the index of the given *pe* image named *module*, building and caching it if needed.
+      ///
+      /// The image is keyed by identity, or by content if *by_content* is true.
+      ///
+      std::shared_ptr<const ExportIndex> get(const PE &pe, const std::string &module, bool by_content=false);
+
+      /// @brief Drop every cached index.
+      ///
+      void clear();
+   };
+}
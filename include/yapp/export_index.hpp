@@ -0,0 +1,113 @@
+//! @file export_index.hpp
+//! @brief An immutable, pre-parsed index of the exports of a module.
+//!
+//! Resolving imports means looking up the same exports of the same handful of system modules over
+//! and over. The export index walks a module's export directory once, copying every export's name,
+//! ordinal, address and forwarder string out of the image, so that lookups afterward neither touch
+//! the image nor allocate. Once built, an index is never modified, so it can be shared freely
+//! between threads.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/forwarder.hpp>
+
+namespace yapp
+{
+   class PE;
+
+   /// @brief The exports of a single module, indexed by name and by ordinal.
+   ///
+   class ExportIndex
+   {
+   public:
+      /// @brief A single export of the module.
+      ///
+      /// The *ordinal* is biased by the export directory's base, as it would be written in an import.
+      /// The *name* is empty for exports only reachable by ordinal, and the *forwarder* is empty for
+      /// exports which aren't forwarded to another module.
+      ///
+      struct Export
+      {
+         std::uint32_t ordinal;
+         std::uint32_t rva;
+         std::string name;
+         std::string forwarder;
+
+         inline bool is_forwarded() const { return !this->forwarder.empty(); }
+
+         /// @brief Parse the forwarder string of this export without allocating.
+         ///
+         /// Returns nothing if the export isn't forwarded or the forwarder string is malformed.
+         ///
+         inline std::optional<Forwarder> parsed_forwarder() const {
+            if (!this->is_forwarded()) { return std::nullopt; }
+            return Forwarder::Parse(this->forwarder);
+         }
+      };
+
+   protected:
+      std::string _module;
+      std::uint32_t _timestamp;
+      std::uint32_t _image_size;
+      std::vector<Export> _exports;
+      std::map<std::string, std::size_t> by_name;
+      std::map<std::uint32_t, std::size_t> by_ordinal;
+
+   public:
+      /// @brief Build the index of the given *pe* image, naming it *module*.
+      ///
+      /// If no *module* name is given, the name in the export directory is used. Module names are
+      /// stored in lowercase. An image without an export directory produces an empty index.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      ExportIndex(const PE &pe, const std::string &module=std::string());
+
+      /// @brief Get the lowercase name of the module.
+      ///
+      inline const std::string &module() const { return this->_module; }
+
+      /// @brief Get the timestamp from the module's file header.
+      ///
+      inline std::uint32_t timestamp() const { return this->_timestamp; }
+
+      /// @brief Get the *SizeOfImage* of the module.
+      ///
+      inline std::uint32_t image_size() const { return this->_image_size; }
+
+      /// @brief Get every export of the module, in ordinal order.
+      ///
+      inline const std::vector<Export> &exports() const { return this->_exports; }
+
+      /// @brief Get the number of exports in the module.
+      ///
+      inline std::size_t size() const { return this->_exports.size(); }
+
+      /// @brief Estimate the number of bytes of memory held by this index.
+      ///
+      std::size_t memory_usage() const;
+
+      /// @brief Look up an export by *name*, returning null if the module doesn't export it.
+      ///
+      const Export *lookup(const std::string &name) const;
+
+      /// @brief Look up an export by biased *ordinal*, returning null if the module doesn't export it.
+      ///
+      const Export *lookup(std::uint32_t ordinal) const;
+
+      /// @brief Convert the given module *name* to the lowercase form used for module identity.
+      ///
+      static std::string NormalizeModule(const std::string &name);
+   };
+}
@@ -0,0 +1,51 @@
+//! @file forwarder.hpp
+//! @brief Allocation-free parsing of export forwarder strings and API set names.
+//!
+//! A forwarded export points at a string of the form "MODULE.Function" or "MODULE.#123" instead of
+//! code. System modules forward thousands of exports, so rather than splitting each string into new
+//! strings, the parsed forwarder holds views into the original one. Many forwarders also name an
+//! API set contract (e.g. "api-ms-win-core-synch-l1-2-0") rather than a real module, which can be
+//! mapped to its usual host module with a small built-in table.
+//!
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace yapp
+{
+   /// @brief A parsed forwarder string.
+   ///
+   /// The views point into the string that was parsed, which must outlive the forwarder.
+   ///
+   struct Forwarder
+   {
+      /// @brief The name of the target module, without an extension.
+      std::string_view module;
+      /// @brief The name of the target export, or empty if forwarded by ordinal.
+      std::string_view name;
+      /// @brief The ordinal of the target export, if forwarded by ordinal.
+      std::optional<std::uint32_t> ordinal;
+
+      inline bool is_ordinal() const { return this->ordinal.has_value(); }
+
+      /// @brief Parse the given forwarder *string*, returning nothing if it isn't a valid forwarder.
+      ///
+      /// The string is split at its last dot, since module names may contain dots but export names don't.
+      ///
+      static std::optional<Forwarder> Parse(std::string_view string) noexcept;
+   };
+
+   /// @brief Check whether the given *module* name is an API set contract (`api-ms-*` or `ext-ms-*`).
+   ///
+   bool IsApiSet(std::string_view module) noexcept;
+
+   /// @brief Map the given API set *module* name to the module which usually hosts it.
+   ///
+   /// The version suffix and any extension are ignored, and names are compared case-insensitively.
+   /// Names which aren't known API set contracts are returned unchanged.
+   ///
+   std::string_view NormalizeApiSet(std::string_view module) noexcept;
+}
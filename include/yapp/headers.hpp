@@ -1,10 +1,12 @@
 #pragma once
 
 #include <yapp/headers/raw.hpp>
+#include <yapp/headers/fields.hpp>
 #include <yapp/headers/dos.hpp>
 #include <yapp/headers/file.hpp>
 #include <yapp/headers/optional.hpp>
 #include <yapp/headers/nt.hpp>
 #include <yapp/headers/section.hpp>
+#include <yapp/headers/symbol.hpp>
 #include <yapp/headers/data_directory.hpp>
 #include <yapp/headers/directories.hpp>
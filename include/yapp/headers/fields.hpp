@@ -0,0 +1,560 @@
+//! @file fields.hpp
+//! @brief Compile-time descriptions of the fields of the raw header structures.
+//!
+//! Every structure in `raw.hpp` has a constexpr table describing its fields in declaration order: their
+//! names, offsets, sizes and kinds, with nested structures pointing at their own tables. Code which
+//! dumps, compares, hashes or serializes headers can walk a table instead of listing fields by hand, so
+//! a new consumer needs no per-structure code and every consumer agrees on the names:
+//!
+//! ```cpp
+//! Fields<raw::IMAGE_FILE_HEADER>::Dump(*pe.file_header(), std::cout);
+//!
+//! constexpr auto &machine = Fields<raw::IMAGE_FILE_HEADER>::Get("Machine");  // resolved at compile time
+//! auto hash = Fields<raw::IMAGE_SECTION_HEADER>::Hash(section);
+//! ```
+//!
+//! Fields::Visit expands over the table at compile time, so each field's offset and size are constants
+//! by the time the visitor sees them and nothing is looked up at runtime. Unions are described as the
+//! alternative the parser reads (`Misc` as `VirtualSize`, for example), and the variable-length tails
+//! of structures like IMAGE_IMPORT_BY_NAME are left out. Structures of your own can be described the
+//! same way by specializing FieldTable with the `YAPP_FIELD` macro.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/span.hpp>
+#include <yapp/headers/raw.hpp>
+
+/// @brief Describe the member *field* of the structure *type*, deducing its size and kind.
+#define YAPP_FIELD(type, field) ::yapp::headers::detail::describe<decltype(type::field)>(#field, offsetof(type, field))
+
+/// @brief Describe a field of the given *type* at a fixed *offset*, such as one alternative of a union.
+#define YAPP_FIELD_AT(name, offset, type) ::yapp::headers::detail::describe<type>(name, offset)
+
+namespace yapp
+{
+namespace headers
+{
+   /// @brief A description of one field of a raw structure.
+   ///
+   struct Field
+   {
+      enum Kind
+      {
+         /// @brief An unsigned little-endian integer, or an array of them.
+         INTEGER = 0,
+         /// @brief An array of bytes or characters, such as a section name.
+         BYTES,
+         /// @brief A nested structure, or an array of them, described by *members*.
+         STRUCTURE,
+      };
+
+      const char *name;
+      std::size_t offset;
+      /// @brief The size of the whole field in bytes, every element included.
+      std::size_t size;
+      Kind kind;
+      /// @brief The number of elements, which is 1 for anything that isn't an array.
+      std::size_t count;
+      const Field *fields;
+      std::size_t field_count;
+
+      constexpr std::size_t element_size() const { return this->size / this->count; }
+
+      /// @brief Get the fields of a nested structure, which is empty for other kinds.
+      ///
+      constexpr Span<const Field> members() const { return Span<const Field>(this->fields, this->field_count); }
+   };
+
+   /// @brief The field table of the raw structure *T*, as a constexpr array named *Fields*.
+   ///
+   template <typename T>
+   struct FieldTable;
+
+   namespace detail
+   {
+      constexpr bool
+      same_name
+      (const char *left, const char *right)
+      {
+         while (*left != 0 && *left == *right) { ++left; ++right; }
+
+         return *left == *right;
+      }
+
+      template <typename U>
+      constexpr Field
+      describe
+      (const char *name, std::size_t offset)
+      {
+         using Element = std::remove_all_extents_t<U>;
+         constexpr auto count = sizeof(U) / sizeof(Element);
+
+         if constexpr (std::is_class<Element>::value)
+            return Field{name, offset, sizeof(U), Field::STRUCTURE, count,
+                         FieldTable<Element>::Fields, std::size(FieldTable<Element>::Fields)};
+         else if constexpr (std::is_array<U>::value && sizeof(Element) == 1)
+            return Field{name, offset, sizeof(U), Field::BYTES, count, nullptr, 0};
+         else
+            return Field{name, offset, sizeof(U), Field::INTEGER, count, nullptr, 0};
+      }
+   }
+
+   template <>
+   struct FieldTable<raw::IMAGE_DOS_HEADER>
+   {
+      using T = raw::IMAGE_DOS_HEADER;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, e_magic), YAPP_FIELD(T, e_cblp), YAPP_FIELD(T, e_cp), YAPP_FIELD(T, e_crlc),
+         YAPP_FIELD(T, e_cparhdr), YAPP_FIELD(T, e_minalloc), YAPP_FIELD(T, e_maxalloc), YAPP_FIELD(T, e_ss),
+         YAPP_FIELD(T, e_sp), YAPP_FIELD(T, e_csum), YAPP_FIELD(T, e_ip), YAPP_FIELD(T, e_cs),
+         YAPP_FIELD(T, e_lfarlc), YAPP_FIELD(T, e_ovno), YAPP_FIELD(T, e_res), YAPP_FIELD(T, e_oemid),
+         YAPP_FIELD(T, e_oeminfo), YAPP_FIELD(T, e_res2), YAPP_FIELD(T, e_lfanew),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_FILE_HEADER>
+   {
+      using T = raw::IMAGE_FILE_HEADER;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Machine),
+         YAPP_FIELD(T, NumberOfSections),
+         YAPP_FIELD(T, TimeDateStamp),
+         YAPP_FIELD(T, PointerToSymbolTable),
+         YAPP_FIELD(T, NumberOfSymbols),
+         YAPP_FIELD(T, SizeOfOptionalHeader),
+         YAPP_FIELD(T, Characteristics),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_DATA_DIRECTORY>
+   {
+      using T = raw::IMAGE_DATA_DIRECTORY;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, VirtualAddress),
+         YAPP_FIELD(T, Size),
+      };
+   };
+
+   // both optional headers name the same fields, but BaseOfData only exists in the 32-bit header
+#define YAPP_OPTIONAL_STANDARD_FIELDS(T)                                                          \
+   YAPP_FIELD(T, Magic), YAPP_FIELD(T, MajorLinkerVersion), YAPP_FIELD(T, MinorLinkerVersion),    \
+   YAPP_FIELD(T, SizeOfCode), YAPP_FIELD(T, SizeOfInitializedData),                               \
+   YAPP_FIELD(T, SizeOfUninitializedData), YAPP_FIELD(T, AddressOfEntryPoint), YAPP_FIELD(T, BaseOfCode)
+
+#define YAPP_OPTIONAL_NT_FIELDS(T)                                                                \
+   YAPP_FIELD(T, ImageBase), YAPP_FIELD(T, SectionAlignment), YAPP_FIELD(T, FileAlignment),       \
+   YAPP_FIELD(T, MajorOperatingSystemVersion), YAPP_FIELD(T, MinorOperatingSystemVersion),        \
+   YAPP_FIELD(T, MajorImageVersion), YAPP_FIELD(T, MinorImageVersion),                            \
+   YAPP_FIELD(T, MajorSubsystemVersion), YAPP_FIELD(T, MinorSubsystemVersion),                    \
+   YAPP_FIELD(T, Win32VersionValue), YAPP_FIELD(T, SizeOfImage), YAPP_FIELD(T, SizeOfHeaders),    \
+   YAPP_FIELD(T, CheckSum), YAPP_FIELD(T, Subsystem), YAPP_FIELD(T, DllCharacteristics),          \
+   YAPP_FIELD(T, SizeOfStackReserve), YAPP_FIELD(T, SizeOfStackCommit),                           \
+   YAPP_FIELD(T, SizeOfHeapReserve), YAPP_FIELD(T, SizeOfHeapCommit), YAPP_FIELD(T, LoaderFlags), \
+   YAPP_FIELD(T, NumberOfRvaAndSizes), YAPP_FIELD(T, DataDirectory)
+
+   template <>
+   struct FieldTable<raw::IMAGE_OPTIONAL_HEADER32>
+   {
+      using T = raw::IMAGE_OPTIONAL_HEADER32;
+
+      static constexpr Field Fields[] = {
+         YAPP_OPTIONAL_STANDARD_FIELDS(T),
+         YAPP_FIELD(T, BaseOfData),
+         YAPP_OPTIONAL_NT_FIELDS(T),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_OPTIONAL_HEADER64>
+   {
+      using T = raw::IMAGE_OPTIONAL_HEADER64;
+
+      static constexpr Field Fields[] = {
+         YAPP_OPTIONAL_STANDARD_FIELDS(T),
+         YAPP_OPTIONAL_NT_FIELDS(T),
+      };
+   };
+
+#undef YAPP_OPTIONAL_NT_FIELDS
+#undef YAPP_OPTIONAL_STANDARD_FIELDS
+
+   template <>
+   struct FieldTable<raw::IMAGE_NT_HEADERS32>
+   {
+      using T = raw::IMAGE_NT_HEADERS32;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Signature),
+         YAPP_FIELD(T, FileHeader),
+         YAPP_FIELD(T, OptionalHeader),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_NT_HEADERS64>
+   {
+      using T = raw::IMAGE_NT_HEADERS64;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Signature),
+         YAPP_FIELD(T, FileHeader),
+         YAPP_FIELD(T, OptionalHeader),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_SECTION_HEADER>
+   {
+      using T = raw::IMAGE_SECTION_HEADER;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Name),
+         YAPP_FIELD_AT("VirtualSize", offsetof(T, Misc), std::uint32_t),
+         YAPP_FIELD(T, VirtualAddress),
+         YAPP_FIELD(T, SizeOfRawData),
+         YAPP_FIELD(T, PointerToRawData),
+         YAPP_FIELD(T, PointerToRelocations),
+         YAPP_FIELD(T, PointerToLinenumbers),
+         YAPP_FIELD(T, NumberOfRelocations),
+         YAPP_FIELD(T, NumberOfLinenumbers),
+         YAPP_FIELD(T, Characteristics),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_SYMBOL>
+   {
+      using T = raw::IMAGE_SYMBOL;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD_AT("ShortName", offsetof(T, N), std::uint8_t[8]),
+         YAPP_FIELD(T, Value),
+         YAPP_FIELD(T, SectionNumber),
+         YAPP_FIELD(T, Type),
+         YAPP_FIELD(T, StorageClass),
+         YAPP_FIELD(T, NumberOfAuxSymbols),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_RELOCATION>
+   {
+      using T = raw::IMAGE_RELOCATION;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, VirtualAddress),
+         YAPP_FIELD(T, SymbolTableIndex),
+         YAPP_FIELD(T, Type),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_ARCHIVE_MEMBER_HEADER>
+   {
+      using T = raw::IMAGE_ARCHIVE_MEMBER_HEADER;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Name),
+         YAPP_FIELD(T, Date),
+         YAPP_FIELD(T, UserID),
+         YAPP_FIELD(T, GroupID),
+         YAPP_FIELD(T, Mode),
+         YAPP_FIELD(T, Size),
+         YAPP_FIELD(T, EndHeader),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMPORT_OBJECT_HEADER>
+   {
+      using T = raw::IMPORT_OBJECT_HEADER;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Sig1),
+         YAPP_FIELD(T, Sig2),
+         YAPP_FIELD(T, Version),
+         YAPP_FIELD(T, Machine),
+         YAPP_FIELD(T, TimeDateStamp),
+         YAPP_FIELD(T, SizeOfData),
+         YAPP_FIELD_AT("Ordinal", offsetof(T, SizeOfData) + sizeof(std::uint32_t), std::uint16_t),
+         // the Type, NameType and Reserved bit fields, which have no offset of their own
+         YAPP_FIELD_AT("Types", offsetof(T, SizeOfData) + sizeof(std::uint32_t) + sizeof(std::uint16_t), std::uint16_t),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_EXPORT_DIRECTORY>
+   {
+      using T = raw::IMAGE_EXPORT_DIRECTORY;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Characteristics),
+         YAPP_FIELD(T, TimeDateStamp),
+         YAPP_FIELD(T, MajorVersion),
+         YAPP_FIELD(T, MinorVersion),
+         YAPP_FIELD(T, Name),
+         YAPP_FIELD(T, Base),
+         YAPP_FIELD(T, NumberOfFunctions),
+         YAPP_FIELD(T, NumberOfNames),
+         YAPP_FIELD(T, AddressOfFunctions),
+         YAPP_FIELD(T, AddressOfNames),
+         YAPP_FIELD(T, AddressOfNameOrdinals),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_IMPORT_DESCRIPTOR>
+   {
+      using T = raw::IMAGE_IMPORT_DESCRIPTOR;
+
+      // the leading union is unnamed under <windows.h>, so it's described by position
+      static constexpr Field Fields[] = {
+         YAPP_FIELD_AT("OriginalFirstThunk", 0, std::uint32_t),
+         YAPP_FIELD(T, TimeDateStamp),
+         YAPP_FIELD(T, ForwarderChain),
+         YAPP_FIELD(T, Name),
+         YAPP_FIELD(T, FirstThunk),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_IMPORT_BY_NAME>
+   {
+      using T = raw::IMAGE_IMPORT_BY_NAME;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Hint),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_BASE_RELOCATION>
+   {
+      using T = raw::IMAGE_BASE_RELOCATION;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, VirtualAddress),
+         YAPP_FIELD(T, SizeOfBlock),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_RESOURCE_DIRECTORY>
+   {
+      using T = raw::IMAGE_RESOURCE_DIRECTORY;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Characteristics),
+         YAPP_FIELD(T, TimeDateStamp),
+         YAPP_FIELD(T, MajorVersion),
+         YAPP_FIELD(T, MinorVersion),
+         YAPP_FIELD(T, NumberOfNamedEntries),
+         YAPP_FIELD(T, NumberOfIdEntries),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_RESOURCE_DIRECTORY_ENTRY>
+   {
+      // both members are unions, unnamed under <windows.h>
+      static constexpr Field Fields[] = {
+         YAPP_FIELD_AT("Name", 0, std::uint32_t),
+         YAPP_FIELD_AT("OffsetToData", sizeof(std::uint32_t), std::uint32_t),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_RESOURCE_DATA_ENTRY>
+   {
+      using T = raw::IMAGE_RESOURCE_DATA_ENTRY;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, OffsetToData),
+         YAPP_FIELD(T, Size),
+         YAPP_FIELD(T, CodePage),
+         YAPP_FIELD(T, Reserved),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_DEBUG_DIRECTORY>
+   {
+      using T = raw::IMAGE_DEBUG_DIRECTORY;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, Characteristics),
+         YAPP_FIELD(T, TimeDateStamp),
+         YAPP_FIELD(T, MajorVersion),
+         YAPP_FIELD(T, MinorVersion),
+         YAPP_FIELD(T, Type),
+         YAPP_FIELD(T, SizeOfData),
+         YAPP_FIELD(T, AddressOfRawData),
+         YAPP_FIELD(T, PointerToRawData),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_TLS_DIRECTORY32>
+   {
+      using T = raw::IMAGE_TLS_DIRECTORY32;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, StartAddressOfRawData),
+         YAPP_FIELD(T, EndAddressOfRawData),
+         YAPP_FIELD(T, AddressOfIndex),
+         YAPP_FIELD(T, AddressOfCallBacks),
+         YAPP_FIELD(T, SizeOfZeroFill),
+         YAPP_FIELD_AT("Characteristics", offsetof(T, SizeOfZeroFill) + sizeof(std::uint32_t), std::uint32_t),
+      };
+   };
+
+   template <>
+   struct FieldTable<raw::IMAGE_TLS_DIRECTORY64>
+   {
+      using T = raw::IMAGE_TLS_DIRECTORY64;
+
+      static constexpr Field Fields[] = {
+         YAPP_FIELD(T, StartAddressOfRawData),
+         YAPP_FIELD(T, EndAddressOfRawData),
+         YAPP_FIELD(T, AddressOfIndex),
+         YAPP_FIELD(T, AddressOfCallBacks),
+         YAPP_FIELD(T, SizeOfZeroFill),
+         YAPP_FIELD_AT("Characteristics", offsetof(T, SizeOfZeroFill) + sizeof(std::uint32_t), std::uint32_t),
+      };
+   };
+
+   /// @brief Read element *index* of an integer *field* from the structure at *data*.
+   ///
+   /// Raw structures are in host order, which the rest of the parser already assumes is little-endian.
+   ///
+   inline std::uint64_t
+   read_field
+   (const Field &field, const std::uint8_t *data, std::size_t index=0)
+   {
+      std::uint64_t value = 0;
+      std::memcpy(&value, data + field.offset + index * field.element_size(), field.element_size());
+
+      return value;
+   }
+
+   /// @brief Write the *fields* of the structure at *data* to *stream*, one per line, nesting structures
+   /// under their names.
+   ///
+   void dump_fields(Span<const Field> fields, const std::uint8_t *data, std::ostream &stream, std::size_t indent=0);
+
+   /// @brief Generic operations over the fields of the raw structure *T*.
+   ///
+   /// Padding between fields is never read, so structures which differ only in padding compare and hash
+   /// equal.
+   ///
+   template <typename T>
+   class Fields
+   {
+   public:
+      static constexpr std::size_t Count = std::size(FieldTable<T>::Fields);
+
+      /// @brief The field table of *T*, in declaration order.
+      ///
+      static constexpr Span<const Field> Table() { return Span<const Field>(FieldTable<T>::Fields); }
+
+      /// @brief Get the field of *T* with the given *name*.
+      ///
+      /// In a constant expression, a missing field is a compile error.
+      ///
+      /// @throw FieldNotFoundException
+      ///
+      static constexpr const Field &Get(const char *name) {
+         for (std::size_t i=0; i<Count; ++i)
+            if (detail::same_name(FieldTable<T>::Fields[i].name, name)) { return FieldTable<T>::Fields[i]; }
+
+         throw FieldNotFoundException(name);
+      }
+
+   protected:
+      template <typename Visitor, std::size_t... Index>
+      static void VisitEach(const std::uint8_t *data, Visitor &visitor, std::index_sequence<Index...>) {
+         (visitor(FieldTable<T>::Fields[Index], data), ...);
+      }
+
+   public:
+      /// @brief Call *visitor* with each field of *T* and the bytes of the given *structure*, as
+      /// `visitor(const Field &, const std::uint8_t *)`.
+      ///
+      /// The calls are expanded at compile time, one per field.
+      ///
+      template <typename Visitor>
+      static void Visit(const T &structure, Visitor &&visitor) {
+         Fields::VisitEach(reinterpret_cast<const std::uint8_t *>(&structure), visitor, std::make_index_sequence<Count>());
+      }
+
+      /// @brief Read element *index* of the integer field named *name* from the given *structure*.
+      ///
+      /// @throw FieldNotFoundException
+      ///
+      static std::uint64_t Read(const T &structure, const char *name, std::size_t index=0) {
+         return read_field(Fields::Get(name), reinterpret_cast<const std::uint8_t *>(&structure), index);
+      }
+
+      /// @brief Write every field of the given *structure* to *stream*, one per line.
+      ///
+      static void Dump(const T &structure, std::ostream &stream, std::size_t indent=0) {
+         dump_fields(Fields::Table(), reinterpret_cast<const std::uint8_t *>(&structure), stream, indent);
+      }
+
+      /// @brief Check whether every field of *left* equals the same field of *right*.
+      ///
+      static bool Equal(const T &left, const T &right) {
+         auto right_data = reinterpret_cast<const std::uint8_t *>(&right);
+         bool equal = true;
+
+         Fields::Visit(left, [&] (const Field &field, const std::uint8_t *data) {
+            equal = equal && std::memcmp(data + field.offset, right_data + field.offset, field.size) == 0;
+         });
+
+         return equal;
+      }
+
+      /// @brief Get the fields which differ between *left* and *right*.
+      ///
+      static std::vector<const Field *> Differences(const T &left, const T &right) {
+         auto right_data = reinterpret_cast<const std::uint8_t *>(&right);
+         auto result = std::vector<const Field *>();
+
+         Fields::Visit(left, [&] (const Field &field, const std::uint8_t *data) {
+            if (std::memcmp(data + field.offset, right_data + field.offset, field.size) != 0)
+               result.push_back(&field);
+         });
+
+         return result;
+      }
+
+      /// @brief Hash the fields of the given *structure* with 64-bit FNV-1a, continuing from *seed*.
+      ///
+      static std::uint64_t Hash(const T &structure, std::uint64_t seed=0xCBF29CE484222325ULL) {
+         auto hash = seed;
+
+         Fields::Visit(structure, [&] (const Field &field, const std::uint8_t *data) {
+            for (std::size_t i=0; i<field.size; ++i)
+               hash = (hash ^ data[field.offset + i]) * 0x100000001B3ULL;
+         });
+
+         return hash;
+      }
+   };
+}}
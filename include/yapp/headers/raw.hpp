@@ -161,6 +161,28 @@ namespace raw
 #undef IMAGE_REL_BASED_MACHINE_SPECIFIC_9  
 #undef IMAGE_REL_BASED_DIR64
 
+#undef IMAGE_SIZEOF_SYMBOL
+#undef IMAGE_SIZEOF_RELOCATION
+#undef IMAGE_SYM_UNDEFINED
+#undef IMAGE_SYM_ABSOLUTE
+#undef IMAGE_SYM_DEBUG
+#undef IMAGE_SYM_CLASS_EXTERNAL
+#undef IMAGE_SYM_CLASS_STATIC
+#undef IMAGE_SYM_CLASS_LABEL
+#undef IMAGE_SYM_CLASS_FUNCTION
+#undef IMAGE_SYM_CLASS_FILE
+#undef IMAGE_SYM_CLASS_SECTION
+#undef IMAGE_SYM_CLASS_WEAK_EXTERNAL
+
+#undef IMAGE_ARCHIVE_START_SIZE
+#undef IMAGE_ARCHIVE_START
+#undef IMAGE_ARCHIVE_END
+#undef IMAGE_ARCHIVE_PAD
+#undef IMAGE_ARCHIVE_LINKER_MEMBER
+#undef IMAGE_ARCHIVE_LONGNAMES_MEMBER
+#undef IMAGE_SIZEOF_ARCHIVE_MEMBER_HDR
+#undef IMPORT_OBJECT_HDR_SIG2
+
 #undef IMAGE_DEBUG_TYPE_UNKNOWN                
 #undef IMAGE_DEBUG_TYPE_COFF                   
 #undef IMAGE_DEBUG_TYPE_CODEVIEW               
@@ -207,6 +229,9 @@ namespace raw
 #undef IMAGE_DLLCHARACTERISTICS_WDM_DRIVER
 #undef IMAGE_DLLCHARACTERISTICS_GUARD_CF
 #undef IMAGE_DLLCHARACTERISTICS_TERMINAL_SERVER_AWARE
+
+#undef IMAGE_ORDINAL_FLAG32
+#undef IMAGE_ORDINAL_FLAG64
 #endif
 
    const std::uint16_t IMAGE_DOS_SIGNATURE =               0x5A4D;      // MZ
@@ -342,6 +367,41 @@ namespace raw
    const std::uint8_t IMAGE_REL_BASED_MACHINE_SPECIFIC_9 =  9;
    const std::uint8_t IMAGE_REL_BASED_DIR64 =               10;
 
+   const std::size_t IMAGE_SIZEOF_SYMBOL =                  18;
+   const std::size_t IMAGE_SIZEOF_RELOCATION =              10;
+
+   const std::int16_t IMAGE_SYM_UNDEFINED =                 0;   // Symbol is undefined or is common.
+   const std::int16_t IMAGE_SYM_ABSOLUTE =                  -1;  // Symbol is an absolute value.
+   const std::int16_t IMAGE_SYM_DEBUG =                     -2;  // Symbol is a special debug item.
+
+   const std::uint8_t IMAGE_SYM_CLASS_EXTERNAL =            2;
+   const std::uint8_t IMAGE_SYM_CLASS_STATIC =              3;
+   const std::uint8_t IMAGE_SYM_CLASS_LABEL =               6;
+   const std::uint8_t IMAGE_SYM_CLASS_FUNCTION =            101;
+   const std::uint8_t IMAGE_SYM_CLASS_FILE =                103;
+   const std::uint8_t IMAGE_SYM_CLASS_SECTION =             104;
+   const std::uint8_t IMAGE_SYM_CLASS_WEAK_EXTERNAL =       105;
+
+   const std::size_t IMAGE_ARCHIVE_START_SIZE =             8;
+   const char IMAGE_ARCHIVE_START[] =                       "!<arch>\n";
+   const char IMAGE_ARCHIVE_END[] =                         "`\n";
+   const char IMAGE_ARCHIVE_PAD[] =                         "\n";
+   const char IMAGE_ARCHIVE_LINKER_MEMBER[] =               "/               ";
+   const char IMAGE_ARCHIVE_LONGNAMES_MEMBER[] =            "//              ";
+   const std::size_t IMAGE_SIZEOF_ARCHIVE_MEMBER_HDR =      60;
+
+   const std::uint16_t IMPORT_OBJECT_HDR_SIG2 =             0xFFFF;
+
+   const std::uint16_t IMPORT_OBJECT_CODE =                 0;
+   const std::uint16_t IMPORT_OBJECT_DATA =                 1;
+   const std::uint16_t IMPORT_OBJECT_CONST =                2;
+
+   const std::uint16_t IMPORT_OBJECT_ORDINAL =              0;   // Import by ordinal
+   const std::uint16_t IMPORT_OBJECT_NAME =                 1;   // Import name == public symbol name.
+   const std::uint16_t IMPORT_OBJECT_NAME_NO_PREFIX =       2;   // Import name == public symbol name skipping leading ?, @, or optionally _.
+   const std::uint16_t IMPORT_OBJECT_NAME_UNDECORATE =      3;   // Import name == public symbol name skipping leading ?, @, or optionally _ and truncating at first @.
+   const std::uint16_t IMPORT_OBJECT_NAME_EXPORTAS =        4;   // Import name == a name is explicitly provided after the DLL name.
+
    const std::uint32_t IMAGE_DEBUG_TYPE_UNKNOWN =              0;
    const std::uint32_t IMAGE_DEBUG_TYPE_COFF =                 1;
    const std::uint32_t IMAGE_DEBUG_TYPE_CODEVIEW =             2;
@@ -389,6 +449,9 @@ namespace raw
    const std::uint16_t IMAGE_DLLCHARACTERISTICS_GUARD_CF =   0x4000;     // Image supports Control Flow Guard.
    const std::uint16_t IMAGE_DLLCHARACTERISTICS_TERMINAL_SERVER_AWARE =   0x8000;
 
+   const std::uint32_t IMAGE_ORDINAL_FLAG32 =               0x80000000;
+   const std::uint64_t IMAGE_ORDINAL_FLAG64 =               0x8000000000000000ULL;
+
    /* next, define the structures */
 
 #ifdef YAPP_WIN32
@@ -448,6 +511,10 @@ namespace raw
    #endif
    using IMAGE_NT_HEADERS = IMAGE_NT_HEADERS;
    using IMAGE_SECTION_HEADER = IMAGE_SECTION_HEADER;
+   using IMAGE_SYMBOL = IMAGE_SYMBOL;
+   using IMAGE_RELOCATION = IMAGE_RELOCATION;
+   using IMAGE_ARCHIVE_MEMBER_HEADER = IMAGE_ARCHIVE_MEMBER_HEADER;
+   using IMPORT_OBJECT_HEADER = IMPORT_OBJECT_HEADER;
    using IMAGE_EXPORT_DIRECTORY = IMAGE_EXPORT_DIRECTORY;
    using IMAGE_IMPORT_DESCRIPTOR = IMAGE_IMPORT_DESCRIPTOR;
    using IMAGE_IMPORT_BY_NAME = IMAGE_IMPORT_BY_NAME;
@@ -635,6 +702,60 @@ namespace raw
       std::uint32_t   Characteristics;
    };
 
+   /* the symbol table and relocations of object files are packed to 2 bytes, as in <winnt.h> */
+#pragma pack(push, 2)
+   struct IMAGE_SYMBOL {
+      union {
+         std::uint8_t ShortName[8];
+         struct {
+            std::uint32_t Short;     // if 0, use LongName
+            std::uint32_t Long;      // offset into string table
+         } Name;
+         std::uint32_t LongName[2];
+      } N;
+      std::uint32_t Value;
+      std::int16_t SectionNumber;
+      std::uint16_t Type;
+      std::uint8_t StorageClass;
+      std::uint8_t NumberOfAuxSymbols;
+   };
+
+   struct IMAGE_RELOCATION {
+      union {
+         std::uint32_t VirtualAddress;
+         std::uint32_t RelocCount;   // set to the real count when IMAGE_SCN_LNK_NRELOC_OVFL is set
+      };
+      std::uint32_t SymbolTableIndex;
+      std::uint16_t Type;
+   };
+#pragma pack(pop)
+
+   struct IMAGE_ARCHIVE_MEMBER_HEADER {
+      std::uint8_t Name[16];       // File member name - `/' terminated.
+      std::uint8_t Date[12];       // File member date - decimal.
+      std::uint8_t UserID[6];      // File member user id - decimal.
+      std::uint8_t GroupID[6];     // File member group id - decimal.
+      std::uint8_t Mode[8];        // File member mode - octal.
+      std::uint8_t Size[10];       // File member size - decimal.
+      std::uint8_t EndHeader[2];   // String to end header.
+   };
+
+   struct IMPORT_OBJECT_HEADER {
+      std::uint16_t Sig1;          // Must be IMAGE_FILE_MACHINE_UNKNOWN
+      std::uint16_t Sig2;          // Must be IMPORT_OBJECT_HDR_SIG2.
+      std::uint16_t Version;
+      std::uint16_t Machine;
+      std::uint32_t TimeDateStamp;
+      std::uint32_t SizeOfData;    // Size of data that follows the header
+      union {
+         std::uint16_t Ordinal;
+         std::uint16_t Hint;
+      };
+      std::uint16_t Type : 2;      // IMPORT_TYPE
+      std::uint16_t NameType : 3;  // IMPORT_NAME_TYPE
+      std::uint16_t Reserved : 11;
+   };
+
    struct IMAGE_EXPORT_DIRECTORY {
       std::uint32_t Characteristics;
       std::uint32_t TimeDateStamp;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+
+#include <yapp/memory.hpp>
+#include <yapp/headers/raw.hpp>
+
+namespace yapp
+{
+namespace headers
+{
+   /// @brief The IMAGE_SYMBOL wrapper class, one record of an object file's symbol table.
+   ///
+   class Symbol : public Memory<raw::IMAGE_SYMBOL>
+   {
+   public:
+      Symbol() : Memory() {}
+      Symbol(Memory::BaseType *pointer) : Memory(pointer) {}
+      Symbol(const Memory::BaseType *pointer) : Memory(pointer) {}
+
+      /// @brief Check whether the name lives in the string table rather than in the record itself.
+      ///
+      bool has_long_name() const { return (*this)->N.Name.Short == 0; }
+
+      /// @brief Get the string table offset of a long name.
+      ///
+      std::uint32_t name_offset() const { return (*this)->N.Name.Long; }
+
+      /// @brief Get the name stored in the record itself, which is empty for long names.
+      ///
+      std::string_view short_name() const {
+         auto name = reinterpret_cast<const char *>(&(*this)->N.ShortName[0]);
+         auto end = static_cast<const char *>(std::memchr(name, 0, 8));
+
+         return std::string_view(name, (end == nullptr) ? 8 : end - name);
+      }
+
+      bool is_external() const { return (*this)->StorageClass == raw::IMAGE_SYM_CLASS_EXTERNAL; }
+
+      /// @brief Check whether this symbol is an external the object references but doesn't define.
+      ///
+      bool is_undefined() const {
+         return this->is_external() && (*this)->SectionNumber == raw::IMAGE_SYM_UNDEFINED && (*this)->Value == 0;
+      }
+
+      /// @brief Check whether this symbol is a common block, whose *Value* is its size.
+      ///
+      bool is_common() const {
+         return this->is_external() && (*this)->SectionNumber == raw::IMAGE_SYM_UNDEFINED && (*this)->Value != 0;
+      }
+
+      std::size_t aux_count() const { return (*this)->NumberOfAuxSymbols; }
+   };
+
+   /// @brief An object file's symbol table, auxiliary records included.
+   ///
+   /// Auxiliary records follow the symbol they belong to and take up indexes of their own, which is
+   /// how relocations and the linker count them, so use *SymbolTable::next* to step between symbols.
+   ///
+   class SymbolTable : public Memory<raw::IMAGE_SYMBOL>
+   {
+   public:
+      SymbolTable() : Memory() {}
+      SymbolTable(Memory::BaseType *pointer, std::size_t size) : Memory(pointer, size) {}
+      SymbolTable(const Memory::BaseType *pointer, std::size_t size) : Memory(pointer, size) {}
+
+      Symbol operator[](std::size_t index) { return this->get_wrapped(index); }
+      const Symbol operator[](std::size_t index) const { return this->get_wrapped(index); }
+
+      Symbol get_wrapped(std::size_t index) { return &this->get(index); }
+      const Symbol get_wrapped(std::size_t index) const { return &this->get(index); }
+
+      /// @brief Get the index of the symbol after the one at *index*, skipping its auxiliary records.
+      ///
+      std::size_t next(std::size_t index) const { return index + 1 + this->get(index).NumberOfAuxSymbols; }
+   };
+}}
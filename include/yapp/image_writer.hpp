@@ -0,0 +1,98 @@
+//! @file image_writer.hpp
+//! @brief A scatter-list writer for emitting images from their existing buffers.
+//!
+//! Rebuilt and patched images are usually made of a handful of large ranges: headers, section data,
+//! an overlay, and a few small patches between them. Rather than assembling those ranges into one
+//! contiguous buffer before writing, the image writer records them as a list of segments pointing
+//! at the buffers they already live in. On POSIX systems, consecutive buffers are written with a
+//! single `writev` call, and ranges which are unchanged from a source file are copied in-kernel
+//! with `copy_file_range` where available.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+
+namespace yapp
+{
+   /// @brief Writes an image to disk from a list of buffer segments and source file ranges.
+   ///
+   /// Buffer segments are not copied, so the buffers they point to must outlive the writer.
+   ///
+   class ImageWriter
+   {
+   public:
+      /// @brief A segment of the output image.
+      ///
+      /// If *data* is null, the segment is the range at *source_offset* of the writer's source file.
+      ///
+      struct Segment
+      {
+         const std::uint8_t *data;
+         std::size_t source_offset;
+         std::size_t size;
+      };
+
+   protected:
+      std::optional<std::string> source;
+      std::vector<Segment> segments;
+      std::size_t _size;
+
+   public:
+      /// @brief Create a writer which only writes buffer segments.
+      ///
+      ImageWriter();
+
+      /// @brief Create a writer which can also copy ranges of the given *source* file.
+      ///
+      ImageWriter(const std::string &source);
+
+      /// @brief Get the total size of the output image.
+      ///
+      inline std::size_t size() const { return this->_size; }
+
+      /// @brief Get the number of segments in the scatter list.
+      ///
+      inline std::size_t segment_count() const { return this->segments.size(); }
+
+      /// @brief Get the scatter list.
+      ///
+      inline const std::vector<Segment> &segment_list() const { return this->segments; }
+
+      /// @brief Append *size* bytes at the given *pointer* to the output.
+      ///
+      /// A buffer immediately following the previous buffer segment in memory extends that segment.
+      ///
+      /// @throw NullPointerException
+      ///
+      void add(const std::uint8_t *pointer, std::size_t size);
+
+      /// @brief Append the given *memory* to the output.
+      ///
+      /// @throw NullPointerException
+      ///
+      void add(const Memory<std::uint8_t> &memory);
+
+      /// @brief Append the range of the source file at *offset* of *size* bytes to the output.
+      ///
+      /// A range immediately following the previous source range extends that segment.
+      ///
+      /// @throw NoSourceFileException
+      ///
+      void add_source(std::size_t offset, std::size_t size);
+
+      /// @brief Write the output image to the given *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void write(const std::string &filename) const;
+   };
+}
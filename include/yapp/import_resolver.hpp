@@ -0,0 +1,145 @@
+//! @file import_resolver.hpp
+//! @brief Resolution of a PE image's imports against a local set of modules.
+//!
+//! The import resolver binds every import of an image to the export it ends up at, the way the
+//! loader would: the imported module is found in a directory of modules, the import is looked up
+//! by name or ordinal, and forwarded exports are followed across modules until they reach code.
+//!
+//! Each module's exports are parsed once into an ExportIndex, held in an ExportIndexCache shared by
+//! every resolver in the process, and the final target of every import is cached, so resolving many
+//! samples against the same system modules mostly costs a few map lookups per import. A resolver can
+//! be shared between threads.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/export_cache.hpp>
+#include <yapp/export_index.hpp>
+
+namespace yapp
+{
+   class PE;
+
+   /// @brief A single import of an image, as written in its import directory.
+   ///
+   struct Import
+   {
+      /// @brief The name of the imported module, as written.
+      std::string module;
+      /// @brief The imported name, or empty if imported by ordinal.
+      std::string name;
+      /// @brief The imported ordinal, if imported by ordinal.
+      std::optional<std::uint32_t> ordinal;
+      /// @brief The RVA of the import's slot in the import address table.
+      std::uint32_t thunk;
+   };
+
+   /// @brief The export an import resolves to after following any forwarders.
+   ///
+   struct ResolvedImport
+   {
+      Import import;
+      bool resolved;
+      /// @brief The lowercase name of the module holding the final export.
+      std::string module;
+      /// @brief The name of the final export, or empty if it is only exported by ordinal.
+      std::string name;
+      std::uint32_t ordinal;
+      std::uint32_t rva;
+      /// @brief The number of forwarders followed to reach the final export.
+      std::size_t forwards;
+   };
+
+   /// @brief Resolved imports keyed by the RVA of their import address table slot.
+   ///
+   using BoundImportMap = std::map<std::uint32_t, ResolvedImport>;
+
+   /// @brief Resolves imports against the modules found in a directory.
+   ///
+   class ImportResolver
+   {
+   public:
+      /// @brief The longest chain of forwarders followed before giving up on an import.
+      ///
+      static const std::size_t MaxForwards = 32;
+
+   protected:
+      struct Target
+      {
+         bool resolved;
+         std::string module;
+         std::string name;
+         std::uint32_t ordinal;
+         std::uint32_t rva;
+         std::size_t forwards;
+      };
+
+      ExportIndexCache &cache;
+      std::map<std::string, std::string> modules;
+      std::map<std::string, std::shared_ptr<const ExportIndex>> indices;
+      std::map<std::string, Target> targets;
+      mutable std::mutex index_mutex;
+      mutable std::mutex target_mutex;
+
+      Target resolve_target(const std::string &module, const std::string &name, std::optional<std::uint32_t> ordinal);
+
+   public:
+      /// @brief Create a resolver over the modules in the given *directory*, sharing export indices
+      /// through the given *cache*.
+      ///
+      /// @throw OpenFileFailureException
+      ///
+      ImportResolver(const std::string &directory, ExportIndexCache &cache=ExportIndexCache::GetInstance());
+
+      /// @brief Get the number of modules available to the resolver.
+      ///
+      inline std::size_t module_count() const { return this->modules.size(); }
+
+      /// @brief Check whether the resolver has a module with the given *name*.
+      ///
+      /// A name without an extension is looked up as a DLL, the way forwarders name modules, and an API set
+      /// contract missing from the directory is looked up as the module hosting it.
+      ///
+      bool has_module(const std::string &name) const;
+
+      /// @brief Get the export index of the module with the given *name*, parsing it on first use.
+      ///
+      /// Returns null if the resolver has no such module.
+      ///
+      std::shared_ptr<const ExportIndex> export_index(const std::string &name);
+
+      /// @brief Resolve the given *name* imported from *module* to its final export.
+      ///
+      ResolvedImport resolve(const std::string &module, const std::string &name);
+
+      /// @brief Resolve the given *ordinal* imported from *module* to its final export.
+      ///
+      ResolvedImport resolve(const std::string &module, std::uint32_t ordinal);
+
+      /// @brief Resolve every import of the given *pe* image.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      BoundImportMap resolve(const PE &pe);
+
+      /// @brief Get the list of imports in the import directory of the given *pe* image.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      static std::vector<Import> ImportList(const PE &pe);
+   };
+}
@@ -0,0 +1,104 @@
+//! @file ingest.hpp
+//! @brief Asynchronous bulk ingestion of PE headers for corpus scanning.
+//!
+//! Loading whole files one at a time with blocking reads leaves cores idle waiting on the disk, and
+//! most scans only look at the headers anyway. The ingester keeps many files in flight at once: it
+//! submits a read of the first page of each file, parses the headers of whichever file completes
+//! first, and follows up with reads of just the ranges that file still needs -- the rest of the
+//! headers and section table, then any requested data directories. On Linux the reads go through
+//! io_uring, so one thread keeps the device queue full; elsewhere, or when io_uring is unavailable,
+//! a pool of threads issues `pread` calls instead; see ReadQueue.
+//!
+//! Each ingested image is a sparse copy of the file: the ranges which were read hold the file's data,
+//! and everything else up to the end of the last range is zero.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/pe.hpp>
+#include <yapp/read_queue.hpp>
+
+namespace yapp
+{
+   /// @brief Reads the headers of many files concurrently.
+   ///
+   class Ingest
+   {
+   public:
+      using Backend = ReadQueue::Backend;
+
+      /// @brief The size of the first read of each file, which usually covers every header.
+      ///
+      static const std::size_t HeaderReadSize = 0x1000;
+
+      /// @brief An ingested file.
+      ///
+      /// If the file couldn't be read or its headers are invalid, *error* holds the exception and *pe* is
+      /// empty.
+      ///
+      struct Image
+      {
+         std::string filename;
+         std::size_t file_size;
+         PE pe;
+         std::exception_ptr error;
+      };
+
+      using Callback = std::function<void(Image &)>;
+
+   protected:
+      std::size_t _depth;
+      std::size_t _threads;
+      Backend _backend;
+      std::set<std::size_t> directories;
+      std::size_t _reads;
+      std::size_t _bytes_read;
+
+   public:
+      /// @brief Create an ingester which keeps up to *depth* files in flight, using the given *backend*.
+      ///
+      /// The thread pool backend uses *threads* threads.
+      ///
+      /// @throw UnsupportedBackendException
+      ///
+      Ingest(std::size_t depth=64, Backend backend=Backend::AUTO, std::size_t threads=4);
+
+      /// @brief Get the backend in use; never AUTO.
+      ///
+      inline Backend backend() const { return this->_backend; }
+
+      /// @brief Also read the data directory with the given *index* of each image.
+      ///
+      /// Only the range named by the directory entry is read, not data the directory points to elsewhere.
+      ///
+      void add_directory(std::size_t index);
+
+      /// @brief Get the number of reads issued by the last run.
+      ///
+      inline std::size_t reads() const { return this->_reads; }
+
+      /// @brief Get the number of bytes read by the last run.
+      ///
+      inline std::size_t bytes_read() const { return this->_bytes_read; }
+
+      /// @brief Ingest the given *filenames*, handing each image to *callback* as it completes.
+      ///
+      /// Images arrive in completion order, not the order of *filenames*. The callback runs on the calling
+      /// thread, so a slow callback stalls further submissions.
+      ///
+      void run(const std::vector<std::string> &filenames, Callback callback);
+
+      /// @brief Check whether io_uring is available on this host.
+      ///
+      static bool HasIoUring();
+   };
+}
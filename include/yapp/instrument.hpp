@@ -0,0 +1,153 @@
+//! @file instrument.hpp
+//! @brief Counters on the library's hot paths, for attributing where parsing spends its time.
+//!
+//! When the library is built with `YAPP_INSTRUMENT` defined (the `YAPP_INSTRUMENT` CMake option), the
+//! hot paths count what they do: MemoryManager reference counting, address translations, bytes copied
+//! out of memory objects, exceptions constructed by type, and time spent in each data directory's
+//! parser. The counters are process-wide and can be read at any moment with Instrumentation::Take:
+//!
+//! ```cpp
+//! auto before = Instrumentation::Take();
+//! auto imports = ImportResolver::ImportList(pe);
+//! auto delta = Instrumentation::Take() - before;
+//!
+//! delta.counter(Instrumentation::ADDRESS_TRANSLATIONS);
+//! delta.directories[IMAGE_DIRECTORY_ENTRY_IMPORT].nanoseconds;
+//! ```
+//!
+//! Without `YAPP_INSTRUMENT`, the counting macros expand to nothing, so the hot paths are exactly as
+//! they would be without this header, and every snapshot is empty. The definition has to match across
+//! the library and everything including its headers.
+//!
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <typeinfo>
+
+#ifdef YAPP_INSTRUMENT
+#define YAPP_COUNT(counter) ::yapp::Instrumentation::Count(::yapp::Instrumentation::counter)
+#define YAPP_COUNT_BYTES(counter, bytes) ::yapp::Instrumentation::Count(::yapp::Instrumentation::counter, (bytes))
+#define YAPP_COUNT_EXCEPTION() ::yapp::Instrumentation::CountException(typeid(*this))
+#define YAPP_TIME_DIRECTORY(index) ::yapp::Instrumentation::Timer yapp_directory_timer(index)
+#else
+#define YAPP_COUNT(counter) ((void)0)
+#define YAPP_COUNT_BYTES(counter, bytes) ((void)0)
+#define YAPP_COUNT_EXCEPTION() ((void)0)
+#define YAPP_TIME_DIRECTORY(index) ((void)0)
+#endif
+
+namespace yapp
+{
+   /// @brief Process-wide counters of hot-path work.
+   ///
+   class Instrumentation
+   {
+   public:
+      enum Counter
+      {
+         MEMORY_REF = 0,
+         MEMORY_DEREF,
+         MEMORY_INVALIDATE,
+         /// @brief Conversions between offsets, RVAs and VAs.
+         ADDRESS_TRANSLATIONS,
+         /// @brief Bytes copied into vectors by Memory::read.
+         BYTES_READ,
+         /// @brief Bytes copied into vectors by Memory::to_vec.
+         BYTES_TO_VEC,
+         /// @brief Bytes copied from the old buffer by Memory::reallocate.
+         BYTES_REALLOCATED,
+         /// @brief Exceptions constructed, of any type.
+         EXCEPTIONS,
+         COUNTER_COUNT,
+      };
+
+      /// @brief One more than the highest data directory index.
+      ///
+      static const std::size_t DirectoryCount = 16;
+
+#ifdef YAPP_INSTRUMENT
+      static const bool Enabled = true;
+#else
+      static const bool Enabled = false;
+#endif
+
+      /// @brief The time spent parsing one kind of data directory.
+      ///
+      struct DirectoryTiming
+      {
+         std::uint64_t calls;
+         std::uint64_t nanoseconds;
+      };
+
+      /// @brief The counters at a moment in time.
+      ///
+      /// Snapshots subtract, so the work done by a stretch of code is the difference between the
+      /// snapshots taken around it.
+      ///
+      struct Snapshot
+      {
+         std::array<std::uint64_t, COUNTER_COUNT> counters;
+         /// @brief Exceptions constructed, keyed by the implementation's name for their type.
+         std::map<std::string, std::uint64_t> exceptions;
+         /// @brief Time per data directory parser, indexed by directory index.
+         std::array<DirectoryTiming, DirectoryCount> directories;
+
+         inline std::uint64_t counter(Counter counter) const { return this->counters[counter]; }
+
+         /// @brief Get the number of exceptions of type *T* constructed.
+         ///
+         template <typename T>
+         std::uint64_t exceptions_of() const {
+            auto iter = this->exceptions.find(typeid(T).name());
+            return (iter == this->exceptions.end()) ? 0 : iter->second;
+         }
+
+         Snapshot operator-(const Snapshot &other) const;
+      };
+
+      /// @brief Charges the time until it's destroyed to a data directory's parser.
+      ///
+      class Timer
+      {
+      protected:
+         std::size_t index;
+         std::chrono::steady_clock::time_point start;
+
+      public:
+         Timer(std::size_t index) : index(index), start(std::chrono::steady_clock::now()) {}
+         Timer(const Timer &) = delete;
+         ~Timer();
+      };
+
+   protected:
+      static std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> Counters;
+      static std::array<std::atomic<std::uint64_t>, DirectoryCount> DirectoryCalls;
+      static std::array<std::atomic<std::uint64_t>, DirectoryCount> DirectoryNanoseconds;
+
+   public:
+      /// @brief Add *amount* to the given *counter*.
+      ///
+      static inline void Count(Counter counter, std::uint64_t amount=1) {
+         Instrumentation::Counters[counter].fetch_add(amount, std::memory_order_relaxed);
+      }
+
+      /// @brief Count the construction of an exception of the given *type*.
+      ///
+      static void CountException(const std::type_info &type);
+
+      /// @brief Read every counter.
+      ///
+      static Snapshot Take();
+
+      /// @brief Zero every counter.
+      ///
+      static void Reset();
+   };
+}
@@ -0,0 +1,151 @@
+//! @file lib_archive.hpp
+//! @brief Reading static and import libraries, the `!<arch>` archives linkers take.
+//!
+//! A `.lib` file is an archive of COFF objects and short import headers, led by linker members which
+//! map every public symbol to the member defining it. *LibArchive* reads those maps into a sorted
+//! symbol index when it's opened, so resolving a symbol is a binary search rather than a scan of
+//! every member:
+//!
+//! ```cpp
+//! LibArchive library(std::string("kernel32.lib"));
+//!
+//! if (auto member = library.find_symbol("__imp_CreateFileW"))
+//! {
+//!    if (auto import = library.import_header(*member)) { std::cout << import->dll << std::endl; }
+//!    else { auto object = library.object(*member); }
+//! }
+//! ```
+//!
+//! The second linker member, which MSVC writes already sorted, is used when it's there. Otherwise the
+//! first linker member, the only one GNU-style archives have, is sorted once on open. Member names and
+//! the data of members are views into the archive, so nothing is copied out of it, and the archive is
+//! not copyable for that reason.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+#include <yapp/coff.hpp>
+
+namespace yapp
+{
+   /// @brief A static or import library.
+   ///
+   class LibArchive
+   {
+   public:
+      /// @brief A member of the archive, other than the linker and longnames members.
+      ///
+      struct Member
+      {
+         std::string_view name;
+         /// @brief The offset of the member's header in the archive.
+         std::size_t offset;
+         /// @brief The size of the member's data, which follows its header.
+         std::size_t size;
+      };
+
+      /// @brief The contents of a short import header, which stands in for the object an import
+      /// library would otherwise need for each function or variable it imports.
+      ///
+      struct Import
+      {
+         std::uint16_t machine;
+         /// @brief One of IMPORT_OBJECT_CODE, IMPORT_OBJECT_DATA or IMPORT_OBJECT_CONST.
+         std::uint16_t type;
+         /// @brief One of the IMPORT_OBJECT_ORDINAL or IMPORT_OBJECT_NAME values.
+         std::uint16_t name_type;
+         /// @brief The ordinal when importing by ordinal, otherwise a hint into the DLL's export names.
+         std::uint16_t ordinal_or_hint;
+         /// @brief The public symbol, without the `__imp_` prefix of its import address.
+         std::string_view symbol;
+         std::string_view dll;
+         /// @brief The name the DLL exports, as *name_type* derives it from *symbol*, which is empty when
+         /// importing by ordinal.
+         std::string_view export_name;
+
+         inline bool by_ordinal() const { return this->name_type == headers::raw::IMPORT_OBJECT_ORDINAL; }
+      };
+
+   protected:
+      struct Symbol
+      {
+         std::string_view name;
+         std::uint32_t member;
+      };
+
+      Memory<std::uint8_t> data;
+      std::string_view longnames;
+      std::vector<Member> _members;
+      /// @brief Every public symbol with the index of its member, sorted by name.
+      std::vector<Symbol> symbols;
+
+      void parse();
+      void read_first_linker_member(std::size_t offset, std::size_t size);
+      void read_second_linker_member(std::size_t offset, std::size_t size);
+      std::uint32_t member_at(std::size_t header_offset, std::size_t linker_offset) const;
+
+   public:
+      /// @brief Read the library from the file at *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw InvalidArchiveException
+      ///
+      LibArchive(const std::string &filename);
+
+      /// @brief Read the library held in *data*.
+      ///
+      /// @throw InvalidArchiveException
+      ///
+      LibArchive(const Memory<std::uint8_t> &data);
+
+      LibArchive(const LibArchive &) = delete;
+      LibArchive &operator=(const LibArchive &) = delete;
+
+      /// @brief Get the members in archive order.
+      ///
+      inline const std::vector<Member> &members() const { return this->_members; }
+
+      /// @brief Get the number of public symbols in the archive's symbol index.
+      ///
+      inline std::size_t symbol_count() const { return this->symbols.size(); }
+
+      /// @brief Find the member which defines the public symbol *name*.
+      ///
+      std::optional<Member> find_symbol(std::string_view name) const;
+
+      /// @brief Find the first member with the given *name*.
+      ///
+      std::optional<Member> find(std::string_view name) const;
+
+      /// @brief Get the data of *member*, as a view into the archive which a COFFObject or PE can parse.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      const Memory<std::uint8_t> member_data(const Member &member) const;
+
+      /// @brief Get the COFF object held by *member*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      COFFObject object(const Member &member) const;
+
+      /// @brief Check whether *member* is a short import header rather than an object.
+      ///
+      bool is_import(const Member &member) const;
+
+      /// @brief Decode the short import header held by *member*, if it is one.
+      ///
+      /// @throw InvalidArchiveException
+      ///
+      std::optional<Import> import_header(const Member &member) const;
+   };
+}
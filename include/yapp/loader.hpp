@@ -0,0 +1,126 @@
+//! @file loader.hpp
+//! @brief A simulation of the Windows loader, mapping a disk image into a flat buffer.
+//!
+//! Emulating a load on a host without the Windows loader means repeating its work by hand: the
+//! headers and sections are copied into a zeroed buffer of *SizeOfImage* bytes at their virtual
+//! addresses, base relocations are applied for the chosen base, the import address table is filled
+//! in from a set of modules, and the TLS callbacks and entry point are located. The loader keeps
+//! each of these as a separate stage which edits the mapped image in place, so a sandbox or unpacker
+//! can stop after any of them, e.g. mapping and relocating without binding.
+//!
+//! Both 32-bit and 64-bit images are supported. The mapped image is a memory image, so RVAs are
+//! offsets into it.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/pe.hpp>
+#include <yapp/import_resolver.hpp>
+
+namespace yapp
+{
+   /// @brief Maps a PE image into memory and runs the stages of a load over it.
+   ///
+   class Loader
+   {
+   public:
+      /// @brief The TLS directory of a mapped image, with addresses as VAs at the current base.
+      ///
+      struct TLS
+      {
+         std::uint64_t raw_data_start;
+         std::uint64_t raw_data_end;
+         std::uint64_t index_address;
+         std::uint64_t callback_table;
+         std::uint32_t zero_fill;
+         /// @brief The callbacks in the callback table, in the order the loader calls them.
+         std::vector<std::uint64_t> callbacks;
+      };
+
+      /// @brief The largest *SizeOfImage* mapped unless the caller allows more.
+      ///
+      static const std::size_t DefaultMaxImageSize = 0x10000000;
+
+   protected:
+      PE _image;
+
+   public:
+      /// @brief Map the given disk image *pe* into a new buffer of at most *max_size* bytes.
+      ///
+      /// @throw UnsupportedImageTypeException
+      /// @throw OversizedImageException
+      /// @throw OutOfBoundsException
+      ///
+      Loader(const PE &pe, std::size_t max_size=Loader::DefaultMaxImageSize);
+
+      /// @brief Get the mapped image.
+      ///
+      inline PE &image() { return this->_image; }
+
+      /// @brief Get the mapped image.
+      ///
+      inline const PE &image() const { return this->_image; }
+
+      /// @brief Get the base the mapped image is currently relocated for.
+      ///
+      inline std::uint64_t base() const { return this->_image.image_base(); }
+
+      /// @brief Apply the image's base relocations to move it to the given *base*, updating the
+      /// *ImageBase* in its optional header.
+      ///
+      /// Returns the number of fixups applied, which is zero if the image is already at *base*.
+      ///
+      /// @throw DirectoryUnavailableException if the image has to move but has no relocations.
+      /// @throw InvalidRelocationException
+      /// @throw OutOfBoundsException
+      ///
+      std::size_t relocate(std::uint64_t base);
+
+      /// @brief Resolve the image's imports with the given *resolver* and write their addresses into
+      /// its import address table, using *bases* to look up where each module is loaded.
+      ///
+      /// Module names in *bases* are matched the way the resolver matches them. The slots of imports
+      /// which don't resolve, or which resolve to a module missing from *bases*, are left untouched.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      BoundImportMap bind(ImportResolver &resolver, const std::map<std::string, std::uint64_t> &bases);
+
+      /// @brief Read the TLS directory of the mapped image, if it has one.
+      ///
+      /// @throw InvalidVAException
+      /// @throw OutOfBoundsException
+      ///
+      std::optional<TLS> tls() const;
+
+      /// @brief Get the VAs the loader would call into, in order: the TLS callbacks, then the entry
+      /// point if the image has one.
+      ///
+      /// @throw InvalidVAException
+      /// @throw OutOfBoundsException
+      ///
+      std::vector<std::uint64_t> entrypoints() const;
+
+      /// @brief Map the given disk image *pe* into a zeroed buffer of *SizeOfImage* bytes, copying its
+      /// headers and each section's raw data to their virtual addresses.
+      ///
+      /// *SizeOfImage* comes from the file, so a tiny file can ask for gigabytes. Images claiming more
+      /// than *max_size* bytes are refused before anything is allocated.
+      ///
+      /// @throw UnsupportedImageTypeException
+      /// @throw OversizedImageException
+      /// @throw OutOfBoundsException
+      ///
+      static PE Map(const PE &pe, std::size_t max_size=Loader::DefaultMaxImageSize);
+   };
+}
@@ -27,9 +27,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -37,25 +39,120 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include <yapp/exception.hpp>
+#include <yapp/span.hpp>
+#include <yapp/encoding.hpp>
 
 namespace yapp
 {
+   /// @brief Tracks every pointer/size pair held by a memory object, and which are views into which.
+   ///
+   /// An entry lives for as long as some memory object references its pair. A view taken from another
+   /// memory object is related to it, so that freeing a buffer invalidates every view into it. Related
+   /// entries are cleaned up as their views are released, and any relationship left behind by a view
+   /// which was never referenced is reclaimed automatically once enough of them accumulate, so the
+   /// manager's footprint stays proportional to the memory objects alive at any one time.
+   ///
    class MemoryManager
    {
+   public:
+      /// @brief A summary of what the manager is tracking.
+      ///
+      struct Statistics
+      {
+         /// @brief Pointer/size pairs currently referenced.
+         std::size_t live_entries;
+         /// @brief The most pointer/size pairs referenced at once.
+         std::size_t peak_live_entries;
+         /// @brief Views currently related to the memory they were taken from.
+         std::size_t relationships;
+         /// @brief Memory objects with views currently related to them.
+         std::size_t parents;
+         /// @brief Dead relationships removed by reclamation so far.
+         std::size_t reclaimed;
+      };
+
+      /// @brief The least number of relationships at which dead ones are reclaimed automatically.
+      ///
+      static constexpr std::size_t ReclaimThreshold = 4096;
+
    private:
       using KeyType = std::pair<const void *, std::size_t>;
       std::map<KeyType, std::size_t> refcount;
       std::map<KeyType, std::set<KeyType>> children;
       std::map<KeyType, KeyType> parents;
       std::mutex mutex;
+      std::size_t peak_live_entries;
+      std::size_t reclaimed;
+      std::size_t reclaim_at;
 
       static std::unique_ptr<MemoryManager> Instance;
       
-      MemoryManager() {}
+      MemoryManager() : peak_live_entries(0), reclaimed(0), reclaim_at(ReclaimThreshold) {}
+
+      /// Drop the relationship between *key* and its parent, if it has one. The mutex must be held.
+      void forget_parent(const KeyType &key) {
+         auto parent = this->parents.find(key);
+         if (parent == this->parents.end()) { return; }
+
+         auto siblings = this->children.find(parent->second);
+
+         if (siblings != this->children.end())
+         {
+            siblings->second.erase(key);
+            if (siblings->second.empty()) { this->children.erase(siblings); }
+         }
+
+         this->parents.erase(parent);
+      }
+
+      /// Remove every relationship whose view no longer has an entry. The mutex must be held.
+      std::size_t reclaim_unlocked() {
+         std::size_t removed = 0;
+
+         for (auto iter=this->parents.begin(); iter!=this->parents.end();)
+         {
+            if (this->refcount.find(iter->first) != this->refcount.end()) { ++iter; continue; }
+
+            auto siblings = this->children.find(iter->second);
+
+            if (siblings != this->children.end())
+            {
+               siblings->second.erase(iter->first);
+               if (siblings->second.empty()) { this->children.erase(siblings); }
+            }
+
+            iter = this->parents.erase(iter);
+            ++removed;
+         }
+
+         for (auto iter=this->children.begin(); iter!=this->children.end();)
+         {
+            auto &set = iter->second;
+
+            for (auto child=set.begin(); child!=set.end();)
+            {
+               if (this->refcount.find(*child) != this->refcount.end()) { ++child; continue; }
+
+               child = set.erase(child);
+               ++removed;
+            }
+
+            if (set.empty()) { iter = this->children.erase(iter); }
+            else { ++iter; }
+         }
+
+         this->reclaimed += removed;
+
+         // sweep again once the relationships have doubled, so reclamation stays amortized
+         this->reclaim_at = std::max(ReclaimThreshold, this->parents.size() * 2);
+
+         return removed;
+      }
       
    public:
       static MemoryManager &GetInstance() {
@@ -65,6 +162,27 @@ namespace yapp
          return *MemoryManager::Instance;
       }
 
+      /// @brief Get a summary of what the manager is tracking.
+      ///
+      Statistics statistics() {
+         std::lock_guard<std::mutex> lock(this->mutex);
+
+         return Statistics{this->refcount.size(),
+                           this->peak_live_entries,
+                           this->parents.size(),
+                           this->children.size(),
+                           this->reclaimed};
+      }
+
+      /// @brief Remove every relationship whose view is no longer referenced, returning how many were removed.
+      ///
+      /// This happens on its own as relationships accumulate; calling it directly just does it sooner.
+      ///
+      std::size_t reclaim() {
+         std::lock_guard<std::mutex> lock(this->mutex);
+         return this->reclaim_unlocked();
+      }
+
       bool is_valid(const void *ptr, std::size_t size) const {
          auto key = std::make_pair(ptr, size);
                                           
@@ -73,12 +191,15 @@ namespace yapp
 
       std::size_t ref(const void *ptr, std::size_t size)
       {
+         YAPP_COUNT(MEMORY_REF);
+
          auto key = std::make_pair(ptr, size);
          this->mutex.lock();
 
          if (this->refcount.find(key) == this->refcount.end())
          {
             this->refcount[key] = 0;
+            this->peak_live_entries = std::max(this->peak_live_entries, this->refcount.size());
          }
 
          ++this->refcount.at(key);
@@ -99,12 +220,15 @@ namespace yapp
 
       std::size_t deref(const void *ptr, std::size_t size)
       {
+         YAPP_COUNT(MEMORY_DEREF);
+
          auto key = std::make_pair(ptr, size);
          this->mutex.lock();
          
          auto iter = this->refcount.find(key);
 
-         if (iter == this->refcount.end()) {
+         // an entry nothing has referenced yet can't be released
+         if (iter == this->refcount.end() || iter->second == 0) {
             this->mutex.unlock();
             return 0;
          }
@@ -140,25 +264,36 @@ namespace yapp
 
          this->mutex.lock();
 
-         this->parents.insert(std::make_pair(child_key, parent_key));
-
-         if (this->children.find(parent_key) == this->children.end())
+         // the view is about to be referenced by its constructor; an unreferenced entry holds its place
+         // so the relationship isn't reclaimed in the meantime
+         if (this->refcount.find(child_key) == this->refcount.end())
          {
-            this->children.insert(std::make_pair(parent_key, std::set<KeyType>()));
+            this->refcount[child_key] = 0;
+            this->peak_live_entries = std::max(this->peak_live_entries, this->refcount.size());
          }
 
-         this->children.at(parent_key).insert(child_key);
+         auto existing = this->parents.insert(std::make_pair(child_key, parent_key));
+
+         // a view already related to other memory keeps that relationship
+         if (existing.second || existing.first->second == parent_key)
+            this->children[parent_key].insert(child_key);
+
+         if (this->parents.size() >= this->reclaim_at) { this->reclaim_unlocked(); }
 
          this->mutex.unlock();
       }
 
       void invalidate(const void *ptr, std::size_t size, bool derefed_parent=false) {
+         YAPP_COUNT(MEMORY_INVALIDATE);
+
          auto key = std::make_pair(ptr, size);
 
          this->mutex.lock();
 
          if (this->refcount.find(key) == this->refcount.end())
          {
+            // nothing references the pair, but a relationship may still have been left behind
+            this->forget_parent(key);
             this->mutex.unlock();
             return;
          }
@@ -168,10 +303,13 @@ namespace yapp
          if (this->parents.find(key) != this->parents.end())
          {
             auto parent_key = this->parents.at(key);
-            auto &children = this->children.at(parent_key);
+            auto siblings = this->children.find(parent_key);
 
-            if (children.find(key) != children.end())
-               children.erase(key);
+            if (siblings != this->children.end())
+            {
+               siblings->second.erase(key);
+               if (siblings->second.empty()) { this->children.erase(siblings); }
+            }
 
             if (!derefed_parent)
             {
@@ -230,56 +368,100 @@ namespace yapp
 
       static const bool variadic = TIsVariadic;
       
-      /// @brief A forward iterator for a memory object.
+      /// @brief A contiguous random-access iterator for a memory object.
+      ///
+      /// The iterators wrap a plain pointer, so algorithms get random access and, under C++20,
+      /// contiguous-memory optimizations. Algorithms which only specialize raw pointers can iterate
+      /// *Memory::span* instead.
       ///
       struct Iterator
       {
-         using iterator_category = std::forward_iterator_tag;
+         using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus >= 202002L
+         using iterator_concept = std::contiguous_iterator_tag;
+#endif
          using difference_type = std::ptrdiff_t;
-         using value_type = T;
+         using value_type = std::remove_cv_t<T>;
          using pointer = T*;
          using reference = T&;
 
+         Iterator() : ptr(nullptr) {}
          Iterator(T* ptr) : ptr(ptr) {}
 
          reference operator*() const { return *this->ptr; }
-         pointer operator->() { return this->ptr; }
+         pointer operator->() const { return this->ptr; }
+         reference operator[](difference_type offset) const { return this->ptr[offset]; }
 
          Iterator& operator++() { ++this->ptr; return *this; }
-         Iterator& operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+         Iterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+         Iterator& operator--() { --this->ptr; return *this; }
+         Iterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+         Iterator& operator+=(difference_type offset) { this->ptr += offset; return *this; }
+         Iterator& operator-=(difference_type offset) { this->ptr -= offset; return *this; }
+
+         friend Iterator operator+ (const Iterator& a, difference_type offset) { return Iterator(a.ptr + offset); }
+         friend Iterator operator+ (difference_type offset, const Iterator& a) { return Iterator(a.ptr + offset); }
+         friend Iterator operator- (const Iterator& a, difference_type offset) { return Iterator(a.ptr - offset); }
+         friend difference_type operator- (const Iterator& a, const Iterator& b) { return a.ptr - b.ptr; }
 
          friend bool operator== (const Iterator& a, const Iterator& b) { return a.ptr == b.ptr; }
          friend bool operator!= (const Iterator& a, const Iterator& b) { return a.ptr != b.ptr; }
+         friend bool operator< (const Iterator& a, const Iterator& b) { return a.ptr < b.ptr; }
+         friend bool operator> (const Iterator& a, const Iterator& b) { return a.ptr > b.ptr; }
+         friend bool operator<= (const Iterator& a, const Iterator& b) { return a.ptr <= b.ptr; }
+         friend bool operator>= (const Iterator& a, const Iterator& b) { return a.ptr >= b.ptr; }
 
       private:
          T* ptr;
       };
 
-      /// @brief A const forward iterator for a memory object.
+      /// @brief A const contiguous random-access iterator for a memory object.
       ///
       struct ConstIterator
       {
-         using iterator_category = std::forward_iterator_tag;
+         using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus >= 202002L
+         using iterator_concept = std::contiguous_iterator_tag;
+#endif
          using difference_type = std::ptrdiff_t;
-         using value_type = const T;
+         using value_type = std::remove_cv_t<T>;
          using pointer = const T*;
          using reference = const T&;
 
+         ConstIterator() : ptr(nullptr) {}
          ConstIterator(const T* ptr) : ptr(ptr) {}
+         ConstIterator(const Iterator& other) : ptr(other.operator->()) {}
 
-         reference operator*() { return *this->ptr; }
-         pointer operator->() { return this->ptr; }
+         reference operator*() const { return *this->ptr; }
+         pointer operator->() const { return this->ptr; }
+         reference operator[](difference_type offset) const { return this->ptr[offset]; }
 
          ConstIterator& operator++() { ++this->ptr; return *this; }
-         ConstIterator& operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+         ConstIterator operator++(int) { auto tmp = *this; ++(*this); return tmp; }
+         ConstIterator& operator--() { --this->ptr; return *this; }
+         ConstIterator operator--(int) { auto tmp = *this; --(*this); return tmp; }
+         ConstIterator& operator+=(difference_type offset) { this->ptr += offset; return *this; }
+         ConstIterator& operator-=(difference_type offset) { this->ptr -= offset; return *this; }
+
+         friend ConstIterator operator+ (const ConstIterator& a, difference_type offset) { return ConstIterator(a.ptr + offset); }
+         friend ConstIterator operator+ (difference_type offset, const ConstIterator& a) { return ConstIterator(a.ptr + offset); }
+         friend ConstIterator operator- (const ConstIterator& a, difference_type offset) { return ConstIterator(a.ptr - offset); }
+         friend difference_type operator- (const ConstIterator& a, const ConstIterator& b) { return a.ptr - b.ptr; }
 
          friend bool operator== (const ConstIterator& a, const ConstIterator& b) { return a.ptr == b.ptr; }
          friend bool operator!= (const ConstIterator& a, const ConstIterator& b) { return a.ptr != b.ptr; }
+         friend bool operator< (const ConstIterator& a, const ConstIterator& b) { return a.ptr < b.ptr; }
+         friend bool operator> (const ConstIterator& a, const ConstIterator& b) { return a.ptr > b.ptr; }
+         friend bool operator<= (const ConstIterator& a, const ConstIterator& b) { return a.ptr <= b.ptr; }
+         friend bool operator>= (const ConstIterator& a, const ConstIterator& b) { return a.ptr >= b.ptr; }
 
       private:
          const T* ptr;
       };
 
+      using ReverseIterator = std::reverse_iterator<Iterator>;
+      using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
    protected:
       Allocator allocator;
       
@@ -297,7 +479,7 @@ namespace yapp
       void throw_if_unallocated() const { if (this->pointer.c != nullptr && !this->allocated) { throw NotAllocatedException(); } }
       template <typename U>
       void throw_if_out_of_bounds(std::size_t offset, std::size_t size, bool size_in_bytes=false) const {
-         if (this->validate_range(offset, size, size_in_bytes)) { return; }
+         if (this->validate_range<U>(offset, size, size_in_bytes)) { return; }
 
          auto byte_size = size;
          if (!size_in_bytes) { byte_size *= sizeof(U); }
@@ -375,6 +557,26 @@ namespace yapp
          this->pointer.m = nullptr;
          this->load_data(data);
       }
+      /// @brief Construct a memory object viewing the elements of a *span*, without copying them.
+      ///
+      /// @throw NullPointerException
+      ///
+      explicit Memory(Span<T> span) : allocator(Allocator()), allocated(false) {
+         this->pointer.m = nullptr;
+         this->set_memory(span.data(), span.size());
+      }
+      /// @brief Construct a memory object viewing the elements of a const *span*, without copying them.
+      ///
+      /// ### Undefined behavior
+      ///
+      /// As with the const pointer constructor, only use this to create a `const Memory<T>` object.
+      ///
+      /// @throw NullPointerException
+      ///
+      explicit Memory(Span<const T> span) : allocator(Allocator()), allocated(false) {
+         this->pointer.m = nullptr;
+         this->set_memory(span.data(), span.size());
+      }
       /// @brief Construct a memory object with a given *size*, with the option to
       /// interpret the size in terms of bytes (*size_in_bytes*).
       ///
@@ -614,14 +816,43 @@ namespace yapp
 
          std::size_t byte_size = size;
          if (!size_in_bytes) { byte_size *= sizeof(T); }
-         
-         auto ptr_start = reinterpret_cast<std::uint8_t *>(this->pointer.m);
-         auto ptr_end = &ptr_start[this->_size];
-         auto data = std::vector<std::uint8_t>(ptr_start, ptr_end);
-         
-         this->deallocate();
-         this->allocate(byte_size, true, padding);
-         this->write<std::uint8_t>(0, data.data(), (byte_size < data.size()) ? byte_size : data.size(), true);
+         if (byte_size < sizeof(T)) { throw InsufficientAllocationException(byte_size, sizeof(T)); }
+
+         // allocate the new buffer before releasing the old one so the data is only copied once
+         auto new_ptr = this->allocator.allocate(byte_size);
+         if (new_ptr == nullptr) { throw BadAllocationException(); }
+
+         auto old_ptr = reinterpret_cast<std::uint8_t *>(this->pointer.m);
+         auto old_size = this->_size;
+         auto copy_size = (byte_size < old_size) ? byte_size : old_size;
+
+         std::memcpy(new_ptr, old_ptr, copy_size);
+         YAPP_COUNT_BYTES(BYTES_REALLOCATED, copy_size);
+
+         MemoryManager::GetInstance().invalidate(old_ptr, old_size);
+         this->allocator.deallocate(old_ptr, old_size);
+
+         this->pointer.m = reinterpret_cast<T*>(new_ptr);
+         this->_size = byte_size;
+
+         MemoryManager::GetInstance().ref(this->pointer.m, byte_size);
+
+         if (padding.has_value())
+         {
+            for (std::size_t i=copy_size/sizeof(T); i<this->elements(); ++i)
+               this->get(i) = *padding;
+         }
+      }
+
+      /// @brief Exchange the underlying memory of this object with the *other* memory object.
+      ///
+      /// No data is copied and the pointer/size pairs stay registered with the memory manager, so
+      /// views into either buffer remain valid for as long as the buffer they point into.
+      ///
+      void swap_memory(Memory &other) {
+         std::swap(this->pointer, other.pointer);
+         std::swap(this->_size, other._size);
+         std::swap(this->allocated, other.allocated);
       }
 
       /// @brief Get the element at the given *index* in the memory object.
@@ -696,7 +927,7 @@ namespace yapp
       ///
       inline bool is_allocated() { return this->allocated; }
 
-      /// @brief Get a forward iterator to the beginning of this memory.
+      /// @brief Get an iterator to the beginning of this memory.
       ///
       /// @throw NullPointerException
       ///
@@ -706,6 +937,8 @@ namespace yapp
          return Iterator(&this->ptr()[0]);
       }
 
+      inline ConstIterator begin() const { return this->cbegin(); }
+
       inline ConstIterator cbegin() const {
          if (this->ptr() == nullptr) { throw NullPointerException(); }
 
@@ -720,8 +953,42 @@ namespace yapp
       ///
       inline Iterator end() { return Iterator(this->eob()); }
 
+      inline ConstIterator end() const { return this->cend(); }
+
       inline ConstIterator cend() const { return ConstIterator(this->eob()); }
 
+      /// @brief Get a reverse iterator to the last element of this memory.
+      ///
+      /// @throw NullPointerException
+      ///
+      inline ReverseIterator rbegin() { return ReverseIterator(this->end()); }
+
+      inline ConstReverseIterator rbegin() const { return ConstReverseIterator(this->cend()); }
+
+      /// @brief Get the reverse end iterator of this memory.
+      ///
+      /// @throw NullPointerException
+      ///
+      inline ReverseIterator rend() { return ReverseIterator(this->begin()); }
+
+      inline ConstReverseIterator rend() const { return ConstReverseIterator(this->cbegin()); }
+
+      /// @brief Get a span over the elements of this memory, for algorithms and kernels which
+      /// work on raw pointers.
+      ///
+      /// The span doesn't keep the memory alive, so it's only valid for as long as this memory is.
+      /// A null memory gives an empty span.
+      ///
+      inline Span<T> span() { return Span<T>(this->ptr(), this->elements()); }
+
+      inline Span<const T> span() const { return Span<const T>(this->ptr(), this->elements()); }
+
+      /// @brief Get a span over the bytes of this memory.
+      ///
+      inline Span<const std::uint8_t> byte_span() const {
+         return Span<const std::uint8_t>(reinterpret_cast<const std::uint8_t *>(this->ptr()), this->_size);
+      }
+
       /// @brief Get the end pointer of this memory, or "end of buffer."
       ///
       /// To return the end iterator of the memory, see *Memory::end*.
@@ -768,6 +1035,14 @@ namespace yapp
          return this->pointer.c;
       }
 
+      /// @brief Get the base pointer of this memory, the same as *Memory::ptr*.
+      ///
+      /// With *Memory::size*, this lets memory objects convert to spans and work with `std::data`.
+      ///
+      inline T* data(void) { return this->ptr(); }
+
+      inline const T* data(void) const { return this->ptr(); }
+
       /// @brief Get the length of this memory region in terms of its base type.
       ///
       inline std::size_t size(void) const { return this->elements(); }
@@ -939,18 +1214,22 @@ namespace yapp
       std::vector<T> to_vec(void) const {
          if (this->ptr() == nullptr) { throw NullPointerException(); }
 
+         YAPP_COUNT_BYTES(BYTES_TO_VEC, this->_size);
+
          return std::vector<T>(this->ptr(), this->eob());
       }
 
       /// @brief Save this memory to disk.
       ///
-      /// @throw std::ios_base::failure
+      /// @throw OpenFileFailureException
       /// @throw NullPointerException
       ///
       void save(const std::string &filename) const {
          if (this->ptr() == nullptr) { throw NullPointerException(); }
          
-         std::ofstream fp(filename);
+         std::ofstream fp(filename, std::ios::binary);
+         if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
          auto bytes = reinterpret_cast<const char *>(this->ptr());
          fp.write(bytes, this->_size);
          fp.close();
@@ -1107,6 +1386,8 @@ namespace yapp
 
          if (cast_bytes > this_bytes) { throw OutOfBoundsException(cast_bytes / sizeof(T), this->elements()); }
 
+         YAPP_COUNT_BYTES(BYTES_READ, byte_size);
+
          return std::vector<U>(reinterpret_cast<const U*>(&this->ptr()[fixed_offset / sizeof(T)]),
                                reinterpret_cast<const U*>(&this->ptr()[cast_bytes / sizeof(T)]));
       }
@@ -2081,10 +2362,8 @@ namespace yapp
          filesize = fp.tellg();
          fp.seekg(0, std::ios::beg);
 
-         auto u8_data = std::vector<std::uint8_t>(filesize);
-         u8_data.insert(u8_data.begin(),
-                        std::istreambuf_iterator<char>(fp),
-                        std::istreambuf_iterator<char>());
+         auto u8_data = std::vector<std::uint8_t>(static_cast<std::size_t>(filesize));
+         fp.read(reinterpret_cast<char *>(u8_data.data()), u8_data.size());
 
          fp.close();
 
@@ -2270,15 +2549,20 @@ namespace yapp
          auto fixed_offset = offset;
          if (!offset_in_bytes) { fixed_offset *= this->element_size(); }
          
-         if (fixed_offset > this->_size) { return OutOfBoundsException(fixed_offset / this->element_size(), this->elements()); }
+         if (fixed_offset > this->_size) { throw OutOfBoundsException(fixed_offset / this->element_size(), this->elements()); }
 
          const auto reinterpretted = memory.reinterpret<T, TIsVariadic>();
-         auto split_point = this->split_at(offset);
-         auto split_data = split_point.second.to_vec();
+         auto insert_size = reinterpretted.byte_size();
+         auto tail_size = this->_size - fixed_offset;
+
+         // copy the inserted data out first in case it aliases this memory, which the reallocation invalidates
+         auto insert_data = reinterpretted.as_bytes();
 
-         this->reallocate(this->_size + reinterpretted.byte_size(), true);
-         this->write(fixed_offset, reinterpretted, true);
-         this->write(fixed_offset + reinterpretted.byte_size(), split_data.data(), split_data.size() * sizeof(T), true);
+         this->reallocate(this->_size + insert_size, true);
+
+         auto bytes = reinterpret_cast<std::uint8_t *>(this->ptr());
+         std::memmove(&bytes[fixed_offset + insert_size], &bytes[fixed_offset], tail_size);
+         std::memcpy(&bytes[fixed_offset], insert_data.data(), insert_size);
       }
 
       /// @brief Insert the given *memory* of the same type as the object at
@@ -2457,16 +2741,14 @@ namespace yapp
          
          if (fixed_end > this->_size) { throw OutOfBoundsException(fixed_end / this->element_size(), this->elements()); }
 
-         std::vector<T> end_data;
-         
-         if (fixed_end != this->_size)
-            end_data = this->subsection(fixed_end, this->_size-fixed_end, true).to_vec();
+         if (fixed_start > fixed_end) { throw OutOfBoundsException(fixed_start / this->element_size(), fixed_end / this->element_size()); }
 
-         auto size_delta = this->_size - (fixed_end - fixed_start);
-         this->reallocate(size_delta);
+         // shift the tail down over the erased range in place, then shrink the allocation
+         auto bytes = reinterpret_cast<std::uint8_t *>(this->ptr());
+         std::memmove(&bytes[fixed_start], &bytes[fixed_end], this->_size - fixed_end);
 
-         if (end_data.size() > 0)
-            this->write(fixed_start, end_data.data(), end_data.size() * this->element_size(), true);
+         auto size_delta = this->_size - (fixed_end - fixed_start);
+         this->reallocate(size_delta, true);
       }
       
       /// @brief Remove (or "erase") the element at the given *offset*, shrinking the backing vector
@@ -2536,18 +2818,20 @@ namespace yapp
          return split_memory;
       }
 
+      /// @brief Encode the bytes of this memory as hex, two digits per byte.
+      ///
+      /// To encode into a buffer of your own, see *Hex::Encode*.
+      ///
       std::string to_hex(bool uppercase=false) const {
-         std::stringstream stream;
-         stream << std::hex << std::setw(2) << std::setfill('0');
-
-         if (uppercase) { stream << std::uppercase; }
-
-         auto reinterpretted = this->reinterpret<std::uint8_t>();
-
-         for (auto byte : reinterpretted)
-            stream << reinterpret_cast<unsigned int>(byte);
+         return Hex::ToString(this->byte_span(), uppercase);
+      }
 
-         return stream.str();
+      /// @brief Encode the bytes of this memory as padded base64.
+      ///
+      /// To encode into a buffer of your own, see *Base64::Encode*.
+      ///
+      std::string to_base64() const {
+         return Base64::ToString(this->byte_span());
       }
    };
 }
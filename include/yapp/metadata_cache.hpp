@@ -0,0 +1,319 @@
+//! @file metadata_cache.hpp
+//! @brief A compact, memory-mappable cache of parsed PE metadata.
+//!
+//! Pipelines which rescan the same corpus spend most of their time re-parsing files they have
+//! already seen. The metadata cache stores what those pipelines look at -- header fields, data
+//! directories, the section table, import and export lists, a summary of the resource tree and
+//! content hashes -- in a flat binary record keyed by the SHA-256 of the file's contents. Records only
+//! contain offsets, never pointers, so a record mapped straight from disk is read in place: a
+//! MetadataView validates the record's bounds once and then hands out references into the mapping
+//! without copying or re-parsing anything.
+//!
+//! Records are written in host byte order; a record from a host of the other byte order fails the
+//! magic check and is rebuilt.
+//!
+//! Looking a record up by its content digest still means reading and hashing the whole file. Callers
+//! with a path can use MetadataCache::get with a filename instead: on POSIX systems the cache also
+//! keeps a small index from a file's device, inode, size and modification time to its digest, so a
+//! warm rerun over unchanged files reads only the cache. A file rewritten in place with the same size
+//! within one timestamp tick of its indexed version is indistinguishable to the index; callers who
+//! can't rule that out should look records up by image.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <yapp/digest.hpp>
+#include <yapp/exception.hpp>
+#include <yapp/headers/raw.hpp>
+
+namespace yapp
+{
+   class PE;
+
+/// @brief The on-disk layout of a metadata record.
+///
+/// A record is a Header followed by its tables and a string pool, each placed at an 8-byte aligned
+/// offset from the start of the record. Strings are referred to by their offset into the pool; offset
+/// zero is the empty string.
+///
+namespace metadata
+{
+   const char Magic[8] = {'Y','A','P','P','M','E','T','A'};
+   const std::uint32_t Version = 2;
+
+   /// @brief The location of a table within a record.
+   ///
+   struct Table
+   {
+      std::uint32_t offset;
+      std::uint32_t count;
+   };
+
+   struct Header
+   {
+      char magic[8];
+      std::uint32_t version;
+      /// @brief The size of the whole record, in bytes.
+      std::uint32_t size;
+      /// @brief The SHA-256 of the file.
+      Sha256::Digest digest;
+      std::uint64_t file_size;
+      std::uint64_t image_base;
+      std::uint16_t machine;
+      std::uint16_t characteristics;
+      std::uint16_t optional_magic;
+      std::uint16_t subsystem;
+      std::uint16_t dll_characteristics;
+      std::uint16_t reserved;
+      std::uint32_t timestamp;
+      std::uint32_t entrypoint;
+      std::uint32_t image_size;
+      std::uint32_t header_size;
+      std::uint32_t checksum;
+      std::uint32_t section_alignment;
+      std::uint32_t file_alignment;
+      std::uint32_t directory_count;
+      headers::raw::IMAGE_DATA_DIRECTORY directories[headers::raw::IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+      Table sections;
+      Table imports;
+      Table exports;
+      Table resources;
+      /// @brief The string pool, where *count* is its size in bytes.
+      Table strings;
+   };
+
+   struct Section
+   {
+      std::uint8_t name[8];
+      std::uint32_t virtual_address;
+      std::uint32_t virtual_size;
+      std::uint32_t raw_pointer;
+      std::uint32_t raw_size;
+      std::uint32_t characteristics;
+      std::uint32_t reserved;
+      /// @brief The 64-bit FNV-1a hash of the section's raw data.
+      std::uint64_t hash;
+   };
+
+   struct Import
+   {
+      std::uint32_t module;
+      /// @brief The imported name, or zero if imported by ordinal.
+      std::uint32_t name;
+      std::uint32_t ordinal;
+      std::uint32_t thunk;
+   };
+
+   struct Export
+   {
+      std::uint32_t ordinal;
+      std::uint32_t rva;
+      std::uint32_t name;
+      /// @brief The forwarder string, or zero if the export isn't forwarded.
+      std::uint32_t forwarder;
+   };
+
+   /// @brief A top-level entry of the resource directory, i.e. a resource type.
+   ///
+   struct Resource
+   {
+      /// @brief The integer type ID, or zero if the type is named.
+      std::uint32_t id;
+      /// @brief The number of resources of this type.
+      std::uint32_t count;
+   };
+}
+
+   /// @brief A read-only view of a metadata record.
+   ///
+   /// Views are cheap to copy; copies share the underlying buffer or mapping, which stays alive until the
+   /// last view over it is gone.
+   ///
+   class MetadataView
+   {
+   protected:
+      std::shared_ptr<const std::uint8_t> storage;
+      std::size_t _size;
+
+      void validate() const;
+
+      template <typename T>
+      const T *table(const metadata::Table &table) const {
+         return reinterpret_cast<const T *>(this->storage.get() + table.offset);
+      }
+
+   public:
+      /// @brief Create a view over the given serialized *record*.
+      ///
+      /// @throw InvalidMetadataException
+      ///
+      MetadataView(std::vector<std::uint8_t> record);
+
+      /// @brief Create a view over *size* bytes of *storage*, which the view keeps alive.
+      ///
+      /// @throw InvalidMetadataException
+      ///
+      MetadataView(std::shared_ptr<const std::uint8_t> storage, std::size_t size);
+
+      /// @brief Serialize the metadata of the given *pe* image into a new record.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      static MetadataView Build(const PE &pe);
+
+      /// @brief Serialize the metadata of the given *pe* image, whose SHA-256 the caller already has.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      ///
+      static MetadataView Build(const PE &pe, const Sha256::Digest &digest);
+
+      /// @brief Map the record in the given *filename* read-only.
+      ///
+      /// On POSIX systems the file is mapped with `mmap`, so only the pages which are read are loaded.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw InvalidMetadataException
+      ///
+      static MetadataView Load(const std::string &filename);
+
+      /// @brief Write the record to the given *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void save(const std::string &filename) const;
+
+      /// @brief Get a pointer to the serialized record.
+      ///
+      inline const std::uint8_t *ptr() const { return this->storage.get(); }
+
+      /// @brief Get the size of the serialized record.
+      ///
+      inline std::size_t size() const { return this->_size; }
+
+      inline const metadata::Header &header() const {
+         return *reinterpret_cast<const metadata::Header *>(this->storage.get());
+      }
+
+      inline const Sha256::Digest &digest() const { return this->header().digest; }
+
+      inline std::size_t section_count() const { return this->header().sections.count; }
+      inline const metadata::Section &section(std::size_t index) const {
+         if (index >= this->section_count()) { throw OutOfBoundsException(index, this->section_count()); }
+         return this->table<metadata::Section>(this->header().sections)[index];
+      }
+
+      inline std::size_t import_count() const { return this->header().imports.count; }
+      inline const metadata::Import &import(std::size_t index) const {
+         if (index >= this->import_count()) { throw OutOfBoundsException(index, this->import_count()); }
+         return this->table<metadata::Import>(this->header().imports)[index];
+      }
+
+      inline std::size_t export_count() const { return this->header().exports.count; }
+      inline const metadata::Export &export_entry(std::size_t index) const {
+         if (index >= this->export_count()) { throw OutOfBoundsException(index, this->export_count()); }
+         return this->table<metadata::Export>(this->header().exports)[index];
+      }
+
+      inline std::size_t resource_count() const { return this->header().resources.count; }
+      inline const metadata::Resource &resource(std::size_t index) const {
+         if (index >= this->resource_count()) { throw OutOfBoundsException(index, this->resource_count()); }
+         return this->table<metadata::Resource>(this->header().resources)[index];
+      }
+
+      /// @brief Get the string at the given *offset* in the string pool, without copying it.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      std::string_view string(std::uint32_t offset) const;
+
+      /// @brief Get the name of the given *section*, without trailing null bytes.
+      ///
+      std::string_view section_name(const metadata::Section &section) const;
+   };
+
+   /// @brief A directory of metadata records keyed by the SHA-256 of the files they describe.
+   ///
+   /// Records are written to a temporary file and renamed into place, so several processes can share a cache
+   /// directory. A cache can be shared between threads.
+   ///
+   class MetadataCache
+   {
+   protected:
+      std::string directory;
+      std::size_t _hits;
+      std::size_t _misses;
+      mutable std::mutex mutex;
+
+   public:
+      /// @brief Use the given *directory* as the cache, creating it if needed.
+      ///
+      /// @throw OpenFileFailureException
+      ///
+      MetadataCache(const std::string &directory);
+
+      /// @brief Get the path of the record for the given content *digest*.
+      ///
+      std::string path(const Sha256::Digest &digest) const;
+
+      /// @brief Get the number of lookups which found a cached record.
+      ///
+      std::size_t hits() const;
+
+      /// @brief Get the number of lookups which didn't find a cached record.
+      ///
+      std::size_t misses() const;
+
+      /// @brief Map the record of the file with the given content *digest* and *file_size*, returning nothing
+      /// if it isn't cached.
+      ///
+      /// A record which fails validation, e.g. a truncated write or an older version, or which describes a file
+      /// of another digest or size, is treated as missing.
+      ///
+      std::optional<MetadataView> find(const Sha256::Digest &digest, std::uint64_t file_size);
+
+      /// @brief Write the given *record* to the cache.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void store(const MetadataView &record);
+
+      /// @brief Get the record of the given *pe* image, building and storing it if it isn't cached.
+      ///
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      /// @throw WriteFailureException
+      ///
+      MetadataView get(const PE &pe);
+
+      /// @brief Get the record of the file at the given *filename*, building and storing it if it isn't cached.
+      ///
+      /// If the file's identity (device, inode, size and modification time) is in the index, the record is
+      /// mapped without opening the file at all. Otherwise the file is parsed and hashed, and its identity is
+      /// indexed once it has been checked not to have changed while being read. Without the index, e.g. on
+      /// Windows, this is the same as looking up the image.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw InvalidRVAException
+      /// @throw InvalidOffsetException
+      /// @throw OutOfBoundsException
+      /// @throw WriteFailureException
+      ///
+      MetadataView get(const std::string &filename);
+   };
+}
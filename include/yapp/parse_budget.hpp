@@ -0,0 +1,146 @@
+//! @file parse_budget.hpp
+//! @brief Deadlines and resource limits for parsing hostile files.
+//!
+//! A crafted file can send any walker into an enormous loop: an import table with millions of thunks,
+//! a relocation directory that spans the whole image, a string with no terminator in sight. A parse
+//! budget bounds that work. It carries a deadline, a limit on the bytes the walkers may touch, and a
+//! limit on the elements of each kind of structure, and the walkers check it cooperatively at every
+//! element they visit, throwing BudgetExceededException as soon as any limit is passed.
+//!
+//! A budget applies to the parsing done on the thread where it's installed with a Scope, so it reaches
+//! every walker without being threaded through each call:
+//!
+//! ```cpp
+//! auto budget = ParseBudget().timeout(std::chrono::milliseconds(50)).max_bytes(0x1000000);
+//! ParseBudget::Scope scope(budget);
+//!
+//! auto imports = ImportResolver::ImportList(pe);  // throws BudgetExceededException if over budget
+//! ```
+//!
+//! Parses interleaved by an AsyncParser share one thread, so they're budgeted per image instead, with
+//! LazyImage::set_budget.
+//!
+//! Walkers cover the import table, exports, base relocations, TLS callbacks, the resource summary of
+//! the metadata cache and the strings they read. The typed directory wrappers returned by
+//! DataDirectory::directory only bounds-check the directory and walk nothing, so they aren't charged.
+//!
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+
+namespace yapp
+{
+   /// @brief Limits on the work done parsing one file.
+   ///
+   /// A budget counts the work charged to it, so it belongs to one parse on one thread at a time.
+   ///
+   class ParseBudget
+   {
+   public:
+      using Clock = std::chrono::steady_clock;
+      using Structure = BudgetExceededException::Structure;
+
+      /// @brief How many elements pass between checks of the clock.
+      ///
+      static const std::size_t DeadlineInterval = 64;
+
+      /// @brief How many bytes of a string are scanned between charges.
+      ///
+      static const std::size_t StringChunk = 256;
+
+      /// @brief Installs a budget on the current thread for as long as the scope lives.
+      ///
+      /// Scopes nest; the innermost budget is the one charged.
+      ///
+      class Scope
+      {
+      protected:
+         ParseBudget *previous;
+
+      public:
+         Scope(ParseBudget &budget);
+         Scope(const Scope &) = delete;
+         ~Scope();
+      };
+
+   protected:
+      std::optional<Clock::time_point> _deadline;
+      std::optional<std::size_t> _max_bytes;
+      std::array<std::optional<std::size_t>, BudgetExceededException::STRUCTURE_COUNT> element_limits;
+      std::size_t _bytes_touched;
+      std::size_t _elements;
+
+   public:
+      /// @brief Create a budget with no limits.
+      ///
+      ParseBudget();
+
+      /// @brief Stop parsing at the given *deadline*.
+      ///
+      ParseBudget &deadline(Clock::time_point deadline);
+
+      /// @brief Stop parsing once *timeout* has passed from now.
+      ///
+      ParseBudget &timeout(Clock::duration timeout);
+
+      /// @brief Stop parsing once the walkers have touched more than *size* bytes.
+      ///
+      ParseBudget &max_bytes(std::size_t size);
+
+      /// @brief Stop any single walk of the given *structure* at *count* elements.
+      ///
+      /// For strings, the count is the length of a single string.
+      ///
+      ParseBudget &max_elements(Structure structure, std::size_t count);
+
+      /// @brief Limit every kind of structure to *count* elements.
+      ///
+      ParseBudget &max_elements(std::size_t count);
+
+      inline std::optional<Clock::time_point> deadline() const { return this->_deadline; }
+
+      /// @brief Get the number of bytes charged so far.
+      ///
+      inline std::size_t bytes_touched() const { return this->_bytes_touched; }
+
+      /// @brief Get the number of elements charged so far, across every structure.
+      ///
+      inline std::size_t elements() const { return this->_elements; }
+
+      /// @brief Charge a walk of *structure* for its element at *index*, which spans *bytes* bytes.
+      ///
+      /// @throw BudgetExceededException
+      ///
+      void charge(Structure structure, std::size_t index, std::size_t bytes);
+
+      /// @brief Get the budget installed on this thread, if any.
+      ///
+      static ParseBudget *Current();
+
+      /// @brief Charge the budget installed on this thread, if any; walkers call this for every element.
+      ///
+      /// @throw BudgetExceededException
+      ///
+      static void Step(Structure structure, std::size_t index, std::size_t bytes);
+
+      /// @brief Read the null-terminated string at *offset* into *memory*, charging the budget
+      /// installed on this thread for every chunk scanned.
+      ///
+      /// The string limit is checked while the terminator is still being looked for, so a string
+      /// without one is given up on at the limit rather than scanned to the end of *memory*.
+      ///
+      /// @throw BudgetExceededException
+      /// @throw OutOfBoundsException
+      ///
+      static std::string ReadString(const Memory<std::uint8_t> &memory, std::size_t offset);
+   };
+}
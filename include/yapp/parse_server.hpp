@@ -0,0 +1,170 @@
+//! @file parse_server.hpp
+//! @brief A long-running parse service over a local Unix domain socket.
+//!
+//! Starting a process per file pays for process startup, cold caches and export index loading on
+//! every sample. The parse server instead stays up and answers parse requests from a socket: a
+//! client sends a file path, or passes an open file descriptor, and gets back the file's metadata
+//! record, the same record MetadataView::Build produces for a batch scan. A fixed pool of workers
+//! serves requests, and the metadata cache and everything the process has already loaded stay
+//! warm between requests. A worker is handed one request at a time; connections waiting for their
+//! next request are watched with `poll` instead of holding a worker, so any number of persistent
+//! clients share the pool.
+//!
+//! The protocol is a fixed header followed by a payload, in host byte order:
+//!
+//! - request: `RequestHeader`, then a path of *size* bytes for `PARSE_PATH`, or nothing for
+//!   `PARSE_FD`, whose descriptor travels as `SCM_RIGHTS` ancillary data with the header.
+//! - response: `ResponseHeader`, then the record for `OK`, or an error message for `ERROR`.
+//!
+//! Only available on POSIX systems.
+//!
+
+#pragma once
+
+#include <yapp/platform.hpp>
+
+#ifndef YAPP_WIN32
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/metadata_cache.hpp>
+
+namespace yapp
+{
+namespace protocol
+{
+   const std::uint32_t RequestMagic = 0x51525059;   // "YPRQ"
+   const std::uint32_t ResponseMagic = 0x53525059;  // "YPRS"
+
+   /// @brief The longest path a request may carry.
+   ///
+   const std::uint32_t MaxPathSize = 4096;
+
+   enum RequestType
+   {
+      PARSE_PATH = 1,
+      PARSE_FD = 2,
+   };
+
+   enum Status
+   {
+      OK = 0,
+      ERROR = 1,
+   };
+
+   struct RequestHeader
+   {
+      std::uint32_t magic;
+      std::uint16_t type;
+      std::uint16_t reserved;
+      std::uint32_t size;
+   };
+
+   struct ResponseHeader
+   {
+      std::uint32_t magic;
+      std::uint32_t status;
+      std::uint32_t size;
+   };
+}
+
+   /// @brief Serves parse requests on a Unix domain socket.
+   ///
+   class ParseServer
+   {
+   protected:
+      std::string _path;
+      std::size_t _workers;
+      std::unique_ptr<MetadataCache> cache;
+      int listener;
+      std::atomic<bool> stopping;
+      std::atomic<std::size_t> _requests;
+      std::set<int> connections;
+      std::mutex connection_mutex;
+      int wakeup[2];
+
+      bool serve_request(int connection);
+      void close_connection(int connection);
+      MetadataView handle(const protocol::RequestHeader &header, const std::string &path, int fd);
+
+   public:
+      /// @brief Listen on the socket at the given *path*, replacing any stale socket file there.
+      ///
+      /// Requests are served by *workers* threads. If a *cache_directory* is given, records are also kept
+      /// in a MetadataCache there, so that repeated files are never parsed twice, even across restarts.
+      ///
+      /// Anyone who can connect can make the server open any path it can, and learn from the error
+      /// whether that path exists, so the socket file is given the permission bits *mode* before the
+      /// server listens. The default lets only the server's own user connect.
+      ///
+      /// @throw OpenFileFailureException
+      ///
+      ParseServer(const std::string &path, std::size_t workers=4, const std::string &cache_directory=std::string(),
+                  unsigned int mode=0600);
+      ~ParseServer();
+
+      inline const std::string &path() const { return this->_path; }
+
+      /// @brief Get the number of requests answered so far.
+      ///
+      inline std::size_t requests() const { return this->_requests; }
+
+      /// @brief Accept and serve connections until stop is called.
+      ///
+      /// A client which stalls partway through a request or response is disconnected after a few seconds,
+      /// so it can't hold a worker.
+      ///
+      void serve();
+
+      /// @brief Stop serving, closing the listening socket and every open connection.
+      ///
+      /// Safe to call from any thread.
+      ///
+      void stop();
+   };
+
+   /// @brief A connection to a parse server.
+   ///
+   class ParseClient
+   {
+   protected:
+      int connection;
+
+      MetadataView exchange(const protocol::RequestHeader &header, const std::string &path, int fd);
+
+   public:
+      /// @brief Connect to the server listening on the given socket *path*.
+      ///
+      /// @throw OpenFileFailureException
+      ///
+      ParseClient(const std::string &path);
+      ParseClient(const ParseClient &) = delete;
+      ~ParseClient();
+
+      /// @brief Ask the server to parse the file at the given *path*.
+      ///
+      /// @throw ParseRequestException
+      /// @throw ReadFailureException
+      /// @throw InvalidMetadataException
+      ///
+      MetadataView parse(const std::string &path);
+
+      /// @brief Ask the server to parse the file open as the given *fd*, which is passed to the server.
+      ///
+      /// @throw ParseRequestException
+      /// @throw ReadFailureException
+      /// @throw InvalidMetadataException
+      ///
+      MetadataView parse(int fd);
+   };
+}
+
+#endif
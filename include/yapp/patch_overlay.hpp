@@ -0,0 +1,179 @@
+//! @file patch_overlay.hpp
+//! @brief A copy-on-write overlay of byte patches on top of a read-only image.
+//!
+//! The overlay records writes as a sorted set of non-overlapping byte ranges keyed by offset. The
+//! base image is never modified, so loading a large image read-only and changing a handful of
+//! header fields or code bytes only costs the size of the patches. Reads are served through the
+//! overlay, and the patched image can be written out directly or emitted as a compact binary diff.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+
+namespace yapp
+{
+   /// @brief A set of byte patches layered over an unmodified base memory.
+   ///
+   /// The base memory is held as a non-owning view, so it must outlive the overlay. Patches cannot
+   /// change the size of the image; for edits which grow or shrink the image, see PieceTable.
+   ///
+   class PatchOverlay
+   {
+   public:
+      /// @brief The magic value at the start of a serialized diff ("YPAT").
+      ///
+      static const std::uint32_t DiffMagic = 0x54415059;
+
+   protected:
+      Memory<std::uint8_t> base;
+      std::map<std::size_t, std::vector<std::uint8_t>> patches;
+
+   public:
+      /// @brief Create an overlay over the given *base* memory.
+      ///
+      /// @throw NullPointerException
+      ///
+      PatchOverlay(const Memory<std::uint8_t> &base);
+
+      /// @brief Get the size of the patched image, which is always the size of the base.
+      ///
+      inline std::size_t size() const { return this->base.byte_size(); }
+
+      /// @brief Get the number of distinct patched ranges.
+      ///
+      inline std::size_t patch_count() const { return this->patches.size(); }
+
+      /// @brief Get the patched ranges, keyed by offset.
+      ///
+      inline const std::map<std::size_t, std::vector<std::uint8_t>> &patch_map() const { return this->patches; }
+
+      /// @brief Check whether the range starting at *offset* of *size* bytes overlaps a patch.
+      ///
+      bool is_patched(std::size_t offset, std::size_t size=1) const;
+
+      /// @brief Get the number of bytes covered by patches.
+      ///
+      std::size_t patched_bytes() const;
+
+      /// @brief Get the byte at the given *offset* as seen through the overlay.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      std::uint8_t get(std::size_t offset) const;
+
+      /// @brief Read *size* bytes at the given *offset* through the overlay into *buffer*.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw NullPointerException
+      ///
+      void read(std::size_t offset, std::uint8_t *buffer, std::size_t size) const;
+
+      /// @brief Read *size* bytes at the given *offset* through the overlay.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      std::vector<std::uint8_t> read(std::size_t offset, std::size_t size) const;
+
+      /// @brief Read a value of type *U* at the given *offset* through the overlay.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      template <typename U>
+      U read(std::size_t offset) const {
+         U value;
+         this->read(offset, reinterpret_cast<std::uint8_t *>(&value), sizeof(U));
+         return value;
+      }
+
+      /// @brief Patch *size* bytes from *pointer* at the given *offset*.
+      ///
+      /// Patches which overlap or touch existing patches are merged with them.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw NullPointerException
+      ///
+      void write(std::size_t offset, const std::uint8_t *pointer, std::size_t size);
+
+      /// @brief Patch the given *vector* of bytes at the given *offset*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void write(std::size_t offset, const std::vector<std::uint8_t> &vector);
+
+      /// @brief Patch the given *reference* of type *U* at the given *offset*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      template <typename U>
+      void write(std::size_t offset, const U &reference) {
+         this->write(offset, reinterpret_cast<const std::uint8_t *>(&reference), sizeof(U));
+      }
+
+      /// @brief Drop any patches overlapping the range starting at *offset* of *size* bytes,
+      /// restoring the base data for that range.
+      ///
+      void revert(std::size_t offset, std::size_t size);
+
+      /// @brief Drop every patch.
+      ///
+      inline void clear() { this->patches.clear(); }
+
+      /// @brief Apply the patches to the given *target* memory, which must be at least as large as the base.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw NullPointerException
+      ///
+      void apply(Memory<std::uint8_t> &target) const;
+
+      /// @brief Render the patched image into a newly allocated memory object.
+      ///
+      Memory<std::uint8_t> materialize() const;
+
+      /// @brief Write the patched image to the given *filename* without materializing it.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void save(const std::string &filename) const;
+
+      /// @brief Write the patched image to the given *filename*, copying the unpatched ranges from the
+      /// *source* file the base was loaded from rather than from memory.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void save(const std::string &filename, const std::string &source) const;
+
+      /// @brief Serialize the patches as a binary diff.
+      ///
+      /// The diff is the *DiffMagic* value and a patch count, followed by each patch as a 64-bit offset,
+      /// a 32-bit size and the patch bytes, all in host byte order, so a diff only loads on a host with the
+      /// byte order of the one which wrote it.
+      ///
+      std::vector<std::uint8_t> diff() const;
+
+      /// @brief Write the binary diff of the patches to the given *filename*.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      ///
+      void save_diff(const std::string &filename) const;
+
+      /// @brief Load the patches of a binary *diff* into this overlay.
+      ///
+      /// Every patch is checked before any is applied, so a diff which is malformed anywhere, or which patches
+      /// past the end of the image, changes nothing.
+      ///
+      /// @throw InvalidDiffException
+      ///
+      void load_diff(const Memory<std::uint8_t> &diff);
+   };
+}
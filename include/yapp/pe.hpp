@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <cstring>
+#include <optional>
 #include <string>
+#include <utility>
 
 #include <yapp/memory.hpp>
 #include <yapp/headers.hpp>
@@ -29,6 +31,11 @@ namespace yapp
          VIRTUAL = 2,
       };
 
+      /// @brief The most leading bytes HeaderExtent lets the headers claim, which leaves room for
+      /// over a thousand sections.
+      ///
+      static const std::size_t MaxHeaderExtent = 0x10000;
+
    protected:
       ImageType _image_type;
       
@@ -36,6 +43,8 @@ namespace yapp
       PE() : _image_type(ImageType::DISK), Memory() {}
       PE(std::string &filename, ImageType _image_type=ImageType::DISK) : _image_type(_image_type), Memory(filename) {}
       PE(const Memory &memory, ImageType _image_type=ImageType::DISK) : _image_type(_image_type), Memory(memory) {}
+      /// @brief Allocate an empty image of *size* bytes, e.g. to map a disk image into.
+      PE(std::size_t size, ImageType _image_type) : _image_type(_image_type), Memory(size, true) {}
       /* this constructor is intended for yanking PE images out of memory
       PE(void *image_base) : _image_type(ImageType::VIRTUAL), Memory() {
          this->parse_virtual(image_base);
@@ -186,20 +195,13 @@ namespace yapp
          for (std::size_t offset=0; offset<eof; offset += 4)
          {
             if (offset == checksum_offset) { continue; }
-            
-            std::vector<std::uint8_t> data;
-            auto left = eof-offset;
 
-            if (left >= 4) { data = this->read(offset, 4); }
-            else {
-               auto padding = 4 - left;
-               data = this->read(offset, left);
-               
-               for (std::size_t i=0; i<padding; ++i)
-                  data.push_back(0);
-            }
+            // copy straight out of the image rather than reading a vector per dword; a short final
+            // dword is padded with zeroes
+            std::uint32_t value = 0;
+            auto left = eof-offset;
 
-            auto value = *reinterpret_cast<std::uint32_t *>(data.data());
+            std::memcpy(&value, this->ptr() + offset, (left >= 4) ? 4 : left);
             checksum = (checksum & 0xFFFFFFFF) + value + (checksum >> 32);
 
             if (checksum > 0xFFFFFFFF)
@@ -304,7 +306,47 @@ namespace yapp
          return section_table[section_table.size()-1];
       }
 
-      // headers::SectionHeader append_section(headers::SectionHeader section) {
+      /// @brief Append a *section* with the given raw *data* to the image, growing the header space and
+      /// placing the data as needed. To add several sections at once, use SectionLayout directly.
+      ///
+      /// @throw UnsupportedImageTypeException
+      /// @throw SectionTableOverflowException
+      ///
+      headers::SectionHeader append_section(const headers::SectionHeader &section, const std::vector<std::uint8_t> &data);
+
+      /// @brief Get the number of leading bytes of a file needed to hold every header, given its first
+      /// *size* bytes at *data*.
+      ///
+      /// The answer grows as more of the headers become known, so ask again once that many bytes are
+      /// present; the headers are complete once the answer is no more than *size*.
+      ///
+      /// The extent is taken from *e_lfanew* and the file header, so it's checked against
+      /// MaxHeaderExtent before anyone buffers that much on the file's word.
+      ///
+      /// @throw InvalidDOSSignatureException
+      /// @throw OversizedHeadersException
+      ///
+      static std::size_t HeaderExtent(const std::uint8_t *data, std::size_t size);
+
+      /// @brief Read only the leading bytes of the file at *filename* which hold its headers.
+      ///
+      /// The result has the headers and section table but none of the sections, which is enough to
+      /// identify a module without paying to load the whole file.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw ReadFailureException
+      /// @throw InvalidDOSSignatureException
+      /// @throw OversizedHeadersException
+      ///
+      static PE LoadHeaders(const std::string &filename);
+
+      /// @brief Get the file range, as a start and end offset, of the data directory with the given *index*.
+      ///
+      /// Only the headers are consulted and the range isn't checked against the image's size, so this works
+      /// on an image holding just its headers, where rva_to_offset would reject section offsets. Returns
+      /// nothing if the directory is empty or isn't backed by file data.
+      ///
+      std::optional<std::pair<std::size_t, std::size_t>> directory_file_range(std::size_t index) const;
             
       bool validate_address(Offset offset) const {
          return *offset < this->size();
@@ -333,7 +375,7 @@ namespace yapp
             std::uint64_t image_size;
 
             if (nt_headers.is_32()) { image_size = nt_headers.get_32().optional_header()->SizeOfImage; }
-            else { image_size = nt_headers.get_32().optional_header()->SizeOfImage; }
+            else { image_size = nt_headers.get_64().optional_header()->SizeOfImage; }
 
             auto start = image_base;
             auto end = start + image_size;
@@ -408,6 +450,8 @@ namespace yapp
       }
 
       RVA offset_to_rva(Offset offset) const {
+         YAPP_COUNT(ADDRESS_TRANSLATIONS);
+
          if (!this->validate_address(offset)) { throw InvalidOffsetException(offset); }
 
          auto section_table = this->section_table();
@@ -442,6 +486,8 @@ namespace yapp
       }
 
       Offset rva_to_offset(RVA rva) const {
+         YAPP_COUNT(ADDRESS_TRANSLATIONS);
+
          if (!this->validate_address(rva))
          {
             throw InvalidRVAException(rva);
@@ -471,6 +517,8 @@ namespace yapp
       }
 
       VA rva_to_va(RVA rva) const {
+         YAPP_COUNT(ADDRESS_TRANSLATIONS);
+
          if (!this->validate_address(rva))
             throw InvalidRVAException(rva);
 
@@ -494,6 +542,8 @@ namespace yapp
       }
 
       RVA va_to_rva(VA va) const {
+         YAPP_COUNT(ADDRESS_TRANSLATIONS);
+
          if (!validate_address(va))
             throw InvalidVAException(va);
 
@@ -540,7 +590,7 @@ namespace yapp
          while (end+1 <= this->size() && this->get(end) != 0)
             ++end;
 
-         return this->subsection<char>(begin, end+1);
+         return this->subsection<char>(begin, end+1-begin);
       }
 
       const Memory<char> cstring_at(std::size_t memory_offset) const {
@@ -550,7 +600,7 @@ namespace yapp
          while (end+1 <= this->size() && this->get(end) != 0)
             ++end;
 
-         return this->subsection<char>(begin, end+1);
+         return this->subsection<char>(begin, end+1-begin);
       }
       
       Memory<std::uint16_t> wstring_at(std::size_t memory_offset) {
@@ -559,7 +609,7 @@ namespace yapp
 
          while (end+2 <= this->size() && this->cast_ref<std::uint16_t>(end) != 0) { end += 2; }
 
-         return this->subsection<std::uint16_t>(begin, end+2, true);
+         return this->subsection<std::uint16_t>(begin, end+2-begin, true);
       }
 
       const Memory<std::uint16_t> wstring_at(std::size_t memory_offset) const {
@@ -569,7 +619,7 @@ namespace yapp
          while (end+2 <= this->size() && this->cast_ref<std::uint16_t>(end) != 0)
             end += 2;
 
-         return this->subsection<std::uint16_t>(begin, end+2, true);
+         return this->subsection<std::uint16_t>(begin, end+2-begin, true);
       }
    };
 }
@@ -0,0 +1,198 @@
+//! @file piece_table.hpp
+//! @brief An editable view over a read-only byte buffer, implemented as a piece table.
+//!
+//! A piece table never modifies the *original* buffer it is constructed over. Instead, every
+//! edit is recorded as a list of *pieces*, each of which points either into the original buffer
+//! or into an append-only *added* buffer holding every byte that was ever inserted. Inserting,
+//! erasing or overwriting data only splits the pieces surrounding the edit and appends the new
+//! bytes to the added buffer, so the cost of an edit is proportional to the size of the edit
+//! (plus the number of pieces), not the size of the image.
+//!
+//! When editing is finished, the pieces can either be *materialized* into a new Memory object
+//! or streamed to disk in order with *PieceTable::save*.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+
+namespace yapp
+{
+   /// @brief An editable byte buffer layered over an unmodified original buffer.
+   ///
+   /// The original buffer is held as a non-owning view, so it must outlive the piece table. If the
+   /// original buffer is deallocated, accessing the piece table throws an InvalidPointerException.
+   ///
+   class PieceTable
+   {
+   public:
+      /// @brief Which buffer a given piece refers to.
+      ///
+      enum Source
+      {
+         ORIGINAL = 0,
+         ADDED = 1,
+      };
+
+      /// @brief A contiguous run of bytes from either the original or the added buffer.
+      ///
+      struct Piece
+      {
+         Source source;
+         std::size_t offset;
+         std::size_t size;
+      };
+
+   protected:
+      Memory<std::uint8_t> original;
+      std::vector<std::uint8_t> added;
+      std::vector<Piece> pieces;
+      std::size_t _size;
+
+      /// @brief Get a pointer to the data backing the given *piece*.
+      ///
+      const std::uint8_t *piece_data(const Piece &piece) const;
+
+      /// @brief Find the index of the piece containing the given *offset*, storing the
+      /// offset of that piece's first byte in *piece_start*.
+      ///
+      /// If the offset is the end of the buffer, the number of pieces is returned.
+      ///
+      std::size_t find_piece(std::size_t offset, std::size_t &piece_start) const;
+
+      /// @brief Split the piece containing *offset* so that a piece boundary lands on it,
+      /// returning the index of the piece which begins at *offset*.
+      ///
+      std::size_t split(std::size_t offset);
+
+   public:
+      /// @brief Create an empty piece table.
+      ///
+      PieceTable();
+      /// @brief Create a piece table over the given *original* memory.
+      ///
+      /// @throw NullPointerException
+      ///
+      PieceTable(const Memory<std::uint8_t> &original);
+
+      /// @brief Get the current size, in bytes, of the edited buffer.
+      ///
+      inline std::size_t size() const { return this->_size; }
+
+      /// @brief Get the number of pieces currently describing the buffer.
+      ///
+      inline std::size_t piece_count() const { return this->pieces.size(); }
+
+      /// @brief Get the pieces currently describing the buffer, in order.
+      ///
+      inline const std::vector<Piece> &piece_list() const { return this->pieces; }
+
+      /// @brief Check whether any edits have been made to the original buffer.
+      ///
+      bool is_modified() const;
+
+      /// @brief Get the byte at the given *offset* of the edited buffer.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw InvalidPointerException
+      ///
+      std::uint8_t get(std::size_t offset) const;
+
+      /// @brief Read *size* bytes from the given *offset* of the edited buffer into *buffer*.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw InvalidPointerException
+      ///
+      void read(std::size_t offset, std::uint8_t *buffer, std::size_t size) const;
+
+      /// @brief Read *size* bytes from the given *offset* of the edited buffer.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw InvalidPointerException
+      ///
+      std::vector<std::uint8_t> read(std::size_t offset, std::size_t size) const;
+
+      /// @brief Insert the given *pointer* of *size* bytes at the given *offset*.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw NullPointerException
+      ///
+      void insert(std::size_t offset, const std::uint8_t *pointer, std::size_t size);
+
+      /// @brief Insert the given *vector* of bytes at the given *offset*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void insert(std::size_t offset, const std::vector<std::uint8_t> &vector);
+
+      /// @brief Insert the given *memory* of type *U* at the given *offset*.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw NullPointerException
+      ///
+      template <typename U, bool UIsVariadic=false>
+      void insert(std::size_t offset, const Memory<U, UIsVariadic> &memory) {
+         this->insert(offset, reinterpret_cast<const std::uint8_t *>(memory.ptr()), memory.byte_size());
+      }
+
+      /// @brief Append the given *pointer* of *size* bytes to the end of the buffer.
+      ///
+      /// @throw NullPointerException
+      ///
+      void append(const std::uint8_t *pointer, std::size_t size);
+
+      /// @brief Append the given *vector* of bytes to the end of the buffer.
+      ///
+      void append(const std::vector<std::uint8_t> &vector);
+
+      /// @brief Remove the bytes in the range of *start* to *end*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void erase(std::size_t start, std::size_t end);
+
+      /// @brief Overwrite the bytes at the given *offset* with the given *pointer* of *size* bytes.
+      ///
+      /// The write may not extend past the end of the buffer; use *PieceTable::append* to grow it.
+      ///
+      /// @throw OutOfBoundsException
+      /// @throw NullPointerException
+      ///
+      void write(std::size_t offset, const std::uint8_t *pointer, std::size_t size);
+
+      /// @brief Overwrite the bytes at the given *offset* with the given *vector*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void write(std::size_t offset, const std::vector<std::uint8_t> &vector);
+
+      /// @brief Overwrite the bytes at the given *offset* with the given *reference* of type *U*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      template <typename U>
+      void write(std::size_t offset, const U &reference) {
+         this->write(offset, reinterpret_cast<const std::uint8_t *>(&reference), sizeof(U));
+      }
+
+      /// @brief Render the edited buffer into a newly allocated memory object.
+      ///
+      /// @throw InvalidPointerException
+      ///
+      Memory<std::uint8_t> materialize() const;
+
+      /// @brief Stream the edited buffer to the given *filename*, writing the pieces as one scatter list.
+      ///
+      /// @throw OpenFileFailureException
+      /// @throw WriteFailureException
+      /// @throw InvalidPointerException
+      ///
+      void save(const std::string &filename) const;
+   };
+}
@@ -11,3 +11,11 @@
 #if defined(_M_AMD64) || defined(__x86_64__)
 #define YAPP_64BIT
 #endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YAPP_SSE2
+#endif
+
+#if defined(__SSSE3__) || (defined(_MSC_VER) && defined(__AVX__))
+#define YAPP_SSSE3
+#endif
@@ -0,0 +1,112 @@
+//! @file read_queue.hpp
+//! @brief Asynchronous positional reads of many files from a single thread.
+//!
+//! A read queue takes reads of file ranges, hands them to the operating system, and returns them as
+//! they complete, so one thread can keep many reads in flight. On Linux the reads go through io_uring
+//! when the kernel allows it; otherwise a pool of threads issues `pread` calls.
+//!
+//! Both Ingest and AsyncParser drive their I/O through a read queue.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <yapp/platform.hpp>
+#include <yapp/exception.hpp>
+
+#ifndef YAPP_WIN32
+#include <sys/uio.h>
+#endif
+
+namespace yapp
+{
+   /// @brief A read of part of a file into a buffer.
+   ///
+   struct FileRead
+   {
+#ifdef YAPP_WIN32
+      std::string filename;
+#else
+      int fd;
+#endif
+      std::uint8_t *buffer;
+      std::size_t offset;
+      std::size_t size;
+      /// @brief Once complete, the number of bytes read, or a negated errno.
+      std::ptrdiff_t result;
+      /// @brief Left alone by the queue, for the submitter to find its own state by.
+      void *context;
+#ifndef YAPP_WIN32
+      /// @brief Used by the queue while the read is in flight.
+      struct iovec iov;
+#endif
+   };
+
+   /// @brief Hands reads to the operating system and returns them as they complete.
+   ///
+   /// A queue is driven from one thread; submitted reads must stay alive until they're returned by wait.
+   ///
+   class ReadQueue
+   {
+   public:
+      enum Backend
+      {
+         /// @brief Use io_uring if the kernel supports it, and the thread pool otherwise.
+         AUTO = 0,
+         IO_URING = 1,
+         THREAD_POOL = 2,
+      };
+
+      virtual ~ReadQueue() {}
+
+      /// @brief Get the backend in use; never AUTO.
+      ///
+      virtual Backend backend() const = 0;
+
+      /// @brief Get the most reads which may be in flight at once.
+      ///
+      virtual std::size_t capacity() const = 0;
+
+      /// @brief Queue a *read*; it may not start until flush or wait is called.
+      ///
+      /// @throw ReadFailureException if *capacity* reads are already queued and can't be started
+      ///
+      virtual void submit(FileRead *read) = 0;
+
+      /// @brief Start every queued read the backend will take now.
+      ///
+      /// Reads the backend can't take until completions are collected stay queued, and are started
+      /// by the next wait.
+      ///
+      /// @throw ReadFailureException
+      ///
+      virtual void flush() = 0;
+
+      /// @brief Block until a read completes, and return it.
+      ///
+      /// @throw ReadFailureException
+      ///
+      virtual FileRead *wait() = 0;
+
+      /// @brief Resolve *backend* against what this host supports.
+      ///
+      /// @throw UnsupportedBackendException
+      ///
+      static Backend Select(Backend backend);
+
+      /// @brief Create a queue using *backend*, sized for *depth* reads in flight, with *threads* threads
+      /// for the thread pool backend.
+      ///
+      /// @throw UnsupportedBackendException
+      ///
+      static std::unique_ptr<ReadQueue> Create(Backend backend, std::size_t depth, std::size_t threads);
+
+      /// @brief Check whether io_uring is available on this host.
+      ///
+      static bool HasIoUring();
+   };
+}
@@ -0,0 +1,135 @@
+//! @file section_layout.hpp
+//! @brief A batched planner for adding, removing and resizing the sections of a PE image.
+//!
+//! Editing sections one at a time means shifting every byte after the edit for each change. The
+//! layout planner instead records a batch of section edits, computes the file and virtual placement
+//! of every section once, and then rebuilds the image in a single pass, copying each section's raw
+//! data exactly once. The headers affected by the layout (*NumberOfSections*, *SizeOfHeaders*,
+//! *SizeOfImage*, the section table and a security directory living in the overlay) are updated
+//! to match.
+//!
+//! Existing sections keep their virtual addresses, since code and data directories refer to them
+//! by RVA. New sections are placed after the last section in virtual memory.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <yapp/exception.hpp>
+#include <yapp/memory.hpp>
+#include <yapp/headers.hpp>
+
+namespace yapp
+{
+   class PE;
+
+   /// @brief Records a batch of section edits against a PE image and applies them in one pass.
+   ///
+   /// Only disk images can be laid out. Sections are referred to by their index in the *planned*
+   /// section table, which includes added sections and excludes removed ones.
+   ///
+   class SectionLayout
+   {
+   protected:
+      struct Entry
+      {
+         headers::raw::IMAGE_SECTION_HEADER header;
+         std::optional<std::size_t> source;
+         std::optional<std::vector<std::uint8_t>> data;
+         std::size_t raw_size;
+      };
+
+      PE &pe;
+      std::vector<Entry> entries;
+
+      Entry &entry(std::size_t index);
+      const Entry &entry(std::size_t index) const;
+      std::size_t header_end(std::size_t sections) const;
+      std::size_t overlay_offset() const;
+
+   public:
+      /// @brief Begin planning a layout for the given *pe* image, starting from its current section table.
+      ///
+      /// @throw UnsupportedImageTypeException
+      ///
+      SectionLayout(PE &pe);
+
+      /// @brief Get the number of sections in the planned section table.
+      ///
+      inline std::size_t size() const { return this->entries.size(); }
+
+      /// @brief Find the planned index of the section with the given *name*.
+      ///
+      /// @throw SectionNotFoundException
+      ///
+      std::size_t find(const std::string &name) const;
+
+      /// @brief Queue a new section built from the given *section* header and its raw *data*.
+      ///
+      /// The file and virtual placement of the header are ignored and computed on commit. If the header's
+      /// virtual size is zero, the size of the data is used. Returns the planned index of the section.
+      ///
+      std::size_t add_section(const headers::raw::IMAGE_SECTION_HEADER &section, const std::vector<std::uint8_t> &data);
+
+      /// @brief Queue a new section with the given *name*, *characteristics* and raw *data*, with an optional
+      /// *virtual_size* larger than the data. Returns the planned index of the section.
+      ///
+      std::size_t add_section(const std::string &name,
+                              std::uint32_t characteristics,
+                              const std::vector<std::uint8_t> &data,
+                              std::optional<std::uint32_t> virtual_size = std::nullopt);
+
+      /// @brief Queue the removal of the section at the planned *index*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void remove_section(std::size_t index);
+
+      /// @brief Queue the removal of the section with the given *name*.
+      ///
+      /// @throw SectionNotFoundException
+      ///
+      void remove_section(const std::string &name);
+
+      /// @brief Queue a resize of the section at the planned *index* to *size* bytes.
+      ///
+      /// The raw data is truncated or zero-padded to the file-aligned size, and the virtual size becomes *size*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void resize_section(std::size_t index, std::uint32_t size);
+
+      /// @brief Queue a resize of the section with the given *name* to *size* bytes.
+      ///
+      /// @throw SectionNotFoundException
+      ///
+      void resize_section(const std::string &name, std::uint32_t size);
+
+      /// @brief Queue a replacement of the raw *data* of the section at the planned *index*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      void set_section_data(std::size_t index, const std::vector<std::uint8_t> &data);
+
+      /// @brief Compute the section table that *commit* would write, without modifying the image.
+      ///
+      /// @throw SectionTableOverflowException
+      /// @throw SectionOverlapException
+      ///
+      std::vector<headers::raw::IMAGE_SECTION_HEADER> plan() const;
+
+      /// @brief Rebuild the image with the planned layout and update the affected header fields.
+      ///
+      /// After committing, the planner is reset to the new section table of the image.
+      ///
+      /// @throw SectionTableOverflowException
+      /// @throw SectionOverlapException
+      ///
+      void commit();
+   };
+}
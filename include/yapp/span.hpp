@@ -0,0 +1,193 @@
+//! @file span.hpp
+//! @brief A contiguous, non-owning view of elements, for handing PE data to standard algorithms.
+//!
+//! Span is a C++17 stand-in for `std::span` with a dynamic extent: a pointer and an element count,
+//! iterated with raw pointers. Standard algorithms specialize raw pointers far more often than any
+//! class iterator (`std::find` over bytes becomes `memchr`, `std::copy` becomes `memmove`), so a span
+//! is the fastest way to run an algorithm or a SIMD kernel over a memory object:
+//!
+//! ```cpp
+//! auto bytes = pe.span();
+//! auto mz = std::search(bytes.begin(), bytes.end(), needle.begin(), needle.end());
+//! ```
+//!
+//! Spans convert implicitly from anything with `data()` and `size()`, including vectors, arrays and
+//! memory objects, and to and from `std::span` when compiled as C++20. Like `std::span`, a span
+//! doesn't keep what it views alive, and indexing it is unchecked; the slicing functions check their
+//! bounds.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define YAPP_STD_SPAN
+#endif
+
+#include <yapp/exception.hpp>
+
+namespace yapp
+{
+   /// @brief A pointer/count pair viewing contiguous elements of type *T*.
+   ///
+   template <typename T>
+   class Span
+   {
+   public:
+      using element_type = T;
+      using value_type = std::remove_cv_t<T>;
+      using size_type = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T*;
+      using const_pointer = const T*;
+      using reference = T&;
+      using const_reference = const T&;
+      using iterator = T*;
+      using reverse_iterator = std::reverse_iterator<iterator>;
+
+      /// @brief The count meaning "through the end" for *Span::subspan*.
+      ///
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+   protected:
+      T* _data;
+      std::size_t _size;
+
+      template <typename Container>
+      using DataType = std::remove_pointer_t<decltype(std::declval<Container &>().data())>;
+
+      template <typename U>
+      using IsCompatible = std::is_convertible<U(*)[], T(*)[]>;
+
+   public:
+      constexpr Span() noexcept : _data(nullptr), _size(0) {}
+      constexpr Span(T* data, std::size_t size) noexcept : _data(data), _size(size) {}
+      constexpr Span(T* first, T* last) noexcept : _data(first), _size(static_cast<std::size_t>(last - first)) {}
+
+      template <std::size_t N>
+      constexpr Span(T (&array)[N]) noexcept : _data(array), _size(N) {}
+
+      /// @brief View the elements of a *container* with contiguous `data()` and `size()`.
+      ///
+      template <typename Container,
+                typename = std::enable_if_t<!std::is_same<std::remove_cv_t<Container>, Span>::value
+                                            && IsCompatible<DataType<Container>>::value>>
+      constexpr Span(Container &container) : _data(container.data()), _size(container.size()) {}
+
+      /// @brief View the elements of a const *container*, which may be a temporary when the span is of
+      /// const elements.
+      ///
+      template <typename Container,
+                typename = std::enable_if_t<!std::is_same<std::remove_cv_t<Container>, Span>::value
+                                            && IsCompatible<DataType<const Container>>::value>>
+      constexpr Span(const Container &container) : _data(container.data()), _size(container.size()) {}
+
+      /// @brief Convert a span of a compatible type, such as a mutable span to a const one.
+      ///
+      template <typename U, typename = std::enable_if_t<!std::is_same<U, T>::value && IsCompatible<U>::value>>
+      constexpr Span(const Span<U> &other) noexcept : _data(other.data()), _size(other.size()) {}
+
+#ifdef YAPP_STD_SPAN
+      template <typename U, std::size_t Extent, typename = std::enable_if_t<IsCompatible<U>::value>>
+      constexpr Span(std::span<U, Extent> other) noexcept : _data(other.data()), _size(other.size()) {}
+
+      constexpr operator std::span<T>() const noexcept { return std::span<T>(this->_data, this->_size); }
+#endif
+
+      constexpr T* data() const noexcept { return this->_data; }
+      constexpr std::size_t size() const noexcept { return this->_size; }
+      constexpr std::size_t size_bytes() const noexcept { return this->_size * sizeof(T); }
+      constexpr bool empty() const noexcept { return this->_size == 0; }
+
+      constexpr iterator begin() const noexcept { return this->_data; }
+      constexpr iterator end() const noexcept { return this->_data + this->_size; }
+      constexpr reverse_iterator rbegin() const noexcept { return reverse_iterator(this->end()); }
+      constexpr reverse_iterator rend() const noexcept { return reverse_iterator(this->begin()); }
+
+      /// @brief Get the element at *index*, without a bounds check.
+      ///
+      constexpr T& operator[](std::size_t index) const noexcept { return this->_data[index]; }
+
+      /// @brief Get the element at *index*.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      T& at(std::size_t index) const {
+         if (index >= this->_size) { throw OutOfBoundsException(index, this->_size); }
+
+         return this->_data[index];
+      }
+
+      /// @throw OutOfBoundsException
+      ///
+      T& front() const { return this->at(0); }
+
+      /// @throw OutOfBoundsException
+      ///
+      T& back() const {
+         if (this->_size == 0) { throw OutOfBoundsException(0, 0); }
+
+         return this->_data[this->_size-1];
+      }
+
+      /// @brief Get a span of the first *count* elements.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      Span first(std::size_t count) const {
+         if (count > this->_size) { throw OutOfBoundsException(count, this->_size); }
+
+         return Span(this->_data, count);
+      }
+
+      /// @brief Get a span of the last *count* elements.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      Span last(std::size_t count) const {
+         if (count > this->_size) { throw OutOfBoundsException(count, this->_size); }
+
+         return Span(this->_data + (this->_size - count), count);
+      }
+
+      /// @brief Get a span of *count* elements at *offset*, or every element from *offset* on.
+      ///
+      /// @throw OutOfBoundsException
+      ///
+      Span subspan(std::size_t offset, std::size_t count=npos) const {
+         if (offset > this->_size) { throw OutOfBoundsException(offset, this->_size); }
+         if (count == npos) { count = this->_size - offset; }
+         if (count > this->_size - offset) { throw OutOfBoundsException(offset+count, this->_size); }
+
+         return Span(this->_data + offset, count);
+      }
+   };
+
+   template <typename T, std::size_t N>
+   Span(T (&)[N]) -> Span<T>;
+
+   template <typename Container>
+   Span(Container &) -> Span<std::remove_pointer_t<decltype(std::declval<Container &>().data())>>;
+
+   template <typename Container>
+   Span(const Container &) -> Span<std::remove_pointer_t<decltype(std::declval<const Container &>().data())>>;
+
+   /// @brief View the bytes of a *span*.
+   ///
+   template <typename T>
+   inline Span<const std::uint8_t> as_bytes(Span<T> span) noexcept {
+      return Span<const std::uint8_t>(reinterpret_cast<const std::uint8_t *>(span.data()), span.size_bytes());
+   }
+
+   /// @brief View the bytes of a mutable *span*, for writing.
+   ///
+   template <typename T, typename = std::enable_if_t<!std::is_const<T>::value>>
+   inline Span<std::uint8_t> as_writable_bytes(Span<T> span) noexcept {
+      return Span<std::uint8_t>(reinterpret_cast<std::uint8_t *>(span.data()), span.size_bytes());
+   }
+}
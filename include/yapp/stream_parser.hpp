@@ -0,0 +1,200 @@
+//! @file stream_parser.hpp
+//! @brief Forward-only parsing of PE files from pipes, sockets and decompressors.
+//!
+//! Memory::load_file seeks to the end of a file to learn its size, which a pipe or a socket can't do.
+//! The stream parser instead consumes a file strictly in order, in whatever chunks it arrives in. It
+//! buffers only the headers, then hands them over as soon as the section table is complete; after
+//! that, bytes are kept only while they fall within a requested data directory, and every section's
+//! hash and entropy, along with the hash of the whole file, are computed as the bytes go past.
+//!
+//! Data can be pushed into the parser with feed and finish, or pulled from a Reader with parse.
+//!
+//! The hashes are the 64-bit FNV-1a hashes used by ExportIndexCache::ContentKey and by the section
+//! table of a MetadataView, so a streamed file's sections can be matched against cached records without
+//! ever being written to disk.
+//!
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <vector>
+
+#include <yapp/platform.hpp>
+#include <yapp/exception.hpp>
+#include <yapp/pe.hpp>
+
+namespace yapp
+{
+   /// @brief Parses a PE file from a forward-only stream of bytes.
+   ///
+   class StreamParser
+   {
+   public:
+      /// @brief Reads up to *size* bytes into *buffer*, returning the number read, or zero at the end of the stream.
+      ///
+      using Reader = std::function<std::size_t(std::uint8_t *buffer, std::size_t size)>;
+
+      /// @brief A section whose raw data has gone past.
+      ///
+      /// If the stream ended inside the section's raw data, *size* is less than SizeOfRawData, and the
+      /// hash and entropy cover only the part that was present.
+      ///
+      struct Section
+      {
+         std::size_t index;
+         headers::raw::IMAGE_SECTION_HEADER header;
+         std::size_t size;
+         std::uint64_t hash;
+         double entropy;
+      };
+
+      /// @brief Receives the parts of a file as they become available.
+      ///
+      /// Every handler does nothing by default, so only the interesting ones need overriding.
+      ///
+      class Handler
+      {
+      public:
+         virtual ~Handler() {}
+
+         /// @brief Called once the DOS header, NT headers and section table have all arrived.
+         ///
+         /// *headers* holds only the leading bytes of the file and is only valid during the call.
+         ///
+         virtual void on_headers(const PE &/*headers*/) {}
+
+         /// @brief Called with the raw contents of a requested data directory once all of it has arrived.
+         ///
+         /// A directory cut short by the end of the stream is never reported.
+         ///
+         virtual void on_directory(std::size_t /*index*/, const std::vector<std::uint8_t> &/*data*/) {}
+
+         /// @brief Called as each section's raw data has gone past, in the order the data ends in the file.
+         ///
+         virtual void on_section(const Section &/*section*/) {}
+
+         /// @brief Called at the end of the stream with its total *size* and *hash*.
+         ///
+         virtual void on_end(std::size_t /*size*/, std::uint64_t /*hash*/) {}
+      };
+
+      /// @brief The size of each read parse makes from a Reader.
+      ///
+      static const std::size_t ChunkSize = 0x10000;
+
+      /// @brief The default limit on the bytes buffered for a single data directory.
+      ///
+      static const std::size_t MaxDirectorySize = 0x1000000;
+
+   protected:
+      /// A section or directory whose file range is still going past.
+      struct Pending
+      {
+         std::size_t start, end;
+         std::size_t index;
+         headers::raw::IMAGE_SECTION_HEADER header;
+         std::uint64_t hash;
+         /// Byte counts for the entropy, allocated only once the section's data starts going past.
+         std::vector<std::uint32_t> counts;
+         std::vector<std::uint8_t> data;
+      };
+
+      Handler &handler;
+      /// The requested directories, with the most bytes to buffer for each.
+      std::map<std::size_t, std::size_t> directories;
+      std::vector<std::uint8_t> header_buffer;
+      bool have_headers;
+      std::size_t _position;
+      std::uint64_t _hash;
+      std::vector<Pending> sections;
+      std::vector<Pending> pending_directories;
+      std::size_t _buffered;
+      std::size_t _peak_buffered;
+
+      void begin_body();
+      void consume(const std::uint8_t *data, std::size_t size);
+      void finish_section(Pending &section);
+
+   public:
+      /// @brief Create a parser which reports to the given *handler*.
+      ///
+      StreamParser(Handler &handler);
+
+      /// @brief Also buffer and report the data directory with the given *index*.
+      ///
+      /// Only the range named by the directory entry is kept, not data the directory points to elsewhere.
+      /// A directory whose entry claims more than *max_size* bytes is neither buffered nor reported, so
+      /// a hostile entry can't make the parser hold the rest of the stream.
+      ///
+      void add_directory(std::size_t index, std::size_t max_size=StreamParser::MaxDirectorySize);
+
+      /// @brief Get the number of bytes of the current file consumed so far.
+      ///
+      inline std::size_t position() const {
+         return (this->have_headers) ? this->_position : this->header_buffer.size();
+      }
+
+      /// @brief Get the number of bytes currently held for headers and unfinished directories.
+      ///
+      inline std::size_t buffered() const { return this->_buffered; }
+
+      /// @brief Get the most bytes held at once while parsing the current or last file.
+      ///
+      inline std::size_t peak_buffered() const { return this->_peak_buffered; }
+
+      /// @brief Consume the next *size* bytes of the file at *data*.
+      ///
+      /// Handlers are called from within feed as soon as what they report is complete. If feed throws,
+      /// the parser is reset, ready for another file.
+      ///
+      /// @throw InvalidDOSSignatureException
+      /// @throw InvalidNTSignatureException
+      /// @throw OversizedHeadersException
+      ///
+      void feed(const std::uint8_t *data, std::size_t size);
+
+      /// @brief End the file, reporting any sections cut short and then the end of the stream.
+      ///
+      /// The parser is then ready for another file.
+      ///
+      /// @throw TruncatedStreamException
+      ///
+      void finish();
+
+      /// @brief Discard the current file without reporting its end, ready for another.
+      ///
+      void reset();
+
+      /// @brief Parse a whole file pulled from *reader*, returning its size.
+      ///
+      /// @throw TruncatedStreamException
+      /// @throw InvalidDOSSignatureException
+      /// @throw InvalidNTSignatureException
+      /// @throw OversizedHeadersException
+      ///
+      std::size_t parse(Reader reader);
+
+      /// @brief Parse a whole file read from *stream*, returning its size.
+      ///
+      /// The stream is never sought, so it may be `std::cin` or any other unbuffered source.
+      ///
+      /// @throw TruncatedStreamException
+      /// @throw InvalidDOSSignatureException
+      /// @throw InvalidNTSignatureException
+      /// @throw OversizedHeadersException
+      ///
+      std::size_t parse(std::istream &stream);
+
+#ifndef YAPP_WIN32
+      /// @brief Get a reader which reads from the file descriptor *fd*, such as a pipe or a socket.
+      ///
+      /// @throw ReadFailureException when the returned reader is called and the read fails
+      ///
+      static Reader DescriptorReader(int fd);
+#endif
+   };
+}
@@ -0,0 +1,885 @@
+#include <yapp.hpp>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace yapp;
+
+const char *ZipArchive::DefaultPassword = "infected";
+
+namespace
+{
+   const std::uint32_t LocalHeaderSignature = 0x04034B50;
+   const std::uint32_t CentralHeaderSignature = 0x02014B50;
+   const std::uint32_t EndSignature = 0x06054B50;
+
+   const std::size_t LocalHeaderSize = 30;
+   const std::size_t CentralHeaderSize = 46;
+   const std::size_t EndSize = 22;
+   const std::size_t EncryptionHeaderSize = 12;
+
+   // back-references reach at most this far into the output
+   const std::size_t WindowSize = 0x8000;
+
+   // a 258-byte copy costs at least two bits, so DEFLATE expands data at most 1032 times
+   const std::size_t MaxDeflateRatio = 1032;
+
+   const std::uint16_t LengthBase[29] = {
+      3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+   };
+
+   const std::uint8_t LengthExtra[29] = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+   };
+
+   const std::uint16_t DistanceBase[30] = {
+      1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+      257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+   };
+
+   const std::uint8_t DistanceExtra[30] = {
+      0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+   };
+
+   const std::uint8_t CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+   std::uint16_t
+   read16
+   (const std::uint8_t *data)
+   {
+      std::uint16_t result;
+      std::memcpy(&result, data, sizeof(result));
+      return result;
+   }
+
+   std::uint32_t
+   read32
+   (const std::uint8_t *data)
+   {
+      std::uint32_t result;
+      std::memcpy(&result, data, sizeof(result));
+      return result;
+   }
+
+   void
+   require
+   (const Memory<std::uint8_t> &data, std::size_t offset, std::size_t size)
+   {
+      if (offset > data.size() || size > data.size() - offset) { throw InvalidArchiveException(offset); }
+   }
+
+   std::uint32_t
+   crc32
+   (std::uint32_t crc, const std::uint8_t *data, std::size_t size)
+   {
+      static const auto table = [] () {
+         std::array<std::uint32_t, 256> result;
+
+         for (std::uint32_t i=0; i<256; ++i)
+         {
+            auto value = i;
+
+            for (int bit=0; bit<8; ++bit) { value = (value & 1) ? 0xEDB88320 ^ (value >> 1) : value >> 1; }
+
+            result[i] = value;
+         }
+
+         return result;
+      }();
+
+      crc = ~crc;
+
+      for (std::size_t i=0; i<size; ++i) { crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8); }
+
+      return ~crc;
+   }
+
+   /// Reads a DEFLATE stream least significant bit first.
+   class BitReader
+   {
+   protected:
+      const std::uint8_t *data;
+      std::size_t size;
+      std::size_t position;
+      std::uint64_t bits;
+      unsigned count;
+
+      void refill() {
+         while (this->count <= 56 && this->position < this->size)
+         {
+            this->bits |= std::uint64_t(this->data[this->position++]) << this->count;
+            this->count += 8;
+         }
+      }
+
+   public:
+      BitReader(const std::uint8_t *data, std::size_t size) : data(data), size(size), position(0), bits(0), count(0) {}
+
+      /// The number of bits buffered, which peek's result is only good for.
+      inline unsigned available() const { return this->count; }
+
+      /// The offset of the first byte which hasn't been consumed.
+      inline std::size_t consumed() const { return this->position - this->count / 8; }
+
+      /// Look at the next *n* bits, zero-filled past the end of the data.
+      std::uint32_t peek(unsigned n) {
+         if (this->count < n) { this->refill(); }
+         return static_cast<std::uint32_t>(this->bits & ((std::uint64_t(1) << n) - 1));
+      }
+
+      void skip(unsigned n) {
+         this->bits >>= n;
+         this->count -= n;
+      }
+
+      std::uint32_t take(unsigned n) {
+         if (this->count < n)
+         {
+            this->refill();
+            if (this->count < n) { throw InvalidArchiveException(this->position); }
+         }
+
+         auto result = this->peek(n);
+         this->skip(n);
+
+         return result;
+      }
+
+      void align() { this->skip(this->count % 8); }
+
+      /// Take *n* whole bytes directly from the data; only valid once no bits are buffered.
+      const std::uint8_t *bytes(std::size_t n) {
+         if (n > this->size - this->position) { throw InvalidArchiveException(this->position); }
+
+         auto result = this->data + this->position;
+         this->position += n;
+
+         return result;
+      }
+   };
+
+   /// A canonical Huffman code, decoded through a lookup table for short codes and bit by bit otherwise.
+   struct Huffman
+   {
+      static const unsigned FastBits = 10;
+
+      // symbol << 4 | length, or zero for codes longer than FastBits
+      std::uint16_t fast[1 << FastBits];
+      std::uint16_t count[16];
+      std::uint16_t symbol[288];
+
+      void build(const std::uint8_t *lengths, std::size_t size) {
+         std::memset(this->count, 0, sizeof(this->count));
+
+         for (std::size_t i=0; i<size; ++i) { ++this->count[lengths[i]]; }
+
+         this->count[0] = 0;
+
+         // over-subscribed codes are invalid, but incomplete ones are allowed, as with a lone distance code
+         int left = 1;
+
+         for (int length=1; length<16; ++length)
+         {
+            left = (left << 1) - this->count[length];
+            if (left < 0) { throw InvalidArchiveException(0); }
+         }
+
+         std::uint16_t offsets[16] = {0};
+
+         for (int length=1; length<15; ++length) { offsets[length+1] = offsets[length] + this->count[length]; }
+
+         for (std::size_t i=0; i<size; ++i)
+         {
+            if (lengths[i] != 0) { this->symbol[offsets[lengths[i]]++] = static_cast<std::uint16_t>(i); }
+         }
+
+         std::memset(this->fast, 0, sizeof(this->fast));
+
+         std::uint32_t code = 0;
+         std::size_t index = 0;
+
+         for (unsigned length=1; length<=FastBits; ++length)
+         {
+            for (std::size_t i=0; i<this->count[length]; ++i, ++code)
+            {
+               // codes are packed most significant bit first, so the table is indexed by their reverse
+               std::uint32_t reversed = 0;
+
+               for (unsigned bit=0; bit<length; ++bit) { reversed |= ((code >> bit) & 1) << (length - 1 - bit); }
+
+               auto entry = static_cast<std::uint16_t>((this->symbol[index++] << 4) | length);
+
+               for (auto slot=reversed; slot<(1U << FastBits); slot+=(1U << length)) { this->fast[slot] = entry; }
+            }
+
+            code <<= 1;
+         }
+      }
+
+      std::uint16_t decode(BitReader &reader) const {
+         auto entry = this->fast[reader.peek(FastBits)];
+
+         if (entry != 0 && (entry & 0xF) <= reader.available())
+         {
+            reader.skip(entry & 0xF);
+            return entry >> 4;
+         }
+
+         int code = 0, first = 0, index = 0;
+
+         for (int length=1; length<16; ++length)
+         {
+            code |= static_cast<int>(reader.take(1));
+
+            int count = this->count[length];
+
+            if (code - count < first) { return this->symbol[index + (code - first)]; }
+
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+         }
+
+         throw InvalidArchiveException(reader.consumed());
+      }
+   };
+
+   /// Inflates into a buffer of a size known up front.
+   class FixedOutput
+   {
+   protected:
+      std::uint8_t *buffer;
+      std::size_t size;
+      std::size_t position;
+
+   public:
+      FixedOutput(std::uint8_t *buffer, std::size_t size) : buffer(buffer), size(size), position(0) {}
+
+      inline std::size_t written() const { return this->position; }
+
+      void put(std::uint8_t byte) {
+         if (this->position >= this->size) { throw InvalidArchiveException(this->position); }
+         this->buffer[this->position++] = byte;
+      }
+
+      void copy(std::size_t distance, std::size_t length) {
+         if (distance > this->position || length > this->size - this->position)
+            throw InvalidArchiveException(this->position);
+
+         // the ranges overlap whenever the distance is shorter than the length, so copy byte by byte
+         auto to = this->buffer + this->position;
+         auto from = to - distance;
+
+         for (std::size_t i=0; i<length; ++i) { to[i] = from[i]; }
+
+         this->position += length;
+      }
+
+      void write(const std::uint8_t *data, std::size_t length) {
+         if (length > this->size - this->position) { throw InvalidArchiveException(this->position); }
+
+         std::memcpy(this->buffer + this->position, data, length);
+         this->position += length;
+      }
+   };
+
+   /// Inflates into a sink in chunks, keeping only a window of history for back-references.
+   class StreamOutput
+   {
+   protected:
+      static const std::size_t FlushSize = 0x10000;
+
+      StreamParser &parser;
+      std::vector<std::uint8_t> buffer;
+      std::size_t _written;
+      std::uint32_t _crc;
+
+      void emit(std::size_t size) {
+         this->_crc = crc32(this->_crc, this->buffer.data(), size);
+         this->parser.feed(this->buffer.data(), size);
+         this->_written += size;
+         this->buffer.erase(this->buffer.begin(), this->buffer.begin() + size);
+      }
+
+      void flush_history() {
+         if (this->buffer.size() >= WindowSize + FlushSize) { this->emit(this->buffer.size() - WindowSize); }
+      }
+
+   public:
+      StreamOutput(StreamParser &parser) : parser(parser), _written(0), _crc(0) {
+         // a single copy is at most 258 bytes, so flushing after each one keeps the buffer in place
+         this->buffer.reserve(WindowSize + FlushSize + 258);
+      }
+
+      inline std::size_t written() const { return this->_written; }
+      inline std::uint32_t crc() const { return this->_crc; }
+
+      void put(std::uint8_t byte) {
+         this->buffer.push_back(byte);
+         this->flush_history();
+      }
+
+      void copy(std::size_t distance, std::size_t length) {
+         if (distance > this->buffer.size()) { throw InvalidArchiveException(this->_written + this->buffer.size()); }
+
+         for (std::size_t i=0; i<length; ++i)
+         {
+            auto byte = this->buffer[this->buffer.size() - distance];
+            this->buffer.push_back(byte);
+         }
+
+         this->flush_history();
+      }
+
+      void write(const std::uint8_t *data, std::size_t length) {
+         for (std::size_t i=0; i<length; ++i) { this->put(data[i]); }
+      }
+
+      void finish() { this->emit(this->buffer.size()); }
+   };
+
+   template <typename Output>
+   void
+   inflate_block
+   (BitReader &reader, Output &output, const Huffman &lengths, const Huffman &distances)
+   {
+      while (true)
+      {
+         auto symbol = lengths.decode(reader);
+
+         if (symbol < 256) { output.put(static_cast<std::uint8_t>(symbol)); continue; }
+         if (symbol == 256) { return; }
+
+         symbol -= 257;
+         if (symbol >= 29) { throw InvalidArchiveException(reader.consumed()); }
+
+         auto length = LengthBase[symbol] + reader.take(LengthExtra[symbol]);
+         auto code = distances.decode(reader);
+
+         if (code >= 30) { throw InvalidArchiveException(reader.consumed()); }
+
+         auto distance = DistanceBase[code] + reader.take(DistanceExtra[code]);
+
+         output.copy(distance, length);
+      }
+   }
+
+   /// Inflate raw DEFLATE *data* into *output*, returning the number of bytes of *data* consumed.
+   template <typename Output>
+   std::size_t
+   inflate
+   (const std::uint8_t *data, std::size_t size, Output &output)
+   {
+      static const auto fixed = [] () {
+         auto result = std::make_pair(std::unique_ptr<Huffman>(new Huffman()), std::unique_ptr<Huffman>(new Huffman()));
+         std::uint8_t lengths[288];
+
+         std::memset(lengths, 8, 144);
+         std::memset(lengths + 144, 9, 112);
+         std::memset(lengths + 256, 7, 24);
+         std::memset(lengths + 280, 8, 8);
+         result.first->build(lengths, 288);
+
+         std::memset(lengths, 5, 30);
+         result.second->build(lengths, 30);
+
+         return result;
+      }();
+
+      auto reader = BitReader(data, size);
+      auto dynamic = std::make_pair(std::unique_ptr<Huffman>(new Huffman()), std::unique_ptr<Huffman>(new Huffman()));
+      auto last = false;
+
+      while (!last)
+      {
+         last = reader.take(1) != 0;
+
+         switch (reader.take(2))
+         {
+         case 0:
+         {
+            reader.align();
+
+            auto length = reader.take(16);
+            auto complement = reader.take(16);
+
+            if (length != (~complement & 0xFFFF)) { throw InvalidArchiveException(reader.consumed()); }
+
+            // drain whatever whole bytes are still buffered, then copy the rest straight across
+            for (; length > 0 && reader.available() > 0; --length) { output.put(static_cast<std::uint8_t>(reader.take(8))); }
+
+            output.write(reader.bytes(length), length);
+            break;
+         }
+
+         case 1:
+            inflate_block(reader, output, *fixed.first, *fixed.second);
+            break;
+
+         case 2:
+         {
+            auto literal_count = reader.take(5) + 257;
+            auto distance_count = reader.take(5) + 1;
+            auto code_count = reader.take(4) + 4;
+
+            if (literal_count > 286 || distance_count > 30) { throw InvalidArchiveException(reader.consumed()); }
+
+            std::uint8_t lengths[286 + 30] = {0};
+
+            for (std::size_t i=0; i<code_count; ++i) { lengths[CodeLengthOrder[i]] = static_cast<std::uint8_t>(reader.take(3)); }
+
+            auto codes = Huffman();
+            codes.build(lengths, 19);
+
+            std::size_t index = 0;
+
+            while (index < literal_count + distance_count)
+            {
+               auto symbol = codes.decode(reader);
+
+               if (symbol < 16) { lengths[index++] = static_cast<std::uint8_t>(symbol); continue; }
+
+               std::uint8_t repeated = 0;
+               std::size_t repeat;
+
+               if (symbol == 16)
+               {
+                  if (index == 0) { throw InvalidArchiveException(reader.consumed()); }
+
+                  repeated = lengths[index-1];
+                  repeat = 3 + reader.take(2);
+               }
+               else if (symbol == 17) { repeat = 3 + reader.take(3); }
+               else { repeat = 11 + reader.take(7); }
+
+               if (index + repeat > literal_count + distance_count) { throw InvalidArchiveException(reader.consumed()); }
+
+               while (repeat-- > 0) { lengths[index++] = repeated; }
+            }
+
+            // without an end-of-block code the block could never finish
+            if (lengths[256] == 0) { throw InvalidArchiveException(reader.consumed()); }
+
+            dynamic.first->build(lengths, literal_count);
+            dynamic.second->build(lengths + literal_count, distance_count);
+            inflate_block(reader, output, *dynamic.first, *dynamic.second);
+            break;
+         }
+
+         default:
+            throw InvalidArchiveException(reader.consumed());
+         }
+      }
+
+      return reader.consumed();
+   }
+
+   /// Decrypt an entry's traditional PKWARE encryption, checking the *password* against its header.
+   /// Check a declared *size* against what *compressed* bytes can inflate to, and against *max_size*,
+   /// before it's allocated.
+   void
+   check_declared_size
+   (const std::string &name, std::size_t size, std::size_t compressed, bool deflated, std::size_t offset, std::size_t max_size)
+   {
+      auto most = (deflated) ? compressed * MaxDeflateRatio : compressed;
+
+      if (size > most) { throw InvalidArchiveException(offset); }
+      if (size > max_size) { throw ArchiveEntryTooLargeException(name, size, max_size); }
+   }
+
+   std::vector<std::uint8_t>
+   decrypt
+   (const ZipArchive::Entry &entry, const std::uint8_t *data, const std::string &password)
+   {
+      if (entry.compressed_size < EncryptionHeaderSize) { throw InvalidArchiveException(entry.header_offset); }
+
+      std::uint32_t keys[3] = {0x12345678, 0x23456789, 0x34567890};
+
+      auto update = [&keys] (std::uint8_t byte) {
+         keys[0] = ~crc32(~keys[0], &byte, 1);
+         keys[1] = (keys[1] + (keys[0] & 0xFF)) * 134775813 + 1;
+
+         auto high = static_cast<std::uint8_t>(keys[1] >> 24);
+         keys[2] = ~crc32(~keys[2], &high, 1);
+      };
+
+      auto next = [&keys, &update] (std::uint8_t byte) {
+         auto temp = (keys[2] | 2) & 0xFFFF;
+         auto plain = static_cast<std::uint8_t>(byte ^ ((temp * (temp ^ 1)) >> 8));
+
+         update(plain);
+
+         return plain;
+      };
+
+      for (auto c : password) { update(static_cast<std::uint8_t>(c)); }
+
+      std::uint8_t header[EncryptionHeaderSize];
+
+      for (std::size_t i=0; i<EncryptionHeaderSize; ++i) { header[i] = next(data[i]); }
+
+      // the last header byte repeats the top of the CRC, or of the time when the CRC follows the data
+      auto check = (entry.flags & 0x8) ? static_cast<std::uint8_t>(entry.time >> 8) : static_cast<std::uint8_t>(entry.crc >> 24);
+
+      if (header[EncryptionHeaderSize-1] != check) { throw ArchivePasswordException(entry.name); }
+
+      auto result = std::vector<std::uint8_t>(entry.compressed_size - EncryptionHeaderSize);
+
+      for (std::size_t i=0; i<result.size(); ++i) { result[i] = next(data[EncryptionHeaderSize + i]); }
+
+      return result;
+   }
+}
+
+ZipArchive::ZipArchive
+(const std::string &filename, const std::string &password)
+   : data(filename),
+     password(password)
+{
+   this->parse_directory();
+}
+
+ZipArchive::ZipArchive
+(const Memory<std::uint8_t> &data, const std::string &password)
+   : data(data),
+     password(password)
+{
+   this->parse_directory();
+}
+
+void
+ZipArchive::parse_directory
+()
+{
+   auto bytes = this->data.ptr();
+   auto size = this->data.size();
+
+   if (size < EndSize) { throw InvalidArchiveException(0); }
+
+   // the end record is followed by a comment of at most 64KB, so it's within reach of the end
+   auto lowest = (size > EndSize + 0xFFFF) ? size - EndSize - 0xFFFF : 0;
+   std::optional<std::size_t> end;
+
+   for (auto offset=size-EndSize+1; offset-- > lowest;)
+   {
+      if (read32(bytes + offset) == EndSignature) { end = offset; break; }
+   }
+
+   if (!end.has_value()) { throw InvalidArchiveException(size); }
+
+   auto record = bytes + *end;
+
+   if (read16(record + 4) != 0 || read16(record + 6) != 0 || read16(record + 8) != read16(record + 10))
+      throw UnsupportedArchiveException("multi-disk archives");
+
+   auto count = read16(record + 10);
+   auto offset = std::size_t(read32(record + 16));
+
+   if (count == 0xFFFF || offset == 0xFFFFFFFF) { throw UnsupportedArchiveException("ZIP64 archives"); }
+
+   for (std::size_t i=0; i<count; ++i)
+   {
+      require(this->data, offset, CentralHeaderSize);
+
+      auto header = bytes + offset;
+      if (read32(header) != CentralHeaderSignature) { throw InvalidArchiveException(offset); }
+
+      auto name_size = read16(header + 28);
+      auto extra_size = read16(header + 30);
+      auto comment_size = read16(header + 32);
+
+      require(this->data, offset + CentralHeaderSize, name_size);
+
+      auto entry = Entry{
+         std::string(reinterpret_cast<const char *>(header + CentralHeaderSize), name_size),
+         read16(header + 8),
+         read16(header + 10),
+         read16(header + 12),
+         read16(header + 14),
+         read32(header + 16),
+         read32(header + 20),
+         read32(header + 24),
+         read32(header + 42)
+      };
+
+      if (entry.compressed_size == 0xFFFFFFFF || entry.size == 0xFFFFFFFF || entry.header_offset == 0xFFFFFFFF)
+         throw UnsupportedArchiveException("ZIP64 archives");
+
+      this->_entries.push_back(entry);
+      offset += CentralHeaderSize + name_size + extra_size + comment_size;
+   }
+}
+
+std::optional<ZipArchive::Entry>
+ZipArchive::find
+(const std::string &name) const
+{
+   for (auto &entry : this->_entries)
+   {
+      if (entry.name == name) { return entry; }
+   }
+
+   return std::nullopt;
+}
+
+void
+ZipArchive::read_payload
+(const Entry &entry, const std::function<void(const std::uint8_t *, std::size_t)> &consume) const
+{
+   // strong encryption, which includes AES, sets bit 6; WinZip's AES marks itself with method 99
+   if ((entry.flags & 0x40) || entry.method == 99) { throw UnsupportedArchiveException("AES encryption"); }
+
+   if (entry.method != Method::STORED && entry.method != Method::DEFLATED)
+      throw UnsupportedArchiveException("compression method " + std::to_string(entry.method));
+
+   auto offset = std::size_t(entry.header_offset);
+
+   require(this->data, offset, LocalHeaderSize);
+
+   auto header = this->data.ptr() + offset;
+   if (read32(header) != LocalHeaderSignature) { throw InvalidArchiveException(offset); }
+
+   // the local extra field can differ from the central one, so the data offset comes from here
+   offset += LocalHeaderSize + read16(header + 26) + read16(header + 28);
+   require(this->data, offset, entry.compressed_size);
+
+   if (!entry.encrypted()) { return consume(this->data.ptr() + offset, entry.compressed_size); }
+
+   auto plain = decrypt(entry, this->data.ptr() + offset, this->password);
+   consume(plain.data(), plain.size());
+}
+
+PE
+ZipArchive::extract
+(const Entry &entry, std::size_t max_size) const
+{
+   if (entry.size == 0)
+   {
+      this->read_payload(entry, [] (const std::uint8_t *, std::size_t) {});
+      return PE();
+   }
+
+   check_declared_size(entry.name, entry.size, entry.compressed_size, entry.method == Method::DEFLATED,
+                       entry.header_offset, max_size);
+
+   PE image(std::size_t(entry.size), PE::ImageType::DISK);
+   auto output = FixedOutput(image.ptr(), image.size());
+
+   this->read_payload(entry, [&entry, &output] (const std::uint8_t *payload, std::size_t size) {
+      if (entry.method == Method::STORED) { output.write(payload, size); }
+      else { inflate(payload, size, output); }
+   });
+
+   if (output.written() != entry.size) { throw InvalidArchiveException(entry.header_offset); }
+   if (crc32(0, image.ptr(), image.size()) != entry.crc) { throw ArchiveChecksumException(entry.name); }
+
+   return image;
+}
+
+void
+ZipArchive::stream
+(const Entry &entry, StreamParser &parser) const
+{
+   try {
+      auto output = StreamOutput(parser);
+
+      this->read_payload(entry, [&entry, &output] (const std::uint8_t *payload, std::size_t size) {
+         if (entry.method == Method::STORED) { output.write(payload, size); }
+         else { inflate(payload, size, output); }
+      });
+
+      output.finish();
+
+      if (output.written() != entry.size) { throw InvalidArchiveException(entry.header_offset); }
+      if (output.crc() != entry.crc) { throw ArchiveChecksumException(entry.name); }
+   }
+   catch (...) {
+      parser.reset();
+      throw;
+   }
+
+   parser.finish();
+}
+
+void
+ZipArchive::for_each
+(Callback callback, std::size_t threads, std::size_t max_size) const
+{
+   std::atomic<std::size_t> next(0);
+   std::exception_ptr failure;
+   std::mutex failure_mutex;
+
+   auto work = [&] () {
+      try {
+         while (true)
+         {
+            auto index = next++;
+            if (index >= this->_entries.size()) { return; }
+
+            auto &entry = this->_entries[index];
+            if (entry.is_directory()) { continue; }
+
+            // PE can't be reassigned, so the image is built in place on the heap
+            std::unique_ptr<PE> image;
+            std::exception_ptr error;
+
+            try {
+               image = std::unique_ptr<PE>(new PE(this->extract(entry, max_size)));
+            }
+            catch (...) {
+               error = std::current_exception();
+               image = std::unique_ptr<PE>(new PE());
+            }
+
+            callback(entry, *image, error);
+         }
+      }
+      catch (...) {
+         // a throwing callback stops every worker, and the first exception is rethrown to the caller
+         std::lock_guard<std::mutex> lock(failure_mutex);
+
+         if (!failure) { failure = std::current_exception(); }
+         next = this->_entries.size();
+      }
+   };
+
+   auto workers = std::vector<std::thread>();
+   auto count = std::min(std::max<std::size_t>(threads, 1), std::max<std::size_t>(this->_entries.size(), 1));
+
+   for (std::size_t i=0; i<count; ++i) { workers.emplace_back(work); }
+   for (auto &worker : workers) { worker.join(); }
+
+   if (failure) { std::rethrow_exception(failure); }
+}
+
+GzipFile::GzipFile
+(const std::string &filename)
+   : data(filename)
+{
+   this->parse_header();
+}
+
+GzipFile::GzipFile
+(const Memory<std::uint8_t> &data)
+   : data(data)
+{
+   this->parse_header();
+}
+
+void
+GzipFile::parse_header
+()
+{
+   const std::uint8_t FlagHeaderCRC = 0x02, FlagExtra = 0x04, FlagName = 0x08, FlagComment = 0x10;
+
+   auto bytes = this->data.ptr();
+   auto size = this->data.size();
+
+   // the fixed header and the trailer
+   require(this->data, 0, 18);
+
+   if (bytes[0] != 0x1F || bytes[1] != 0x8B) { throw InvalidArchiveException(0); }
+   if (bytes[2] != 8) { throw UnsupportedArchiveException("compression method " + std::to_string(bytes[2])); }
+
+   auto flags = bytes[3];
+   if (flags & 0xE0) { throw InvalidArchiveException(3); }
+
+   std::size_t offset = 10;
+
+   if (flags & FlagExtra)
+   {
+      require(this->data, offset, 2);
+      offset += 2 + read16(bytes + offset);
+   }
+
+   for (auto flag : {FlagName, FlagComment})
+   {
+      if (!(flags & flag)) { continue; }
+
+      auto start = offset;
+
+      while (offset < size && bytes[offset] != 0) { ++offset; }
+      if (offset >= size) { throw InvalidArchiveException(start); }
+
+      if (flag == FlagName) { this->_name = std::string(reinterpret_cast<const char *>(bytes + start), offset - start); }
+
+      ++offset;
+   }
+
+   if (flags & FlagHeaderCRC) { offset += 2; }
+
+   require(this->data, offset, 8);
+   this->payload_offset = offset;
+}
+
+std::size_t
+GzipFile::declared_size
+() const
+{
+   return read32(this->data.ptr() + this->data.size() - 4);
+}
+
+PE
+GzipFile::extract
+(std::size_t max_size) const
+{
+   auto payload = this->data.ptr() + this->payload_offset;
+   auto payload_size = this->data.size() - this->payload_offset;
+   auto size = this->declared_size();
+
+   if (size == 0)
+   {
+      auto output = FixedOutput(nullptr, 0);
+      inflate(payload, payload_size, output);
+
+      return PE();
+   }
+
+   // the payload ends with the eight byte trailer
+   check_declared_size(this->_name, size, payload_size - 8, true, this->payload_offset, max_size);
+
+   PE image(size, PE::ImageType::DISK);
+   auto output = FixedOutput(image.ptr(), image.size());
+   auto consumed = inflate(payload, payload_size, output);
+
+   // the trailer follows the compressed data
+   require(this->data, this->payload_offset + consumed, 8);
+
+   if (output.written() != size) { throw InvalidArchiveException(this->payload_offset + consumed); }
+
+   if (crc32(0, image.ptr(), image.size()) != read32(payload + consumed))
+      throw ArchiveChecksumException(this->_name);
+
+   return image;
+}
+
+void
+GzipFile::stream
+(StreamParser &parser) const
+{
+   try {
+      auto payload = this->data.ptr() + this->payload_offset;
+      auto output = StreamOutput(parser);
+      auto consumed = inflate(payload, this->data.size() - this->payload_offset, output);
+
+      output.finish();
+
+      require(this->data, this->payload_offset + consumed, 8);
+
+      if (output.crc() != read32(payload + consumed)) { throw ArchiveChecksumException(this->_name); }
+      if (static_cast<std::uint32_t>(output.written()) != read32(payload + consumed + 4))
+         throw InvalidArchiveException(this->payload_offset + consumed + 4);
+   }
+   catch (...) {
+      parser.reset();
+      throw;
+   }
+
+   parser.finish();
+}
@@ -0,0 +1,564 @@
+#include <yapp.hpp>
+
+#include <filesystem>
+#include <set>
+
+#ifndef YAPP_WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   using Range = std::pair<std::size_t, std::size_t>;
+
+   void
+   fail
+   (const AsyncParser::Callback &then, std::exception_ptr error)
+   {
+      auto pe = PE();
+      then(pe, error);
+   }
+
+   void
+   fail
+   (const AsyncParser::ImportsCallback &then, std::exception_ptr error)
+   {
+      auto imports = std::vector<Import>();
+      then(imports, error);
+   }
+
+   /// Load every header, a page further each time the headers loaded so far say they run longer.
+   void
+   load_headers
+   (LazyImage &image, std::size_t extent, AsyncParser::Callback then)
+   {
+      image.load(0, extent, [&image, extent, then] (std::exception_ptr error) {
+         if (error) { fail(then, error); return; }
+
+         try {
+            auto loaded = std::min(extent, image.size());
+            auto needed = PE::HeaderExtent(image.data(), loaded);
+
+            if (needed > loaded)
+            {
+               if (needed > image.size()) { throw ReadFailureException(image.filename()); }
+
+               load_headers(image, std::max(needed, extent + LazyImage::PageSize), then);
+               return;
+            }
+
+            // everything is present, so validation errors are real
+            image.image().section_table();
+         }
+         catch (...) {
+            fail(then, std::current_exception());
+            return;
+         }
+
+         auto pe = image.image();
+         then(pe, nullptr);
+      });
+   }
+
+   /// Load every range, then call the continuation with the first error any of them failed with.
+   void
+   load_ranges
+   (LazyImage &image, const std::set<Range> &ranges, LazyImage::Continuation continuation)
+   {
+      if (ranges.empty()) { image.load(0, 0, continuation); return; }
+
+      auto remaining = std::make_shared<std::size_t>(ranges.size());
+      auto first_error = std::make_shared<std::exception_ptr>();
+
+      for (auto &range : ranges)
+      {
+         image.load(range.first, range.second - range.first, [remaining, first_error, continuation] (std::exception_ptr error) {
+            if (error && !*first_error) { *first_error = error; }
+            if (--*remaining == 0) { continuation(*first_error); }
+         });
+      }
+   }
+
+   /// Get the file range of the raw data of the section holding *rva*, or of the page holding it if
+   /// it's in the headers.
+   std::optional<Range>
+   section_range
+   (const PE &pe, std::uint32_t rva)
+   {
+      auto section_table = pe.section_table();
+
+      for (std::size_t i=0; i<section_table.size(); ++i)
+      {
+         auto &section = section_table.get(i);
+         auto extent = std::max(section.Misc.VirtualSize, section.SizeOfRawData);
+
+         if (rva >= section.VirtualAddress && rva - section.VirtualAddress < extent)
+         {
+            if (section.SizeOfRawData == 0) { return std::nullopt; }
+
+            return std::make_pair(std::size_t(section.PointerToRawData),
+                                  std::size_t(section.PointerToRawData) + section.SizeOfRawData);
+         }
+      }
+
+      if (rva >= pe.size()) { return std::nullopt; }
+
+      auto page = rva - rva % LazyImage::PageSize;
+      return std::make_pair(std::size_t(page), std::size_t(page) + LazyImage::PageSize);
+   }
+
+   /// Visit each import descriptor of an image whose import directory is loaded, with the RVA of its
+   /// lookup table.
+   template <typename Visitor>
+   void
+   for_each_descriptor
+   (const PE &pe, Visitor visit)
+   {
+      auto data_directory = pe.data_directory();
+      if (!data_directory.has_directory(pe, headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT)) { return; }
+
+      auto &entry = data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT);
+      if (entry.VirtualAddress == 0) { return; }
+
+      for (std::uint32_t descriptor_rva = entry.VirtualAddress, descriptors = 0;
+           ;
+           descriptor_rva += sizeof(headers::raw::IMAGE_IMPORT_DESCRIPTOR), ++descriptors)
+      {
+         ParseBudget::Step(ParseBudget::Structure::IMPORT_DESCRIPTORS, descriptors, sizeof(headers::raw::IMAGE_IMPORT_DESCRIPTOR));
+
+         auto descriptor_offset = RVA(descriptor_rva).as_memory(pe);
+         auto &descriptor = pe.cast_ref<headers::raw::IMAGE_IMPORT_DESCRIPTOR>(descriptor_offset);
+         if (descriptor.Name == 0 || descriptor.FirstThunk == 0) { break; }
+
+         // as in ImportResolver::ImportList, the lookup table is the descriptor's first field
+         auto lookup_rva = pe.cast_ref<std::uint32_t>(descriptor_offset);
+         if (lookup_rva == 0) { lookup_rva = descriptor.FirstThunk; }
+
+         visit(descriptor, lookup_rva);
+      }
+   }
+
+   /// Get the ranges holding the module names and thunk arrays of an image whose import directory is
+   /// loaded.
+   std::set<Range>
+   descriptor_ranges
+   (const PE &pe)
+   {
+      auto result = std::set<Range>();
+
+      for_each_descriptor(pe, [&pe, &result] (const headers::raw::IMAGE_IMPORT_DESCRIPTOR &descriptor, std::uint32_t lookup_rva) {
+         for (auto rva : {descriptor.Name, lookup_rva})
+         {
+            auto range = section_range(pe, rva);
+            if (range.has_value()) { result.insert(*range); }
+         }
+      });
+
+      return result;
+   }
+
+   /// Get the ranges holding the imported names of an image whose thunk arrays are loaded.
+   std::set<Range>
+   name_ranges
+   (const PE &pe)
+   {
+      auto result = std::set<Range>();
+      auto is_32 = pe.valid_nt_headers().is_32();
+      std::size_t thunk_size = (is_32) ? sizeof(std::uint32_t) : sizeof(std::uint64_t);
+
+      for_each_descriptor(pe, [&] (const headers::raw::IMAGE_IMPORT_DESCRIPTOR &, std::uint32_t lookup_rva) {
+         for (std::uint32_t i=0; ; ++i)
+         {
+            ParseBudget::Step(ParseBudget::Structure::IMPORT_THUNKS, i, thunk_size);
+
+            auto thunk_rva = static_cast<std::uint32_t>(lookup_rva + i * thunk_size);
+            std::uint64_t value;
+            bool by_ordinal;
+
+            if (is_32)
+            {
+               value = pe.cast_ref<std::uint32_t>(RVA(thunk_rva).as_memory(pe));
+               by_ordinal = (value & headers::raw::IMAGE_ORDINAL_FLAG32) != 0;
+            }
+            else
+            {
+               value = pe.cast_ref<std::uint64_t>(RVA(thunk_rva).as_memory(pe));
+               by_ordinal = (value & headers::raw::IMAGE_ORDINAL_FLAG64) != 0;
+            }
+
+            if (value == 0) { break; }
+            if (by_ordinal) { continue; }
+
+            auto range = section_range(pe, static_cast<std::uint32_t>(value));
+            if (range.has_value()) { result.insert(*range); }
+         }
+      });
+
+      return result;
+   }
+}
+
+LazyImage::LazyImage
+(AsyncParser &parser, const std::string &filename)
+   : parser(&parser),
+     _filename(filename),
+     _size(0),
+     _bytes_loaded(0),
+     _budget(nullptr)
+{
+#ifdef YAPP_WIN32
+   std::error_code error;
+   this->_size = static_cast<std::size_t>(std::filesystem::file_size(filename, error));
+
+   if (error) { throw OpenFileFailureException(filename); }
+#else
+   struct stat info;
+   this->fd = ::open(filename.c_str(), O_RDONLY);
+
+   if (this->fd < 0) { throw OpenFileFailureException(filename); }
+
+   if (fstat(this->fd, &info) != 0)
+   {
+      ::close(this->fd);
+      throw OpenFileFailureException(filename);
+   }
+
+   this->_size = static_cast<std::size_t>(info.st_size);
+#endif
+
+   this->buffer.resize(this->_size, 0);
+   this->pages.resize((this->_size + LazyImage::PageSize - 1) / LazyImage::PageSize, PageState::MISSING);
+}
+
+LazyImage::~LazyImage
+()
+{
+#ifndef YAPP_WIN32
+   ::close(this->fd);
+#endif
+}
+
+bool
+LazyImage::pages_loaded
+(std::size_t first_page, std::size_t last_page) const
+{
+   for (auto page=first_page; page<last_page; ++page)
+      if (this->pages[page] != PageState::LOADED) { return false; }
+
+   return true;
+}
+
+bool
+LazyImage::loaded
+(std::size_t offset, std::size_t size) const
+{
+   if (offset >= this->_size || size == 0) { return true; }
+
+   auto end = offset + std::min(size, this->_size - offset);
+
+   return this->pages_loaded(offset / LazyImage::PageSize, (end + LazyImage::PageSize - 1) / LazyImage::PageSize);
+}
+
+PE
+LazyImage::image
+()
+{
+   return PE(Memory<std::uint8_t>(this->buffer.data(), this->buffer.size()));
+}
+
+void
+LazyImage::load
+(std::size_t offset, std::size_t size, Continuation continuation)
+{
+   // every parse shares the loop's thread, so the image's budget has to be installed each time it resumes
+   if (this->_budget != nullptr)
+   {
+      auto budget = this->_budget;
+
+      continuation = [budget, continuation = std::move(continuation)] (std::exception_ptr error) {
+         ParseBudget::Scope scope(*budget);
+         continuation(error);
+      };
+   }
+
+   if (this->_error)
+   {
+      auto error = this->_error;
+      this->parser->post([continuation, error] () { continuation(error); });
+      return;
+   }
+
+   if (this->loaded(offset, size))
+   {
+      this->parser->post([continuation] () { continuation(nullptr); });
+      return;
+   }
+
+   auto end = offset + std::min(size, this->_size - offset);
+   auto first_page = offset / LazyImage::PageSize;
+   auto last_page = (end + LazyImage::PageSize - 1) / LazyImage::PageSize;
+
+   // read each run of missing pages at once; pages already loading are covered by an earlier read
+   for (auto page=first_page; page<last_page; ++page)
+   {
+      if (this->pages[page] != PageState::MISSING) { continue; }
+
+      auto run_end = page;
+
+      while (run_end < last_page && this->pages[run_end] == PageState::MISSING)
+         this->pages[run_end++] = PageState::LOADING;
+
+      auto read = FileRead();
+      read.offset = page * LazyImage::PageSize;
+      read.size = std::min(run_end * LazyImage::PageSize, this->_size) - read.offset;
+#ifdef YAPP_WIN32
+      read.filename = this->_filename;
+#else
+      read.fd = this->fd;
+#endif
+      read.buffer = this->buffer.data() + read.offset;
+      read.result = 0;
+      read.context = this;
+
+      this->reads.push_back(read);
+      this->parser->submit(&this->reads.back());
+
+      page = run_end;
+   }
+
+   this->waiters.push_back(Waiter{first_page, last_page, continuation});
+}
+
+void
+LazyImage::complete
+(FileRead *read)
+{
+   if (read->result > 0)
+   {
+      auto amount = static_cast<std::size_t>(read->result);
+      auto end = read->offset + amount;
+      this->_bytes_loaded += amount;
+
+      // a page is loaded once the read passes its end, or the end of the file
+      auto last_page = (end == this->_size) ? this->pages.size() : end / LazyImage::PageSize;
+
+      for (auto page=read->offset / LazyImage::PageSize; page<last_page; ++page)
+         this->pages[page] = PageState::LOADED;
+
+      // a short read isn't an error, the rest just has to be asked for again
+      if (amount < read->size)
+      {
+         read->buffer += amount;
+         read->offset += amount;
+         read->size -= amount;
+         this->parser->submit(read);
+         return;
+      }
+   }
+   else if (!this->_error) { this->_error = std::make_exception_ptr(ReadFailureException(this->_filename)); }
+
+   for (auto iter=this->reads.begin(); iter!=this->reads.end(); ++iter)
+   {
+      if (&*iter != read) { continue; }
+
+      this->reads.erase(iter);
+      break;
+   }
+
+   for (auto iter=this->waiters.begin(); iter!=this->waiters.end();)
+   {
+      if (!this->_error && !this->pages_loaded(iter->first_page, iter->last_page)) { ++iter; continue; }
+
+      auto continuation = std::move(iter->continuation);
+      auto error = this->_error;
+
+      this->parser->post([continuation, error] () { continuation(error); });
+      iter = this->waiters.erase(iter);
+   }
+}
+
+AsyncParser::AsyncParser
+(std::size_t depth, Backend backend, std::size_t threads)
+   : queue(ReadQueue::Create(ReadQueue::Select(backend), std::max<std::size_t>(depth, 1), threads)),
+     in_flight(0),
+     _reads(0),
+     _bytes_read(0)
+{
+}
+
+AsyncParser::~AsyncParser
+()
+{
+#ifdef YAPP_COROUTINES
+   this->tasks.clear();
+#endif
+   this->ready.clear();
+
+   // stop the reads in flight before the images they read into are freed
+   this->queue.reset();
+}
+
+void
+AsyncParser::submit
+(FileRead *read)
+{
+   this->pending.push_back(read);
+}
+
+LazyImage &
+AsyncParser::open
+(const std::string &filename)
+{
+   this->images.emplace_back(*this, filename);
+   return this->images.back();
+}
+
+void
+AsyncParser::close
+(LazyImage &image)
+{
+   for (auto iter=this->images.begin(); iter!=this->images.end(); ++iter)
+   {
+      if (&*iter != &image) { continue; }
+
+      this->images.erase(iter);
+      return;
+   }
+}
+
+void
+AsyncParser::post
+(std::function<void()> task)
+{
+   this->ready.push_back(std::move(task));
+}
+
+void
+AsyncParser::run
+()
+{
+   while (true)
+   {
+      while (!this->ready.empty())
+      {
+         auto task = std::move(this->ready.front());
+         this->ready.pop_front();
+         task();
+      }
+
+#ifdef YAPP_COROUTINES
+      for (auto iter=this->tasks.begin(); iter!=this->tasks.end();)
+      {
+         if (!iter->done()) { ++iter; continue; }
+
+         try { iter->result(); }
+         catch (...) { if (!this->task_error) { this->task_error = std::current_exception(); } }
+
+         iter = this->tasks.erase(iter);
+      }
+#endif
+
+      while (!this->pending.empty() && this->in_flight < this->queue->capacity())
+      {
+         this->queue->submit(this->pending.front());
+         this->pending.pop_front();
+         ++this->in_flight;
+         ++this->_reads;
+      }
+
+      if (this->in_flight == 0) { break; }
+
+      this->queue->flush();
+
+      auto read = this->queue->wait();
+      --this->in_flight;
+
+      if (read->result > 0) { this->_bytes_read += static_cast<std::size_t>(read->result); }
+
+      static_cast<LazyImage *>(read->context)->complete(read);
+   }
+
+#ifdef YAPP_COROUTINES
+   if (this->task_error) { std::rethrow_exception(std::exchange(this->task_error, nullptr)); }
+#endif
+}
+
+void
+AsyncParser::headers
+(LazyImage &image, Callback then)
+{
+   load_headers(image, LazyImage::PageSize, then);
+}
+
+void
+AsyncParser::directory
+(LazyImage &image, std::size_t index, Callback then)
+{
+   this->headers(image, [&image, index, then] (PE &pe, std::exception_ptr error) {
+      if (error) { then(pe, error); return; }
+
+      std::optional<Range> range;
+
+      try { range = pe.directory_file_range(index); }
+      catch (...) { fail(then, std::current_exception()); return; }
+
+      if (!range.has_value() || range->first >= image.size()) { then(pe, nullptr); return; }
+
+      image.load(range->first, range->second - range->first, [&image, then] (std::exception_ptr error) {
+         if (error) { fail(then, error); return; }
+
+         auto pe = image.image();
+         then(pe, nullptr);
+      });
+   });
+}
+
+void
+AsyncParser::imports
+(LazyImage &image, ImportsCallback then)
+{
+   this->directory(image, headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT, [&image, then] (PE &pe, std::exception_ptr error) {
+      if (error) { fail(then, error); return; }
+
+      std::set<Range> ranges;
+
+      try { ranges = descriptor_ranges(pe); }
+      catch (...) { fail(then, std::current_exception()); return; }
+
+      load_ranges(image, ranges, [&image, then] (std::exception_ptr error) {
+         if (error) { fail(then, error); return; }
+
+         std::set<Range> ranges;
+
+         try { ranges = name_ranges(image.image()); }
+         catch (...) { fail(then, std::current_exception()); return; }
+
+         load_ranges(image, ranges, [&image, then] (std::exception_ptr error) {
+            if (error) { fail(then, error); return; }
+
+            std::vector<Import> imports;
+
+            try { imports = ImportResolver::ImportList(image.image()); }
+            catch (...) { fail(then, std::current_exception()); return; }
+
+            then(imports, nullptr);
+         });
+      });
+   });
+}
+
+#ifdef YAPP_COROUTINES
+void
+AsyncParser::spawn
+(Task<void> task)
+{
+   this->tasks.push_back(std::move(task));
+
+   auto spawned = &this->tasks.back();
+   this->post([spawned] () { spawned->start(); });
+}
+#endif
@@ -0,0 +1,183 @@
+#include <yapp.hpp>
+
+#include <cstring>
+
+using namespace yapp;
+
+namespace
+{
+   std::string_view
+   short_name
+   (const std::uint8_t *name, std::size_t size)
+   {
+      auto chars = reinterpret_cast<const char *>(name);
+      auto end = static_cast<const char *>(std::memchr(chars, 0, size));
+
+      return std::string_view(chars, (end == nullptr) ? size : end - chars);
+   }
+
+   /* offsets too big for seven decimal digits are written as "//" and six base64 digits, most
+      significant first */
+   std::optional<std::uint32_t>
+   long_name_offset
+   (std::string_view digits)
+   {
+      std::uint64_t offset = 0;
+
+      if (digits.size() > 1 && digits[0] == '/')
+      {
+         digits.remove_prefix(1);
+         if (digits.empty() || digits.size() > 6) { return std::nullopt; }
+
+         for (auto c : digits)
+         {
+            std::uint32_t value;
+
+            if (c >= 'A' && c <= 'Z') { value = c - 'A'; }
+            else if (c >= 'a' && c <= 'z') { value = c - 'a' + 26; }
+            else if (c >= '0' && c <= '9') { value = c - '0' + 52; }
+            else if (c == '+') { value = 62; }
+            else if (c == '/') { value = 63; }
+            else { return std::nullopt; }
+
+            offset = offset * 64 + value;
+         }
+      }
+      else
+      {
+         if (digits.empty() || digits.size() > 7) { return std::nullopt; }
+
+         for (auto c : digits)
+         {
+            if (c < '0' || c > '9') { return std::nullopt; }
+
+            offset = offset * 10 + (c - '0');
+         }
+      }
+
+      if (offset > 0xFFFFFFFF) { return std::nullopt; }
+
+      return static_cast<std::uint32_t>(offset);
+   }
+}
+
+const Memory<headers::raw::IMAGE_RELOCATION>
+COFFObject::relocations
+(const headers::SectionHeader &section) const
+{
+   std::size_t offset = section->PointerToRelocations;
+   std::size_t count = section->NumberOfRelocations;
+
+   if (count == 0) { return Memory<headers::raw::IMAGE_RELOCATION>(); }
+
+   if ((section->Characteristics & headers::raw::IMAGE_SCN_LNK_NRELOC_OVFL) != 0 && count == 0xFFFF)
+   {
+      // the real count is in the first record, and counts that record too
+      count = this->cast_ref<headers::raw::IMAGE_RELOCATION>(offset).RelocCount;
+      if (count == 0) { throw InvalidObjectException(offset); }
+
+      offset += sizeof(headers::raw::IMAGE_RELOCATION);
+      --count;
+
+      if (count == 0) { return Memory<headers::raw::IMAGE_RELOCATION>(); }
+   }
+
+   return this->subsection<headers::raw::IMAGE_RELOCATION>(offset, count);
+}
+
+Span<const char>
+COFFObject::string_table
+() const
+{
+   auto header = this->valid_file_header();
+   if (header->PointerToSymbolTable == 0) { return Span<const char>(); }
+
+   auto start = std::size_t(header->PointerToSymbolTable) + std::size_t(header->NumberOfSymbols) * sizeof(headers::raw::IMAGE_SYMBOL);
+
+   // objects without long names may end right after the symbol table
+   if (start == this->size()) { return Span<const char>(); }
+   if (start > this->size() || this->size() - start < sizeof(std::uint32_t))
+      throw OutOfBoundsException(start + sizeof(std::uint32_t), this->size());
+
+   std::uint32_t size;
+   std::memcpy(&size, this->ptr() + start, sizeof(size));
+
+   // some writers leave the size of an empty table as zero
+   if (size < sizeof(std::uint32_t)) { size = sizeof(std::uint32_t); }
+   if (this->size() - start < size) { throw OutOfBoundsException(start + size, this->size()); }
+
+   return Span<const char>(reinterpret_cast<const char *>(this->ptr() + start), size);
+}
+
+std::string_view
+COFFObject::StringAt
+(Span<const char> strings, std::uint32_t offset)
+{
+   // offsets count the size at the start of the table, so none can point into it
+   if (offset < sizeof(std::uint32_t) || offset >= strings.size()) { throw OutOfBoundsException(offset, strings.size()); }
+
+   auto string = strings.data() + offset;
+   auto end = static_cast<const char *>(std::memchr(string, 0, strings.size() - offset));
+
+   return std::string_view(string, (end == nullptr) ? strings.end() - string : end - string);
+}
+
+std::string_view
+COFFObject::string_at
+(std::uint32_t offset) const
+{
+   return COFFObject::StringAt(this->string_table(), offset);
+}
+
+std::string_view
+COFFObject::SymbolName
+(const headers::raw::IMAGE_SYMBOL &symbol, Span<const char> strings)
+{
+   if (symbol.N.Name.Short == 0) { return COFFObject::StringAt(strings, symbol.N.Name.Long); }
+
+   return short_name(&symbol.N.ShortName[0], sizeof(symbol.N.ShortName));
+}
+
+std::string_view
+COFFObject::symbol_name
+(const headers::raw::IMAGE_SYMBOL &symbol) const
+{
+   if (symbol.N.Name.Short == 0) { return COFFObject::StringAt(this->string_table(), symbol.N.Name.Long); }
+
+   return short_name(&symbol.N.ShortName[0], sizeof(symbol.N.ShortName));
+}
+
+std::string_view
+COFFObject::section_name
+(const headers::SectionHeader &section) const
+{
+   auto name = short_name(&section->Name[0], headers::raw::IMAGE_SIZEOF_SHORT_NAME);
+   if (name.size() < 2 || name[0] != '/') { return name; }
+
+   auto offset = long_name_offset(name.substr(1));
+
+   if (!offset.has_value())
+      throw InvalidObjectException(reinterpret_cast<const std::uint8_t *>(section.ptr()) - this->ptr());
+
+   return this->string_at(*offset);
+}
+
+std::optional<std::size_t>
+COFFObject::find_symbol
+(std::string_view name) const
+{
+   const auto table = this->symbol_table();
+   if (table.size() == 0) { return std::nullopt; }
+
+   auto strings = this->string_table();
+   auto symbols = table.ptr();
+
+   for (std::size_t index=0; index<table.size(); index += 1 + symbols[index].NumberOfAuxSymbols)
+   {
+      // short names can't match anything longer than eight characters, so skip reading them
+      if (symbols[index].N.Name.Short != 0 && name.size() > sizeof(symbols[index].N.ShortName)) { continue; }
+      if (COFFObject::SymbolName(symbols[index], strings) == name) { return index; }
+   }
+
+   return std::nullopt;
+}
@@ -0,0 +1,578 @@
+#include <yapp.hpp>
+
+#include <cmath>
+
+using namespace yapp;
+
+namespace
+{
+   using headers::Field;
+
+   // columns are a selection of each structure's fields, looked up in its field table at compile time
+#define YAPP_RAW_FIELD(type, field) headers::Fields<type>::Get(#field)
+
+   constexpr Field FileHeaderFields[] = {
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, Machine),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, NumberOfSections),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, TimeDateStamp),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, PointerToSymbolTable),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, NumberOfSymbols),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, SizeOfOptionalHeader),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_FILE_HEADER, Characteristics),
+   };
+
+   // both optional header lists name the same fields in the same order; columns take the 64-bit widths
+#define YAPP_OPTIONAL_FIELDS(type) {             \
+      YAPP_RAW_FIELD(type, Magic),               \
+      YAPP_RAW_FIELD(type, MajorLinkerVersion),  \
+      YAPP_RAW_FIELD(type, MinorLinkerVersion),  \
+      YAPP_RAW_FIELD(type, SizeOfCode),          \
+      YAPP_RAW_FIELD(type, AddressOfEntryPoint), \
+      YAPP_RAW_FIELD(type, ImageBase),           \
+      YAPP_RAW_FIELD(type, SectionAlignment),    \
+      YAPP_RAW_FIELD(type, FileAlignment),       \
+      YAPP_RAW_FIELD(type, MajorOperatingSystemVersion), \
+      YAPP_RAW_FIELD(type, MajorSubsystemVersion), \
+      YAPP_RAW_FIELD(type, SizeOfImage),         \
+      YAPP_RAW_FIELD(type, SizeOfHeaders),       \
+      YAPP_RAW_FIELD(type, CheckSum),            \
+      YAPP_RAW_FIELD(type, Subsystem),           \
+      YAPP_RAW_FIELD(type, DllCharacteristics),  \
+      YAPP_RAW_FIELD(type, SizeOfStackReserve),  \
+      YAPP_RAW_FIELD(type, NumberOfRvaAndSizes), \
+   }
+
+   constexpr Field OptionalHeader32Fields[] = YAPP_OPTIONAL_FIELDS(headers::raw::IMAGE_OPTIONAL_HEADER32);
+   constexpr Field OptionalHeader64Fields[] = YAPP_OPTIONAL_FIELDS(headers::raw::IMAGE_OPTIONAL_HEADER64);
+
+   constexpr Field SectionFields[] = {
+      YAPP_RAW_FIELD(headers::raw::IMAGE_SECTION_HEADER, VirtualSize),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_SECTION_HEADER, VirtualAddress),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_SECTION_HEADER, SizeOfRawData),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_SECTION_HEADER, PointerToRawData),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_SECTION_HEADER, NumberOfRelocations),
+      YAPP_RAW_FIELD(headers::raw::IMAGE_SECTION_HEADER, Characteristics),
+   };
+
+#undef YAPP_OPTIONAL_FIELDS
+#undef YAPP_RAW_FIELD
+
+   static_assert(sizeof(OptionalHeader32Fields) == sizeof(OptionalHeader64Fields),
+                 "Optional header field lists differ in length.");
+
+   ColumnTable::ColumnType
+   integer_type
+   (std::size_t size)
+   {
+      switch (size)
+      {
+      case 1: { return ColumnTable::UINT8; }
+      case 2: { return ColumnTable::UINT16; }
+      case 4: { return ColumnTable::UINT32; }
+      default: { return ColumnTable::UINT64; }
+      }
+   }
+
+   double
+   entropy
+   (const std::uint8_t *data, std::size_t size)
+   {
+      if (size == 0) { return 0.0; }
+
+      std::size_t counts[256] = {0};
+
+      for (std::size_t i=0; i<size; ++i) { ++counts[data[i]]; }
+
+      double result = 0.0;
+
+      for (auto count : counts)
+      {
+         if (count == 0) { continue; }
+
+         auto probability = double(count) / size;
+         result -= probability * std::log2(probability);
+      }
+
+      return result;
+   }
+
+   void
+   write_integer
+   (std::ostream &stream, std::uint64_t value, std::size_t width)
+   {
+      for (std::size_t i=0; i<width; ++i)
+         stream.put(static_cast<char>((value >> (i * 8)) & 0xFF));
+   }
+
+   void
+   write_string
+   (std::ostream &stream, const std::string &value)
+   {
+      write_integer(stream, value.size(), sizeof(std::uint32_t));
+      stream.write(value.data(), value.size());
+   }
+
+   std::uint64_t
+   read_integer
+   (std::istream &stream, std::size_t width)
+   {
+      std::uint8_t bytes[8];
+
+      if (!stream.read(reinterpret_cast<char *>(bytes), width))
+         throw InvalidColumnarFileException(static_cast<std::size_t>(stream.tellg()));
+
+      std::uint64_t value = 0;
+
+      for (std::size_t i=0; i<width; ++i) { value |= std::uint64_t(bytes[i]) << (i * 8); }
+
+      return value;
+   }
+
+   std::string
+   read_string
+   (std::istream &stream)
+   {
+      auto offset = static_cast<std::size_t>(stream.tellg());
+      auto size = read_integer(stream, sizeof(std::uint32_t));
+      auto result = std::string();
+
+      // read in bounded chunks so a corrupt length can't force a huge allocation up front
+      while (result.size() < size)
+      {
+         char buffer[0x1000];
+         auto amount = std::min<std::uint64_t>(sizeof(buffer), size - result.size());
+
+         if (!stream.read(buffer, amount)) { throw InvalidColumnarFileException(offset); }
+
+         result.append(buffer, amount);
+      }
+
+      return result;
+   }
+}
+
+std::size_t
+ColumnTable::Width
+(ColumnType type)
+{
+   switch (type)
+   {
+   case ColumnType::UINT8: { return 1; }
+   case ColumnType::UINT16: { return 2; }
+   case ColumnType::UINT32: { return 4; }
+   case ColumnType::DICTIONARY: { return 4; }
+   default: { return 8; }
+   }
+}
+
+ColumnTable::ColumnTable
+(const std::string &name)
+   : _name(name),
+     _rows(0)
+{
+}
+
+std::size_t
+ColumnTable::add_column
+(const std::string &name, ColumnType type)
+{
+   if (this->_rows != 0) { throw IncompleteRowException(this->_columns.size()); }
+
+   this->_columns.push_back(Column{name, type, std::vector<std::uint8_t>(), std::vector<std::string>(), std::map<std::string, std::uint32_t>()});
+
+   return this->_columns.size()-1;
+}
+
+std::size_t
+ColumnTable::add_fields
+(Span<const headers::Field> fields, const std::string &prefix)
+{
+   auto first = this->_columns.size();
+
+   for (auto &field : fields)
+   {
+      if (field.kind == Field::BYTES)
+      {
+         this->add_column(prefix + field.name, ColumnTable::DICTIONARY);
+         continue;
+      }
+
+      for (std::size_t i=0; i<field.count; ++i)
+      {
+         auto name = prefix + field.name;
+         if (field.count > 1) { name += "[" + std::to_string(i) + "]"; }
+
+         if (field.kind == Field::STRUCTURE) { this->add_fields(field.members(), name + "."); }
+         else { this->add_column(name, integer_type(field.element_size())); }
+      }
+   }
+
+   return first;
+}
+
+std::size_t
+ColumnTable::column_index
+(const std::string &name) const
+{
+   for (std::size_t i=0; i<this->_columns.size(); ++i)
+      if (this->_columns[i].name == name) { return i; }
+
+   throw ColumnNotFoundException(name);
+}
+
+void
+ColumnTable::append
+(std::size_t column, std::uint64_t value)
+{
+   if (column >= this->_columns.size()) { throw OutOfBoundsException(column, this->_columns.size()); }
+
+   auto &entry = this->_columns[column];
+
+   for (std::size_t i=0; i<ColumnTable::Width(entry.type); ++i)
+      entry.data.push_back(static_cast<std::uint8_t>((value >> (i * 8)) & 0xFF));
+}
+
+void
+ColumnTable::append
+(std::size_t column, double value)
+{
+   std::uint64_t bits;
+   std::memcpy(&bits, &value, sizeof(bits));
+
+   this->append(column, bits);
+}
+
+void
+ColumnTable::append
+(std::size_t column, const std::string &value)
+{
+   if (column >= this->_columns.size()) { throw OutOfBoundsException(column, this->_columns.size()); }
+
+   auto &entry = this->_columns[column];
+   auto iter = entry.codes.find(value);
+   std::uint32_t code;
+
+   if (iter != entry.codes.end()) { code = iter->second; }
+   else
+   {
+      code = static_cast<std::uint32_t>(entry.dictionary.size());
+      entry.dictionary.push_back(value);
+      entry.codes[value] = code;
+   }
+
+   this->append(column, std::uint64_t(code));
+}
+
+std::size_t
+ColumnTable::append_fields
+(std::size_t column, Span<const headers::Field> fields, const std::uint8_t *data)
+{
+   for (auto &field : fields)
+   {
+      if (field.kind == Field::BYTES)
+      {
+         auto start = reinterpret_cast<const char *>(data + field.offset);
+         auto end = std::find(start, start + field.size, 0);
+
+         this->append(column++, std::string(start, end));
+         continue;
+      }
+
+      for (std::size_t i=0; i<field.count; ++i)
+      {
+         if (field.kind == Field::STRUCTURE)
+            column = this->append_fields(column, field.members(), data + field.offset + i * field.element_size());
+         else
+            this->append(column++, headers::read_field(field, data, i));
+      }
+   }
+
+   return column;
+}
+
+void
+ColumnTable::end_row
+()
+{
+   for (std::size_t i=0; i<this->_columns.size(); ++i)
+   {
+      auto &column = this->_columns[i];
+
+      if (column.data.size() != (this->_rows + 1) * ColumnTable::Width(column.type))
+         throw IncompleteRowException(i);
+   }
+
+   ++this->_rows;
+}
+
+std::uint64_t
+ColumnTable::integer
+(std::size_t column, std::size_t row) const
+{
+   if (column >= this->_columns.size()) { throw OutOfBoundsException(column, this->_columns.size()); }
+   if (row >= this->_rows) { throw OutOfBoundsException(row, this->_rows); }
+
+   auto &entry = this->_columns[column];
+   auto width = ColumnTable::Width(entry.type);
+   std::uint64_t value = 0;
+
+   for (std::size_t i=0; i<width; ++i)
+      value |= std::uint64_t(entry.data[row * width + i]) << (i * 8);
+
+   return value;
+}
+
+double
+ColumnTable::number
+(std::size_t column, std::size_t row) const
+{
+   auto bits = this->integer(column, row);
+   double value;
+
+   std::memcpy(&value, &bits, sizeof(value));
+
+   return value;
+}
+
+const std::string &
+ColumnTable::string
+(std::size_t column, std::size_t row) const
+{
+   auto code = this->integer(column, row);
+   auto &dictionary = this->_columns[column].dictionary;
+
+   if (code >= dictionary.size()) { throw OutOfBoundsException(code, dictionary.size()); }
+
+   return dictionary[code];
+}
+
+void
+ColumnTable::write
+(std::ostream &stream) const
+{
+   write_string(stream, this->_name);
+   write_integer(stream, this->_rows, sizeof(std::uint64_t));
+   write_integer(stream, this->_columns.size(), sizeof(std::uint32_t));
+
+   for (auto &column : this->_columns)
+   {
+      write_string(stream, column.name);
+      write_integer(stream, column.type, sizeof(std::uint8_t));
+
+      if (column.type == ColumnType::DICTIONARY)
+      {
+         write_integer(stream, column.dictionary.size(), sizeof(std::uint32_t));
+
+         for (auto &value : column.dictionary) { write_string(stream, value); }
+      }
+
+      // the values are already little-endian, so they go out as-is
+      stream.write(reinterpret_cast<const char *>(column.data.data()), column.data.size());
+   }
+}
+
+ColumnTable
+ColumnTable::Read
+(std::istream &stream)
+{
+   auto result = ColumnTable(read_string(stream));
+   auto rows = read_integer(stream, sizeof(std::uint64_t));
+   auto columns = read_integer(stream, sizeof(std::uint32_t));
+
+   for (std::uint64_t i=0; i<columns; ++i)
+   {
+      auto name = read_string(stream);
+      auto offset = static_cast<std::size_t>(stream.tellg());
+      auto type = read_integer(stream, sizeof(std::uint8_t));
+
+      if (type > ColumnType::DICTIONARY) { throw InvalidColumnarFileException(offset); }
+
+      auto index = result.add_column(name, static_cast<ColumnType>(type));
+      auto &column = result._columns[index];
+
+      if (column.type == ColumnType::DICTIONARY)
+      {
+         auto entries = read_integer(stream, sizeof(std::uint32_t));
+
+         for (std::uint64_t j=0; j<entries; ++j)
+         {
+            column.dictionary.push_back(read_string(stream));
+            column.codes[column.dictionary.back()] = static_cast<std::uint32_t>(j);
+         }
+      }
+
+      offset = static_cast<std::size_t>(stream.tellg());
+
+      auto width = ColumnTable::Width(column.type);
+
+      // grow with the data actually read, so a corrupt row count fails on the read rather than the allocation
+      for (std::uint64_t row=0; row<rows; ++row)
+      {
+         std::uint8_t value[8];
+
+         if (!stream.read(reinterpret_cast<char *>(value), width)) { throw InvalidColumnarFileException(offset); }
+
+         column.data.insert(column.data.end(), value, value + width);
+      }
+
+      if (column.type == ColumnType::DICTIONARY)
+      {
+         for (std::uint64_t row=0; row<rows; ++row)
+         {
+            std::uint32_t code;
+            std::memcpy(&code, column.data.data() + row * width, sizeof(code));
+
+            if (code >= column.dictionary.size()) { throw InvalidColumnarFileException(offset); }
+         }
+      }
+   }
+
+   result._rows = static_cast<std::size_t>(rows);
+
+   return result;
+}
+
+const char CorpusExporter::Magic[8] = {'Y','A','P','P','C','O','L','S'};
+
+CorpusExporter::CorpusExporter
+()
+   : _images("images"),
+     _sections("sections"),
+     _imports("imports")
+{
+   this->_images.add_column("Name", ColumnTable::DICTIONARY);
+   this->_images.add_column("FileSize", ColumnTable::UINT64);
+
+   for (auto &field : FileHeaderFields)
+      this->_images.add_column(field.name, integer_type(field.size));
+
+   for (auto &field : OptionalHeader64Fields)
+      this->_images.add_column(field.name, integer_type(field.size));
+
+   this->_sections.add_column("image", ColumnTable::UINT64);
+   this->_sections.add_column("Name", ColumnTable::DICTIONARY);
+
+   for (auto &field : SectionFields)
+      this->_sections.add_column(field.name, integer_type(field.size));
+
+   this->_sections.add_column("Entropy", ColumnTable::FLOAT64);
+
+   this->_imports.add_column("image", ColumnTable::UINT64);
+   this->_imports.add_column("Module", ColumnTable::DICTIONARY);
+   this->_imports.add_column("Functions", ColumnTable::UINT32);
+}
+
+void
+CorpusExporter::add
+(const PE &pe, const std::string &name)
+{
+   auto nt_headers = pe.valid_nt_headers();
+   auto section_table = pe.section_table();
+   auto import_list = ImportResolver::ImportList(pe);
+
+   const void *optional_header;
+   const Field *optional_fields;
+
+   if (nt_headers.is_32())
+   {
+      optional_header = nt_headers.get_32().optional_header().ptr();
+      optional_fields = OptionalHeader32Fields;
+   }
+   else
+   {
+      optional_header = nt_headers.get_64().optional_header().ptr();
+      optional_fields = OptionalHeader64Fields;
+   }
+
+   // count imports per module in the order the modules first appear
+   auto modules = std::vector<std::pair<std::string, std::uint32_t>>();
+
+   for (auto &import : import_list)
+   {
+      auto module = ExportIndex::NormalizeModule(import.module);
+
+      if (modules.empty() || modules.back().first != module) { modules.push_back(std::make_pair(module, 0)); }
+
+      ++modules.back().second;
+   }
+
+   // everything which can throw has been read, so the tables can't be left with a partial row
+   auto image = std::uint64_t(this->_images.rows());
+   std::size_t column = 0;
+
+   this->_images.append(column++, name);
+   this->_images.append(column++, std::uint64_t(pe.size()));
+
+   for (auto &field : FileHeaderFields)
+      this->_images.append(column++, headers::read_field(field, reinterpret_cast<const std::uint8_t *>(nt_headers.file_header().ptr())));
+
+   for (std::size_t i=0; i<std::size(OptionalHeader64Fields); ++i)
+      this->_images.append(column++, headers::read_field(optional_fields[i], static_cast<const std::uint8_t *>(optional_header)));
+
+   this->_images.end_row();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto section = section_table[i];
+      auto &raw = section_table.get(i);
+      auto start = std::min<std::size_t>(raw.PointerToRawData, pe.size());
+      auto end = std::min<std::size_t>(std::size_t(raw.PointerToRawData) + raw.SizeOfRawData, pe.size());
+
+      column = 0;
+      this->_sections.append(column++, image);
+      this->_sections.append(column++, section.name_string());
+
+      for (auto &field : SectionFields)
+         this->_sections.append(column++, headers::read_field(field, reinterpret_cast<const std::uint8_t *>(&raw)));
+
+      this->_sections.append(column++, entropy(pe.ptr() + start, end - start));
+      this->_sections.end_row();
+   }
+
+   for (auto &module : modules)
+   {
+      this->_imports.append(0, image);
+      this->_imports.append(1, module.first);
+      this->_imports.append(2, std::uint64_t(module.second));
+      this->_imports.end_row();
+   }
+}
+
+void
+CorpusExporter::write
+(const std::string &filename) const
+{
+   std::ofstream fp(filename, std::ios::binary);
+   if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
+   fp.write(CorpusExporter::Magic, sizeof(CorpusExporter::Magic));
+   write_integer(fp, 3, sizeof(std::uint32_t));
+
+   this->_images.write(fp);
+   this->_sections.write(fp);
+   this->_imports.write(fp);
+
+   if (!fp) { throw WriteFailureException(filename); }
+
+   fp.close();
+}
+
+std::vector<ColumnTable>
+CorpusExporter::Read
+(const std::string &filename)
+{
+   std::ifstream fp(filename, std::ios::binary);
+   if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
+   char magic[sizeof(CorpusExporter::Magic)];
+
+   if (!fp.read(magic, sizeof(magic)) || std::memcmp(magic, CorpusExporter::Magic, sizeof(magic)) != 0)
+      throw InvalidColumnarFileException(0);
+
+   auto count = read_integer(fp, sizeof(std::uint32_t));
+   auto result = std::vector<ColumnTable>();
+
+   for (std::uint64_t i=0; i<count; ++i) { result.push_back(ColumnTable::Read(fp)); }
+
+   return result;
+}
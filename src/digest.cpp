@@ -0,0 +1,162 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+namespace
+{
+   const std::uint32_t RoundConstants[64] = {
+      0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+      0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+      0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+      0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+      0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+      0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+      0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+      0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+   };
+
+   inline std::uint32_t
+   rotr
+   (std::uint32_t value, int count)
+   {
+      return (value >> count) | (value << (32 - count));
+   }
+
+   inline std::uint32_t
+   load_be32
+   (const std::uint8_t *data)
+   {
+      return (std::uint32_t(data[0]) << 24) | (std::uint32_t(data[1]) << 16)
+         | (std::uint32_t(data[2]) << 8) | std::uint32_t(data[3]);
+   }
+
+   inline void
+   store_be32
+   (std::uint8_t *data, std::uint32_t value)
+   {
+      data[0] = static_cast<std::uint8_t>(value >> 24);
+      data[1] = static_cast<std::uint8_t>(value >> 16);
+      data[2] = static_cast<std::uint8_t>(value >> 8);
+      data[3] = static_cast<std::uint8_t>(value);
+   }
+}
+
+Sha256::Sha256
+()
+{
+   this->reset();
+}
+
+Sha256::Digest
+Sha256::Hash
+(Span<const std::uint8_t> data)
+{
+   auto hash = Sha256();
+
+   hash.update(data);
+
+   return hash.finish();
+}
+
+void
+Sha256::reset
+()
+{
+   const std::uint32_t initial[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+                                     0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+   std::memcpy(this->state, initial, sizeof(this->state));
+   this->buffered = 0;
+   this->length = 0;
+}
+
+void
+Sha256::compress
+(const std::uint8_t *data)
+{
+   std::uint32_t schedule[64];
+
+   for (std::size_t i=0; i<16; ++i) { schedule[i] = load_be32(data + i * 4); }
+
+   for (std::size_t i=16; i<64; ++i)
+   {
+      auto s0 = rotr(schedule[i-15], 7) ^ rotr(schedule[i-15], 18) ^ (schedule[i-15] >> 3);
+      auto s1 = rotr(schedule[i-2], 17) ^ rotr(schedule[i-2], 19) ^ (schedule[i-2] >> 10);
+      schedule[i] = schedule[i-16] + s0 + schedule[i-7] + s1;
+   }
+
+   auto a = this->state[0], b = this->state[1], c = this->state[2], d = this->state[3];
+   auto e = this->state[4], f = this->state[5], g = this->state[6], h = this->state[7];
+
+   for (std::size_t i=0; i<64; ++i)
+   {
+      auto t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + RoundConstants[i] + schedule[i];
+      auto t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+      h = g; g = f; f = e; e = d + t1;
+      d = c; c = b; b = a; a = t1 + t2;
+   }
+
+   this->state[0] += a; this->state[1] += b; this->state[2] += c; this->state[3] += d;
+   this->state[4] += e; this->state[5] += f; this->state[6] += g; this->state[7] += h;
+}
+
+void
+Sha256::update
+(Span<const std::uint8_t> data)
+{
+   auto bytes = data.data();
+   auto size = data.size();
+
+   this->length += size;
+
+   if (this->buffered != 0)
+   {
+      auto count = sizeof(this->block) - this->buffered;
+      if (count > size) { count = size; }
+
+      std::memcpy(this->block + this->buffered, bytes, count);
+      this->buffered += count;
+      bytes += count;
+      size -= count;
+
+      if (this->buffered < sizeof(this->block)) { return; }
+
+      this->compress(this->block);
+      this->buffered = 0;
+   }
+
+   // whole blocks are compressed straight from the input
+   for (; size >= sizeof(this->block); bytes += sizeof(this->block), size -= sizeof(this->block))
+      this->compress(bytes);
+
+   if (size != 0) { std::memcpy(this->block, bytes, size); }
+   this->buffered = size;
+}
+
+Sha256::Digest
+Sha256::finish
+()
+{
+   auto bits = this->length * 8;
+
+   this->block[this->buffered++] = 0x80;
+
+   if (this->buffered > 56)
+   {
+      std::memset(this->block + this->buffered, 0, sizeof(this->block) - this->buffered);
+      this->compress(this->block);
+      this->buffered = 0;
+   }
+
+   std::memset(this->block + this->buffered, 0, 56 - this->buffered);
+   store_be32(this->block + 56, static_cast<std::uint32_t>(bits >> 32));
+   store_be32(this->block + 60, static_cast<std::uint32_t>(bits));
+   this->compress(this->block);
+
+   auto digest = Digest();
+
+   for (std::size_t i=0; i<8; ++i) { store_be32(digest.data() + i * 4, this->state[i]); }
+
+   return digest;
+}
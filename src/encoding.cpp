@@ -0,0 +1,400 @@
+#include <yapp.hpp>
+
+#include <array>
+
+#ifdef YAPP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef YAPP_SSSE3
+#include <tmmintrin.h>
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   const char LowerDigits[] = "0123456789abcdef";
+   const char UpperDigits[] = "0123456789ABCDEF";
+   const char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+   const std::uint8_t Invalid = 0xFF;
+
+   constexpr std::array<std::uint8_t, 256>
+   hex_values
+   ()
+   {
+      auto result = std::array<std::uint8_t, 256>();
+
+      for (std::size_t i=0; i<result.size(); ++i) { result[i] = Invalid; }
+      for (std::uint8_t i=0; i<10; ++i) { result['0'+i] = i; }
+      for (std::uint8_t i=0; i<6; ++i) { result['a'+i] = 10+i; result['A'+i] = 10+i; }
+
+      return result;
+   }
+
+   constexpr std::array<std::uint8_t, 256>
+   base64_values
+   ()
+   {
+      auto result = std::array<std::uint8_t, 256>();
+
+      for (std::size_t i=0; i<result.size(); ++i) { result[i] = Invalid; }
+      for (std::uint8_t i=0; i<64; ++i) { result[static_cast<std::uint8_t>(Alphabet[i])] = i; }
+
+      return result;
+   }
+
+   constexpr auto HexValues = hex_values();
+   constexpr auto Base64Values = base64_values();
+
+   inline std::uint8_t
+   value_of
+   (const std::array<std::uint8_t, 256> &values, char c)
+   {
+      return values[static_cast<std::uint8_t>(c)];
+   }
+
+   void
+   check_output
+   (std::size_t needed, std::size_t size)
+   {
+      if (needed > size) { throw OutOfBoundsException(needed, size); }
+   }
+
+#ifdef YAPP_SSE2
+   /// Convert nibbles to hex digits; *letters* is the distance from '0'+10 to the first letter digit.
+   inline __m128i
+   hex_digits
+   (__m128i nibbles, __m128i letters)
+   {
+      auto is_letter = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+
+      return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), _mm_and_si128(is_letter, letters));
+   }
+
+   /// Encode 16 bytes into 32 hex digits.
+   inline void
+   hex_encode_16
+   (const std::uint8_t *input, char *output, __m128i letters)
+   {
+      auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+      auto mask = _mm_set1_epi8(0x0F);
+      auto high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+      auto low = _mm_and_si128(bytes, mask);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(output), hex_digits(_mm_unpacklo_epi8(high, low), letters));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 16), hex_digits(_mm_unpackhi_epi8(high, low), letters));
+   }
+
+   /// Convert 16 hex digits to their values, setting *valid* to all ones for every byte which was a digit.
+   inline __m128i
+   hex_values_16
+   (const char *input, __m128i &valid)
+   {
+      auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+      auto zero = _mm_setzero_si128();
+
+      // anything below '0' wraps around, so one unsigned comparison checks both ends of each range
+      auto digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+      auto is_digit = _mm_cmpeq_epi8(_mm_subs_epu8(digit, _mm_set1_epi8(9)), zero);
+      auto letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+      auto is_letter = _mm_cmpeq_epi8(_mm_subs_epu8(letter, _mm_set1_epi8(5)), zero);
+
+      valid = _mm_or_si128(is_digit, is_letter);
+
+      return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                          _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+   }
+
+   /// Decode 32 hex digits into 16 bytes, returning false without writing if any isn't a digit.
+   inline bool
+   hex_decode_32
+   (const char *input, std::uint8_t *output)
+   {
+      __m128i first_valid, second_valid;
+      auto first = hex_values_16(input, first_valid);
+      auto second = hex_values_16(input + 16, second_valid);
+
+      if (_mm_movemask_epi8(_mm_and_si128(first_valid, second_valid)) != 0xFFFF) { return false; }
+
+      // each 16-bit lane holds a high nibble in its low byte and a low nibble in its high byte
+      auto low_bytes = _mm_set1_epi16(0x00FF);
+      first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, low_bytes), 4), _mm_srli_epi16(first, 8));
+      second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, low_bytes), 4), _mm_srli_epi16(second, 8));
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_packus_epi16(first, second));
+
+      return true;
+   }
+#endif
+
+#ifdef YAPP_SSSE3
+   /// Encode the first 12 of 16 readable bytes into 16 base64 characters.
+   inline void
+   base64_encode_12
+   (const std::uint8_t *input, char *output)
+   {
+      auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+
+      // spread each group of three bytes over a 32-bit lane, then shift each 6-bit index into its own byte
+      bytes = _mm_shuffle_epi8(bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+      auto first = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+      auto second = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+      auto indices = _mm_or_si128(first, second);
+
+      // map each index range (A-Z, a-z, 0-9, +, /) to the offset taking it to its character
+      auto range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+      range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+
+      auto offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range)));
+   }
+
+   /// Decode 16 base64 characters into 12 bytes, returning false without writing if any is invalid.
+   inline bool
+   base64_decode_16
+   (const char *input, std::uint8_t *output)
+   {
+      auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+      auto nibble = _mm_set1_epi8(0x0F);
+      auto high = _mm_and_si128(_mm_srli_epi32(chars, 4), nibble);
+      auto low = _mm_and_si128(chars, nibble);
+
+      // a character is valid when the bit for its high nibble is set in the mask for its low nibble
+      auto masks = _mm_setr_epi8(char(0xA8), char(0xF8), char(0xF8), char(0xF8), char(0xF8), char(0xF8),
+                                 char(0xF8), char(0xF8), char(0xF8), char(0xF8), char(0xF0), char(0x54),
+                                 char(0x50), char(0x50), char(0x50), char(0x54));
+      auto bits = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, char(0x80), 0, 0, 0, 0, 0, 0, 0, 0);
+      auto matched = _mm_and_si128(_mm_shuffle_epi8(masks, low), _mm_shuffle_epi8(bits, high));
+
+      // characters at or above 0x80 index past the bit table with their top bit set, which yields zero
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(matched, _mm_setzero_si128())) != 0) { return false; }
+
+      // every valid character shares an offset to its value with the others of its high nibble, except '/'
+      auto offsets = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+      auto is_slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+      auto shift = _mm_or_si128(_mm_andnot_si128(is_slash, _mm_shuffle_epi8(offsets, high)),
+                                _mm_and_si128(is_slash, _mm_set1_epi8(16)));
+      auto values = _mm_add_epi8(chars, shift);
+
+      // pack four 6-bit values per 32-bit lane into three bytes, then gather the bytes in order
+      auto pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+      auto lanes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+      auto packed = _mm_shuffle_epi8(lanes, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+      std::uint8_t buffer[16];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), packed);
+      std::memcpy(output, buffer, 12);
+
+      return true;
+   }
+#endif
+
+   /// Decode one group of four base64 characters, which may end in padding only if it's *last*.
+   std::size_t
+   base64_decode_group
+   (const char *input, std::uint8_t *output, std::size_t offset, bool last)
+   {
+      std::size_t padding = 0;
+
+      if (last && input[3] == '=') { padding = (input[2] == '=') ? 2 : 1; }
+
+      std::uint8_t values[4] = {0, 0, 0, 0};
+
+      for (std::size_t i=0; i<4-padding; ++i)
+      {
+         values[i] = value_of(Base64Values, input[i]);
+         if (values[i] == Invalid) { throw InvalidEncodingException(offset + i); }
+      }
+
+      output[0] = static_cast<std::uint8_t>((values[0] << 2) | (values[1] >> 4));
+      if (padding < 2) { output[1] = static_cast<std::uint8_t>((values[1] << 4) | (values[2] >> 2)); }
+      if (padding < 1) { output[2] = static_cast<std::uint8_t>((values[2] << 6) | values[3]); }
+
+      return 3 - padding;
+   }
+}
+
+std::size_t
+Hex::Encode
+(Span<const std::uint8_t> input, Span<char> output, bool uppercase)
+{
+   check_output(Hex::EncodedSize(input.size()), output.size());
+
+   auto digits = uppercase ? UpperDigits : LowerDigits;
+   auto in = input.data();
+   auto out = output.data();
+   std::size_t i = 0;
+
+#ifdef YAPP_SSE2
+   auto letters = _mm_set1_epi8(uppercase ? 'A' - '0' - 10 : 'a' - '0' - 10);
+
+   for (; i+16 <= input.size(); i+=16)
+      hex_encode_16(in + i, out + i * 2, letters);
+#endif
+
+   for (; i<input.size(); ++i)
+   {
+      out[i * 2] = digits[in[i] >> 4];
+      out[i * 2 + 1] = digits[in[i] & 0xF];
+   }
+
+   return Hex::EncodedSize(input.size());
+}
+
+std::size_t
+Hex::Decode
+(Span<const char> input, Span<std::uint8_t> output)
+{
+   if (input.size() % 2 != 0) { throw InvalidEncodingException(input.size()); }
+
+   auto size = Hex::DecodedSize(input.size());
+   check_output(size, output.size());
+
+   auto in = input.data();
+   auto out = output.data();
+   std::size_t i = 0;
+
+#ifdef YAPP_SSE2
+   // a block with a bad digit is left to the scalar loop, which finds where it is
+   for (; i+16 <= size; i+=16)
+      if (!hex_decode_32(in + i * 2, out + i)) { break; }
+#endif
+
+   for (; i<size; ++i)
+   {
+      auto high = value_of(HexValues, in[i * 2]);
+      auto low = value_of(HexValues, in[i * 2 + 1]);
+
+      if (high == Invalid) { throw InvalidEncodingException(i * 2); }
+      if (low == Invalid) { throw InvalidEncodingException(i * 2 + 1); }
+
+      out[i] = static_cast<std::uint8_t>((high << 4) | low);
+   }
+
+   return size;
+}
+
+std::string
+Hex::ToString
+(Span<const std::uint8_t> input, bool uppercase)
+{
+   auto result = std::string(Hex::EncodedSize(input.size()), '\0');
+   Hex::Encode(input, Span<char>(result), uppercase);
+
+   return result;
+}
+
+std::vector<std::uint8_t>
+Hex::ToBytes
+(Span<const char> input)
+{
+   auto result = std::vector<std::uint8_t>(Hex::DecodedSize(input.size()));
+   Hex::Decode(input, Span<std::uint8_t>(result));
+
+   return result;
+}
+
+std::size_t
+Base64::DecodedSize
+(Span<const char> input)
+{
+   auto size = Base64::DecodedSize(input.size());
+   if (size == 0 || input.size() % 4 != 0) { return size; }
+
+   if (input[input.size()-1] == '=') { --size; }
+   if (input[input.size()-2] == '=') { --size; }
+
+   return size;
+}
+
+std::size_t
+Base64::Encode
+(Span<const std::uint8_t> input, Span<char> output)
+{
+   auto size = Base64::EncodedSize(input.size());
+   check_output(size, output.size());
+
+   auto in = input.data();
+   auto out = output.data();
+   std::size_t i = 0, o = 0;
+
+#ifdef YAPP_SSSE3
+   // each block reads 16 bytes but only encodes 12
+   for (; i+16 <= input.size(); i+=12, o+=16)
+      base64_encode_12(in + i, out + o);
+#endif
+
+   for (; i+3 <= input.size(); i+=3, o+=4)
+   {
+      std::uint32_t group = (std::uint32_t(in[i]) << 16) | (std::uint32_t(in[i+1]) << 8) | in[i+2];
+
+      out[o] = Alphabet[(group >> 18) & 0x3F];
+      out[o+1] = Alphabet[(group >> 12) & 0x3F];
+      out[o+2] = Alphabet[(group >> 6) & 0x3F];
+      out[o+3] = Alphabet[group & 0x3F];
+   }
+
+   if (i < input.size())
+   {
+      std::uint32_t group = std::uint32_t(in[i]) << 16;
+      if (i+1 < input.size()) { group |= std::uint32_t(in[i+1]) << 8; }
+
+      out[o] = Alphabet[(group >> 18) & 0x3F];
+      out[o+1] = Alphabet[(group >> 12) & 0x3F];
+      out[o+2] = (i+1 < input.size()) ? Alphabet[(group >> 6) & 0x3F] : '=';
+      out[o+3] = '=';
+   }
+
+   return size;
+}
+
+std::size_t
+Base64::Decode
+(Span<const char> input, Span<std::uint8_t> output)
+{
+   if (input.size() % 4 != 0) { throw InvalidEncodingException(input.size()); }
+   if (input.empty()) { return 0; }
+
+   auto size = Base64::DecodedSize(input);
+   check_output(size, output.size());
+
+   auto in = input.data();
+   auto out = output.data();
+   auto last = input.size() - 4;
+   std::size_t i = 0, o = 0;
+
+#ifdef YAPP_SSSE3
+   // the last group may be padded, so it's always left to the scalar loop, as is any block with a bad character
+   for (; i+16 <= last; i+=16, o+=12)
+      if (!base64_decode_16(in + i, out + o)) { break; }
+#endif
+
+   for (; i<=last; i+=4)
+      o += base64_decode_group(in + i, out + o, i, i == last);
+
+   return o;
+}
+
+std::string
+Base64::ToString
+(Span<const std::uint8_t> input)
+{
+   auto result = std::string(Base64::EncodedSize(input.size()), '\0');
+   Base64::Encode(input, Span<char>(result));
+
+   return result;
+}
+
+std::vector<std::uint8_t>
+Base64::ToBytes
+(Span<const char> input)
+{
+   auto result = std::vector<std::uint8_t>(Base64::DecodedSize(input));
+   Base64::Decode(input, Span<std::uint8_t>(result));
+
+   return result;
+}
@@ -7,6 +7,8 @@ InvalidOffsetException::InvalidOffsetException
    : offset(*offset),
      Exception()
 {
+   YAPP_COUNT_EXCEPTION();
+
    std::stringstream stream;
 
    stream << "Offset " << std::hex << std::showbase << this->offset
@@ -20,6 +22,8 @@ InvalidRVAException::InvalidRVAException
    : rva(*rva),
      Exception()
 {
+   YAPP_COUNT_EXCEPTION();
+
    std::stringstream stream;
 
    stream << "RVA " << std::hex << std::showbase << this->rva
@@ -33,6 +37,8 @@ InvalidVAException::InvalidVAException
    : va(*va),
      Exception()
 {
+   YAPP_COUNT_EXCEPTION();
+
    std::stringstream stream;
 
    stream << "VA " << std::hex << std::showbase << this->va
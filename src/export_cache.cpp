@@ -0,0 +1,192 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+std::unique_ptr<ExportIndexCache> ExportIndexCache::Instance;
+std::once_flag ExportIndexCache::InstanceFlag;
+
+ExportIndexCache::ExportIndexCache
+(std::size_t budget)
+   : _budget(budget),
+     _usage(0),
+     _hits(0),
+     _misses(0)
+{
+}
+
+ExportIndexCache &
+ExportIndexCache::GetInstance
+()
+{
+   // workers share the instance from many threads, so creation has to be race-free
+   std::call_once(ExportIndexCache::InstanceFlag, [] () {
+      ExportIndexCache::Instance = std::unique_ptr<ExportIndexCache>(new ExportIndexCache());
+   });
+
+   return *ExportIndexCache::Instance;
+}
+
+ExportIndexCache::Key
+ExportIndexCache::IdentityKey
+(const PE &pe, const std::string &module)
+{
+   auto nt_headers = pe.valid_nt_headers();
+   std::uint32_t image_size;
+
+   if (nt_headers.is_32()) { image_size = nt_headers.get_32().optional_header()->SizeOfImage; }
+   else { image_size = nt_headers.get_64().optional_header()->SizeOfImage; }
+
+   return Key{ExportIndex::NormalizeModule(module), nt_headers.file_header()->TimeDateStamp, image_size, 0};
+}
+
+ExportIndexCache::Key
+ExportIndexCache::ContentKey
+(const PE &pe)
+{
+   // 64-bit FNV-1a
+   std::uint64_t hash = 0xCBF29CE484222325ULL;
+   auto bytes = pe.ptr();
+
+   for (std::size_t i=0; i<pe.size(); ++i)
+   {
+      hash ^= bytes[i];
+      hash *= 0x100000001B3ULL;
+   }
+
+   return Key{std::string(), 0, 0, hash};
+}
+
+void
+ExportIndexCache::evict
+()
+{
+   // the most recently cached index is kept even if it alone is over budget
+   while (this->_usage > this->_budget && this->entries.size() > 1)
+   {
+      auto &entry = this->entries.back();
+
+      this->_usage -= entry.size;
+      this->lookup.erase(entry.key);
+      this->entries.pop_back();
+   }
+}
+
+std::size_t
+ExportIndexCache::budget
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->_budget;
+}
+
+void
+ExportIndexCache::set_budget
+(std::size_t budget)
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   this->_budget = budget;
+   this->evict();
+}
+
+std::size_t
+ExportIndexCache::usage
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->_usage;
+}
+
+std::size_t
+ExportIndexCache::size
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->entries.size();
+}
+
+std::size_t
+ExportIndexCache::hits
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->_hits;
+}
+
+std::size_t
+ExportIndexCache::misses
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->_misses;
+}
+
+std::shared_ptr<const ExportIndex>
+ExportIndexCache::find
+(const Key &key)
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   auto iter = this->lookup.find(key);
+
+   if (iter == this->lookup.end())
+   {
+      ++this->_misses;
+      return nullptr;
+   }
+
+   ++this->_hits;
+
+   // move the entry to the front of the list, marking it most recently used
+   this->entries.splice(this->entries.begin(), this->entries, iter->second);
+
+   return iter->second->index;
+}
+
+std::shared_ptr<const ExportIndex>
+ExportIndexCache::insert
+(const Key &key, std::shared_ptr<const ExportIndex> index)
+{
+   if (index == nullptr) { throw NullPointerException(); }
+
+   std::lock_guard<std::mutex> lock(this->mutex);
+   auto iter = this->lookup.find(key);
+
+   if (iter != this->lookup.end())
+   {
+      this->entries.splice(this->entries.begin(), this->entries, iter->second);
+      return iter->second->index;
+   }
+
+   auto size = index->memory_usage();
+
+   this->entries.push_front(Entry{key, index, size});
+   this->lookup[key] = this->entries.begin();
+   this->_usage += size;
+   this->evict();
+
+   return index;
+}
+
+std::shared_ptr<const ExportIndex>
+ExportIndexCache::get
+(const PE &pe, const std::string &module, bool by_content)
+{
+   auto key = (by_content) ? ExportIndexCache::ContentKey(pe) : ExportIndexCache::IdentityKey(pe, module);
+   auto index = this->find(key);
+
+   if (index != nullptr) { return index; }
+
+   // build outside of the lock so that indexing one module doesn't stall lookups of others
+   return this->insert(key, std::make_shared<const ExportIndex>(pe, module));
+}
+
+void
+ExportIndexCache::clear
+()
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   this->lookup.clear();
+   this->entries.clear();
+   this->_usage = 0;
+}
@@ -0,0 +1,124 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+ExportIndex::ExportIndex
+(const PE &pe, const std::string &module)
+   : _module(ExportIndex::NormalizeModule(module)),
+     _timestamp(0),
+     _image_size(0)
+{
+   YAPP_TIME_DIRECTORY(headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT);
+
+   auto nt_headers = pe.valid_nt_headers();
+   this->_timestamp = nt_headers.file_header()->TimeDateStamp;
+
+   if (nt_headers.is_32()) { this->_image_size = nt_headers.get_32().optional_header()->SizeOfImage; }
+   else { this->_image_size = nt_headers.get_64().optional_header()->SizeOfImage; }
+
+   auto data_directory = pe.data_directory();
+   if (!data_directory.has_directory(pe, headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT)) { return; }
+
+   auto &entry = data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT);
+   if (entry.VirtualAddress == 0) { return; }
+
+   // computed in 64 bits, since a directory whose end passes 4 GiB would wrap and hide its forwarders
+   auto directory_start = std::uint64_t(entry.VirtualAddress);
+   auto directory_end = directory_start + entry.Size;
+   auto &directory = pe.cast_ref<headers::raw::IMAGE_EXPORT_DIRECTORY>(RVA(entry.VirtualAddress).as_memory(pe));
+
+   auto read_u32 = [&pe] (std::uint32_t rva) { return pe.cast_ref<std::uint32_t>(RVA(rva).as_memory(pe)); };
+   auto read_u16 = [&pe] (std::uint32_t rva) { return pe.cast_ref<std::uint16_t>(RVA(rva).as_memory(pe)); };
+   auto read_string = [&pe] (std::uint32_t rva) { return ParseBudget::ReadString(pe, RVA(rva).as_memory(pe)); };
+
+   if (this->_module.empty() && directory.Name != 0)
+      this->_module = ExportIndex::NormalizeModule(read_string(directory.Name));
+
+   // export address table entries are 32-bit RVAs on both 32-bit and 64-bit images
+   auto function_index = std::map<std::uint32_t, std::size_t>();
+
+   for (std::uint32_t i=0; i<directory.NumberOfFunctions; ++i)
+   {
+      ParseBudget::Step(ParseBudget::Structure::EXPORT_FUNCTIONS, i, sizeof(std::uint32_t));
+
+      auto rva = read_u32(directory.AddressOfFunctions + i * sizeof(std::uint32_t));
+      if (rva == 0) { continue; }
+
+      auto export_entry = Export{directory.Base + i, rva, std::string(), std::string()};
+
+      // an address within the export directory is a forwarder string rather than code
+      if (rva >= directory_start && rva < directory_end) { export_entry.forwarder = read_string(rva); }
+
+      function_index[i] = this->_exports.size();
+      this->by_ordinal[export_entry.ordinal] = this->_exports.size();
+      this->_exports.push_back(std::move(export_entry));
+   }
+
+   for (std::uint32_t i=0; i<directory.NumberOfNames; ++i)
+   {
+      ParseBudget::Step(ParseBudget::Structure::EXPORT_NAMES, i, sizeof(std::uint32_t) + sizeof(std::uint16_t));
+
+      auto name_rva = read_u32(directory.AddressOfNames + i * sizeof(std::uint32_t));
+      auto index = read_u16(directory.AddressOfNameOrdinals + i * sizeof(std::uint16_t));
+      auto iter = function_index.find(index);
+
+      if (iter == function_index.end()) { continue; }
+
+      auto &export_entry = this->_exports[iter->second];
+      export_entry.name = read_string(name_rva);
+      this->by_name[export_entry.name] = iter->second;
+   }
+}
+
+std::size_t
+ExportIndex::memory_usage
+() const
+{
+   // map nodes carry a few pointers of bookkeeping on top of their value
+   const std::size_t node_overhead = 4 * sizeof(void *);
+
+   auto result = sizeof(ExportIndex) + this->_module.capacity();
+   result += this->_exports.capacity() * sizeof(Export);
+
+   for (auto &export_entry : this->_exports)
+      result += export_entry.name.capacity() + export_entry.forwarder.capacity();
+
+   for (auto &entry : this->by_name)
+      result += node_overhead + sizeof(entry) + entry.first.capacity();
+
+   result += this->by_ordinal.size() * (node_overhead + sizeof(std::pair<const std::uint32_t, std::size_t>));
+
+   return result;
+}
+
+const ExportIndex::Export *
+ExportIndex::lookup
+(const std::string &name) const
+{
+   auto iter = this->by_name.find(name);
+   if (iter == this->by_name.end()) { return nullptr; }
+
+   return &this->_exports[iter->second];
+}
+
+const ExportIndex::Export *
+ExportIndex::lookup
+(std::uint32_t ordinal) const
+{
+   auto iter = this->by_ordinal.find(ordinal);
+   if (iter == this->by_ordinal.end()) { return nullptr; }
+
+   return &this->_exports[iter->second];
+}
+
+std::string
+ExportIndex::NormalizeModule
+(const std::string &name)
+{
+   auto result = name;
+
+   for (auto &c : result)
+      if (c >= 'A' && c <= 'Z') { c = static_cast<char>(c - 'A' + 'a'); }
+
+   return result;
+}
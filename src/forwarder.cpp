@@ -0,0 +1,156 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+namespace
+{
+   struct ApiSetEntry
+   {
+      std::string_view contract;
+      std::string_view host;
+   };
+
+   // contracts without their "-lN-N-N" version suffix, mapped to their host on current Windows 10/11.
+   // an entry ending in '-' matches every contract starting with it.
+   const ApiSetEntry ApiSetTable[] = {
+      { "api-ms-win-core-apiquery", "ntdll.dll" },
+      { "api-ms-win-core-com", "combase.dll" },
+      { "api-ms-win-core-console", "kernelbase.dll" },
+      { "api-ms-win-core-datetime", "kernelbase.dll" },
+      { "api-ms-win-core-debug", "kernelbase.dll" },
+      { "api-ms-win-core-delayload", "kernelbase.dll" },
+      { "api-ms-win-core-errorhandling", "kernelbase.dll" },
+      { "api-ms-win-core-fibers", "kernelbase.dll" },
+      { "api-ms-win-core-file", "kernelbase.dll" },
+      { "api-ms-win-core-handle", "kernelbase.dll" },
+      { "api-ms-win-core-heap", "kernelbase.dll" },
+      { "api-ms-win-core-interlocked", "kernelbase.dll" },
+      { "api-ms-win-core-io", "kernelbase.dll" },
+      { "api-ms-win-core-libraryloader", "kernelbase.dll" },
+      { "api-ms-win-core-localization", "kernelbase.dll" },
+      { "api-ms-win-core-memory", "kernelbase.dll" },
+      { "api-ms-win-core-namedpipe", "kernelbase.dll" },
+      { "api-ms-win-core-processenvironment", "kernelbase.dll" },
+      { "api-ms-win-core-processthreads", "kernelbase.dll" },
+      { "api-ms-win-core-profile", "kernelbase.dll" },
+      { "api-ms-win-core-registry", "kernelbase.dll" },
+      { "api-ms-win-core-rtlsupport", "ntdll.dll" },
+      { "api-ms-win-core-string", "kernelbase.dll" },
+      { "api-ms-win-core-synch", "kernelbase.dll" },
+      { "api-ms-win-core-sysinfo", "kernelbase.dll" },
+      { "api-ms-win-core-threadpool", "kernelbase.dll" },
+      { "api-ms-win-core-timezone", "kernelbase.dll" },
+      { "api-ms-win-core-util", "kernelbase.dll" },
+      { "api-ms-win-core-winrt", "combase.dll" },
+      { "api-ms-win-crt-", "ucrtbase.dll" },
+      { "api-ms-win-eventing-provider", "kernelbase.dll" },
+      { "api-ms-win-security-base", "kernelbase.dll" },
+      { "api-ms-win-security-lsalookup", "sechost.dll" },
+      { "api-ms-win-service-core", "sechost.dll" },
+      { "api-ms-win-service-management", "sechost.dll" },
+   };
+
+   char
+   lower
+   (char c)
+   {
+      return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+   }
+
+   bool
+   starts_with
+   (std::string_view string, std::string_view prefix)
+   {
+      if (string.size() < prefix.size()) { return false; }
+
+      for (std::size_t i=0; i<prefix.size(); ++i)
+         if (lower(string[i]) != prefix[i]) { return false; }
+
+      return true;
+   }
+
+   bool
+   is_digit
+   (char c)
+   {
+      return c >= '0' && c <= '9';
+   }
+
+   std::string_view
+   strip_version
+   (std::string_view module)
+   {
+      // strip a trailing ".dll", then a trailing "-lN-N-N"
+      if (module.size() > 4 && starts_with(module.substr(module.size()-4), ".dll"))
+         module = module.substr(0, module.size()-4);
+
+      auto index = module.rfind("-l");
+
+      if (index == std::string_view::npos || index+2 >= module.size() || !is_digit(module[index+2]))
+         return module;
+
+      for (auto c : module.substr(index+2))
+         if (!is_digit(c) && c != '-') { return module; }
+
+      return module.substr(0, index);
+   }
+}
+
+std::optional<Forwarder>
+Forwarder::Parse
+(std::string_view string) noexcept
+{
+   auto dot = string.rfind('.');
+
+   if (dot == std::string_view::npos || dot == 0 || dot+1 == string.size()) { return std::nullopt; }
+
+   auto result = Forwarder{string.substr(0, dot), string.substr(dot+1), std::nullopt};
+
+   if (result.name[0] != '#') { return result; }
+
+   auto digits = result.name.substr(1);
+   std::uint64_t ordinal = 0;
+
+   if (digits.empty()) { return std::nullopt; }
+
+   for (auto c : digits)
+   {
+      if (!is_digit(c)) { return std::nullopt; }
+
+      ordinal = ordinal * 10 + static_cast<std::uint64_t>(c - '0');
+      if (ordinal > 0xFFFFFFFF) { return std::nullopt; }
+   }
+
+   result.name = std::string_view();
+   result.ordinal = static_cast<std::uint32_t>(ordinal);
+
+   return result;
+}
+
+bool
+yapp::IsApiSet
+(std::string_view module) noexcept
+{
+   return starts_with(module, "api-ms-") || starts_with(module, "ext-ms-");
+}
+
+std::string_view
+yapp::NormalizeApiSet
+(std::string_view module) noexcept
+{
+   if (!IsApiSet(module)) { return module; }
+
+   auto contract = strip_version(module);
+
+   for (auto &entry : ApiSetTable)
+   {
+      if (entry.contract.back() == '-')
+      {
+         if (starts_with(contract, entry.contract)) { return entry.host; }
+      }
+      else if (contract.size() == entry.contract.size() && starts_with(contract, entry.contract))
+         return entry.host;
+   }
+
+   return module;
+}
@@ -34,6 +34,8 @@ yapp::headers::DataDirectory::directory
    static_assert(has_index<T>::value,
                  "Template class must have a DirectoryIndex static variable.");
 
+   YAPP_TIME_DIRECTORY(T::DirectoryIndex);
+
    if (!this->has_directory<T>(pe))
       throw DirectoryUnavailableException(T::DirectoryIndex);
    
@@ -106,6 +108,8 @@ yapp::headers::DataDirectory::directory
    static_assert(has_index<T>::value,
                  "Template class must have a DirectoryIndex static variable.");
 
+   YAPP_TIME_DIRECTORY(T::DirectoryIndex);
+
    if (!this->has_directory<T>(pe))
       throw DirectoryUnavailableException(T::DirectoryIndex);
    
@@ -0,0 +1,89 @@
+#include <yapp.hpp>
+
+#include <iomanip>
+#include <ostream>
+
+using namespace yapp;
+using namespace yapp::headers;
+
+namespace
+{
+   void
+   write_integer
+   (std::ostream &stream, std::uint64_t value)
+   {
+      stream << "0x" << std::hex << std::uppercase << value << std::nouppercase << std::dec;
+   }
+
+   void
+   write_bytes
+   (std::ostream &stream, const std::uint8_t *data, std::size_t size)
+   {
+      stream << '"';
+
+      for (std::size_t i=0; i<size && data[i] != 0; ++i)
+      {
+         if (data[i] >= 0x20 && data[i] < 0x7F && data[i] != '"' && data[i] != '\\') { stream << static_cast<char>(data[i]); }
+         else { stream << "\\x" << std::hex << std::setw(2) << std::setfill('0') << int(data[i]) << std::dec << std::setfill(' '); }
+      }
+
+      stream << '"';
+   }
+}
+
+void
+yapp::headers::dump_fields
+(Span<const Field> fields, const std::uint8_t *data, std::ostream &stream, std::size_t indent)
+{
+   auto prefix = std::string(indent * 3, ' ');
+
+   for (auto &field : fields)
+   {
+      switch (field.kind)
+      {
+      case Field::INTEGER:
+      {
+         stream << prefix << field.name << ": ";
+
+         if (field.count == 1) { write_integer(stream, read_field(field, data)); }
+         else
+         {
+            stream << '[';
+
+            for (std::size_t i=0; i<field.count; ++i)
+            {
+               if (i > 0) { stream << ", "; }
+               write_integer(stream, read_field(field, data, i));
+            }
+
+            stream << ']';
+         }
+
+         stream << std::endl;
+         break;
+      }
+
+      case Field::BYTES:
+      {
+         stream << prefix << field.name << ": ";
+         write_bytes(stream, data + field.offset, field.size);
+         stream << std::endl;
+         break;
+      }
+
+      case Field::STRUCTURE:
+      {
+         for (std::size_t i=0; i<field.count; ++i)
+         {
+            stream << prefix << field.name;
+            if (field.count > 1) { stream << '[' << i << ']'; }
+            stream << ':' << std::endl;
+
+            dump_fields(field.members(), data + field.offset + i * field.element_size(), stream, indent+1);
+         }
+
+         break;
+      }
+      }
+   }
+}
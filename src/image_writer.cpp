@@ -0,0 +1,245 @@
+#include <yapp.hpp>
+
+#ifndef YAPP_WIN32
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace yapp;
+
+ImageWriter::ImageWriter
+()
+   : _size(0)
+{
+}
+
+ImageWriter::ImageWriter
+(const std::string &source)
+   : source(source),
+     _size(0)
+{
+}
+
+void
+ImageWriter::add
+(const std::uint8_t *pointer, std::size_t size)
+{
+   if (size == 0) { return; }
+   if (pointer == nullptr) { throw NullPointerException(); }
+
+   this->_size += size;
+
+   if (this->segments.size() > 0)
+   {
+      auto &previous = this->segments.back();
+
+      if (previous.data != nullptr && &previous.data[previous.size] == pointer)
+      {
+         previous.size += size;
+         return;
+      }
+   }
+
+   this->segments.push_back(Segment{pointer, 0, size});
+}
+
+void
+ImageWriter::add
+(const Memory<std::uint8_t> &memory)
+{
+   this->add(memory.ptr(), memory.byte_size());
+}
+
+void
+ImageWriter::add_source
+(std::size_t offset, std::size_t size)
+{
+   if (!this->source.has_value()) { throw NoSourceFileException(); }
+   if (size == 0) { return; }
+
+   this->_size += size;
+
+   if (this->segments.size() > 0)
+   {
+      auto &previous = this->segments.back();
+
+      if (previous.data == nullptr && previous.source_offset + previous.size == offset)
+      {
+         previous.size += size;
+         return;
+      }
+   }
+
+   this->segments.push_back(Segment{nullptr, offset, size});
+}
+
+#ifdef YAPP_WIN32
+void
+ImageWriter::write
+(const std::string &filename) const
+{
+   std::ofstream fp(filename, std::ios::binary);
+   if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
+   std::ifstream source_fp;
+
+   if (this->source.has_value())
+   {
+      source_fp.open(*this->source, std::ios::binary);
+      if (!source_fp.is_open()) { throw OpenFileFailureException(*this->source); }
+   }
+
+   std::vector<char> buffer(0x10000);
+
+   for (auto &segment : this->segments)
+   {
+      if (segment.data != nullptr)
+      {
+         fp.write(reinterpret_cast<const char *>(segment.data), segment.size);
+         continue;
+      }
+
+      source_fp.seekg(segment.source_offset);
+
+      for (std::size_t copied=0; copied<segment.size;)
+      {
+         auto amount = std::min<std::size_t>(buffer.size(), segment.size - copied);
+
+         if (!source_fp.read(buffer.data(), amount)) { throw WriteFailureException(filename); }
+
+         fp.write(buffer.data(), amount);
+         copied += amount;
+      }
+   }
+
+   if (!fp) { throw WriteFailureException(filename); }
+
+   fp.close();
+}
+#else
+namespace
+{
+   // closes a file descriptor when it leaves scope, so that every throw below releases it
+   struct FileDescriptor
+   {
+      int fd;
+
+      FileDescriptor(int fd) : fd(fd) {}
+      ~FileDescriptor() { if (this->fd >= 0) { close(this->fd); } }
+   };
+
+   void
+   write_vectored
+   (int fd, std::vector<struct iovec> &vectors, const std::string &filename)
+   {
+      std::size_t index = 0;
+
+      while (index < vectors.size())
+      {
+         auto count = std::min<std::size_t>(vectors.size() - index, IOV_MAX);
+         auto written = writev(fd, &vectors[index], static_cast<int>(count));
+
+         if (written < 0)
+         {
+            if (errno == EINTR) { continue; }
+
+            throw WriteFailureException(filename);
+         }
+
+         // a short write leaves us somewhere in the middle of the list, so skip what was written
+         auto left = static_cast<std::size_t>(written);
+
+         while (index < vectors.size() && left >= vectors[index].iov_len)
+            left -= vectors[index++].iov_len;
+
+         if (left > 0)
+         {
+            vectors[index].iov_base = static_cast<std::uint8_t *>(vectors[index].iov_base) + left;
+            vectors[index].iov_len -= left;
+         }
+      }
+
+      vectors.clear();
+   }
+
+   void
+   copy_range
+   (int source_fd, int target_fd, std::size_t offset, std::size_t size, const std::string &filename)
+   {
+      std::size_t copied = 0;
+
+#ifdef __linux__
+      // copy in-kernel if we can, falling back to reading and writing if the filesystems don't support it
+      auto source_offset = static_cast<off_t>(offset);
+
+      while (copied < size)
+      {
+         auto result = copy_file_range(source_fd, &source_offset, target_fd, nullptr, size - copied, 0);
+
+         if (result < 0)
+         {
+            if (errno == EINTR) { continue; }
+            if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) { break; }
+
+            throw WriteFailureException(filename);
+         }
+         else if (result == 0) { throw WriteFailureException(filename); }
+
+         copied += static_cast<std::size_t>(result);
+      }
+#endif
+
+      std::vector<std::uint8_t> buffer(std::min<std::size_t>(size - copied, 0x10000));
+
+      while (copied < size)
+      {
+         auto amount = std::min<std::size_t>(buffer.size(), size - copied);
+         auto result = pread(source_fd, buffer.data(), amount, static_cast<off_t>(offset + copied));
+
+         if (result < 0 && errno == EINTR) { continue; }
+         if (result <= 0) { throw WriteFailureException(filename); }
+
+         auto vectors = std::vector<struct iovec>{ { buffer.data(), static_cast<std::size_t>(result) } };
+         write_vectored(target_fd, vectors, filename);
+
+         copied += static_cast<std::size_t>(result);
+      }
+   }
+}
+
+void
+ImageWriter::write
+(const std::string &filename) const
+{
+   FileDescriptor target(open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+   if (target.fd < 0) { throw OpenFileFailureException(filename); }
+
+   FileDescriptor source(-1);
+
+   if (this->source.has_value())
+   {
+      source.fd = open(this->source->c_str(), O_RDONLY | O_CLOEXEC);
+      if (source.fd < 0) { throw OpenFileFailureException(*this->source); }
+   }
+
+   // consecutive buffers are gathered into one writev call, source ranges flush the batch
+   std::vector<struct iovec> vectors;
+
+   for (auto &segment : this->segments)
+   {
+      if (segment.data != nullptr)
+      {
+         vectors.push_back({ const_cast<std::uint8_t *>(segment.data), segment.size });
+         continue;
+      }
+
+      write_vectored(target.fd, vectors, filename);
+      copy_range(source.fd, target.fd, segment.source_offset, segment.size, filename);
+   }
+
+   write_vectored(target.fd, vectors, filename);
+}
+#endif
@@ -0,0 +1,284 @@
+#include <yapp.hpp>
+
+#include <filesystem>
+
+using namespace yapp;
+
+namespace
+{
+   std::string
+   module_key
+   (const std::string &name)
+   {
+      auto result = ExportIndex::NormalizeModule(name);
+
+      // forwarders name their module without an extension, which the loader takes to be a dll
+      if (result.find('.') == std::string::npos) { result += ".dll"; }
+
+      return result;
+   }
+
+   std::string
+   target_key
+   (const std::string &module, const std::string &name, std::optional<std::uint32_t> ordinal)
+   {
+      if (ordinal.has_value()) { return module + "!#" + std::to_string(*ordinal); }
+
+      return module + "!" + name;
+   }
+}
+
+ImportResolver::ImportResolver
+(const std::string &directory, ExportIndexCache &cache)
+   : cache(cache)
+{
+   std::error_code error;
+   auto iter = std::filesystem::directory_iterator(directory, error);
+
+   if (error) { throw OpenFileFailureException(directory); }
+
+   for (auto &entry : iter)
+   {
+      if (!entry.is_regular_file(error)) { continue; }
+
+      this->modules[module_key(entry.path().filename().string())] = entry.path().string();
+   }
+}
+
+bool
+ImportResolver::has_module
+(const std::string &name) const
+{
+   auto key = module_key(name);
+
+   if (this->modules.find(key) != this->modules.end()) { return true; }
+
+   return IsApiSet(key) && this->modules.find(module_key(std::string(NormalizeApiSet(key)))) != this->modules.end();
+}
+
+std::shared_ptr<const ExportIndex>
+ImportResolver::export_index
+(const std::string &name)
+{
+   auto key = module_key(name);
+   auto module = this->modules.find(key);
+
+   // API set contracts are only stubs on disk, if present at all, so fall back to their host module
+   if (module == this->modules.end() && IsApiSet(key))
+   {
+      key = module_key(std::string(NormalizeApiSet(key)));
+      module = this->modules.find(key);
+   }
+
+   if (module == this->modules.end()) { return nullptr; }
+
+   {
+      std::lock_guard<std::mutex> lock(this->index_mutex);
+      auto iter = this->indices.find(key);
+
+      if (iter != this->indices.end()) { return iter->second; }
+   }
+
+   // load outside of the lock so different modules can be indexed in parallel. if two threads
+   // race on the same module, the first index stored wins and the other is dropped.
+   // the identity key needs only the headers, so the whole module is read only when it isn't cached
+   auto filename = module->second;
+   auto identity = ExportIndexCache::IdentityKey(PE::LoadHeaders(filename), key);
+   auto index = this->cache.find(identity);
+
+   if (index == nullptr)
+   {
+      auto pe = PE(filename);
+      index = this->cache.insert(identity, std::make_shared<const ExportIndex>(pe, key));
+   }
+
+   std::lock_guard<std::mutex> lock(this->index_mutex);
+
+   return this->indices.emplace(key, index).first->second;
+}
+
+ImportResolver::Target
+ImportResolver::resolve_target
+(const std::string &module, const std::string &name, std::optional<std::uint32_t> ordinal)
+{
+   auto key = target_key(module_key(module), name, ordinal);
+
+   {
+      std::lock_guard<std::mutex> lock(this->target_mutex);
+      auto iter = this->targets.find(key);
+
+      if (iter != this->targets.end()) { return iter->second; }
+   }
+
+   auto target = Target{false, module_key(module), name, ordinal.value_or(0), 0, 0};
+
+   while (true)
+   {
+      auto index = this->export_index(target.module);
+      if (index == nullptr) { break; }
+
+      const ExportIndex::Export *export_entry;
+
+      if (ordinal.has_value()) { export_entry = index->lookup(*ordinal); }
+      else { export_entry = index->lookup(target.name); }
+
+      if (export_entry == nullptr) { break; }
+
+      target.module = index->module();
+      target.name = export_entry->name;
+      target.ordinal = export_entry->ordinal;
+
+      if (!export_entry->is_forwarded())
+      {
+         target.resolved = true;
+         target.rva = export_entry->rva;
+         break;
+      }
+
+      if (target.forwards == ImportResolver::MaxForwards) { break; }
+
+      auto forwarder = export_entry->parsed_forwarder();
+      if (!forwarder.has_value()) { break; }
+
+      target.module = module_key(std::string(forwarder->module));
+      ++target.forwards;
+
+      if (forwarder->is_ordinal())
+      {
+         ordinal = forwarder->ordinal;
+         target.name.clear();
+         target.ordinal = *ordinal;
+      }
+      else
+      {
+         ordinal = std::nullopt;
+         target.name = std::string(forwarder->name);
+      }
+   }
+
+   std::lock_guard<std::mutex> lock(this->target_mutex);
+   this->targets[key] = target;
+
+   return target;
+}
+
+ResolvedImport
+ImportResolver::resolve
+(const std::string &module, const std::string &name)
+{
+   auto target = this->resolve_target(module, name, std::nullopt);
+
+   return ResolvedImport{Import{module, name, std::nullopt, 0},
+                         target.resolved,
+                         target.module,
+                         target.name,
+                         target.ordinal,
+                         target.rva,
+                         target.forwards};
+}
+
+ResolvedImport
+ImportResolver::resolve
+(const std::string &module, std::uint32_t ordinal)
+{
+   auto target = this->resolve_target(module, std::string(), ordinal);
+
+   return ResolvedImport{Import{module, std::string(), ordinal, 0},
+                         target.resolved,
+                         target.module,
+                         target.name,
+                         target.ordinal,
+                         target.rva,
+                         target.forwards};
+}
+
+BoundImportMap
+ImportResolver::resolve
+(const PE &pe)
+{
+   auto result = BoundImportMap();
+
+   for (auto &import : ImportResolver::ImportList(pe))
+   {
+      auto target = this->resolve_target(import.module, import.name, import.ordinal);
+
+      result[import.thunk] = ResolvedImport{import,
+                                            target.resolved,
+                                            target.module,
+                                            target.name,
+                                            target.ordinal,
+                                            target.rva,
+                                            target.forwards};
+   }
+
+   return result;
+}
+
+std::vector<Import>
+ImportResolver::ImportList
+(const PE &pe)
+{
+   YAPP_TIME_DIRECTORY(headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT);
+
+   auto result = std::vector<Import>();
+   auto data_directory = pe.data_directory();
+
+   if (!data_directory.has_directory(pe, headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT)) { return result; }
+
+   auto &entry = data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT);
+   if (entry.VirtualAddress == 0) { return result; }
+
+   auto is_32 = pe.valid_nt_headers().is_32();
+   std::size_t thunk_size = (is_32) ? sizeof(std::uint32_t) : sizeof(std::uint64_t);
+
+   auto read_string = [&pe] (std::uint32_t rva) { return ParseBudget::ReadString(pe, RVA(rva).as_memory(pe)); };
+
+   for (std::uint32_t descriptor_rva = entry.VirtualAddress, descriptors = 0;
+        ;
+        descriptor_rva += sizeof(headers::raw::IMAGE_IMPORT_DESCRIPTOR), ++descriptors)
+   {
+      ParseBudget::Step(ParseBudget::Structure::IMPORT_DESCRIPTORS, descriptors, sizeof(headers::raw::IMAGE_IMPORT_DESCRIPTOR));
+
+      auto descriptor_offset = RVA(descriptor_rva).as_memory(pe);
+      auto &descriptor = pe.cast_ref<headers::raw::IMAGE_IMPORT_DESCRIPTOR>(descriptor_offset);
+      if (descriptor.Name == 0 || descriptor.FirstThunk == 0) { break; }
+
+      auto module = read_string(descriptor.Name);
+
+      // the lookup table is unbound, so prefer it over the address table when it's present. it's the
+      // first field of the descriptor, read directly since the union around it is only named off Windows.
+      auto lookup_rva = pe.cast_ref<std::uint32_t>(descriptor_offset);
+      if (lookup_rva == 0) { lookup_rva = descriptor.FirstThunk; }
+
+      for (std::uint32_t i=0; ; ++i)
+      {
+         ParseBudget::Step(ParseBudget::Structure::IMPORT_THUNKS, i, thunk_size);
+
+         auto thunk_rva = static_cast<std::uint32_t>(lookup_rva + i * thunk_size);
+         std::uint64_t value;
+         bool by_ordinal;
+
+         if (is_32)
+         {
+            value = pe.cast_ref<std::uint32_t>(RVA(thunk_rva).as_memory(pe));
+            by_ordinal = (value & headers::raw::IMAGE_ORDINAL_FLAG32) != 0;
+         }
+         else
+         {
+            value = pe.cast_ref<std::uint64_t>(RVA(thunk_rva).as_memory(pe));
+            by_ordinal = (value & headers::raw::IMAGE_ORDINAL_FLAG64) != 0;
+         }
+
+         if (value == 0) { break; }
+
+         auto import = Import{module, std::string(), std::nullopt, static_cast<std::uint32_t>(descriptor.FirstThunk + i * thunk_size)};
+
+         if (by_ordinal) { import.ordinal = static_cast<std::uint32_t>(value & 0xFFFF); }
+         else { import.name = read_string(static_cast<std::uint32_t>(value) + offsetof(headers::raw::IMAGE_IMPORT_BY_NAME, Name)); }
+
+         result.push_back(std::move(import));
+      }
+   }
+
+   return result;
+}
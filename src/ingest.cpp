@@ -0,0 +1,282 @@
+#include <yapp.hpp>
+
+#include <deque>
+#include <filesystem>
+#include <list>
+
+#ifndef YAPP_WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   enum Stage
+   {
+      HEADERS = 0,
+      DIRECTORIES = 1,
+      DONE = 2,
+   };
+
+   struct File
+   {
+      std::string filename;
+      std::size_t size;
+#ifndef YAPP_WIN32
+      int fd;
+#endif
+      std::vector<std::uint8_t> buffer;
+      /// The number of leading bytes of the buffer read contiguously by the header stage.
+      std::size_t header_size;
+      std::list<FileRead> reads;
+      std::size_t outstanding;
+      Stage stage;
+      std::exception_ptr error;
+      std::list<File>::iterator self;
+   };
+
+   std::size_t
+   require
+   (const File &file, std::size_t size)
+   {
+      if (size > file.size) { throw ReadFailureException(file.filename); }
+      return size;
+   }
+
+   /// Get the number of leading bytes needed to parse every header, or zero if the buffer has them all.
+   std::size_t
+   headers_needed
+   (const File &file)
+   {
+      auto needed = PE::HeaderExtent(file.buffer.data(), file.buffer.size());
+
+      if (file.buffer.size() < needed) { return require(file, needed); }
+
+      // everything is present, so validation errors are real
+      PE(Memory<std::uint8_t>(file.buffer.data(), file.buffer.size())).section_table();
+
+      return 0;
+   }
+
+   /// Get the file ranges of the given data directories of a file whose headers have been read.
+   std::vector<std::pair<std::size_t, std::size_t>>
+   directory_ranges
+   (const File &file, const std::set<std::size_t> &directories)
+   {
+      auto result = std::vector<std::pair<std::size_t, std::size_t>>();
+      if (directories.empty()) { return result; }
+
+      auto pe = PE(Memory<std::uint8_t>(file.buffer.data(), file.header_size));
+
+      for (auto index : directories)
+      {
+         auto range = pe.directory_file_range(index);
+         if (!range.has_value() || range->first >= file.size) { continue; }
+
+         auto start = std::max(range->first, file.header_size);
+         auto end = std::min(range->second, file.size);
+
+         if (start < end) { result.push_back(std::make_pair(start, end)); }
+      }
+
+      return result;
+   }
+}
+
+Ingest::Ingest
+(std::size_t depth, Backend backend, std::size_t threads)
+   : _depth(std::max<std::size_t>(depth, 1)),
+     _threads(threads),
+     _backend(ReadQueue::Select(backend)),
+     _reads(0),
+     _bytes_read(0)
+{
+}
+
+bool
+Ingest::HasIoUring
+()
+{
+   return ReadQueue::HasIoUring();
+}
+
+void
+Ingest::add_directory
+(std::size_t index)
+{
+   this->directories.insert(index);
+}
+
+void
+Ingest::run
+(const std::vector<std::string> &filenames, Callback callback)
+{
+   this->_reads = 0;
+   this->_bytes_read = 0;
+
+   std::list<File> active;
+   std::deque<FileRead *> pending;
+
+   // declared after the files so in-flight reads are stopped before their buffers are freed
+   auto queue = ReadQueue::Create(this->_backend, this->_depth * 2, this->_threads);
+
+   auto queue_read = [&pending] (File &file, std::size_t offset, std::size_t size) {
+      auto read = FileRead();
+
+#ifdef YAPP_WIN32
+      read.filename = file.filename;
+#else
+      read.fd = file.fd;
+#endif
+      read.buffer = file.buffer.data() + offset;
+      read.offset = offset;
+      read.size = size;
+      read.result = 0;
+      read.context = &file;
+
+      file.reads.push_back(read);
+      ++file.outstanding;
+      pending.push_back(&file.reads.back());
+   };
+
+   auto advance = [this, &queue_read] (File &file) {
+      file.reads.clear();
+
+      try {
+         if (file.stage == Stage::HEADERS)
+         {
+            auto needed = headers_needed(file);
+
+            if (needed != 0)
+            {
+               // read a whole page at a time, since the next header is usually right behind this one
+               auto start = file.buffer.size();
+               auto end = std::min(std::max(needed, start + Ingest::HeaderReadSize), file.size);
+
+               file.buffer.resize(end, 0);
+               queue_read(file, start, end - start);
+               return;
+            }
+
+            file.header_size = file.buffer.size();
+            file.stage = Stage::DIRECTORIES;
+
+            auto ranges = directory_ranges(file, this->directories);
+
+            if (!ranges.empty())
+            {
+               std::size_t end = file.buffer.size();
+
+               for (auto &range : ranges) { end = std::max(end, range.second); }
+
+               file.buffer.resize(end, 0);
+
+               for (auto &range : ranges) { queue_read(file, range.first, range.second - range.first); }
+
+               return;
+            }
+         }
+
+         file.stage = Stage::DONE;
+      }
+      catch (...) {
+         file.error = std::current_exception();
+         file.stage = Stage::DONE;
+      }
+   };
+
+   auto finish = [&active, &callback] (std::list<File>::iterator file) {
+      auto pe = (file->error) ? PE() : PE(Memory<std::uint8_t>(file->buffer));
+      auto image = Image{file->filename, file->size, pe, file->error};
+
+#ifndef YAPP_WIN32
+      if (file->fd >= 0) { close(file->fd); }
+#endif
+
+      active.erase(file);
+      callback(image);
+   };
+
+   std::size_t next = 0;
+   std::size_t in_flight = 0;
+
+   while (next < filenames.size() || !active.empty())
+   {
+      while (active.size() < this->_depth && next < filenames.size())
+      {
+         active.push_back(File());
+
+         auto file = std::prev(active.end());
+         file->filename = filenames[next++];
+         file->size = 0;
+         file->header_size = 0;
+         file->outstanding = 0;
+         file->stage = Stage::HEADERS;
+         file->self = file;
+
+#ifdef YAPP_WIN32
+         std::error_code error;
+         file->size = static_cast<std::size_t>(std::filesystem::file_size(file->filename, error));
+
+         if (error) { file->error = std::make_exception_ptr(OpenFileFailureException(file->filename)); }
+#else
+         struct stat info;
+         file->fd = open(file->filename.c_str(), O_RDONLY);
+
+         if (file->fd < 0 || fstat(file->fd, &info) != 0)
+            file->error = std::make_exception_ptr(OpenFileFailureException(file->filename));
+         else
+            file->size = static_cast<std::size_t>(info.st_size);
+#endif
+
+         if (file->error) { file->stage = Stage::DONE; }
+         else { advance(*file); }
+
+         if (file->stage == Stage::DONE) { finish(file); }
+      }
+
+      while (!pending.empty() && in_flight < queue->capacity())
+      {
+         queue->submit(pending.front());
+         pending.pop_front();
+         ++in_flight;
+         ++this->_reads;
+      }
+
+      // every file started this round may have failed to open
+      if (in_flight == 0) { continue; }
+
+      queue->flush();
+
+      auto read = queue->wait();
+      auto &file = *static_cast<File *>(read->context);
+      --in_flight;
+
+      if (read->result > 0)
+      {
+         auto amount = static_cast<std::size_t>(read->result);
+         this->_bytes_read += amount;
+
+         // a short read isn't an error, the rest just has to be asked for again
+         if (amount < read->size)
+         {
+            read->buffer += amount;
+            read->offset += amount;
+            read->size -= amount;
+            pending.push_back(read);
+            continue;
+         }
+      }
+      else if (!file.error) { file.error = std::make_exception_ptr(ReadFailureException(file.filename)); }
+
+      if (--file.outstanding != 0) { continue; }
+
+      if (file.error) { file.stage = Stage::DONE; }
+      else { advance(file); }
+
+      if (file.stage == Stage::DONE) { finish(file.self); }
+   }
+}
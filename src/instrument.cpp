@@ -0,0 +1,103 @@
+#include <yapp.hpp>
+
+#include <mutex>
+
+using namespace yapp;
+
+namespace
+{
+   std::mutex &
+   exceptions_mutex
+   ()
+   {
+      static std::mutex mutex;
+      return mutex;
+   }
+
+   std::map<std::string, std::uint64_t> &
+   exception_counts
+   ()
+   {
+      static std::map<std::string, std::uint64_t> counts;
+      return counts;
+   }
+}
+
+std::array<std::atomic<std::uint64_t>, Instrumentation::COUNTER_COUNT> Instrumentation::Counters;
+std::array<std::atomic<std::uint64_t>, Instrumentation::DirectoryCount> Instrumentation::DirectoryCalls;
+std::array<std::atomic<std::uint64_t>, Instrumentation::DirectoryCount> Instrumentation::DirectoryNanoseconds;
+
+Instrumentation::Timer::~Timer
+()
+{
+   if (this->index >= Instrumentation::DirectoryCount) { return; }
+
+   auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start);
+
+   Instrumentation::DirectoryCalls[this->index].fetch_add(1, std::memory_order_relaxed);
+   Instrumentation::DirectoryNanoseconds[this->index].fetch_add(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+}
+
+Instrumentation::Snapshot
+Instrumentation::Snapshot::operator-
+(const Snapshot &other) const
+{
+   auto result = *this;
+
+   for (std::size_t i=0; i<result.counters.size(); ++i)
+      result.counters[i] -= other.counters[i];
+
+   for (auto &entry : other.exceptions)
+      result.exceptions[entry.first] -= entry.second;
+
+   for (std::size_t i=0; i<result.directories.size(); ++i)
+   {
+      result.directories[i].calls -= other.directories[i].calls;
+      result.directories[i].nanoseconds -= other.directories[i].nanoseconds;
+   }
+
+   return result;
+}
+
+void
+Instrumentation::CountException
+(const std::type_info &type)
+{
+   Instrumentation::Count(Instrumentation::EXCEPTIONS);
+
+   std::lock_guard<std::mutex> lock(exceptions_mutex());
+   ++exception_counts()[type.name()];
+}
+
+Instrumentation::Snapshot
+Instrumentation::Take
+()
+{
+   auto result = Snapshot();
+
+   for (std::size_t i=0; i<result.counters.size(); ++i)
+      result.counters[i] = Instrumentation::Counters[i].load(std::memory_order_relaxed);
+
+   for (std::size_t i=0; i<result.directories.size(); ++i)
+   {
+      result.directories[i].calls = Instrumentation::DirectoryCalls[i].load(std::memory_order_relaxed);
+      result.directories[i].nanoseconds = Instrumentation::DirectoryNanoseconds[i].load(std::memory_order_relaxed);
+   }
+
+   std::lock_guard<std::mutex> lock(exceptions_mutex());
+   result.exceptions = exception_counts();
+
+   return result;
+}
+
+void
+Instrumentation::Reset
+()
+{
+   for (auto &counter : Instrumentation::Counters) { counter.store(0, std::memory_order_relaxed); }
+   for (auto &counter : Instrumentation::DirectoryCalls) { counter.store(0, std::memory_order_relaxed); }
+   for (auto &counter : Instrumentation::DirectoryNanoseconds) { counter.store(0, std::memory_order_relaxed); }
+
+   std::lock_guard<std::mutex> lock(exceptions_mutex());
+   exception_counts().clear();
+}
@@ -0,0 +1,379 @@
+#include <yapp.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace yapp;
+using namespace yapp::headers;
+
+namespace
+{
+   const std::size_t HeaderSize = raw::IMAGE_SIZEOF_ARCHIVE_MEMBER_HDR;
+
+   /* the first linker member was written for big-endian machines, everything else is little-endian */
+   std::uint32_t
+   read32be
+   (const std::uint8_t *data)
+   {
+      return (std::uint32_t(data[0]) << 24) | (std::uint32_t(data[1]) << 16) | (std::uint32_t(data[2]) << 8) | data[3];
+   }
+
+   std::uint32_t
+   read32
+   (const std::uint8_t *data)
+   {
+      std::uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+
+      return value;
+   }
+
+   std::uint16_t
+   read16
+   (const std::uint8_t *data)
+   {
+      std::uint16_t value;
+      std::memcpy(&value, data, sizeof(value));
+
+      return value;
+   }
+
+   /* header fields are decimal, padded on the right with spaces */
+   std::optional<std::size_t>
+   read_decimal
+   (std::string_view field)
+   {
+      std::size_t value = 0;
+      std::size_t digits = 0;
+
+      for (; digits<field.size() && field[digits] >= '0' && field[digits] <= '9'; ++digits)
+         value = value * 10 + (field[digits] - '0');
+
+      if (digits == 0) { return std::nullopt; }
+
+      for (auto i=digits; i<field.size(); ++i)
+         if (field[i] != ' ') { return std::nullopt; }
+
+      return value;
+   }
+
+   std::string_view
+   header_field
+   (const std::uint8_t *field, std::size_t size)
+   {
+      return std::string_view(reinterpret_cast<const char *>(field), size);
+   }
+
+   /* names are "name/" in the header, or "/offset" into the longnames member, where MSVC terminates
+      them with a null and GNU with "/\n" */
+   std::optional<std::string_view>
+   member_name
+   (std::string_view name, std::string_view longnames)
+   {
+      if (name.size() > 1 && name[0] == '/' && name[1] >= '0' && name[1] <= '9')
+      {
+         auto offset = read_decimal(name.substr(1));
+         if (!offset.has_value() || *offset >= longnames.size()) { return std::nullopt; }
+
+         auto result = longnames.substr(*offset);
+         result = result.substr(0, result.find_first_of(std::string_view("\0\n", 2)));
+
+         if (!result.empty() && result.back() == '/') { result.remove_suffix(1); }
+
+         return result;
+      }
+
+      auto end = name.find('/');
+      if (end != std::string_view::npos) { return name.substr(0, end); }
+
+      return name.substr(0, name.find_last_not_of(' ') + 1);
+   }
+
+   /* names imported without their prefix drop one leading '?', '@' or '_' */
+   std::string_view
+   trim_prefix
+   (std::string_view name)
+   {
+      if (!name.empty() && (name[0] == '?' || name[0] == '@' || name[0] == '_')) { name.remove_prefix(1); }
+
+      return name;
+   }
+}
+
+LibArchive::LibArchive
+(const std::string &filename)
+   : data(filename)
+{
+   this->parse();
+}
+
+LibArchive::LibArchive
+(const Memory<std::uint8_t> &data)
+   : data(data)
+{
+   this->parse();
+}
+
+void
+LibArchive::parse
+()
+{
+   auto bytes = this->data.ptr();
+   auto size = this->data.size();
+
+   if (size < raw::IMAGE_ARCHIVE_START_SIZE || std::memcmp(bytes, raw::IMAGE_ARCHIVE_START, raw::IMAGE_ARCHIVE_START_SIZE) != 0)
+      throw InvalidArchiveException(0);
+
+   std::optional<std::pair<std::size_t, std::size_t>> first, second;
+   auto offset = raw::IMAGE_ARCHIVE_START_SIZE;
+
+   while (offset < size)
+   {
+      if (size - offset < HeaderSize) { throw InvalidArchiveException(offset); }
+
+      auto header = reinterpret_cast<const raw::IMAGE_ARCHIVE_MEMBER_HEADER *>(bytes + offset);
+
+      if (std::memcmp(&header->EndHeader[0], raw::IMAGE_ARCHIVE_END, sizeof(header->EndHeader)) != 0)
+         throw InvalidArchiveException(offset);
+
+      auto member_size = read_decimal(header_field(&header->Size[0], sizeof(header->Size)));
+
+      if (!member_size.has_value() || *member_size > size - offset - HeaderSize)
+         throw InvalidArchiveException(offset);
+
+      auto name = header_field(&header->Name[0], sizeof(header->Name));
+      auto member = std::make_pair(offset + HeaderSize, *member_size);
+
+      if (name == raw::IMAGE_ARCHIVE_LINKER_MEMBER)
+      {
+         if (!first.has_value()) { first = member; }
+         else if (!second.has_value()) { second = member; }
+      }
+      else if (name == raw::IMAGE_ARCHIVE_LONGNAMES_MEMBER)
+      {
+         this->longnames = header_field(bytes + member.first, member.second);
+      }
+      else if (name.substr(0, 7) != "/SYM64/") // GNU's 64-bit symbol table, which COFF libraries never need
+      {
+         auto resolved = member_name(name, this->longnames);
+         if (!resolved.has_value()) { throw InvalidArchiveException(offset); }
+
+         this->_members.push_back(Member{*resolved, offset, *member_size});
+      }
+
+      // members start on even offsets
+      offset = member.first + member.second + (member.second & 1);
+   }
+
+   if (second.has_value()) { this->read_second_linker_member(second->first, second->second); }
+   else if (first.has_value()) { this->read_first_linker_member(first->first, first->second); }
+}
+
+std::uint32_t
+LibArchive::member_at
+(std::size_t header_offset, std::size_t linker_offset) const
+{
+   auto iter = std::lower_bound(this->_members.begin(), this->_members.end(), header_offset, [] (const Member &member, std::size_t offset) {
+      return member.offset < offset;
+   });
+
+   if (iter == this->_members.end() || iter->offset != header_offset) { throw InvalidArchiveException(linker_offset); }
+
+   return static_cast<std::uint32_t>(iter - this->_members.begin());
+}
+
+void
+LibArchive::read_first_linker_member
+(std::size_t offset, std::size_t size)
+{
+   auto bytes = this->data.ptr();
+   auto end = offset + size;
+
+   if (size < sizeof(std::uint32_t)) { throw InvalidArchiveException(offset); }
+
+   auto count = std::size_t(read32be(bytes + offset));
+   if (count > (size - sizeof(std::uint32_t)) / sizeof(std::uint32_t)) { throw InvalidArchiveException(offset); }
+
+   auto offsets = bytes + offset + sizeof(std::uint32_t);
+   auto strings = offset + sizeof(std::uint32_t) + count * sizeof(std::uint32_t);
+
+   this->symbols.reserve(count);
+
+   for (std::size_t i=0; i<count; ++i)
+   {
+      auto name = reinterpret_cast<const char *>(bytes + strings);
+      auto name_end = static_cast<const char *>(std::memchr(name, 0, end - strings));
+      if (name_end == nullptr) { throw InvalidArchiveException(strings); }
+
+      this->symbols.push_back(Symbol{std::string_view(name, name_end - name), this->member_at(read32be(offsets + i * 4), offset)});
+      strings += (name_end - name) + 1;
+   }
+
+   // the first linker member is in member order, so this is the one sort an archive ever needs
+   std::stable_sort(this->symbols.begin(), this->symbols.end(), [] (const Symbol &left, const Symbol &right) {
+      return left.name < right.name;
+   });
+}
+
+void
+LibArchive::read_second_linker_member
+(std::size_t offset, std::size_t size)
+{
+   auto bytes = this->data.ptr();
+   auto end = offset + size;
+
+   if (size < sizeof(std::uint32_t)) { throw InvalidArchiveException(offset); }
+
+   auto member_count = std::size_t(read32(bytes + offset));
+   if (member_count > (size - sizeof(std::uint32_t)) / sizeof(std::uint32_t)) { throw InvalidArchiveException(offset); }
+
+   auto offsets = bytes + offset + sizeof(std::uint32_t);
+   auto position = offset + sizeof(std::uint32_t) + member_count * sizeof(std::uint32_t);
+
+   if (end - position < sizeof(std::uint32_t)) { throw InvalidArchiveException(position); }
+
+   auto count = std::size_t(read32(bytes + position));
+   position += sizeof(std::uint32_t);
+
+   if (count > (end - position) / sizeof(std::uint16_t)) { throw InvalidArchiveException(position); }
+
+   auto indices = bytes + position;
+   auto strings = position + count * sizeof(std::uint16_t);
+
+   // resolve each of the linker's member offsets once, rather than once per symbol
+   auto members = std::vector<std::uint32_t>(member_count);
+
+   for (std::size_t i=0; i<member_count; ++i)
+      members[i] = this->member_at(read32(offsets + i * 4), offset);
+
+   this->symbols.reserve(count);
+
+   for (std::size_t i=0; i<count; ++i)
+   {
+      auto index = read16(indices + i * 2);
+      if (index == 0 || index > member_count) { throw InvalidArchiveException(position + i * 2); }
+
+      auto name = reinterpret_cast<const char *>(bytes + strings);
+      auto name_end = static_cast<const char *>(std::memchr(name, 0, end - strings));
+      if (name_end == nullptr) { throw InvalidArchiveException(strings); }
+
+      this->symbols.push_back(Symbol{std::string_view(name, name_end - name), members[index-1]});
+      strings += (name_end - name) + 1;
+   }
+
+   auto by_name = [] (const Symbol &left, const Symbol &right) { return left.name < right.name; };
+
+   // the linker writes this member sorted, but don't trust a binary search to it unchecked
+   if (!std::is_sorted(this->symbols.begin(), this->symbols.end(), by_name))
+      std::stable_sort(this->symbols.begin(), this->symbols.end(), by_name);
+}
+
+std::optional<LibArchive::Member>
+LibArchive::find_symbol
+(std::string_view name) const
+{
+   auto iter = std::lower_bound(this->symbols.begin(), this->symbols.end(), name, [] (const Symbol &symbol, std::string_view name) {
+      return symbol.name < name;
+   });
+
+   if (iter == this->symbols.end() || iter->name != name) { return std::nullopt; }
+
+   return this->_members[iter->member];
+}
+
+std::optional<LibArchive::Member>
+LibArchive::find
+(std::string_view name) const
+{
+   for (auto &member : this->_members)
+   {
+      if (member.name == name) { return member; }
+   }
+
+   return std::nullopt;
+}
+
+const Memory<std::uint8_t>
+LibArchive::member_data
+(const Member &member) const
+{
+   if (member.size == 0) { return Memory<std::uint8_t>(); }
+
+   return this->data.subsection(member.offset + HeaderSize, member.size);
+}
+
+COFFObject
+LibArchive::object
+(const Member &member) const
+{
+   return COFFObject(this->member_data(member));
+}
+
+bool
+LibArchive::is_import
+(const Member &member) const
+{
+   if (member.size < sizeof(raw::IMPORT_OBJECT_HEADER)) { return false; }
+
+   auto header = this->data.ptr() + member.offset + HeaderSize;
+
+   // anonymous objects share the first two signatures, but only import headers are version 0
+   return read16(header) == raw::IMAGE_FILE_MACHINE_UNKNOWN
+      && read16(header + 2) == raw::IMPORT_OBJECT_HDR_SIG2
+      && read16(header + 4) == 0;
+}
+
+std::optional<LibArchive::Import>
+LibArchive::import_header
+(const Member &member) const
+{
+   if (!this->is_import(member)) { return std::nullopt; }
+
+   auto data_offset = member.offset + HeaderSize;
+   raw::IMPORT_OBJECT_HEADER header;
+
+   std::memcpy(&header, this->data.ptr() + data_offset, sizeof(header));
+
+   if (header.SizeOfData > member.size - sizeof(header)) { throw InvalidArchiveException(data_offset); }
+
+   // the symbol and the DLL name follow the header, both null-terminated
+   auto strings = header_field(this->data.ptr() + data_offset + sizeof(header), header.SizeOfData);
+   auto symbol_end = strings.find('\0');
+   if (symbol_end == std::string_view::npos) { throw InvalidArchiveException(data_offset + sizeof(header)); }
+
+   auto dll = strings.substr(symbol_end + 1);
+   auto dll_end = dll.find('\0');
+   if (dll_end == std::string_view::npos) { throw InvalidArchiveException(data_offset + sizeof(header) + symbol_end + 1); }
+
+   auto result = Import{header.Machine, header.Type, header.NameType, header.Ordinal,
+                        strings.substr(0, symbol_end), dll.substr(0, dll_end), std::string_view()};
+
+   switch (header.NameType)
+   {
+   case raw::IMPORT_OBJECT_ORDINAL: { break; }
+   case raw::IMPORT_OBJECT_NAME: { result.export_name = result.symbol; break; }
+   case raw::IMPORT_OBJECT_NAME_NO_PREFIX: { result.export_name = trim_prefix(result.symbol); break; }
+
+   case raw::IMPORT_OBJECT_NAME_UNDECORATE:
+   {
+      auto name = trim_prefix(result.symbol);
+      result.export_name = name.substr(0, name.find('@'));
+      break;
+   }
+
+   case raw::IMPORT_OBJECT_NAME_EXPORTAS:
+   {
+      // the exported name is a third string, after the DLL name
+      auto name = dll.substr(dll_end + 1);
+      auto name_end = name.find('\0');
+      if (name_end == std::string_view::npos) { throw InvalidArchiveException(data_offset); }
+
+      result.export_name = name.substr(0, name_end);
+      break;
+   }
+
+   default: { throw InvalidArchiveException(data_offset); }
+   }
+
+   return result;
+}
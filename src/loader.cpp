@@ -0,0 +1,269 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+namespace
+{
+   std::string
+   module_key
+   (const std::string &name)
+   {
+      auto result = ExportIndex::NormalizeModule(name);
+
+      // match modules the way the import resolver names them
+      if (result.find('.') == std::string::npos) { result += ".dll"; }
+
+      return result;
+   }
+
+   template <typename Directory, typename Pointer>
+   Loader::TLS
+   read_tls
+   (const PE &image, std::uint32_t rva)
+   {
+      auto &directory = image.cast_ref<Directory>(RVA(rva).as_memory(image));
+      auto result = Loader::TLS{directory.StartAddressOfRawData,
+                                directory.EndAddressOfRawData,
+                                directory.AddressOfIndex,
+                                directory.AddressOfCallBacks,
+                                directory.SizeOfZeroFill,
+                                std::vector<std::uint64_t>()};
+
+      if (directory.AddressOfCallBacks == 0) { return result; }
+
+      // the table is null-terminated, and reading past the end of the image throws
+      auto table = image.va_to_rva(VA64(directory.AddressOfCallBacks));
+
+      for (std::uint32_t slot = *table, index = 0; ; slot += sizeof(Pointer), ++index)
+      {
+         ParseBudget::Step(ParseBudget::Structure::TLS_CALLBACKS, index, sizeof(Pointer));
+
+         auto callback = image.cast_ref<Pointer>(RVA(slot).as_memory(image));
+         if (callback == 0) { break; }
+
+         result.callbacks.push_back(callback);
+      }
+
+      return result;
+   }
+}
+
+Loader::Loader
+(const PE &pe, std::size_t max_size)
+   : _image(Loader::Map(pe, max_size))
+{
+}
+
+std::size_t
+Loader::relocate
+(std::uint64_t base)
+{
+   YAPP_TIME_DIRECTORY(headers::raw::IMAGE_DIRECTORY_ENTRY_BASERELOC);
+
+   auto &image = this->_image;
+   auto nt_headers = image.valid_nt_headers();
+   auto delta = base - image.image_base();
+
+   if (delta == 0) { return 0; }
+   if (nt_headers.is_32() && base > 0xFFFFFFFF) { throw InvalidVAException(VA64(base)); }
+
+   auto data_directory = image.data_directory();
+
+   if (!data_directory.has_directory(image, headers::raw::IMAGE_DIRECTORY_ENTRY_BASERELOC)
+       || data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_BASERELOC).VirtualAddress == 0)
+      throw DirectoryUnavailableException(headers::raw::IMAGE_DIRECTORY_ENTRY_BASERELOC);
+
+   auto &entry = data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_BASERELOC);
+   std::uint64_t end = std::uint64_t(entry.VirtualAddress) + entry.Size;
+   std::size_t fixups = 0;
+
+   for (std::uint64_t block_rva = entry.VirtualAddress, blocks = 0; block_rva + sizeof(headers::raw::IMAGE_BASE_RELOCATION) <= end; ++blocks)
+   {
+      ParseBudget::Step(ParseBudget::Structure::RELOCATION_BLOCKS, blocks, sizeof(headers::raw::IMAGE_BASE_RELOCATION));
+
+      auto block_offset = RVA(static_cast<std::uint32_t>(block_rva)).as_memory(image);
+      auto &block = image.cast_ref<headers::raw::IMAGE_BASE_RELOCATION>(block_offset);
+
+      if (block.SizeOfBlock < sizeof(headers::raw::IMAGE_BASE_RELOCATION) || block_rva + block.SizeOfBlock > end)
+         throw InvalidRelocationException(static_cast<std::uint32_t>(block_rva));
+
+      std::size_t count = (block.SizeOfBlock - sizeof(headers::raw::IMAGE_BASE_RELOCATION)) / sizeof(std::uint16_t);
+      auto read_entry = [&] (std::size_t index) {
+         return image.cast_ref<std::uint16_t>(block_offset
+                                              + sizeof(headers::raw::IMAGE_BASE_RELOCATION)
+                                              + index * sizeof(std::uint16_t));
+      };
+
+      for (std::size_t i=0; i<count; ++i)
+      {
+         ParseBudget::Step(ParseBudget::Structure::RELOCATIONS, i, sizeof(std::uint16_t));
+
+         auto value = read_entry(i);
+         std::uint8_t type = value >> 12;
+         auto target = RVA(block.VirtualAddress + (value & 0xFFF)).as_memory(image);
+
+         switch (type)
+         {
+         case headers::raw::IMAGE_REL_BASED_ABSOLUTE: { continue; }
+         case headers::raw::IMAGE_REL_BASED_HIGH:
+         {
+            image.cast_ref<std::uint16_t>(target) += static_cast<std::uint16_t>(delta >> 16);
+            break;
+         }
+         case headers::raw::IMAGE_REL_BASED_LOW:
+         {
+            image.cast_ref<std::uint16_t>(target) += static_cast<std::uint16_t>(delta);
+            break;
+         }
+         case headers::raw::IMAGE_REL_BASED_HIGHLOW:
+         {
+            image.cast_ref<std::uint32_t>(target) += static_cast<std::uint32_t>(delta);
+            break;
+         }
+         case headers::raw::IMAGE_REL_BASED_HIGHADJ:
+         {
+            // the low half of the adjusted value is held in the next entry, and rounds the high half
+            if (++i >= count) { throw InvalidRelocationException(static_cast<std::uint32_t>(block_rva)); }
+
+            auto &word = image.cast_ref<std::uint16_t>(target);
+            std::uint32_t adjusted = std::uint32_t(word) << 16;
+
+            adjusted += static_cast<std::uint32_t>(static_cast<std::int16_t>(read_entry(i)));
+            adjusted += static_cast<std::uint32_t>(delta);
+            adjusted += 0x8000;
+            word = static_cast<std::uint16_t>(adjusted >> 16);
+            break;
+         }
+         case headers::raw::IMAGE_REL_BASED_DIR64:
+         {
+            image.cast_ref<std::uint64_t>(target) += delta;
+            break;
+         }
+         default: { throw InvalidRelocationException(static_cast<std::uint32_t>(block_rva)); }
+         }
+
+         ++fixups;
+      }
+
+      block_rva += block.SizeOfBlock;
+   }
+
+   if (nt_headers.is_32()) { nt_headers.get_32().optional_header()->ImageBase = static_cast<std::uint32_t>(base); }
+   else { nt_headers.get_64().optional_header()->ImageBase = base; }
+
+   return fixups;
+}
+
+BoundImportMap
+Loader::bind
+(ImportResolver &resolver, const std::map<std::string, std::uint64_t> &bases)
+{
+   auto &image = this->_image;
+   auto is_32 = image.valid_nt_headers().is_32();
+   auto module_bases = std::map<std::string, std::uint64_t>();
+
+   for (auto &module : bases)
+      module_bases[module_key(module.first)] = module.second;
+
+   auto result = resolver.resolve(image);
+
+   for (auto &entry : result)
+   {
+      auto &import = entry.second;
+      if (!import.resolved) { continue; }
+
+      auto module_base = module_bases.find(import.module);
+      if (module_base == module_bases.end()) { continue; }
+
+      auto address = module_base->second + import.rva;
+      auto slot = RVA(entry.first).as_memory(image);
+
+      if (is_32) { image.cast_ref<std::uint32_t>(slot) = static_cast<std::uint32_t>(address); }
+      else { image.cast_ref<std::uint64_t>(slot) = address; }
+   }
+
+   return result;
+}
+
+std::optional<Loader::TLS>
+Loader::tls
+() const
+{
+   YAPP_TIME_DIRECTORY(headers::raw::IMAGE_DIRECTORY_ENTRY_TLS);
+
+   auto &image = this->_image;
+   auto data_directory = image.data_directory();
+
+   if (!data_directory.has_directory(image, headers::raw::IMAGE_DIRECTORY_ENTRY_TLS)) { return std::nullopt; }
+
+   auto &entry = data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_TLS);
+   if (entry.VirtualAddress == 0) { return std::nullopt; }
+
+   if (image.valid_nt_headers().is_32())
+      return read_tls<headers::raw::IMAGE_TLS_DIRECTORY32, std::uint32_t>(image, entry.VirtualAddress);
+   else
+      return read_tls<headers::raw::IMAGE_TLS_DIRECTORY64, std::uint64_t>(image, entry.VirtualAddress);
+}
+
+std::vector<std::uint64_t>
+Loader::entrypoints
+() const
+{
+   auto result = std::vector<std::uint64_t>();
+   auto tls = this->tls();
+
+   if (tls.has_value()) { result = tls->callbacks; }
+
+   auto entrypoint = *this->_image.entrypoint();
+   if (entrypoint != 0) { result.push_back(this->base() + entrypoint); }
+
+   return result;
+}
+
+PE
+Loader::Map
+(const PE &pe, std::size_t max_size)
+{
+   if (pe.image_type() != PE::ImageType::DISK) { throw UnsupportedImageTypeException(); }
+
+   auto nt_headers = pe.valid_nt_headers();
+   std::size_t image_size, header_size;
+
+   if (nt_headers.is_32())
+   {
+      image_size = nt_headers.get_32().optional_header()->SizeOfImage;
+      header_size = nt_headers.get_32().optional_header()->SizeOfHeaders;
+   }
+   else
+   {
+      image_size = nt_headers.get_64().optional_header()->SizeOfImage;
+      header_size = nt_headers.get_64().optional_header()->SizeOfHeaders;
+   }
+
+   if (image_size > max_size) { throw OversizedImageException(image_size, max_size); }
+
+   PE image(image_size, PE::ImageType::MEMORY);
+   std::memset(image.ptr(), 0, image.size());
+   std::memcpy(image.ptr(), pe.ptr(), std::min({header_size, image_size, pe.size()}));
+
+   auto section_table = pe.section_table();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto section = section_table[i];
+      std::size_t raw_size = section->SizeOfRawData;
+      std::size_t raw_offset = section->PointerToRawData;
+      std::size_t virtual_address = section->VirtualAddress;
+
+      if (virtual_address >= image_size) { throw OutOfBoundsException(virtual_address, image_size); }
+
+      // raw data past the virtual size isn't mapped, and data past the end of the file is left zeroed
+      if (section->Misc.VirtualSize != 0) { raw_size = std::min<std::size_t>(raw_size, section->Misc.VirtualSize); }
+      if (raw_size == 0 || raw_offset >= pe.size()) { continue; }
+
+      raw_size = std::min({raw_size, pe.size() - raw_offset, image_size - virtual_address});
+      std::memcpy(image.ptr() + virtual_address, pe.ptr() + raw_offset, raw_size);
+   }
+
+   return image;
+}
@@ -0,0 +1,535 @@
+#include <yapp.hpp>
+
+#include <filesystem>
+#include <random>
+#include <thread>
+
+#ifndef YAPP_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   std::uint64_t
+   fnv1a
+   (const std::uint8_t *data, std::size_t size)
+   {
+      std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+      for (std::size_t i=0; i<size; ++i)
+      {
+         hash ^= data[i];
+         hash *= 0x100000001B3ULL;
+      }
+
+      return hash;
+   }
+
+   /// A unique temporary name per writer, so concurrent writers never see each other's partial files.
+   std::string
+   temporary_name
+   (const std::string &filename)
+   {
+      std::stringstream temporary;
+
+      temporary << filename << "." << std::hex << std::random_device()()
+                << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+
+      return temporary.str();
+   }
+
+   void
+   rename_into_place
+   (const std::string &temporary, const std::string &filename)
+   {
+      std::error_code error;
+      std::filesystem::rename(temporary, filename, error);
+
+      if (error)
+      {
+         std::filesystem::remove(temporary, error);
+         throw WriteFailureException(filename);
+      }
+   }
+
+#ifndef YAPP_WIN32
+   /// The name of the index entry for a file, from everything which changes when the file is replaced or rewritten.
+   std::string
+   identity_name
+   (const struct stat &info)
+   {
+      std::stringstream stream;
+
+      stream << std::hex << std::uint64_t(info.st_dev) << "-" << std::uint64_t(info.st_ino) << "-"
+             << std::uint64_t(info.st_size) << "-" << std::uint64_t(info.st_mtim.tv_sec) << "."
+             << std::uint64_t(info.st_mtim.tv_nsec) << ".yidx";
+
+      return stream.str();
+   }
+#endif
+
+   std::size_t
+   align8
+   (std::size_t value)
+   {
+      return (value + 7) & ~std::size_t(7);
+   }
+
+   /// Accumulates the string pool of a record, storing each distinct string once.
+   class StringPool
+   {
+   public:
+      std::vector<std::uint8_t> data;
+      std::map<std::string, std::uint32_t> offsets;
+
+      StringPool() : data(1, 0) {}
+
+      std::uint32_t add(const std::string &string) {
+         if (string.empty()) { return 0; }
+
+         auto iter = this->offsets.find(string);
+         if (iter != this->offsets.end()) { return iter->second; }
+
+         auto offset = static_cast<std::uint32_t>(this->data.size());
+         this->data.insert(this->data.end(), string.begin(), string.end());
+         this->data.push_back(0);
+         this->offsets[string] = offset;
+
+         return offset;
+      }
+   };
+
+   template <typename T>
+   metadata::Table
+   append_table
+   (std::vector<std::uint8_t> &record, const T *entries, std::size_t count)
+   {
+      auto offset = align8(record.size());
+      auto size = count * sizeof(T);
+
+      record.resize(offset + size, 0);
+      if (size != 0) { std::memcpy(record.data() + offset, entries, size); }
+
+      return metadata::Table{static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(count)};
+   }
+
+   std::vector<metadata::Resource>
+   resource_summary
+   (const PE &pe)
+   {
+      auto result = std::vector<metadata::Resource>();
+      auto data_directory = pe.data_directory();
+
+      if (!data_directory.has_directory(pe, headers::raw::IMAGE_DIRECTORY_ENTRY_RESOURCE)) { return result; }
+
+      auto &entry = data_directory.get(headers::raw::IMAGE_DIRECTORY_ENTRY_RESOURCE);
+      if (entry.VirtualAddress == 0) { return result; }
+
+      auto root_rva = entry.VirtualAddress;
+      auto entry_count = [&pe] (std::uint32_t rva) {
+         auto &directory = pe.cast_ref<headers::raw::IMAGE_RESOURCE_DIRECTORY>(RVA(rva).as_memory(pe));
+         return std::uint32_t(directory.NumberOfNamedEntries) + directory.NumberOfIdEntries;
+      };
+
+      auto types = entry_count(root_rva);
+
+      for (std::uint32_t i=0; i<types; ++i)
+      {
+         ParseBudget::Step(ParseBudget::Structure::RESOURCES, i, sizeof(headers::raw::IMAGE_RESOURCE_DIRECTORY_ENTRY));
+
+         // entries are read as a pair of words, since the names of their unions differ between SDKs
+         auto entry_rva = root_rva + sizeof(headers::raw::IMAGE_RESOURCE_DIRECTORY)
+            + i * sizeof(headers::raw::IMAGE_RESOURCE_DIRECTORY_ENTRY);
+         auto name = pe.cast_ref<std::uint32_t>(RVA(static_cast<std::uint32_t>(entry_rva)).as_memory(pe));
+         auto data = pe.cast_ref<std::uint32_t>(RVA(static_cast<std::uint32_t>(entry_rva + 4)).as_memory(pe));
+         auto resource = metadata::Resource{(name & 0x80000000) ? 0 : (name & 0xFFFF), 0};
+
+         if (data & 0x80000000) { resource.count = entry_count(root_rva + (data & 0x7FFFFFFF)); }
+
+         result.push_back(resource);
+      }
+
+      return result;
+   }
+}
+
+MetadataView::MetadataView
+(std::vector<std::uint8_t> record)
+   : _size(record.size())
+{
+   // alias the vector's buffer so the view owns it without another copy
+   auto owner = std::make_shared<std::vector<std::uint8_t>>(std::move(record));
+   this->storage = std::shared_ptr<const std::uint8_t>(owner, owner->data());
+   this->validate();
+}
+
+MetadataView::MetadataView
+(std::shared_ptr<const std::uint8_t> storage, std::size_t size)
+   : storage(storage),
+     _size(size)
+{
+   this->validate();
+}
+
+void
+MetadataView::validate
+() const
+{
+   if (this->storage == nullptr || this->_size < sizeof(metadata::Header)) { throw InvalidMetadataException(0); }
+
+   auto &header = this->header();
+
+   if (std::memcmp(header.magic, metadata::Magic, sizeof(metadata::Magic)) != 0) { throw InvalidMetadataException(0); }
+   if (header.version != metadata::Version) { throw InvalidMetadataException(offsetof(metadata::Header, version)); }
+   if (header.size > this->_size) { throw InvalidMetadataException(offsetof(metadata::Header, size)); }
+
+   auto check_table = [&header] (const metadata::Table &table, std::size_t entry_size, std::size_t field) {
+      if (table.offset % 8 != 0
+          || std::uint64_t(table.offset) + std::uint64_t(table.count) * entry_size > header.size)
+         throw InvalidMetadataException(field);
+   };
+
+   check_table(header.sections, sizeof(metadata::Section), offsetof(metadata::Header, sections));
+   check_table(header.imports, sizeof(metadata::Import), offsetof(metadata::Header, imports));
+   check_table(header.exports, sizeof(metadata::Export), offsetof(metadata::Header, exports));
+   check_table(header.resources, sizeof(metadata::Resource), offsetof(metadata::Header, resources));
+   check_table(header.strings, 1, offsetof(metadata::Header, strings));
+
+   // a pool which starts and ends with a null byte can't yield an unterminated string
+   auto strings = this->table<char>(header.strings);
+
+   if (header.strings.count == 0 || strings[0] != 0 || strings[header.strings.count-1] != 0)
+      throw InvalidMetadataException(header.strings.offset);
+}
+
+MetadataView
+MetadataView::Build
+(const PE &pe)
+{
+   return MetadataView::Build(pe, Sha256::Hash(Span<const std::uint8_t>(pe.ptr(), pe.size())));
+}
+
+MetadataView
+MetadataView::Build
+(const PE &pe, const Sha256::Digest &digest)
+{
+   auto nt_headers = pe.valid_nt_headers();
+   auto header = metadata::Header();
+   std::memset(&header, 0, sizeof(header));
+
+   std::memcpy(header.magic, metadata::Magic, sizeof(metadata::Magic));
+   header.version = metadata::Version;
+   header.digest = digest;
+   header.file_size = pe.size();
+   header.image_base = pe.image_base();
+   header.machine = nt_headers.file_header()->Machine;
+   header.characteristics = nt_headers.file_header()->Characteristics;
+   header.timestamp = nt_headers.file_header()->TimeDateStamp;
+   header.entrypoint = *pe.entrypoint();
+
+   auto fill_optional = [&header] (const auto &optional_header) {
+      header.optional_magic = optional_header.Magic;
+      header.subsystem = optional_header.Subsystem;
+      header.dll_characteristics = optional_header.DllCharacteristics;
+      header.image_size = optional_header.SizeOfImage;
+      header.header_size = optional_header.SizeOfHeaders;
+      header.checksum = optional_header.CheckSum;
+      header.section_alignment = optional_header.SectionAlignment;
+      header.file_alignment = optional_header.FileAlignment;
+   };
+
+   if (nt_headers.is_32()) { fill_optional(*nt_headers.get_32().optional_header().ptr()); }
+   else { fill_optional(*nt_headers.get_64().optional_header().ptr()); }
+
+   auto data_directory = pe.data_directory();
+   header.directory_count = static_cast<std::uint32_t>(std::min<std::size_t>(data_directory.size(),
+                                                                            headers::raw::IMAGE_NUMBEROF_DIRECTORY_ENTRIES));
+
+   for (std::uint32_t i=0; i<header.directory_count; ++i)
+      header.directories[i] = data_directory.get(i);
+
+   auto strings = StringPool();
+   auto sections = std::vector<metadata::Section>();
+   auto section_table = pe.section_table();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto &raw = section_table.get(i);
+      auto section = metadata::Section();
+
+      std::memcpy(section.name, raw.Name, sizeof(section.name));
+      section.virtual_address = raw.VirtualAddress;
+      section.virtual_size = raw.Misc.VirtualSize;
+      section.raw_pointer = raw.PointerToRawData;
+      section.raw_size = raw.SizeOfRawData;
+      section.characteristics = raw.Characteristics;
+      section.reserved = 0;
+
+      // truncated files are common, so hash whatever part of the section is actually present
+      auto start = std::min<std::size_t>(raw.PointerToRawData, pe.size());
+      auto end = std::min<std::size_t>(std::size_t(raw.PointerToRawData) + raw.SizeOfRawData, pe.size());
+      section.hash = fnv1a(pe.ptr() + start, end - start);
+
+      sections.push_back(section);
+   }
+
+   auto imports = std::vector<metadata::Import>();
+
+   for (auto &import : ImportResolver::ImportList(pe))
+   {
+      imports.push_back(metadata::Import{strings.add(import.module),
+                                         strings.add(import.name),
+                                         import.ordinal.value_or(0),
+                                         import.thunk});
+   }
+
+   auto exports = std::vector<metadata::Export>();
+   auto export_index = ExportIndex(pe);
+
+   for (auto &export_entry : export_index.exports())
+   {
+      exports.push_back(metadata::Export{export_entry.ordinal,
+                                         export_entry.rva,
+                                         strings.add(export_entry.name),
+                                         strings.add(export_entry.forwarder)});
+   }
+
+   auto resources = resource_summary(pe);
+   auto record = std::vector<std::uint8_t>(sizeof(metadata::Header), 0);
+
+   header.sections = append_table(record, sections.data(), sections.size());
+   header.imports = append_table(record, imports.data(), imports.size());
+   header.exports = append_table(record, exports.data(), exports.size());
+   header.resources = append_table(record, resources.data(), resources.size());
+   header.strings = append_table(record, strings.data.data(), strings.data.size());
+
+   record.resize(align8(record.size()), 0);
+   header.size = static_cast<std::uint32_t>(record.size());
+   std::memcpy(record.data(), &header, sizeof(header));
+
+   return MetadataView(std::move(record));
+}
+
+#ifdef YAPP_WIN32
+MetadataView
+MetadataView::Load
+(const std::string &filename)
+{
+   auto memory = Memory<std::uint8_t>(filename);
+   return MetadataView(memory.read(0, memory.size()));
+}
+#else
+MetadataView
+MetadataView::Load
+(const std::string &filename)
+{
+   auto fd = open(filename.c_str(), O_RDONLY);
+   if (fd < 0) { throw OpenFileFailureException(filename); }
+
+   struct stat info;
+
+   if (fstat(fd, &info) != 0)
+   {
+      close(fd);
+      throw OpenFileFailureException(filename);
+   }
+
+   auto size = static_cast<std::size_t>(info.st_size);
+   if (size == 0) { close(fd); throw InvalidMetadataException(0); }
+
+   auto mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+   // the mapping keeps its own reference to the file
+   close(fd);
+
+   if (mapping == MAP_FAILED) { throw OpenFileFailureException(filename); }
+
+   auto storage = std::shared_ptr<const std::uint8_t>(static_cast<const std::uint8_t *>(mapping),
+                                                      [size] (const std::uint8_t *pointer) {
+                                                         munmap(const_cast<std::uint8_t *>(pointer), size);
+                                                      });
+
+   return MetadataView(storage, size);
+}
+#endif
+
+void
+MetadataView::save
+(const std::string &filename) const
+{
+   std::ofstream fp(filename, std::ios::binary);
+   if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
+   fp.write(reinterpret_cast<const char *>(this->ptr()), this->header().size);
+   if (!fp) { throw WriteFailureException(filename); }
+
+   fp.close();
+}
+
+std::string_view
+MetadataView::string
+(std::uint32_t offset) const
+{
+   auto &pool = this->header().strings;
+   if (offset >= pool.count) { throw OutOfBoundsException(offset, pool.count); }
+
+   return std::string_view(this->table<char>(pool) + offset);
+}
+
+std::string_view
+MetadataView::section_name
+(const metadata::Section &section) const
+{
+   std::size_t size = sizeof(section.name);
+
+   while (size != 0 && section.name[size-1] == 0) { --size; }
+
+   return std::string_view(reinterpret_cast<const char *>(section.name), size);
+}
+
+MetadataCache::MetadataCache
+(const std::string &directory)
+   : directory(directory),
+     _hits(0),
+     _misses(0)
+{
+   std::error_code error;
+   std::filesystem::create_directories(directory, error);
+
+   if (!std::filesystem::is_directory(directory)) { throw OpenFileFailureException(directory); }
+}
+
+std::string
+MetadataCache::path
+(const Sha256::Digest &digest) const
+{
+   return (std::filesystem::path(this->directory) / (Hex::ToString(digest) + ".ymeta")).string();
+}
+
+std::size_t
+MetadataCache::hits
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->_hits;
+}
+
+std::size_t
+MetadataCache::misses
+() const
+{
+   std::lock_guard<std::mutex> lock(this->mutex);
+   return this->_misses;
+}
+
+std::optional<MetadataView>
+MetadataCache::find
+(const Sha256::Digest &digest, std::uint64_t file_size)
+{
+   std::optional<MetadataView> result;
+
+   try {
+      result = MetadataView::Load(this->path(digest));
+
+      // a record under the wrong name is as good as missing
+      if (result->digest() != digest || result->header().file_size != file_size) { result = std::nullopt; }
+   }
+   catch (Exception &) {
+      result = std::nullopt;
+   }
+
+   std::lock_guard<std::mutex> lock(this->mutex);
+
+   if (result.has_value()) { ++this->_hits; }
+   else { ++this->_misses; }
+
+   return result;
+}
+
+void
+MetadataCache::store
+(const MetadataView &record)
+{
+   auto filename = this->path(record.digest());
+   auto temporary = temporary_name(filename);
+
+   record.save(temporary);
+   rename_into_place(temporary, filename);
+}
+
+MetadataView
+MetadataCache::get
+(const PE &pe)
+{
+   // hash once, for both the lookup and the record built on a miss
+   auto digest = Sha256::Hash(Span<const std::uint8_t>(pe.ptr(), pe.size()));
+   auto cached = this->find(digest, pe.size());
+
+   if (cached.has_value()) { return *cached; }
+
+   auto record = MetadataView::Build(pe, digest);
+   this->store(record);
+
+   return record;
+}
+
+#ifdef YAPP_WIN32
+MetadataView
+MetadataCache::get
+(const std::string &filename)
+{
+   return this->get(PE(filename));
+}
+#else
+MetadataView
+MetadataCache::get
+(const std::string &filename)
+{
+   struct stat before;
+   if (stat(filename.c_str(), &before) != 0) { throw OpenFileFailureException(filename); }
+
+   auto index = (std::filesystem::path(this->directory) / identity_name(before)).string();
+   auto indexed = Sha256::Digest();
+   std::ifstream fp(index, std::ios::binary);
+
+   if (fp.read(reinterpret_cast<char *>(indexed.data()), indexed.size()) && fp.peek() == EOF)
+   {
+      auto cached = this->find(indexed, before.st_size);
+      if (cached.has_value()) { return *cached; }
+   }
+
+   fp.close();
+
+   auto record = this->get(PE(filename));
+
+   // a file which changed while it was read must not be indexed under its old identity
+   struct stat after;
+
+   if (stat(filename.c_str(), &after) != 0 || identity_name(after) != identity_name(before)
+       || record.header().file_size != std::uint64_t(before.st_size))
+      return record;
+
+   auto temporary = temporary_name(index);
+   std::ofstream out(temporary, std::ios::binary);
+   if (!out.is_open()) { throw OpenFileFailureException(temporary); }
+
+   out.write(reinterpret_cast<const char *>(record.digest().data()), record.digest().size());
+   out.close();
+
+   if (!out)
+   {
+      std::error_code error;
+      std::filesystem::remove(temporary, error);
+      throw WriteFailureException(temporary);
+   }
+
+   rename_into_place(temporary, index);
+
+   return record;
+}
+#endif
@@ -0,0 +1,142 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+namespace
+{
+   ParseBudget *&
+   current_budget
+   ()
+   {
+      thread_local ParseBudget *budget = nullptr;
+      return budget;
+   }
+}
+
+ParseBudget::Scope::Scope
+(ParseBudget &budget)
+   : previous(current_budget())
+{
+   current_budget() = &budget;
+}
+
+ParseBudget::Scope::~Scope
+()
+{
+   current_budget() = this->previous;
+}
+
+ParseBudget::ParseBudget
+()
+   : _bytes_touched(0),
+     _elements(0)
+{
+}
+
+ParseBudget &
+ParseBudget::deadline
+(Clock::time_point deadline)
+{
+   this->_deadline = deadline;
+   return *this;
+}
+
+ParseBudget &
+ParseBudget::timeout
+(Clock::duration timeout)
+{
+   return this->deadline(Clock::now() + timeout);
+}
+
+ParseBudget &
+ParseBudget::max_bytes
+(std::size_t size)
+{
+   this->_max_bytes = size;
+   return *this;
+}
+
+ParseBudget &
+ParseBudget::max_elements
+(Structure structure, std::size_t count)
+{
+   this->element_limits[structure] = count;
+   return *this;
+}
+
+ParseBudget &
+ParseBudget::max_elements
+(std::size_t count)
+{
+   for (auto &limit : this->element_limits) { limit = count; }
+   return *this;
+}
+
+void
+ParseBudget::charge
+(Structure structure, std::size_t index, std::size_t bytes)
+{
+   auto &limit = this->element_limits[structure];
+
+   if (limit.has_value() && index >= *limit)
+      throw BudgetExceededException(BudgetExceededException::ELEMENTS, structure);
+
+   auto element = this->_elements++;
+   this->_bytes_touched += bytes;
+
+   if (this->_max_bytes.has_value() && this->_bytes_touched > *this->_max_bytes)
+      throw BudgetExceededException(BudgetExceededException::BYTES, structure);
+
+   // reading the clock costs more than a typical element, so only look at it every so often
+   if (this->_deadline.has_value() && element % ParseBudget::DeadlineInterval == 0 && Clock::now() >= *this->_deadline)
+      throw BudgetExceededException(BudgetExceededException::DEADLINE, structure);
+}
+
+ParseBudget *
+ParseBudget::Current
+()
+{
+   return current_budget();
+}
+
+void
+ParseBudget::Step
+(Structure structure, std::size_t index, std::size_t bytes)
+{
+   auto budget = current_budget();
+   if (budget != nullptr) { budget->charge(structure, index, bytes); }
+}
+
+std::string
+ParseBudget::ReadString
+(const Memory<std::uint8_t> &memory, std::size_t offset)
+{
+   if (offset >= memory.size()) { throw OutOfBoundsException(offset, memory.size()); }
+
+   auto string = reinterpret_cast<const char *>(memory.ptr() + offset);
+   auto available = memory.size() - offset;
+   std::size_t length = 0;
+
+   while (length < available)
+   {
+      auto chunk = available - length;
+      if (chunk > ParseBudget::StringChunk) { chunk = ParseBudget::StringChunk; }
+
+      auto end = static_cast<const char *>(std::memchr(string + length, 0, chunk));
+
+      if (end != nullptr)
+      {
+         auto scanned = static_cast<std::size_t>(end - (string + length));
+         length += scanned;
+         ParseBudget::Step(Structure::STRINGS, length, scanned + 1);
+
+         return std::string(string, length);
+      }
+
+      // charging the length so far fails the walk once it reaches the limit, terminator or not
+      length += chunk;
+      ParseBudget::Step(Structure::STRINGS, length, chunk);
+   }
+
+   throw OutOfBoundsException(offset + length + 1, memory.size());
+}
@@ -0,0 +1,541 @@
+#include <yapp.hpp>
+
+#ifndef YAPP_WIN32
+
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace yapp;
+
+namespace
+{
+   /// How long, in seconds, a client may stall partway through a request or response.
+   const int RequestTimeout = 5;
+
+   /// Wake the poller; a full pipe already has a wakeup pending, so a failed write is harmless.
+   void
+   wake
+   (int pipe)
+   {
+      char byte = 0;
+      auto written = write(pipe, &byte, 1);
+      (void)written;
+   }
+
+   void
+   drain
+   (int pipe)
+   {
+      char buffer[64];
+
+      while (read(pipe, buffer, sizeof(buffer)) > 0) {}
+   }
+
+   bool
+   send_all
+   (int socket, const void *data, std::size_t size)
+   {
+      auto bytes = static_cast<const std::uint8_t *>(data);
+
+      while (size > 0)
+      {
+         auto sent = send(socket, bytes, size, MSG_NOSIGNAL);
+
+         if (sent < 0)
+         {
+            if (errno == EINTR) { continue; }
+            return false;
+         }
+
+         bytes += sent;
+         size -= sent;
+      }
+
+      return true;
+   }
+
+   bool
+   recv_all
+   (int socket, void *data, std::size_t size)
+   {
+      auto bytes = static_cast<std::uint8_t *>(data);
+
+      while (size > 0)
+      {
+         auto received = recv(socket, bytes, size, 0);
+
+         if (received < 0 && errno == EINTR) { continue; }
+         if (received <= 0) { return false; }
+
+         bytes += received;
+         size -= received;
+      }
+
+      return true;
+   }
+
+   /// Closes a descriptor received from a client however the request it came with ends.
+   class PassedDescriptor
+   {
+   public:
+      int fd;
+
+      PassedDescriptor() : fd(-1) {}
+      PassedDescriptor(const PassedDescriptor &) = delete;
+      ~PassedDescriptor() { if (this->fd >= 0) { close(this->fd); } }
+   };
+
+   /// Receive a request header, along with the descriptor passed with it, if any.
+   bool
+   recv_header
+   (int socket, protocol::RequestHeader &header, int &passed)
+   {
+      union {
+         char buffer[CMSG_SPACE(sizeof(int))];
+         struct cmsghdr align;
+      } control;
+
+      struct iovec iov = {&header, sizeof(header)};
+      struct msghdr message;
+
+      std::memset(&message, 0, sizeof(message));
+      message.msg_iov = &iov;
+      message.msg_iovlen = 1;
+      message.msg_control = control.buffer;
+      message.msg_controllen = sizeof(control.buffer);
+
+      ssize_t received;
+
+      do { received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC); } while (received < 0 && errno == EINTR);
+
+      if (received <= 0) { return false; }
+
+      for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+      {
+         if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+            std::memcpy(&passed, CMSG_DATA(cmsg), sizeof(int));
+      }
+
+      // the ancillary data arrives with the first byte, so the rest of the header is plain data
+      return recv_all(socket, reinterpret_cast<std::uint8_t *>(&header) + received, sizeof(header) - received);
+   }
+
+   std::vector<std::uint8_t>
+   read_descriptor
+   (int fd)
+   {
+      struct stat info;
+      if (fstat(fd, &info) != 0) { throw ReadFailureException(std::string("passed descriptor")); }
+
+      auto result = std::vector<std::uint8_t>(static_cast<std::size_t>(info.st_size));
+
+      for (std::size_t offset=0; offset<result.size();)
+      {
+         auto amount = pread(fd, result.data() + offset, result.size() - offset, static_cast<off_t>(offset));
+
+         if (amount < 0 && errno == EINTR) { continue; }
+         if (amount <= 0) { throw ReadFailureException(std::string("passed descriptor")); }
+
+         offset += amount;
+      }
+
+      return result;
+   }
+
+   sockaddr_un
+   socket_address
+   (const std::string &path)
+   {
+      sockaddr_un address;
+      std::memset(&address, 0, sizeof(address));
+
+      if (path.size() >= sizeof(address.sun_path)) { throw OpenFileFailureException(path); }
+
+      address.sun_family = AF_UNIX;
+      std::memcpy(address.sun_path, path.c_str(), path.size());
+
+      return address;
+   }
+}
+
+ParseServer::ParseServer
+(const std::string &path, std::size_t workers, const std::string &cache_directory, unsigned int mode)
+   : _path(path),
+     _workers(std::max<std::size_t>(workers, 1)),
+     listener(-1),
+     stopping(false),
+     _requests(0)
+{
+   if (!cache_directory.empty()) { this->cache = std::unique_ptr<MetadataCache>(new MetadataCache(cache_directory)); }
+
+   auto address = socket_address(path);
+
+   this->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (this->listener < 0) { throw OpenFileFailureException(path); }
+
+   // lets stop and the workers interrupt the poll which waits for connections and requests
+   if (pipe2(this->wakeup, O_CLOEXEC | O_NONBLOCK) != 0)
+   {
+      close(this->listener);
+      throw OpenFileFailureException(path);
+   }
+
+   // a socket file left behind by a previous daemon would make bind fail
+   unlink(path.c_str());
+
+   // the socket file is created with the umask's mode, so narrow it before anyone can connect
+   if (bind(this->listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+       || chmod(path.c_str(), static_cast<mode_t>(mode)) != 0
+       || listen(this->listener, SOMAXCONN) != 0)
+   {
+      unlink(path.c_str());
+      close(this->listener);
+      close(this->wakeup[0]);
+      close(this->wakeup[1]);
+      throw OpenFileFailureException(path);
+   }
+}
+
+ParseServer::~ParseServer
+()
+{
+   this->stop();
+   close(this->listener);
+   close(this->wakeup[0]);
+   close(this->wakeup[1]);
+   unlink(this->_path.c_str());
+}
+
+void
+ParseServer::stop
+()
+{
+   this->stopping = true;
+
+   // shutting down wakes a blocked recv without racing a close against it
+   shutdown(this->listener, SHUT_RDWR);
+   wake(this->wakeup[1]);
+
+   std::lock_guard<std::mutex> lock(this->connection_mutex);
+
+   for (auto connection : this->connections) { shutdown(connection, SHUT_RDWR); }
+}
+
+void
+ParseServer::serve
+()
+{
+   std::deque<int> queue;
+   std::vector<int> returned;
+   std::mutex queue_mutex;
+   std::condition_variable queue_ready;
+   bool done = false;
+   std::vector<std::thread> workers;
+
+   for (std::size_t i=0; i<this->_workers; ++i)
+   {
+      workers.emplace_back([&] () {
+         while (true)
+         {
+            int connection;
+
+            {
+               std::unique_lock<std::mutex> lock(queue_mutex);
+               queue_ready.wait(lock, [&] () { return done || !queue.empty(); });
+
+               if (queue.empty()) { return; }
+
+               connection = queue.front();
+               queue.pop_front();
+            }
+
+            if (this->stopping || !this->serve_request(connection))
+            {
+               this->close_connection(connection);
+               continue;
+            }
+
+            // between requests the connection waits in poll, not on a worker
+            {
+               std::lock_guard<std::mutex> lock(queue_mutex);
+               returned.push_back(connection);
+            }
+
+            wake(this->wakeup[1]);
+         }
+      });
+   }
+
+   // the listener and the wakeup pipe come first, then every connection waiting for its next request
+   std::vector<pollfd> watched = {pollfd{this->listener, POLLIN, 0}, pollfd{this->wakeup[0], POLLIN, 0}};
+
+   while (!this->stopping)
+   {
+      if (poll(watched.data(), watched.size(), -1) < 0)
+      {
+         if (errno != EINTR) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+         continue;
+      }
+
+      if (watched[1].revents != 0) { drain(this->wakeup[0]); }
+
+      // a connection with a request or a hangup pending is handed to a worker until that request is answered
+      std::vector<int> ready;
+
+      for (std::size_t i=watched.size(); i-- > 2;)
+      {
+         if (watched[i].revents == 0) { continue; }
+
+         ready.push_back(watched[i].fd);
+         watched[i] = watched.back();
+         watched.pop_back();
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(queue_mutex);
+
+         for (auto connection : returned) { watched.push_back(pollfd{connection, POLLIN, 0}); }
+         returned.clear();
+
+         for (auto connection : ready) { queue.push_back(connection); }
+      }
+
+      if (!ready.empty()) { queue_ready.notify_all(); }
+
+      if (watched[0].revents == 0) { continue; }
+
+      auto connection = accept4(this->listener, nullptr, nullptr, SOCK_CLOEXEC);
+
+      if (connection < 0)
+      {
+         if (this->stopping) { break; }
+
+         // running out of descriptors is transient, so back off rather than spin or give up
+         if (errno == EMFILE || errno == ENFILE) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+
+         continue;
+      }
+
+      // a client which stalls partway through a request or response would otherwise keep its worker
+      struct timeval timeout = {RequestTimeout, 0};
+      setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+      {
+         std::lock_guard<std::mutex> lock(this->connection_mutex);
+         this->connections.insert(connection);
+
+         if (this->stopping) { shutdown(connection, SHUT_RDWR); }
+      }
+
+      watched.push_back(pollfd{connection, POLLIN, 0});
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(queue_mutex);
+      done = true;
+   }
+
+   queue_ready.notify_all();
+
+   for (auto &worker : workers) { worker.join(); }
+
+   // with the workers gone, nothing else holds the idle connections
+   for (std::size_t i=2; i<watched.size(); ++i) { this->close_connection(watched[i].fd); }
+   for (auto connection : returned) { this->close_connection(connection); }
+}
+
+MetadataView
+ParseServer::handle
+(const protocol::RequestHeader &header, const std::string &path, int fd)
+{
+   // PE can't be reassigned, so each branch builds its own image
+   auto build = [this] (const PE &pe) {
+      if (this->cache != nullptr) { return this->cache->get(pe); }
+      return MetadataView::Build(pe);
+   };
+
+   if (header.type == protocol::PARSE_PATH)
+   {
+      // a path lets the cache skip reading files it has already indexed
+      if (this->cache != nullptr) { return this->cache->get(path); }
+
+      auto filename = path;
+      return build(PE(filename));
+   }
+
+   return build(PE(Memory<std::uint8_t>(read_descriptor(fd))));
+}
+
+bool
+ParseServer::serve_request
+(int connection)
+{
+   auto header = protocol::RequestHeader();
+   PassedDescriptor passed;
+
+   if (!recv_header(connection, header, passed.fd)) { return false; }
+
+   auto path = std::string();
+   auto valid = header.magic == protocol::RequestMagic;
+
+   if (valid && header.type == protocol::PARSE_PATH && header.size <= protocol::MaxPathSize)
+   {
+      path.resize(header.size);
+      if (!recv_all(connection, &path[0], path.size())) { return false; }
+   }
+   else if (!valid || header.type != protocol::PARSE_FD || header.size != 0 || passed.fd < 0) { valid = false; }
+
+   auto response = protocol::ResponseHeader{protocol::ResponseMagic, protocol::OK, 0};
+   std::string error;
+   std::optional<MetadataView> record;
+
+   if (!valid) { error = "malformed request"; }
+   else
+   {
+      try {
+         record = this->handle(header, path, passed.fd);
+      }
+      catch (std::exception &exception) {
+         error = exception.what();
+      }
+   }
+
+   const void *payload;
+
+   if (record.has_value())
+   {
+      response.size = static_cast<std::uint32_t>(record->size());
+      payload = record->ptr();
+   }
+   else
+   {
+      response.status = protocol::ERROR;
+      response.size = static_cast<std::uint32_t>(error.size());
+      payload = error.data();
+   }
+
+   ++this->_requests;
+
+   if (!send_all(connection, &response, sizeof(response)) || !send_all(connection, payload, response.size)) { return false; }
+
+   // after a malformed request the stream can't be trusted to be at a header boundary
+   return valid;
+}
+
+void
+ParseServer::close_connection
+(int connection)
+{
+   std::lock_guard<std::mutex> lock(this->connection_mutex);
+
+   this->connections.erase(connection);
+   close(connection);
+}
+
+ParseClient::ParseClient
+(const std::string &path)
+{
+   auto address = socket_address(path);
+
+   this->connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+   if (this->connection < 0) { throw OpenFileFailureException(path); }
+
+   if (connect(this->connection, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+   {
+      close(this->connection);
+      throw OpenFileFailureException(path);
+   }
+}
+
+ParseClient::~ParseClient
+()
+{
+   close(this->connection);
+}
+
+MetadataView
+ParseClient::exchange
+(const protocol::RequestHeader &header, const std::string &path, int fd)
+{
+   union {
+      char buffer[CMSG_SPACE(sizeof(int))];
+      struct cmsghdr align;
+   } control;
+
+   struct iovec iov = {const_cast<protocol::RequestHeader *>(&header), sizeof(header)};
+   struct msghdr message;
+
+   std::memset(&message, 0, sizeof(message));
+   message.msg_iov = &iov;
+   message.msg_iovlen = 1;
+
+   if (fd >= 0)
+   {
+      std::memset(control.buffer, 0, sizeof(control.buffer));
+      message.msg_control = control.buffer;
+      message.msg_controllen = sizeof(control.buffer);
+
+      auto cmsg = CMSG_FIRSTHDR(&message);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+      std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+   }
+
+   ssize_t sent;
+
+   do { sent = sendmsg(this->connection, &message, MSG_NOSIGNAL); } while (sent < 0 && errno == EINTR);
+
+   if (sent <= 0
+       || !send_all(this->connection, reinterpret_cast<const std::uint8_t *>(&header) + sent, sizeof(header) - sent)
+       || !send_all(this->connection, path.data(), path.size()))
+      throw ReadFailureException(std::string("parse server"));
+
+   auto response = protocol::ResponseHeader();
+
+   if (!recv_all(this->connection, &response, sizeof(response)) || response.magic != protocol::ResponseMagic)
+      throw ReadFailureException(std::string("parse server"));
+
+   auto payload = std::vector<std::uint8_t>(response.size);
+
+   if (!recv_all(this->connection, payload.data(), payload.size())) { throw ReadFailureException(std::string("parse server")); }
+
+   if (response.status != protocol::OK)
+      throw ParseRequestException(std::string(payload.begin(), payload.end()));
+
+   return MetadataView(std::move(payload));
+}
+
+MetadataView
+ParseClient::parse
+(const std::string &path)
+{
+   if (path.size() > protocol::MaxPathSize) { throw ParseRequestException(std::string("path too long")); }
+
+   auto header = protocol::RequestHeader{protocol::RequestMagic, protocol::PARSE_PATH, 0, static_cast<std::uint32_t>(path.size())};
+
+   return this->exchange(header, path, -1);
+}
+
+MetadataView
+ParseClient::parse
+(int fd)
+{
+   auto header = protocol::RequestHeader{protocol::RequestMagic, protocol::PARSE_FD, 0, 0};
+
+   return this->exchange(header, std::string(), fd);
+}
+
+#endif
@@ -0,0 +1,320 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+PatchOverlay::PatchOverlay
+(const Memory<std::uint8_t> &base)
+   : base()
+{
+   // take a non-owning view of the base so that it isn't copied
+   this->base.set_memory(base.ptr(), base.byte_size(), false, true);
+}
+
+bool
+PatchOverlay::is_patched
+(std::size_t offset, std::size_t size) const
+{
+   auto end = offset + size;
+   auto iter = this->patches.upper_bound(offset);
+
+   if (iter != this->patches.begin())
+   {
+      auto prev = std::prev(iter);
+
+      if (prev->first + prev->second.size() > offset) { return true; }
+   }
+
+   return iter != this->patches.end() && iter->first < end;
+}
+
+std::size_t
+PatchOverlay::patched_bytes
+() const
+{
+   std::size_t result = 0;
+
+   for (auto &patch : this->patches)
+      result += patch.second.size();
+
+   return result;
+}
+
+std::uint8_t
+PatchOverlay::get
+(std::size_t offset) const
+{
+   std::uint8_t result;
+   this->read(offset, &result, 1);
+
+   return result;
+}
+
+void
+PatchOverlay::read
+(std::size_t offset, std::uint8_t *buffer, std::size_t size) const
+{
+   if (size == 0) { return; }
+   if (buffer == nullptr) { throw NullPointerException(); }
+   if (offset > this->size() || size > this->size() - offset) { throw OutOfBoundsException(offset, this->size()); }
+
+   std::memcpy(buffer, &this->base.ptr()[offset], size);
+
+   auto end = offset + size;
+   auto iter = this->patches.upper_bound(offset);
+
+   if (iter != this->patches.begin()) { --iter; }
+
+   for (; iter != this->patches.end() && iter->first < end; ++iter)
+   {
+      auto patch_start = iter->first;
+      auto patch_end = patch_start + iter->second.size();
+
+      if (patch_end <= offset) { continue; }
+
+      auto copy_start = std::max<std::size_t>(patch_start, offset);
+      auto copy_end = std::min<std::size_t>(patch_end, end);
+
+      std::memcpy(&buffer[copy_start - offset], &iter->second[copy_start - patch_start], copy_end - copy_start);
+   }
+}
+
+std::vector<std::uint8_t>
+PatchOverlay::read
+(std::size_t offset, std::size_t size) const
+{
+   auto result = std::vector<std::uint8_t>(size);
+   this->read(offset, result.data(), size);
+
+   return result;
+}
+
+void
+PatchOverlay::write
+(std::size_t offset, const std::uint8_t *pointer, std::size_t size)
+{
+   if (size == 0) { return; }
+   if (pointer == nullptr) { throw NullPointerException(); }
+   if (offset > this->size() || size > this->size() - offset) { throw OutOfBoundsException(offset, this->size()); }
+
+   auto merged_start = offset;
+   auto merged_end = offset + size;
+
+   // find every patch that overlaps or touches the new range so they can be merged into one
+   auto first = this->patches.upper_bound(offset);
+
+   if (first != this->patches.begin())
+   {
+      auto prev = std::prev(first);
+
+      if (prev->first + prev->second.size() >= offset) { first = prev; }
+   }
+
+   auto last = first;
+
+   while (last != this->patches.end() && last->first <= offset + size)
+   {
+      merged_start = std::min<std::size_t>(merged_start, last->first);
+      merged_end = std::max<std::size_t>(merged_end, last->first + last->second.size());
+      ++last;
+   }
+
+   auto merged = std::vector<std::uint8_t>(merged_end - merged_start);
+
+   for (auto iter=first; iter!=last; ++iter)
+      std::memcpy(&merged[iter->first - merged_start], iter->second.data(), iter->second.size());
+
+   std::memcpy(&merged[offset - merged_start], pointer, size);
+
+   this->patches.erase(first, last);
+   this->patches.emplace(merged_start, std::move(merged));
+}
+
+void
+PatchOverlay::write
+(std::size_t offset, const std::vector<std::uint8_t> &vector)
+{
+   this->write(offset, vector.data(), vector.size());
+}
+
+void
+PatchOverlay::revert
+(std::size_t offset, std::size_t size)
+{
+   if (size == 0) { return; }
+
+   auto end = offset + size;
+   auto iter = this->patches.upper_bound(offset);
+
+   if (iter != this->patches.begin()) { --iter; }
+
+   while (iter != this->patches.end() && iter->first < end)
+   {
+      auto patch_start = iter->first;
+      auto patch_end = patch_start + iter->second.size();
+
+      if (patch_end <= offset) { ++iter; continue; }
+
+      auto data = std::move(iter->second);
+      iter = this->patches.erase(iter);
+
+      // keep whatever parts of the patch fall outside of the reverted range
+      if (patch_start < offset)
+         this->patches.emplace(patch_start, std::vector<std::uint8_t>(data.begin(), data.begin() + (offset - patch_start)));
+
+      if (patch_end > end)
+         iter = this->patches.emplace(end, std::vector<std::uint8_t>(data.begin() + (end - patch_start), data.end())).first;
+   }
+}
+
+void
+PatchOverlay::apply
+(Memory<std::uint8_t> &target) const
+{
+   if (target.byte_size() < this->size()) { throw OutOfBoundsException(this->size(), target.byte_size()); }
+
+   auto bytes = target.ptr();
+   if (bytes == nullptr) { throw NullPointerException(); }
+
+   for (auto &patch : this->patches)
+      std::memcpy(&bytes[patch.first], patch.second.data(), patch.second.size());
+}
+
+Memory<std::uint8_t>
+PatchOverlay::materialize
+() const
+{
+   auto result = Memory<std::uint8_t>(this->base.ptr(), this->size(), true);
+   this->apply(result);
+
+   return result;
+}
+
+void
+PatchOverlay::save
+(const std::string &filename) const
+{
+   auto writer = ImageWriter();
+   auto bytes = this->base.ptr();
+   std::size_t offset = 0;
+
+   for (auto &patch : this->patches)
+   {
+      writer.add(&bytes[offset], patch.first - offset);
+      writer.add(patch.second.data(), patch.second.size());
+      offset = patch.first + patch.second.size();
+   }
+
+   writer.add(&bytes[offset], this->size() - offset);
+   writer.write(filename);
+}
+
+void
+PatchOverlay::save
+(const std::string &filename, const std::string &source) const
+{
+   auto writer = ImageWriter(source);
+   std::size_t offset = 0;
+
+   for (auto &patch : this->patches)
+   {
+      writer.add_source(offset, patch.first - offset);
+      writer.add(patch.second.data(), patch.second.size());
+      offset = patch.first + patch.second.size();
+   }
+
+   writer.add_source(offset, this->size() - offset);
+   writer.write(filename);
+}
+
+std::vector<std::uint8_t>
+PatchOverlay::diff
+() const
+{
+   auto result = std::vector<std::uint8_t>();
+   auto push = [&result] (const void *data, std::size_t size) {
+      auto bytes = reinterpret_cast<const std::uint8_t *>(data);
+      result.insert(result.end(), bytes, &bytes[size]);
+   };
+
+   auto magic = PatchOverlay::DiffMagic;
+   auto count = static_cast<std::uint32_t>(this->patches.size());
+
+   push(&magic, sizeof(magic));
+   push(&count, sizeof(count));
+
+   for (auto &patch : this->patches)
+   {
+      auto offset = static_cast<std::uint64_t>(patch.first);
+      auto size = static_cast<std::uint32_t>(patch.second.size());
+
+      push(&offset, sizeof(offset));
+      push(&size, sizeof(size));
+      push(patch.second.data(), patch.second.size());
+   }
+
+   return result;
+}
+
+void
+PatchOverlay::save_diff
+(const std::string &filename) const
+{
+   std::ofstream fp(filename, std::ios::binary);
+   if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
+   auto data = this->diff();
+   fp.write(reinterpret_cast<const char *>(data.data()), data.size());
+   fp.close();
+
+   if (!fp) { throw WriteFailureException(filename); }
+}
+
+void
+PatchOverlay::load_diff
+(const Memory<std::uint8_t> &diff)
+{
+   std::size_t offset = 0;
+   auto take = [&diff, &offset] (void *out, std::size_t size) {
+      if (size > diff.byte_size() - offset) { throw InvalidDiffException(offset); }
+      std::memcpy(out, &diff.ptr()[offset], size);
+      offset += size;
+   };
+
+   std::uint32_t magic, count;
+
+   take(&magic, sizeof(magic));
+   if (magic != PatchOverlay::DiffMagic) { throw InvalidDiffException(0); }
+
+   take(&count, sizeof(count));
+
+   struct Record
+   {
+      std::size_t offset;
+      std::size_t data;
+      std::uint32_t size;
+   };
+
+   // validate every record before applying any, so a bad diff leaves the overlay untouched
+   std::vector<Record> records;
+
+   for (std::uint32_t i=0; i<count; ++i)
+   {
+      auto record_start = offset;
+      std::uint64_t patch_offset;
+      std::uint32_t patch_size;
+
+      take(&patch_offset, sizeof(patch_offset));
+      take(&patch_size, sizeof(patch_size));
+
+      if (patch_size > diff.byte_size() - offset) { throw InvalidDiffException(offset); }
+
+      // checked before the offset is narrowed, so it can't wrap
+      if (patch_offset > this->size() || patch_size > this->size() - patch_offset) { throw InvalidDiffException(record_start); }
+
+      records.push_back(Record{static_cast<std::size_t>(patch_offset), offset, patch_size});
+      offset += patch_size;
+   }
+
+   for (auto &record : records)
+      this->write(record.offset, &diff.ptr()[record.data], record.size);
+}
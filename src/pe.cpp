@@ -0,0 +1,109 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+headers::SectionHeader
+PE::append_section
+(const headers::SectionHeader &section, const std::vector<std::uint8_t> &data)
+{
+   auto layout = SectionLayout(*this);
+   auto index = layout.add_section(*section.ptr(), data);
+   layout.commit();
+
+   return this->section_table()[index];
+}
+
+std::size_t
+PE::HeaderExtent
+(const std::uint8_t *data, std::size_t size)
+{
+   if (size < sizeof(headers::raw::IMAGE_DOS_HEADER)) { return sizeof(headers::raw::IMAGE_DOS_HEADER); }
+
+   std::uint16_t signature;
+   std::uint32_t e_lfanew;
+
+   std::memcpy(&signature, data, sizeof(signature));
+   std::memcpy(&e_lfanew, data + offsetof(headers::raw::IMAGE_DOS_HEADER, e_lfanew), sizeof(e_lfanew));
+
+   if (signature != headers::raw::IMAGE_DOS_SIGNATURE) { throw InvalidDOSSignatureException(signature); }
+
+   // the signature, the file header and the optional header's magic
+   auto file_header = std::size_t(e_lfanew) + sizeof(std::uint32_t);
+   auto extent = file_header + sizeof(headers::raw::IMAGE_FILE_HEADER) + sizeof(std::uint16_t);
+
+   if (extent > PE::MaxHeaderExtent) { throw OversizedHeadersException(extent, PE::MaxHeaderExtent); }
+   if (size < extent) { return extent; }
+
+   headers::raw::IMAGE_FILE_HEADER header;
+   std::memcpy(&header, data + file_header, sizeof(header));
+
+   extent = file_header + sizeof(header) + header.SizeOfOptionalHeader
+      + header.NumberOfSections * sizeof(headers::raw::IMAGE_SECTION_HEADER);
+
+   if (extent > PE::MaxHeaderExtent) { throw OversizedHeadersException(extent, PE::MaxHeaderExtent); }
+
+   return extent;
+}
+
+PE
+PE::LoadHeaders
+(const std::string &filename)
+{
+   std::ifstream fp(filename, std::ios::binary);
+   if (!fp.is_open()) { throw OpenFileFailureException(filename); }
+
+   auto buffer = std::vector<std::uint8_t>();
+   auto needed = PE::HeaderExtent(buffer.data(), buffer.size());
+
+   // the extent grows as more of the headers are read, so keep reading until it stops. reads are
+   // at least a page, which usually holds every header at once
+   while (needed > buffer.size())
+   {
+      auto have = buffer.size();
+
+      buffer.resize(std::max<std::size_t>(needed, have + 0x1000));
+      fp.read(reinterpret_cast<char *>(buffer.data() + have), buffer.size() - have);
+      buffer.resize(have + static_cast<std::size_t>(fp.gcount()));
+
+      if (buffer.size() < needed) { throw ReadFailureException(filename); }
+
+      needed = PE::HeaderExtent(buffer.data(), buffer.size());
+   }
+
+   return PE(Memory<std::uint8_t>(buffer));
+}
+
+std::optional<std::pair<std::size_t, std::size_t>>
+PE::directory_file_range
+(std::size_t index) const
+{
+   auto data_directory = this->data_directory();
+   if (index >= data_directory.size()) { return std::nullopt; }
+
+   auto &entry = data_directory.get(index);
+   if (entry.VirtualAddress == 0 || entry.Size == 0) { return std::nullopt; }
+
+   // the certificate table is the one directory addressed by file offset
+   if (index == headers::raw::IMAGE_DIRECTORY_ENTRY_SECURITY)
+      return std::make_pair(std::size_t(entry.VirtualAddress), std::size_t(entry.VirtualAddress) + entry.Size);
+
+   auto section_table = this->section_table();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto &section = section_table.get(i);
+      auto extent = std::max(section.Misc.VirtualSize, section.SizeOfRawData);
+
+      if (entry.VirtualAddress >= section.VirtualAddress && entry.VirtualAddress - section.VirtualAddress < extent)
+      {
+         auto offset = std::size_t(entry.VirtualAddress) - section.VirtualAddress + section.PointerToRawData;
+         return std::make_pair(offset, offset + entry.Size);
+      }
+   }
+
+   // outside every section, the RVA is a header offset
+   if (entry.VirtualAddress < this->size())
+      return std::make_pair(std::size_t(entry.VirtualAddress), std::size_t(entry.VirtualAddress) + entry.Size);
+
+   return std::nullopt;
+}
@@ -0,0 +1,255 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+PieceTable::PieceTable
+()
+   : original(),
+     _size(0)
+{
+}
+
+PieceTable::PieceTable
+(const Memory<std::uint8_t> &original)
+   : original(),
+     _size(0)
+{
+   if (original.byte_size() == 0) { return; }
+
+   // take a non-owning view of the original so that no copy is made, and so that
+   // the view is invalidated if the original is deallocated out from under us
+   this->original.set_memory(original.ptr(), original.byte_size(), false, true);
+
+   this->pieces.push_back(Piece{Source::ORIGINAL, 0, original.byte_size()});
+   this->_size = original.byte_size();
+}
+
+const std::uint8_t *
+PieceTable::piece_data
+(const Piece &piece) const
+{
+   if (piece.source == Source::ORIGINAL)
+      return &this->original.ptr()[piece.offset];
+   else
+      return &this->added.data()[piece.offset];
+}
+
+std::size_t
+PieceTable::find_piece
+(std::size_t offset, std::size_t &piece_start) const
+{
+   std::size_t start = 0;
+
+   for (std::size_t i=0; i<this->pieces.size(); ++i)
+   {
+      auto &piece = this->pieces[i];
+
+      if (offset < start + piece.size)
+      {
+         piece_start = start;
+         return i;
+      }
+
+      start += piece.size;
+   }
+
+   piece_start = start;
+   return this->pieces.size();
+}
+
+std::size_t
+PieceTable::split
+(std::size_t offset)
+{
+   std::size_t piece_start;
+   auto index = this->find_piece(offset, piece_start);
+
+   if (index == this->pieces.size() || piece_start == offset)
+      return index;
+
+   auto &piece = this->pieces[index];
+   auto left_size = offset - piece_start;
+   Piece right = { piece.source, piece.offset + left_size, piece.size - left_size };
+   piece.size = left_size;
+
+   this->pieces.insert(this->pieces.begin() + index + 1, right);
+
+   return index+1;
+}
+
+bool
+PieceTable::is_modified
+() const
+{
+   if (this->pieces.size() == 0) { return this->original.byte_size() != 0; }
+   if (this->pieces.size() != 1) { return true; }
+
+   auto &piece = this->pieces[0];
+
+   return piece.source != Source::ORIGINAL || piece.offset != 0 || piece.size != this->original.byte_size();
+}
+
+std::uint8_t
+PieceTable::get
+(std::size_t offset) const
+{
+   if (offset >= this->_size) { throw OutOfBoundsException(offset, this->_size); }
+
+   std::size_t piece_start;
+   auto index = this->find_piece(offset, piece_start);
+
+   return this->piece_data(this->pieces[index])[offset - piece_start];
+}
+
+void
+PieceTable::read
+(std::size_t offset, std::uint8_t *buffer, std::size_t size) const
+{
+   if (size == 0) { return; }
+   if (buffer == nullptr) { throw NullPointerException(); }
+   if (offset + size > this->_size) { throw OutOfBoundsException(offset + size, this->_size); }
+
+   std::size_t piece_start;
+   auto index = this->find_piece(offset, piece_start);
+   std::size_t written = 0;
+   auto skip = offset - piece_start;
+
+   while (written < size)
+   {
+      auto &piece = this->pieces[index++];
+      auto amount = std::min<std::size_t>(piece.size - skip, size - written);
+
+      std::memcpy(&buffer[written], &this->piece_data(piece)[skip], amount);
+
+      written += amount;
+      skip = 0;
+   }
+}
+
+std::vector<std::uint8_t>
+PieceTable::read
+(std::size_t offset, std::size_t size) const
+{
+   auto result = std::vector<std::uint8_t>(size);
+   this->read(offset, result.data(), size);
+
+   return result;
+}
+
+void
+PieceTable::insert
+(std::size_t offset, const std::uint8_t *pointer, std::size_t size)
+{
+   if (offset > this->_size) { throw OutOfBoundsException(offset, this->_size); }
+   if (size == 0) { return; }
+   if (pointer == nullptr) { throw NullPointerException(); }
+
+   auto added_offset = this->added.size();
+   this->added.insert(this->added.end(), pointer, &pointer[size]);
+
+   auto index = this->split(offset);
+
+   // consecutive appends to the added buffer extend the previous piece rather than creating a new one
+   if (index > 0)
+   {
+      auto &previous = this->pieces[index-1];
+
+      if (previous.source == Source::ADDED && previous.offset + previous.size == added_offset)
+      {
+         previous.size += size;
+         this->_size += size;
+         return;
+      }
+   }
+
+   this->pieces.insert(this->pieces.begin() + index, Piece{Source::ADDED, added_offset, size});
+   this->_size += size;
+}
+
+void
+PieceTable::insert
+(std::size_t offset, const std::vector<std::uint8_t> &vector)
+{
+   this->insert(offset, vector.data(), vector.size());
+}
+
+void
+PieceTable::append
+(const std::uint8_t *pointer, std::size_t size)
+{
+   this->insert(this->_size, pointer, size);
+}
+
+void
+PieceTable::append
+(const std::vector<std::uint8_t> &vector)
+{
+   this->insert(this->_size, vector.data(), vector.size());
+}
+
+void
+PieceTable::erase
+(std::size_t start, std::size_t end)
+{
+   if (end > this->_size) { throw OutOfBoundsException(end, this->_size); }
+   if (start > end) { throw OutOfBoundsException(start, end); }
+   if (start == end) { return; }
+
+   auto first = this->split(start);
+   auto last = this->split(end);
+
+   this->pieces.erase(this->pieces.begin() + first, this->pieces.begin() + last);
+   this->_size -= end - start;
+}
+
+void
+PieceTable::write
+(std::size_t offset, const std::uint8_t *pointer, std::size_t size)
+{
+   if (offset + size > this->_size) { throw OutOfBoundsException(offset + size, this->_size); }
+   if (size == 0) { return; }
+   if (pointer == nullptr) { throw NullPointerException(); }
+
+   this->erase(offset, offset + size);
+   this->insert(offset, pointer, size);
+}
+
+void
+PieceTable::write
+(std::size_t offset, const std::vector<std::uint8_t> &vector)
+{
+   this->write(offset, vector.data(), vector.size());
+}
+
+Memory<std::uint8_t>
+PieceTable::materialize
+() const
+{
+   auto result = Memory<std::uint8_t>();
+
+   if (this->_size == 0) { return result; }
+
+   result.allocate(this->_size);
+   auto buffer = result.ptr();
+   std::size_t written = 0;
+
+   for (auto &piece : this->pieces)
+   {
+      std::memcpy(&buffer[written], this->piece_data(piece), piece.size);
+      written += piece.size;
+   }
+
+   return result;
+}
+
+void
+PieceTable::save
+(const std::string &filename) const
+{
+   auto writer = ImageWriter();
+
+   for (auto &piece : this->pieces)
+      writer.add(this->piece_data(piece), piece.size);
+
+   writer.write(filename);
+}
@@ -0,0 +1,331 @@
+#include <yapp.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <thread>
+
+#ifndef YAPP_WIN32
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define YAPP_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   std::ptrdiff_t
+   read_at
+   (FileRead &read)
+   {
+#ifdef YAPP_WIN32
+      std::ifstream fp(read.filename, std::ios::binary);
+      if (!fp.is_open()) { return -1; }
+
+      fp.seekg(read.offset);
+      fp.read(reinterpret_cast<char *>(read.buffer), read.size);
+
+      return static_cast<std::ptrdiff_t>(fp.gcount());
+#else
+      auto result = pread(read.fd, read.buffer, read.size, static_cast<off_t>(read.offset));
+
+      return (result < 0) ? -errno : result;
+#endif
+   }
+
+   class PoolQueue : public ReadQueue
+   {
+   protected:
+      std::vector<std::thread> threads;
+      std::deque<FileRead *> requests;
+      std::deque<FileRead *> completions;
+      std::mutex mutex;
+      std::condition_variable request_ready;
+      std::condition_variable completion_ready;
+      bool stopping;
+
+      void work() {
+         while (true)
+         {
+            FileRead *read;
+
+            {
+               std::unique_lock<std::mutex> lock(this->mutex);
+               this->request_ready.wait(lock, [this] () { return this->stopping || !this->requests.empty(); });
+
+               if (this->stopping) { return; }
+
+               read = this->requests.front();
+               this->requests.pop_front();
+            }
+
+            read->result = read_at(*read);
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->completions.push_back(read);
+            this->completion_ready.notify_one();
+         }
+      }
+
+   public:
+      PoolQueue(std::size_t count) : stopping(false) {
+         for (std::size_t i=0; i<std::max<std::size_t>(count, 1); ++i)
+            this->threads.emplace_back([this] () { this->work(); });
+      }
+
+      ~PoolQueue() {
+         {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+         }
+
+         this->request_ready.notify_all();
+
+         for (auto &thread : this->threads) { thread.join(); }
+      }
+
+      Backend backend() const { return Backend::THREAD_POOL; }
+      std::size_t capacity() const { return std::numeric_limits<std::size_t>::max(); }
+
+      void submit(FileRead *read) {
+         std::lock_guard<std::mutex> lock(this->mutex);
+
+         this->requests.push_back(read);
+         this->request_ready.notify_one();
+      }
+
+      void flush() {}
+
+      FileRead *wait() {
+         std::unique_lock<std::mutex> lock(this->mutex);
+         this->completion_ready.wait(lock, [this] () { return !this->completions.empty(); });
+
+         auto read = this->completions.front();
+         this->completions.pop_front();
+
+         return read;
+      }
+   };
+
+#ifdef YAPP_IO_URING
+   int
+   uring_setup
+   (unsigned entries, io_uring_params *params)
+   {
+      return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+   }
+
+   int
+   uring_enter
+   (int fd, unsigned submit, unsigned complete, unsigned flags)
+   {
+      return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0));
+   }
+
+   /// A minimal io_uring driver; liburing isn't required, only the kernel header.
+   class UringQueue : public ReadQueue
+   {
+   protected:
+      int ring;
+      unsigned entries;
+      std::size_t queued;
+      void *sq_ring;
+      void *cq_ring;
+      std::size_t sq_ring_size;
+      std::size_t cq_ring_size;
+      std::size_t sqes_size;
+      unsigned *sq_tail;
+      unsigned *sq_mask;
+      unsigned *sq_array;
+      unsigned *cq_head;
+      unsigned *cq_tail;
+      unsigned *cq_mask;
+      io_uring_sqe *sqes;
+      io_uring_cqe *cqes;
+
+      template <typename T>
+      static T *at(void *ring, std::uint32_t offset) {
+         return reinterpret_cast<T *>(static_cast<std::uint8_t *>(ring) + offset);
+      }
+
+      void release() {
+         if (this->sqes != nullptr) { munmap(this->sqes, this->sqes_size); }
+         if (this->cq_ring != MAP_FAILED) { munmap(this->cq_ring, this->cq_ring_size); }
+         if (this->sq_ring != MAP_FAILED) { munmap(this->sq_ring, this->sq_ring_size); }
+         if (this->ring >= 0) { close(this->ring); }
+
+         this->sqes = nullptr;
+         this->sq_ring = this->cq_ring = MAP_FAILED;
+         this->ring = -1;
+      }
+
+   public:
+      UringQueue(unsigned entries) : queued(0), sq_ring(MAP_FAILED), cq_ring(MAP_FAILED), sqes(nullptr) {
+         io_uring_params params;
+         std::memset(&params, 0, sizeof(params));
+
+         this->ring = uring_setup(entries, &params);
+         if (this->ring < 0) { throw UnsupportedBackendException(); }
+
+         this->entries = params.sq_entries;
+         this->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+         this->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+         this->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+         this->sq_ring = mmap(nullptr, this->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              this->ring, IORING_OFF_SQ_RING);
+         this->cq_ring = mmap(nullptr, this->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              this->ring, IORING_OFF_CQ_RING);
+         auto sqes = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          this->ring, IORING_OFF_SQES);
+
+         if (this->sq_ring == MAP_FAILED || this->cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+         {
+            if (sqes != MAP_FAILED) { munmap(sqes, this->sqes_size); }
+            this->release();
+            throw UnsupportedBackendException();
+         }
+
+         this->sqes = static_cast<io_uring_sqe *>(sqes);
+         this->sq_tail = at<unsigned>(this->sq_ring, params.sq_off.tail);
+         this->sq_mask = at<unsigned>(this->sq_ring, params.sq_off.ring_mask);
+         this->sq_array = at<unsigned>(this->sq_ring, params.sq_off.array);
+         this->cq_head = at<unsigned>(this->cq_ring, params.cq_off.head);
+         this->cq_tail = at<unsigned>(this->cq_ring, params.cq_off.tail);
+         this->cq_mask = at<unsigned>(this->cq_ring, params.cq_off.ring_mask);
+         this->cqes = at<io_uring_cqe>(this->cq_ring, params.cq_off.cqes);
+      }
+
+      ~UringQueue() { this->release(); }
+
+      Backend backend() const { return Backend::IO_URING; }
+      std::size_t capacity() const { return this->entries; }
+
+      void submit(FileRead *read) {
+         // a full submission queue would overwrite entries the kernel hasn't taken yet
+         if (this->queued >= this->entries) { this->flush(); }
+         if (this->queued >= this->entries) { throw ReadFailureException(std::string("io_uring submission queue")); }
+
+         // this thread is the only producer, so the tail can be read plainly
+         auto tail = *this->sq_tail;
+         auto index = tail & *this->sq_mask;
+         auto sqe = &this->sqes[index];
+
+         read->iov.iov_base = read->buffer;
+         read->iov.iov_len = read->size;
+
+         // READV rather than READ, which needs a newer kernel
+         std::memset(sqe, 0, sizeof(io_uring_sqe));
+         sqe->opcode = IORING_OP_READV;
+         sqe->fd = read->fd;
+         sqe->addr = reinterpret_cast<std::uint64_t>(&read->iov);
+         sqe->len = 1;
+         sqe->off = read->offset;
+         sqe->user_data = reinterpret_cast<std::uint64_t>(read);
+
+         this->sq_array[index] = index;
+         __atomic_store_n(this->sq_tail, tail + 1, __ATOMIC_RELEASE);
+         ++this->queued;
+      }
+
+      void flush() {
+         while (this->queued > 0)
+         {
+            auto submitted = uring_enter(this->ring, static_cast<unsigned>(this->queued), 0, 0);
+
+            if (submitted < 0)
+            {
+               if (errno == EINTR) { continue; }
+
+               // the kernel takes no more until completions are reaped, so leave the rest queued
+               // for wait to submit once it has made room
+               if (errno == EAGAIN || errno == EBUSY) { return; }
+
+               throw ReadFailureException(std::string("io_uring"));
+            }
+
+            this->queued -= submitted;
+         }
+      }
+
+      FileRead *wait() {
+         while (true)
+         {
+            // reap before submitting, since a full completion queue is what makes submission fail
+            auto head = *this->cq_head;
+
+            if (head != __atomic_load_n(this->cq_tail, __ATOMIC_ACQUIRE))
+            {
+               auto &cqe = this->cqes[head & *this->cq_mask];
+               auto read = reinterpret_cast<FileRead *>(cqe.user_data);
+
+               read->result = cqe.res;
+               __atomic_store_n(this->cq_head, head + 1, __ATOMIC_RELEASE);
+
+               return read;
+            }
+
+            this->flush();
+
+            // waiting also moves completions the kernel had to hold back into the now empty queue
+            if (uring_enter(this->ring, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EBUSY)
+               throw ReadFailureException(std::string("io_uring"));
+         }
+      }
+   };
+#endif
+}
+
+ReadQueue::Backend
+ReadQueue::Select
+(Backend backend)
+{
+   auto has_io_uring = ReadQueue::HasIoUring();
+
+   if (backend == Backend::IO_URING && !has_io_uring) { throw UnsupportedBackendException(); }
+   if (backend == Backend::AUTO) { return (has_io_uring) ? Backend::IO_URING : Backend::THREAD_POOL; }
+
+   return backend;
+}
+
+std::unique_ptr<ReadQueue>
+ReadQueue::Create
+(Backend backend, std::size_t depth, std::size_t threads)
+{
+#ifdef YAPP_IO_URING
+   if (ReadQueue::Select(backend) == Backend::IO_URING)
+      return std::unique_ptr<ReadQueue>(new UringQueue(static_cast<unsigned>(std::max<std::size_t>(depth, 8))));
+#else
+   ReadQueue::Select(backend);
+#endif
+
+   return std::unique_ptr<ReadQueue>(new PoolQueue(threads));
+}
+
+bool
+ReadQueue::HasIoUring
+()
+{
+#ifdef YAPP_IO_URING
+   io_uring_params params;
+   std::memset(&params, 0, sizeof(params));
+
+   // seccomp filters and sysctls can disable io_uring even on kernels which have it
+   auto ring = uring_setup(1, &params);
+   if (ring < 0) { return false; }
+
+   close(ring);
+   return true;
+#else
+   return false;
+#endif
+}
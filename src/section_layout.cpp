@@ -0,0 +1,360 @@
+#include <yapp.hpp>
+
+using namespace yapp;
+
+SectionLayout::SectionLayout
+(PE &pe)
+   : pe(pe)
+{
+   if (pe.image_type() != PE::ImageType::DISK) { throw UnsupportedImageTypeException(); }
+
+   auto section_table = pe.section_table();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto header = section_table[i];
+      this->entries.push_back(Entry{*header.ptr(), i, std::nullopt, header->SizeOfRawData});
+   }
+}
+
+SectionLayout::Entry &
+SectionLayout::entry
+(std::size_t index)
+{
+   if (index >= this->entries.size()) { throw OutOfBoundsException(index, this->entries.size()); }
+
+   return this->entries[index];
+}
+
+const SectionLayout::Entry &
+SectionLayout::entry
+(std::size_t index) const
+{
+   if (index >= this->entries.size()) { throw OutOfBoundsException(index, this->entries.size()); }
+
+   return this->entries[index];
+}
+
+std::size_t
+SectionLayout::header_end
+(std::size_t sections) const
+{
+   return *this->pe.section_table_offset() + sections * sizeof(headers::raw::IMAGE_SECTION_HEADER);
+}
+
+std::size_t
+SectionLayout::overlay_offset
+() const
+{
+   auto nt_headers = this->pe.valid_nt_headers();
+   std::size_t result;
+
+   if (nt_headers.is_32()) { result = nt_headers.get_32().optional_header()->SizeOfHeaders; }
+   else { result = nt_headers.get_64().optional_header()->SizeOfHeaders; }
+
+   auto section_table = this->pe.section_table();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto section = section_table[i];
+      std::size_t end = section->PointerToRawData + section->SizeOfRawData;
+
+      if (section->SizeOfRawData != 0 && end > result) { result = end; }
+   }
+
+   return std::min<std::size_t>(result, this->pe.size());
+}
+
+std::size_t
+SectionLayout::find
+(const std::string &name) const
+{
+   for (std::size_t i=0; i<this->entries.size(); ++i)
+   {
+      auto &header = this->entries[i].header;
+      std::size_t size = headers::raw::IMAGE_SIZEOF_SHORT_NAME;
+
+      while (size != 0 && header.Name[size-1] == 0)
+         --size;
+
+      if (name == std::string(reinterpret_cast<const char *>(&header.Name[0]), size))
+         return i;
+   }
+
+   throw SectionNotFoundException();
+}
+
+std::size_t
+SectionLayout::add_section
+(const headers::raw::IMAGE_SECTION_HEADER &section, const std::vector<std::uint8_t> &data)
+{
+   auto header = section;
+
+   if (header.Misc.VirtualSize == 0) { header.Misc.VirtualSize = static_cast<std::uint32_t>(data.size()); }
+
+   // placement is computed when planning, so any placement given by the caller is dropped
+   header.VirtualAddress = 0;
+   header.PointerToRawData = 0;
+   header.SizeOfRawData = 0;
+
+   this->entries.push_back(Entry{header, std::nullopt, data, data.size()});
+
+   return this->entries.size()-1;
+}
+
+std::size_t
+SectionLayout::add_section
+(const std::string &name, std::uint32_t characteristics, const std::vector<std::uint8_t> &data, std::optional<std::uint32_t> virtual_size)
+{
+   headers::raw::IMAGE_SECTION_HEADER header;
+   std::memset(&header, 0, sizeof(header));
+
+   std::memcpy(&header.Name[0],
+               name.c_str(),
+               std::min<std::size_t>(name.size(), headers::raw::IMAGE_SIZEOF_SHORT_NAME));
+
+   header.Characteristics = characteristics;
+   header.Misc.VirtualSize = std::max<std::uint32_t>(virtual_size.value_or(0), static_cast<std::uint32_t>(data.size()));
+
+   return this->add_section(header, data);
+}
+
+void
+SectionLayout::remove_section
+(std::size_t index)
+{
+   this->entry(index);
+   this->entries.erase(this->entries.begin() + index);
+}
+
+void
+SectionLayout::remove_section
+(const std::string &name)
+{
+   this->remove_section(this->find(name));
+}
+
+void
+SectionLayout::resize_section
+(std::size_t index, std::uint32_t size)
+{
+   auto &entry = this->entry(index);
+
+   entry.header.Misc.VirtualSize = size;
+   entry.raw_size = size;
+
+   if (entry.data.has_value()) { entry.data->resize(size, 0); }
+}
+
+void
+SectionLayout::resize_section
+(const std::string &name, std::uint32_t size)
+{
+   this->resize_section(this->find(name), size);
+}
+
+void
+SectionLayout::set_section_data
+(std::size_t index, const std::vector<std::uint8_t> &data)
+{
+   auto &entry = this->entry(index);
+
+   entry.data = data;
+   entry.raw_size = data.size();
+
+   if (entry.header.Misc.VirtualSize < data.size()) { entry.header.Misc.VirtualSize = static_cast<std::uint32_t>(data.size()); }
+}
+
+std::vector<headers::raw::IMAGE_SECTION_HEADER>
+SectionLayout::plan
+() const
+{
+   if (this->entries.size() > 0xFFFF) { throw SectionTableOverflowException(); }
+
+   auto nt_headers = this->pe.valid_nt_headers();
+   std::uint32_t size_of_headers;
+
+   if (nt_headers.is_32()) { size_of_headers = nt_headers.get_32().optional_header()->SizeOfHeaders; }
+   else { size_of_headers = nt_headers.get_64().optional_header()->SizeOfHeaders; }
+
+   auto header_end = static_cast<std::uint32_t>(this->header_end(this->entries.size()));
+   size_of_headers = std::max<std::uint32_t>(size_of_headers, this->pe.align_to_file<std::uint32_t>(header_end));
+
+   auto virtual_span = [this] (const headers::raw::IMAGE_SECTION_HEADER &header) {
+      auto size = std::max<std::uint32_t>(header.Misc.VirtualSize, header.SizeOfRawData);
+      return this->pe.align_to_section<std::uint32_t>(std::max<std::uint32_t>(size, 1));
+   };
+
+   // existing sections keep their virtual address, new sections go after the highest one
+   std::uint32_t next_rva = this->pe.align_to_section<std::uint32_t>(size_of_headers);
+
+   for (auto &entry : this->entries)
+   {
+      if (!entry.source.has_value()) { continue; }
+
+      next_rva = std::max<std::uint32_t>(next_rva, entry.header.VirtualAddress + virtual_span(entry.header));
+   }
+
+   auto result = std::vector<headers::raw::IMAGE_SECTION_HEADER>();
+   std::uint32_t next_offset = size_of_headers;
+   std::uint32_t previous_end = 0;
+
+   for (std::size_t i=0; i<this->entries.size(); ++i)
+   {
+      auto &entry = this->entries[i];
+      auto header = entry.header;
+
+      header.SizeOfRawData = this->pe.align_to_file<std::uint32_t>(static_cast<std::uint32_t>(entry.raw_size));
+      header.PointerToRawData = (header.SizeOfRawData == 0) ? 0 : next_offset;
+      next_offset += header.SizeOfRawData;
+
+      if (!entry.source.has_value())
+      {
+         header.VirtualAddress = next_rva;
+         next_rva += virtual_span(header);
+      }
+
+      // the headers have to be mapped below the first section
+      if (i == 0 && header.VirtualAddress < size_of_headers) { throw SectionTableOverflowException(); }
+      if (header.VirtualAddress < previous_end) { throw SectionOverlapException(i); }
+
+      previous_end = header.VirtualAddress + virtual_span(header);
+      result.push_back(header);
+   }
+
+   return result;
+}
+
+void
+SectionLayout::commit
+()
+{
+   auto table = this->plan();
+   auto nt_headers = this->pe.valid_nt_headers();
+   auto old_table = this->pe.section_table();
+   std::uint32_t old_size_of_headers, section_alignment;
+
+   if (nt_headers.is_32())
+   {
+      old_size_of_headers = nt_headers.get_32().optional_header()->SizeOfHeaders;
+      section_alignment = nt_headers.get_32().optional_header()->SectionAlignment;
+   }
+   else
+   {
+      old_size_of_headers = nt_headers.get_64().optional_header()->SizeOfHeaders;
+      section_alignment = nt_headers.get_64().optional_header()->SectionAlignment;
+   }
+
+   auto table_offset = *this->pe.section_table_offset();
+   auto table_end = this->header_end(table.size());
+   auto size_of_headers = this->pe.align_to_file<std::uint32_t>(static_cast<std::uint32_t>(table_end));
+   size_of_headers = std::max<std::uint32_t>(size_of_headers, old_size_of_headers);
+
+   std::size_t raw_end = size_of_headers;
+   std::uint32_t size_of_image = this->pe.align_to_section<std::uint32_t>(size_of_headers);
+
+   for (auto &header : table)
+   {
+      if (header.SizeOfRawData != 0) { raw_end = header.PointerToRawData + header.SizeOfRawData; }
+
+      auto virtual_size = std::max<std::uint32_t>(header.Misc.VirtualSize, header.SizeOfRawData);
+      size_of_image = std::max<std::uint32_t>(size_of_image, align<std::uint32_t>(header.VirtualAddress + virtual_size, section_alignment));
+   }
+
+   auto old_overlay = this->overlay_offset();
+   auto overlay_size = this->pe.size() - old_overlay;
+   auto image = Memory<std::uint8_t>(raw_end + overlay_size, true);
+   auto source = this->pe.ptr();
+   auto target = image.ptr();
+
+   // the headers are copied once and the section table is rewritten in place
+   auto header_copy = std::min<std::size_t>({old_size_of_headers, size_of_headers, this->pe.size()});
+   std::memcpy(target, source, header_copy);
+   std::memset(&target[header_copy], 0, size_of_headers - header_copy);
+
+   // clear the old table too, in case the new one is smaller
+   auto old_table_end = std::min<std::size_t>(this->header_end(old_table.size()), size_of_headers);
+   std::memset(&target[table_offset], 0, std::max<std::size_t>(table_end, old_table_end) - table_offset);
+
+   if (table.size() > 0)
+      std::memcpy(&target[table_offset], table.data(), table.size() * sizeof(headers::raw::IMAGE_SECTION_HEADER));
+
+   // each section's raw data is copied exactly once, from either the original image or its replacement
+   for (std::size_t i=0; i<table.size(); ++i)
+   {
+      auto &entry = this->entries[i];
+      auto &header = table[i];
+
+      if (header.SizeOfRawData == 0) { continue; }
+
+      const std::uint8_t *data = nullptr;
+      std::size_t data_size = 0;
+
+      if (entry.data.has_value())
+      {
+         data = entry.data->data();
+         data_size = entry.data->size();
+      }
+      else if (entry.source.has_value())
+      {
+         auto original = old_table[*entry.source];
+         std::size_t start = original->PointerToRawData;
+
+         if (original->SizeOfRawData != 0 && start < this->pe.size())
+         {
+            data = &source[start];
+            data_size = std::min<std::size_t>(original->SizeOfRawData, this->pe.size() - start);
+         }
+      }
+
+      data_size = std::min<std::size_t>(data_size, header.SizeOfRawData);
+
+      if (data_size > 0) { std::memcpy(&target[header.PointerToRawData], data, data_size); }
+
+      std::memset(&target[header.PointerToRawData + data_size], 0, header.SizeOfRawData - data_size);
+   }
+
+   if (overlay_size > 0) { std::memcpy(&target[raw_end], &source[old_overlay], overlay_size); }
+
+   this->pe.swap_memory(image);
+
+   // fix up the header fields affected by the new layout
+   auto update = [&] (auto &nt) {
+      nt.FileHeader.NumberOfSections = static_cast<std::uint16_t>(table.size());
+      nt.OptionalHeader.SizeOfHeaders = size_of_headers;
+      nt.OptionalHeader.SizeOfImage = size_of_image;
+
+      auto directories = std::min<std::uint32_t>(nt.OptionalHeader.NumberOfRvaAndSizes, headers::raw::IMAGE_NUMBEROF_DIRECTORY_ENTRIES);
+
+      // the security directory is the one directory addressed by file offset, and it lives in the overlay
+      if (directories > headers::raw::IMAGE_DIRECTORY_ENTRY_SECURITY)
+      {
+         auto &security = nt.OptionalHeader.DataDirectory[headers::raw::IMAGE_DIRECTORY_ENTRY_SECURITY];
+
+         if (security.VirtualAddress != 0 && security.VirtualAddress >= old_overlay)
+            security.VirtualAddress = static_cast<std::uint32_t>(security.VirtualAddress - old_overlay + raw_end);
+      }
+
+      // bound imports live in the header slack after the section table, drop them if the table grew over them
+      if (directories > headers::raw::IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT)
+      {
+         auto &bound = nt.OptionalHeader.DataDirectory[headers::raw::IMAGE_DIRECTORY_ENTRY_BOUND_IMPORT];
+
+         if (bound.VirtualAddress != 0 && bound.VirtualAddress < table_end)
+         {
+            bound.VirtualAddress = 0;
+            bound.Size = 0;
+         }
+      }
+   };
+
+   auto new_headers = this->pe.valid_nt_headers();
+
+   if (new_headers.is_32()) { update(*new_headers.get_32().ptr()); }
+   else { update(*new_headers.get_64().ptr()); }
+
+   this->entries.clear();
+
+   for (std::size_t i=0; i<table.size(); ++i)
+      this->entries.push_back(Entry{table[i], i, std::nullopt, table[i].SizeOfRawData});
+}
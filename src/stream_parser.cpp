@@ -0,0 +1,285 @@
+#include <yapp.hpp>
+
+#include <cmath>
+
+#ifndef YAPP_WIN32
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   // 64-bit FNV-1a, fed incrementally
+   const std::uint64_t FNVBasis = 0xCBF29CE484222325ULL;
+   const std::uint64_t FNVPrime = 0x100000001B3ULL;
+
+   double
+   entropy
+   (const std::vector<std::uint32_t> &counts, std::size_t size)
+   {
+      if (size == 0) { return 0.0; }
+
+      double result = 0.0;
+
+      for (auto count : counts)
+      {
+         if (count == 0) { continue; }
+
+         auto probability = double(count) / size;
+         result -= probability * std::log2(probability);
+      }
+
+      return result;
+   }
+}
+
+StreamParser::StreamParser
+(Handler &handler)
+   : handler(handler),
+     _peak_buffered(0)
+{
+   this->reset();
+}
+
+void
+StreamParser::add_directory
+(std::size_t index, std::size_t max_size)
+{
+   this->directories[index] = max_size;
+}
+
+void
+StreamParser::reset
+()
+{
+   this->header_buffer.clear();
+   this->header_buffer.shrink_to_fit();
+   this->have_headers = false;
+   this->_position = 0;
+   this->_hash = FNVBasis;
+   this->sections.clear();
+   this->pending_directories.clear();
+   this->_buffered = 0;
+}
+
+void
+StreamParser::begin_body
+()
+{
+   auto pe = PE(Memory<std::uint8_t>(this->header_buffer.data(), this->header_buffer.size()));
+   auto section_table = pe.section_table();
+
+   for (std::size_t i=0; i<section_table.size(); ++i)
+   {
+      auto &header = section_table.get(i);
+      auto start = std::size_t(header.PointerToRawData);
+
+      this->sections.push_back(Pending{start, start + header.SizeOfRawData, i, header, FNVBasis, {}, {}});
+   }
+
+   // completed sections are reported front to back, so keep them in the order their data ends
+   std::stable_sort(this->sections.begin(), this->sections.end(), [] (const Pending &left, const Pending &right) {
+      return left.end < right.end;
+   });
+
+   for (auto &directory : this->directories)
+   {
+      auto range = pe.directory_file_range(directory.first);
+      if (!range.has_value() || range->second - range->first > directory.second) { continue; }
+
+      this->pending_directories.push_back(Pending{range->first, range->second, directory.first, {}, 0, {}, {}});
+   }
+
+   this->have_headers = true;
+   this->handler.on_headers(pe);
+
+   // the headers are replayed like any other bytes, since sections and directories may overlap them
+   auto headers = std::move(this->header_buffer);
+
+   this->header_buffer.clear();
+   this->_buffered = 0;
+   this->consume(headers.data(), headers.size());
+}
+
+void
+StreamParser::consume
+(const std::uint8_t *data, std::size_t size)
+{
+   auto start = this->_position;
+   auto end = start + size;
+
+   for (std::size_t i=0; i<size; ++i)
+   {
+      this->_hash ^= data[i];
+      this->_hash *= FNVPrime;
+   }
+
+   for (auto &section : this->sections)
+   {
+      auto from = std::max(section.start, start);
+      auto to = std::min(section.end, end);
+
+      if (from >= to) { continue; }
+      if (section.counts.empty()) { section.counts.resize(256, 0); }
+
+      for (auto i=from; i<to; ++i)
+      {
+         auto byte = data[i - start];
+
+         section.hash ^= byte;
+         section.hash *= FNVPrime;
+         ++section.counts[byte];
+      }
+   }
+
+   for (auto &directory : this->pending_directories)
+   {
+      auto from = std::max(directory.start, start);
+      auto to = std::min(directory.end, end);
+
+      if (from >= to) { continue; }
+
+      directory.data.insert(directory.data.end(), data + (from - start), data + (to - start));
+      this->_buffered += to - from;
+   }
+
+   this->_position = end;
+   this->_peak_buffered = std::max(this->_peak_buffered, this->_buffered);
+
+   while (!this->sections.empty() && this->sections.front().end <= end)
+   {
+      this->finish_section(this->sections.front());
+      this->sections.erase(this->sections.begin());
+   }
+
+   for (auto directory=this->pending_directories.begin(); directory!=this->pending_directories.end();)
+   {
+      if (directory->end > end) { ++directory; continue; }
+
+      this->_buffered -= directory->data.size();
+      this->handler.on_directory(directory->index, directory->data);
+      directory = this->pending_directories.erase(directory);
+   }
+}
+
+void
+StreamParser::finish_section
+(Pending &section)
+{
+   auto seen = (this->_position > section.start) ? std::min(this->_position, section.end) - section.start : 0;
+
+   this->handler.on_section(Section{section.index, section.header, seen, section.hash, entropy(section.counts, seen)});
+}
+
+void
+StreamParser::feed
+(const std::uint8_t *data, std::size_t size)
+{
+   if (!this->have_headers && this->header_buffer.empty()) { this->_peak_buffered = 0; }
+
+   try {
+      // take only as many bytes as the headers need, so that the rest is never copied
+      while (!this->have_headers)
+      {
+         auto &buffer = this->header_buffer;
+         auto needed = PE::HeaderExtent(buffer.data(), buffer.size());
+
+         if (needed <= buffer.size()) { this->begin_body(); break; }
+         if (size == 0) { return; }
+
+         auto amount = std::min(size, needed - buffer.size());
+
+         buffer.insert(buffer.end(), data, data + amount);
+         data += amount;
+         size -= amount;
+
+         this->_buffered = buffer.size();
+         this->_peak_buffered = std::max(this->_peak_buffered, this->_buffered);
+      }
+
+      if (size > 0) { this->consume(data, size); }
+   }
+   catch (...) {
+      this->reset();
+      throw;
+   }
+}
+
+void
+StreamParser::finish
+()
+{
+   if (!this->have_headers)
+   {
+      // a bad signature would already have been thrown by feed
+      auto size = this->header_buffer.size();
+      auto needed = PE::HeaderExtent(this->header_buffer.data(), size);
+
+      this->reset();
+      throw TruncatedStreamException(size, needed);
+   }
+
+   // whatever is left was cut short by the end of the stream
+   for (auto &section : this->sections) { this->finish_section(section); }
+
+   auto size = this->_position;
+   auto hash = this->_hash;
+
+   this->reset();
+   this->handler.on_end(size, hash);
+}
+
+std::size_t
+StreamParser::parse
+(Reader reader)
+{
+   auto buffer = std::vector<std::uint8_t>(StreamParser::ChunkSize);
+
+   try {
+      while (true)
+      {
+         auto amount = reader(buffer.data(), buffer.size());
+         if (amount == 0) { break; }
+
+         this->feed(buffer.data(), amount);
+      }
+   }
+   catch (...) {
+      this->reset();
+      throw;
+   }
+
+   auto size = this->position();
+   this->finish();
+
+   return size;
+}
+
+std::size_t
+StreamParser::parse
+(std::istream &stream)
+{
+   return this->parse([&stream] (std::uint8_t *buffer, std::size_t size) {
+      stream.read(reinterpret_cast<char *>(buffer), size);
+      return static_cast<std::size_t>(stream.gcount());
+   });
+}
+
+#ifndef YAPP_WIN32
+StreamParser::Reader
+StreamParser::DescriptorReader
+(int fd)
+{
+   return [fd] (std::uint8_t *buffer, std::size_t size) {
+      while (true)
+      {
+         auto amount = read(fd, buffer, size);
+
+         if (amount >= 0) { return static_cast<std::size_t>(amount); }
+         if (errno != EINTR) { throw ReadFailureException(std::string("stream descriptor")); }
+      }
+   };
+}
+#endif
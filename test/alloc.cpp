@@ -0,0 +1,192 @@
+#include <cstdlib>
+#include <new>
+
+#include <framework.hpp>
+#include <yapp.hpp>
+
+using namespace yapp;
+using namespace yapp::headers;
+
+/* every allocation made by the library and the standard containers it uses goes through the global
+   operator new, so replacing it here counts them all for the thread making them */
+namespace
+{
+   thread_local std::size_t allocations = 0;
+   thread_local std::ptrdiff_t live = 0;
+
+   struct AllocationCount
+   {
+      std::size_t allocations;
+      /// Blocks allocated and not yet freed; nonzero means the operation retained memory.
+      std::ptrdiff_t retained;
+
+      bool operator==(const AllocationCount &other) const {
+         return this->allocations == other.allocations && this->retained == other.retained;
+      }
+   };
+
+   template <typename Operation>
+   AllocationCount
+   count_allocations
+   (Operation operation)
+   {
+      auto start_allocations = allocations;
+      auto start_live = live;
+
+      operation();
+
+      return AllocationCount{allocations - start_allocations, live - start_live};
+   }
+
+   /// Check that repeating an operation costs the same every time and never retains anything.
+   template <typename Operation>
+   bool
+   steady
+   (Operation operation, std::size_t repeats=1000)
+   {
+      auto first = count_allocations(operation);
+      if (first.retained != 0) { return false; }
+
+      for (std::size_t i=0; i<repeats; ++i)
+         if (!(count_allocations(operation) == first)) { return false; }
+
+      return true;
+   }
+
+   void *
+   allocate
+   (std::size_t size)
+   {
+      ++allocations;
+      ++live;
+
+      return std::malloc((size == 0) ? 1 : size);
+   }
+
+   void
+   release
+   (void *pointer)
+   {
+      if (pointer == nullptr) { return; }
+
+      --live;
+      std::free(pointer);
+   }
+
+   void *
+   allocate_aligned
+   (std::size_t size, std::align_val_t alignment)
+   {
+      ++allocations;
+      ++live;
+
+      auto align = static_cast<std::size_t>(alignment);
+      size = ((size + align - 1) / align) * align;
+
+#ifdef YAPP_WIN32
+      return _aligned_malloc(size, align);
+#else
+      return std::aligned_alloc(align, (size == 0) ? align : size);
+#endif
+   }
+
+   void
+   release_aligned
+   (void *pointer)
+   {
+      if (pointer == nullptr) { return; }
+
+      --live;
+
+#ifdef YAPP_WIN32
+      _aligned_free(pointer);
+#else
+      std::free(pointer);
+#endif
+   }
+}
+
+void *operator new(std::size_t size) {
+   auto pointer = allocate(size);
+   if (pointer == nullptr) { throw std::bad_alloc(); }
+   return pointer;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) {
+   auto pointer = allocate_aligned(size, alignment);
+   if (pointer == nullptr) { throw std::bad_alloc(); }
+   return pointer;
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+
+void operator delete(void *pointer) noexcept { release(pointer); }
+void operator delete[](void *pointer) noexcept { release(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { release(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { release(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { release(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { release(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { release_aligned(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { release_aligned(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { release_aligned(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { release_aligned(pointer); }
+
+int test_zero_allocation() {
+   INIT();
+
+   auto pe = PE(std::string("../test/corpus/compiled.exe"));
+   auto &const_pe = static_cast<const PE &>(pe);
+
+   ASSERT(count_allocations([&] () { (void)pe.cast_ptr<std::uint32_t>(0x40, true); }).allocations == 0);
+   ASSERT(count_allocations([&] () { (void)const_pe.cast_ref<std::uint16_t>(0); }).allocations == 0);
+   ASSERT(count_allocations([&] () { (void)pe.get(0x3C); }).allocations == 0);
+   ASSERT(count_allocations([&] () { (void)pe.size(); (void)pe.byte_size(); }).allocations == 0);
+
+   COMPLETE();
+}
+
+int test_bounded_allocation() {
+   INIT();
+
+   auto pe = PE(std::string("../test/corpus/compiled.exe"));
+   auto dll = PE(std::string("../test/corpus/dll.dll"));
+   auto rva = pe.entrypoint();
+
+   // the views these create are registered with the MemoryManager, which may allocate to track them,
+   // but the cost must not grow from call to call and nothing may be left behind
+   ASSERT(steady([&] () { (void)pe.rva_to_offset(rva); }));
+   ASSERT(steady([&] () { (void)pe.offset_to_rva(pe.rva_to_offset(rva)); }));
+   ASSERT(steady([&] () { (void)pe.section_table().section_by_rva(rva); }));
+   ASSERT(steady([&] () { (void)pe.valid_nt_headers(); }));
+   ASSERT(steady([&] () { (void)pe.calculate_checksum(); }, 100));
+   ASSERT(steady([&] () { (void)dll.data_directory().has_directory(dll, raw::IMAGE_DIRECTORY_ENTRY_EXPORT); }));
+   ASSERT(steady([&] () { (void)dll.data_directory().directory<ExportDirectory>(dll); }));
+
+   // the checksum walks every dword of the image, so its cost must not depend on the image's size
+   ASSERT(count_allocations([&] () { (void)pe.calculate_checksum(); }).allocations
+          == count_allocations([&] () { (void)dll.calculate_checksum(); }).allocations);
+
+   // a failed translation allocates for its message, but retains nothing once it's caught
+   ASSERT(steady([&] () {
+      try { (void)pe.rva_to_offset(RVA(0xFFFFFFF0)); }
+      catch (InvalidRVAException &) {}
+   }, 100));
+
+   COMPLETE();
+}
+
+int
+main
+(int argc, char *argv[])
+{
+   INIT();
+
+   LOG_INFO("Testing zero-allocation operations.");
+   PROCESS_RESULT(test_zero_allocation);
+
+   LOG_INFO("Testing bounded-allocation operations.");
+   PROCESS_RESULT(test_bounded_allocation);
+
+   COMPLETE();
+}
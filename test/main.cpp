@@ -1,6 +1,14 @@
+#include <filesystem>
+#include <thread>
+
 #include <framework.hpp>
 #include <yapp.hpp>
 
+#ifndef YAPP_WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 using namespace yapp;
 using namespace yapp::headers;
 
@@ -105,6 +113,15 @@ int test_dynamic_memory() {
                       "\xfa\xce\xba\xbe\xde\xad\xbe\xef\xc0\xff\xee\x74\xde\xad\xbe\xa7\xde\xfa\xce\xd1\xab\xad\x1d\xea",
                       buffer.byte_size()) == 0);
 
+   ASSERT_SUCCESS(buffer.insert<std::uint8_t>(4, Memory<std::uint8_t>(facebabe, (std::size_t)4), true));
+   ASSERT(buffer.byte_size() == 28);
+   ASSERT(buffer.cast_ref<std::uint32_t>(4) == 0xBEBACEFA);
+   ASSERT(buffer.cast_ref<std::uint32_t>(8) == 0xEFBEADDE);
+
+   ASSERT_SUCCESS(buffer.erase(4, 8, true));
+   ASSERT(buffer.byte_size() == 24);
+   ASSERT(buffer.cast_ref<std::uint32_t>(4) == 0xEFBEADDE);
+
    auto invalid_slice = buffer.subsection(0, buffer.size());
    buffer.deallocate();
 
@@ -113,6 +130,39 @@ int test_dynamic_memory() {
    COMPLETE();
 }
 
+int test_piece_table() {
+   INIT();
+
+   auto data = "\xde\xad\xbe\xef\xab\xad\x1d\xea\xde\xad\xbe\xa7\xde\xfa\xce\xd1";
+   const Memory<std::uint8_t> original((const std::uint8_t *)data, (std::size_t)16);
+   PieceTable table(original);
+
+   ASSERT(table.size() == 16);
+   ASSERT(table.is_modified() == false);
+
+   std::uint8_t facebabe[] = {0xFA, 0xCE, 0xBA, 0xBE};
+   ASSERT_SUCCESS(table.insert(4, facebabe, 4));
+   ASSERT(table.size() == 20);
+   ASSERT(table.get(4) == 0xFA);
+   ASSERT(table.get(8) == 0xAB);
+   ASSERT(std::memcmp(original.ptr(), data, 16) == 0);
+
+   ASSERT_SUCCESS(table.erase(0, 4));
+   ASSERT(table.size() == 16);
+   ASSERT(std::memcmp(table.read(0, 8).data(), "\xfa\xce\xba\xbe\xab\xad\x1d\xea", 8) == 0);
+
+   ASSERT_SUCCESS(table.write<std::uint32_t>(12, 0x74EEFFC0));
+   ASSERT_THROWS(table.write<std::uint32_t>(14, 0x74EEFFC0), OutOfBoundsException);
+
+   auto materialized = table.materialize();
+   ASSERT(materialized.size() == 16);
+   ASSERT(std::memcmp(materialized.ptr(),
+                      "\xfa\xce\xba\xbe\xab\xad\x1d\xea\xde\xad\xbe\xa7\xc0\xff\xee\x74",
+                      materialized.byte_size()) == 0);
+
+   COMPLETE();
+}
+
 int test_compiled() {
    INIT();
 
@@ -136,6 +186,1197 @@ int test_compiled() {
    COMPLETE();
 }
 
+int test_patch_overlay() {
+   INIT();
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   PatchOverlay overlay(compiled);
+
+   auto e_lfanew = compiled.e_lfanew();
+   auto checksum_offset = *e_lfanew + offsetof(headers::raw::IMAGE_NT_HEADERS32, OptionalHeader.CheckSum);
+   auto original_checksum = overlay.read<std::uint32_t>(checksum_offset);
+
+   ASSERT_SUCCESS(overlay.write<std::uint32_t>(checksum_offset, 0xDEADBEEF));
+   ASSERT(overlay.read<std::uint32_t>(checksum_offset) == 0xDEADBEEF);
+   ASSERT(compiled.cast_ref<std::uint32_t>(checksum_offset, true) == original_checksum);
+
+   ASSERT_SUCCESS(overlay.write<std::uint16_t>(checksum_offset+4, 0x4141));
+   ASSERT(overlay.patch_count() == 1);
+   ASSERT(overlay.patched_bytes() == 6);
+   ASSERT_THROWS(overlay.write<std::uint32_t>(compiled.size()-2, 0), OutOfBoundsException);
+
+   auto patched = overlay.materialize();
+   ASSERT(patched.cast_ref<std::uint32_t>(checksum_offset, true) == 0xDEADBEEF);
+
+   auto diff = overlay.diff();
+   PatchOverlay reloaded(compiled);
+   ASSERT_SUCCESS(reloaded.load_diff(Memory<std::uint8_t>(diff)));
+   ASSERT(reloaded.read<std::uint32_t>(checksum_offset) == 0xDEADBEEF);
+
+   // a patch offset near SIZE_MAX must be rejected rather than wrap the bounds check
+   auto wrapping = std::vector<std::uint8_t>(diff.begin(), diff.begin() + 8);
+   std::uint32_t one = 1;
+   std::uint64_t wild_offset = SIZE_MAX - 1;
+   std::uint32_t wild_size = 4;
+   std::memcpy(&wrapping[4], &one, sizeof(one));
+   wrapping.insert(wrapping.end(), reinterpret_cast<std::uint8_t *>(&wild_offset), reinterpret_cast<std::uint8_t *>(&wild_offset) + sizeof(wild_offset));
+   wrapping.insert(wrapping.end(), reinterpret_cast<std::uint8_t *>(&wild_size), reinterpret_cast<std::uint8_t *>(&wild_size) + sizeof(wild_size));
+   wrapping.insert(wrapping.end(), wild_size, 0x41);
+   PatchOverlay rejected(compiled);
+   ASSERT_THROWS(rejected.load_diff(Memory<std::uint8_t>(wrapping)), InvalidDiffException);
+   ASSERT(rejected.patch_count() == 0);
+   ASSERT_THROWS(rejected.write(SIZE_MAX - 1, &wrapping[0], 4), OutOfBoundsException);
+
+   // a patch running past the end of the image spoils the whole diff, including the good patch before it
+   auto overrunning = diff;
+   std::uint32_t two = 2;
+   std::uint64_t tail_offset = compiled.size() - 2;
+   std::memcpy(&overrunning[4], &two, sizeof(two));
+   overrunning.insert(overrunning.end(), reinterpret_cast<std::uint8_t *>(&tail_offset), reinterpret_cast<std::uint8_t *>(&tail_offset) + sizeof(tail_offset));
+   overrunning.insert(overrunning.end(), reinterpret_cast<std::uint8_t *>(&wild_size), reinterpret_cast<std::uint8_t *>(&wild_size) + sizeof(wild_size));
+   overrunning.insert(overrunning.end(), wild_size, 0x41);
+   ASSERT_THROWS(rejected.load_diff(Memory<std::uint8_t>(overrunning)), InvalidDiffException);
+   ASSERT(rejected.patch_count() == 0);
+
+   ASSERT_SUCCESS(overlay.save(std::string("patched.exe"), std::string("../test/corpus/compiled.exe")));
+   PE saved(std::string("patched.exe"));
+   ASSERT(saved.size() == compiled.size());
+   ASSERT(std::memcmp(saved.ptr(), patched.ptr(), saved.size()) == 0);
+
+   ImageWriter writer;
+   ASSERT_SUCCESS(writer.add(&compiled.ptr()[0], 0x100));
+   ASSERT_SUCCESS(writer.add(&compiled.ptr()[0x100], compiled.size() - 0x100));
+   ASSERT(writer.segment_count() == 1);
+   ASSERT_THROWS(writer.add_source(0, 0x10), NoSourceFileException);
+
+   ASSERT_SUCCESS(overlay.revert(checksum_offset, 4));
+   ASSERT(overlay.read<std::uint32_t>(checksum_offset) == original_checksum);
+   ASSERT(overlay.patched_bytes() == 2);
+
+   COMPLETE();
+}
+
+int test_section_layout() {
+   INIT();
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   auto original_sections = compiled.section_table().size();
+   auto original_first = *compiled.section_table()[0].ptr();
+   auto entrypoint = compiled.entrypoint();
+
+   SectionLayout layout(compiled);
+   auto payload = std::vector<std::uint8_t>(0x1234, 0x41);
+
+   ASSERT(layout.add_section(".yapp0", 0x40000040, payload) == original_sections);
+   ASSERT(layout.add_section(".yapp1", 0x40000040, std::vector<std::uint8_t>(0x10, 0x42), 0x3000) == original_sections+1);
+   ASSERT_SUCCESS(layout.resize_section(0, original_first.Misc.VirtualSize));
+   ASSERT_THROWS(layout.remove_section(std::string(".nope")), SectionNotFoundException);
+   ASSERT_THROWS(layout.resize_section(original_sections+2, 0x10), OutOfBoundsException);
+
+   auto plan = layout.plan();
+   ASSERT(plan.size() == original_sections+2);
+   ASSERT(plan[0].VirtualAddress == original_first.VirtualAddress);
+   ASSERT(compiled.section_table().size() == original_sections);
+
+   ASSERT_SUCCESS(layout.commit());
+
+   auto section_table = compiled.section_table();
+   ASSERT(section_table.size() == original_sections+2);
+   ASSERT(compiled.entrypoint() == entrypoint);
+   ASSERT(section_table[original_sections].name_string() == std::string(".yapp0"));
+   ASSERT(section_table[original_sections].is_aligned_to_file(compiled));
+   ASSERT(section_table[original_sections].is_aligned_to_section(compiled));
+   ASSERT(section_table[original_sections].section_data(compiled)[0x1233] == 0x41);
+   ASSERT(section_table[original_sections+1]->VirtualAddress >= section_table[original_sections]->VirtualAddress + 0x2000);
+
+   auto last = section_table[original_sections+1];
+   auto image_size = compiled.valid_nt_headers().get_32().optional_header()->SizeOfImage;
+   ASSERT(image_size == compiled.align_to_section<std::uint32_t>(last->VirtualAddress + 0x3000));
+   ASSERT(compiled.rva_to_offset(RVA(section_table[original_sections]->VirtualAddress)) == Offset(section_table[original_sections]->PointerToRawData));
+
+   SectionLayout shrink(compiled);
+   ASSERT_SUCCESS(shrink.remove_section(std::string(".yapp1")));
+   ASSERT_SUCCESS(shrink.commit());
+   ASSERT(compiled.section_table().size() == original_sections+1);
+
+   auto appended = compiled.append_section(compiled.section_table()[original_sections], std::vector<std::uint8_t>(0x200, 0x43));
+   ASSERT(appended.name_string() == std::string(".yapp0"));
+   ASSERT(appended.section_data(compiled)[0] == 0x43);
+   ASSERT(compiled.section_table().size() == original_sections+2);
+
+   COMPLETE();
+}
+
+// build a module directory where kernel32 forwards ExitProcess to msvcrt.printf, and msvcrt
+// is dll.dll with its "export" export renamed to "printf"
+bool make_module_directory(const std::string &directory) {
+   std::filesystem::remove_all(directory);
+   std::filesystem::create_directories(directory);
+   std::filesystem::copy_file("../test/corpus/dllfw.dll", directory + "/KERNEL32.dll");
+
+   PE msvcrt(std::string("../test/corpus/dll.dll"));
+   auto export_name = msvcrt.search(Memory<std::uint8_t>(std::vector<std::uint8_t>{'e','x','p','o','r','t',0}));
+   if (export_name.size() != 1) { return false; }
+
+   PatchOverlay renamed(msvcrt);
+   renamed.write(export_name[0], std::vector<std::uint8_t>{'p','r','i','n','t','f'});
+   renamed.save(directory + "/msvcrt.dll");
+
+   return true;
+}
+
+int test_import_resolver() {
+   INIT();
+
+   ASSERT(make_module_directory("modules"));
+
+   ExportIndexCache cache;
+   ImportResolver resolver(std::string("modules"), cache);
+   ASSERT(resolver.module_count() == 2);
+   ASSERT(resolver.has_module(std::string("Kernel32")));
+   ASSERT_THROWS(ImportResolver(std::string("no_such_directory")), OpenFileFailureException);
+
+   auto kernel32 = resolver.export_index(std::string("kernel32.dll"));
+   ASSERT(kernel32 != nullptr);
+   ASSERT(kernel32 == resolver.export_index(std::string("KERNEL32")));
+   ASSERT(kernel32->lookup(std::string("ExitProcess"))->forwarder == std::string("msvcrt.printf"));
+   ASSERT(kernel32->lookup(std::string("printf")) == nullptr);
+
+   auto forwarder = kernel32->lookup(std::string("ExitProcess"))->parsed_forwarder();
+   ASSERT(forwarder.has_value() && forwarder->module == "msvcrt" && forwarder->name == "printf");
+
+   auto by_ordinal = Forwarder::Parse("NTDLL.#123");
+   ASSERT(by_ordinal.has_value() && by_ordinal->is_ordinal() && *by_ordinal->ordinal == 123);
+   ASSERT(Forwarder::Parse("foo.dll.Bar")->module == "foo.dll");
+   ASSERT(!Forwarder::Parse("NoDot").has_value());
+   ASSERT(!Forwarder::Parse("NTDLL.#12a").has_value());
+   ASSERT(!Forwarder::Parse("NTDLL.").has_value());
+
+   ASSERT(NormalizeApiSet("api-ms-win-core-synch-l1-2-0") == "kernelbase.dll");
+   ASSERT(NormalizeApiSet("API-MS-WIN-CRT-RUNTIME-L1-1-0.DLL") == "ucrtbase.dll");
+   ASSERT(NormalizeApiSet("api-ms-win-unknown-l1-1-0") == "api-ms-win-unknown-l1-1-0");
+   ASSERT(NormalizeApiSet("kernel32") == "kernel32");
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   auto imports = ImportResolver::ImportList(compiled);
+   ASSERT(imports.size() == 2);
+   ASSERT(imports[0].module == std::string("kernel32.dll") && imports[0].name == std::string("ExitProcess"));
+
+   auto bound = resolver.resolve(compiled);
+   ASSERT(bound.size() == 2);
+
+   auto &exit_process = bound[imports[0].thunk];
+   ASSERT(exit_process.resolved);
+   ASSERT(exit_process.module == std::string("msvcrt.dll"));
+   ASSERT(exit_process.name == std::string("printf"));
+   ASSERT(exit_process.rva == 0x1024);
+   ASSERT(exit_process.forwards == 1);
+
+   auto &printf_import = bound[imports[1].thunk];
+   ASSERT(printf_import.resolved && printf_import.rva == 0x1024 && printf_import.forwards == 0);
+
+   auto missing = resolver.resolve(std::string("user32.dll"), std::string("MessageBoxA"));
+   ASSERT(!missing.resolved);
+
+   std::filesystem::create_directories("apisets");
+   std::filesystem::copy_file("modules/msvcrt.dll", "apisets/ucrtbase.dll", std::filesystem::copy_options::overwrite_existing);
+   ImportResolver api_sets(std::string("apisets"), cache);
+   auto api_set = api_sets.resolve(std::string("api-ms-win-crt-stdio-l1-1-0.dll"), std::string("printf"));
+   ASSERT(api_set.resolved && api_set.module == std::string("ucrtbase.dll"));
+
+   // a second resolver over the same modules shares the cached indices
+   ASSERT(cache.size() == 3);
+   ImportResolver second(std::string("modules"), cache);
+   ASSERT(second.export_index(std::string("kernel32")) == kernel32);
+   ASSERT(cache.hits() == 1);
+
+   // the cache is consulted with a key built from the headers alone
+   auto kernel32_file = std::string("modules/KERNEL32.dll");
+   PE kernel32_image(kernel32_file);
+   auto kernel32_headers = PE::LoadHeaders(kernel32_file);
+   ASSERT(ExportIndexCache::IdentityKey(kernel32_headers, std::string("kernel32.dll")) == ExportIndexCache::IdentityKey(kernel32_image, std::string("kernel32.dll")));
+   ASSERT_THROWS(PE::LoadHeaders(std::string("modules/no_such_module.dll")), OpenFileFailureException);
+
+   auto content_key = ExportIndexCache::ContentKey(compiled);
+   ASSERT(cache.find(content_key) == nullptr);
+   auto compiled_index = cache.get(compiled, std::string("compiled.exe"), true);
+   ASSERT(compiled_index->size() == 0);
+   ASSERT(cache.find(content_key) == compiled_index);
+   ASSERT(cache.size() == 4);
+
+   // shrinking the budget evicts the least recently used indices, but holders keep theirs
+   ASSERT_SUCCESS(cache.set_budget(1));
+   ASSERT(cache.size() == 1);
+   PE msvcrt(std::string("../test/corpus/dll.dll"));
+   ASSERT(cache.find(ExportIndexCache::IdentityKey(msvcrt, std::string("msvcrt.dll"))) == nullptr);
+   ASSERT(kernel32->lookup(std::string("ExitProcess")) != nullptr);
+
+   COMPLETE();
+}
+
+int test_loader() {
+   INIT();
+
+   PE dll(std::string("../test/corpus/dll.dll"));
+   ASSERT_SUCCESS((void)Loader(dll));
+
+   Loader loader(dll);
+   auto &image = loader.image();
+   auto original_base = loader.base();
+
+   ASSERT(image.image_type() == PE::ImageType::MEMORY);
+   ASSERT(image.size() == dll.valid_nt_headers().get_32().optional_header()->SizeOfImage);
+   ASSERT_THROWS(Loader::Map(dll, image.size() - 1), OversizedImageException);
+
+   // sections land at their virtual addresses
+   auto section = dll.section_table()[0];
+   ASSERT(std::memcmp(image.ptr() + section->VirtualAddress,
+                      dll.ptr() + section->PointerToRawData,
+                      std::min<std::size_t>(section->SizeOfRawData, section->Misc.VirtualSize)) == 0);
+
+   // relocating moves the base, and relocating back restores the original image
+   auto mapped = image.read(0, image.size());
+   ASSERT(loader.relocate(original_base) == 0);
+
+   auto fixups = loader.relocate(original_base + 0x10000);
+   ASSERT(fixups > 0);
+   ASSERT(loader.base() == original_base + 0x10000);
+   ASSERT(image.read(0, image.size()) != mapped);
+   ASSERT(loader.relocate(original_base) == fixups);
+   ASSERT(image.read(0, image.size()) == mapped);
+
+   ASSERT(!loader.tls().has_value());
+   ASSERT(loader.entrypoints().size() == 1 && loader.entrypoints()[0] == original_base + *dll.entrypoint());
+
+   // compiled.exe has no relocations, and binds both imports to msvcrt
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   Loader exe(compiled);
+
+   ASSERT(exe.relocate(exe.base()) == 0);
+   ASSERT_THROWS(exe.relocate(exe.base() + 0x10000), DirectoryUnavailableException);
+
+   ASSERT(make_module_directory("loader_modules"));
+
+   ExportIndexCache cache;
+   ImportResolver resolver(std::string("loader_modules"), cache);
+   auto bound = exe.bind(resolver, std::map<std::string, std::uint64_t>{{"MSVCRT.dll", 0x10000000}});
+
+   ASSERT(bound.size() == 2);
+   ASSERT(exe.image().cast_ref<std::uint32_t>(0x2080) == 0x10001024);
+   ASSERT(exe.image().cast_ref<std::uint32_t>(0x2088) == 0x10001024);
+
+   // imports of modules without a base are left alone
+   Loader unbound(compiled);
+   auto slot = unbound.image().cast_ref<std::uint32_t>(0x2080);
+   ASSERT_SUCCESS((void)unbound.bind(resolver, std::map<std::string, std::uint64_t>()));
+   ASSERT(unbound.image().cast_ref<std::uint32_t>(0x2080) == slot);
+
+   ASSERT_THROWS(Loader::Map(exe.image()), UnsupportedImageTypeException);
+
+   COMPLETE();
+}
+
+int test_metadata_cache() {
+   INIT();
+
+   PE dll(std::string("../test/corpus/dll.dll"));
+   auto record = MetadataView::Build(dll);
+
+   ASSERT(record.digest() == Sha256::Hash(Span<const std::uint8_t>(dll.ptr(), dll.size())));
+   ASSERT(record.header().file_size == dll.size());
+   ASSERT(record.header().machine == dll.machine());
+   ASSERT(record.header().entrypoint == *dll.entrypoint());
+   ASSERT(record.section_count() == dll.section_table().size());
+   ASSERT(record.section_name(record.section(0)) == dll.section_table()[0].name_string());
+   ASSERT(record.export_count() == 1);
+   ASSERT(record.string(record.export_entry(0).name) == "export");
+   ASSERT(record.export_entry(0).rva == 0x1024);
+   ASSERT(record.string(0).empty());
+   ASSERT_THROWS(record.section(record.section_count()), OutOfBoundsException);
+
+   // a record rebuilt from its own bytes reads the same
+   auto copy = MetadataView(std::vector<std::uint8_t>(record.ptr(), record.ptr() + record.size()));
+   ASSERT(std::memcmp(copy.ptr(), record.ptr(), record.size()) == 0);
+
+   auto truncated = std::vector<std::uint8_t>(record.ptr(), record.ptr() + record.size() - 8);
+   ASSERT_THROWS(MetadataView(truncated), InvalidMetadataException);
+
+   // a warm lookup maps the stored record instead of rebuilding it
+   std::filesystem::remove_all("metadata");
+   MetadataCache cache(std::string("metadata"));
+   ASSERT(!cache.find(record.digest(), dll.size()).has_value());
+
+   auto stored = cache.get(dll);
+   ASSERT(cache.misses() == 2);
+   ASSERT(std::filesystem::exists(cache.path(record.digest())));
+
+   // a record is only served for a file of the size it describes
+   ASSERT(!cache.find(record.digest(), dll.size() + 1).has_value());
+   ASSERT(cache.misses() == 3);
+
+   auto mapped = cache.get(dll);
+   ASSERT(cache.hits() == 1);
+   ASSERT(mapped.size() == record.size());
+   ASSERT(std::memcmp(mapped.ptr(), record.ptr(), record.size()) == 0);
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   auto exe = cache.get(compiled);
+   ASSERT(exe.import_count() == 2);
+   ASSERT(exe.string(exe.import(0).module) == "kernel32.dll");
+   ASSERT(exe.string(exe.import(0).name) == "ExitProcess");
+
+   // a file lookup indexes the file's identity, so the next one maps the record without reading the file
+   auto by_name = cache.get(std::string("../test/corpus/dll.dll"));
+   ASSERT(by_name.digest() == record.digest());
+   ASSERT(cache.hits() == 2);
+
+#ifndef YAPP_WIN32
+   auto indexed = cache.get(std::string("../test/corpus/dll.dll"));
+   ASSERT(indexed.digest() == record.digest());
+   ASSERT(cache.hits() == 3);
+   ASSERT(cache.misses() == 4);
+#endif
+
+   COMPLETE();
+}
+
+int test_columnar() {
+   INIT();
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   PE dll(std::string("../test/corpus/dll.dll"));
+
+   CorpusExporter exporter;
+   ASSERT_SUCCESS(exporter.add(compiled, std::string("compiled.exe")));
+   ASSERT_SUCCESS(exporter.add(dll, std::string("dll.dll")));
+
+   auto &images = exporter.images();
+   ASSERT(images.rows() == 2);
+   ASSERT(images.integer(images.column_index("Machine"), 1) == dll.machine());
+   ASSERT(images.integer(images.column_index("AddressOfEntryPoint"), 1) == *dll.entrypoint());
+   ASSERT_THROWS(images.column_index("NoSuchField"), ColumnNotFoundException);
+
+   auto &sections = exporter.sections();
+   auto name_column = sections.column_index("Name");
+   ASSERT(sections.rows() == compiled.section_table().size() + dll.section_table().size());
+   ASSERT(sections.string(name_column, 0) == compiled.section_table()[0].name_string());
+
+   // repeated section names share one dictionary entry
+   ASSERT(sections.columns()[name_column].dictionary.size() < sections.rows());
+
+   auto entropy = sections.number(sections.column_index("Entropy"), 0);
+   ASSERT(entropy >= 0.0 && entropy <= 8.0);
+
+   auto &imports = exporter.imports();
+   ASSERT(imports.rows() == 2);
+   ASSERT(imports.string(1, 0) == "kernel32.dll");
+   ASSERT(imports.integer(2, 0) == 1);
+
+   ASSERT_SUCCESS(exporter.write(std::string("corpus.ycol")));
+
+   auto tables = CorpusExporter::Read(std::string("corpus.ycol"));
+   ASSERT(tables.size() == 3);
+   ASSERT(tables[0].name() == "images" && tables[0].rows() == 2);
+   ASSERT(tables[0].string(0, 1) == "dll.dll");
+   ASSERT(tables[1].columns()[name_column].data == sections.columns()[name_column].data);
+   ASSERT(tables[1].number(tables[1].column_index("Entropy"), 0) == entropy);
+   ASSERT_THROWS(CorpusExporter::Read(std::string("../test/corpus/dll.dll")), InvalidColumnarFileException);
+
+   COMPLETE();
+}
+
+int test_ingest() {
+   INIT();
+
+   auto filenames = std::vector<std::string>{"../test/corpus/compiled.exe",
+                                             "../test/corpus/dll.dll",
+                                             "../test/corpus/no_such_file.exe",
+                                             "../test/framework.hpp"};
+
+   for (auto backend : {Ingest::Backend::THREAD_POOL, Ingest::Backend::AUTO})
+   {
+      Ingest ingest(2, backend);
+      ingest.add_directory(headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT);
+
+      std::map<std::string, Ingest::Image> images;
+      ASSERT_SUCCESS(ingest.run(filenames, [&images] (Ingest::Image &image) { images.emplace(image.filename, image); }));
+      ASSERT(images.size() == 4);
+      ASSERT(ingest.backend() != Ingest::Backend::AUTO);
+
+      auto &compiled = images.at("../test/corpus/compiled.exe");
+      ASSERT(!compiled.error);
+      ASSERT(compiled.pe.section_table().size() == PE(std::string("../test/corpus/compiled.exe")).section_table().size());
+      ASSERT(compiled.pe.size() <= compiled.file_size);
+
+      // the export directory is fetched on top of the headers
+      auto &dll = images.at("../test/corpus/dll.dll");
+      ASSERT(!dll.error);
+      ASSERT(ExportIndex(dll.pe).module() == "dll.dll");
+
+      ASSERT(images.at("../test/corpus/no_such_file.exe").error != nullptr);
+      ASSERT_THROWS(std::rethrow_exception(images.at("../test/corpus/no_such_file.exe").error), OpenFileFailureException);
+      ASSERT_THROWS(std::rethrow_exception(images.at("../test/framework.hpp").error), InvalidDOSSignatureException);
+
+      // the corpus files are smaller than a page, so each is read once, whole
+      ASSERT(ingest.bytes_read() == std::filesystem::file_size("../test/corpus/compiled.exe")
+                                    + std::filesystem::file_size("../test/corpus/dll.dll")
+                                    + std::filesystem::file_size("../test/framework.hpp"));
+   }
+
+   if (!Ingest::HasIoUring()) { ASSERT_THROWS(Ingest(2, Ingest::Backend::IO_URING), UnsupportedBackendException); }
+
+   COMPLETE();
+}
+
+#ifndef YAPP_WIN32
+int test_parse_server() {
+   INIT();
+
+   std::filesystem::remove_all("yappd_cache");
+   ParseServer server(std::string("yappd.sock"), 2, std::string("yappd_cache"));
+   std::thread serving([&server] () { server.serve(); });
+
+   // only the server's own user may connect
+   auto permissions = std::filesystem::status("yappd.sock").permissions();
+   ASSERT(permissions == (std::filesystem::perms::owner_read | std::filesystem::perms::owner_write));
+
+   PE dll(std::string("../test/corpus/dll.dll"));
+   auto expected = MetadataView::Build(dll);
+
+   {
+      ParseClient client(std::string("yappd.sock"));
+
+      // the daemon answers with the same record a batch scan builds
+      auto by_path = client.parse(std::string("../test/corpus/dll.dll"));
+      ASSERT(by_path.size() == expected.size());
+      ASSERT(std::memcmp(by_path.ptr(), expected.ptr(), expected.size()) == 0);
+
+      auto fd = open("../test/corpus/compiled.exe", O_RDONLY);
+      auto by_fd = client.parse(fd);
+      close(fd);
+      ASSERT(by_fd.import_count() == 2);
+
+      // a failed request leaves the connection usable
+      ASSERT_THROWS(client.parse(std::string("../test/corpus/no_such_file.exe")), ParseRequestException);
+      ASSERT(client.parse(std::string("../test/corpus/dll.dll")).digest() == expected.digest());
+
+      // idle connections don't hold workers, so more persistent clients than workers are all served
+      ParseClient other(std::string("yappd.sock"));
+      ParseClient third(std::string("yappd.sock"));
+
+      for (std::size_t i=0; i<2; ++i)
+      {
+         ASSERT(third.parse(std::string("../test/corpus/dll.dll")).digest() == expected.digest());
+         ASSERT(other.parse(std::string("../test/corpus/dll.dll")).digest() == expected.digest());
+         ASSERT(client.parse(std::string("../test/corpus/dll.dll")).digest() == expected.digest());
+      }
+   }
+
+   ParseClient second(std::string("yappd.sock"));
+   ASSERT(second.parse(std::string("../test/corpus/dll.dll")).digest() == expected.digest());
+   ASSERT(server.requests() == 11);
+
+   server.stop();
+   serving.join();
+
+   ASSERT_THROWS(second.parse(std::string("../test/corpus/dll.dll")), ReadFailureException);
+
+   COMPLETE();
+}
+#endif
+
+int test_stream_parser() {
+   INIT();
+
+   struct Collector : public StreamParser::Handler
+   {
+      std::size_t headers = 0, size = 0;
+      std::uint64_t hash = 0;
+      std::vector<StreamParser::Section> sections;
+      std::map<std::size_t, std::vector<std::uint8_t>> directories;
+
+      void on_headers(const PE &pe) override { this->headers = pe.size(); }
+      void on_directory(std::size_t index, const std::vector<std::uint8_t> &data) override { this->directories[index] = data; }
+      void on_section(const StreamParser::Section &section) override { this->sections.push_back(section); }
+      void on_end(std::size_t size, std::uint64_t hash) override { this->size = size; this->hash = hash; }
+   };
+
+   PE dll(std::string("../test/corpus/dll.dll"));
+   auto record = MetadataView::Build(dll);
+   auto range = dll.directory_file_range(headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT);
+   ASSERT(range.has_value());
+
+   Collector streamed;
+   StreamParser parser(streamed);
+   parser.add_directory(headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT);
+
+   std::ifstream stream("../test/corpus/dll.dll", std::ios::binary);
+   ASSERT(parser.parse(stream) == dll.size());
+
+   // the hashes match the ones computed over the whole file
+   ASSERT(streamed.size == dll.size());
+   ASSERT(streamed.hash == ExportIndexCache::ContentKey(dll).hash);
+   ASSERT(streamed.headers < dll.size());
+   ASSERT(streamed.sections.size() == record.section_count());
+
+   for (auto &section : streamed.sections)
+   {
+      ASSERT(section.hash == record.section(section.index).hash);
+      ASSERT(section.entropy >= 0.0 && section.entropy <= 8.0);
+   }
+
+   ASSERT(streamed.directories.size() == 1);
+   auto &exports = streamed.directories[headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT];
+   ASSERT(exports.size() == range->second - range->first);
+   ASSERT(std::memcmp(exports.data(), dll.ptr() + range->first, exports.size()) == 0);
+   ASSERT(parser.peak_buffered() < dll.size());
+   ASSERT(parser.buffered() == 0);
+
+   // chunk boundaries don't matter, even a byte at a time
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   Collector trickled;
+   StreamParser trickle(trickled);
+
+   for (std::size_t i=0; i<compiled.size(); ++i) { trickle.feed(compiled.ptr() + i, 1); }
+
+   trickle.finish();
+   ASSERT(trickled.hash == ExportIndexCache::ContentKey(compiled).hash);
+   ASSERT(trickled.sections.size() == compiled.section_table().size());
+
+   // a stream which ends before its headers do can't be parsed, but the parser can be reused
+   ASSERT_SUCCESS(trickle.feed(compiled.ptr(), 0x40));
+   ASSERT_THROWS(trickle.finish(), TruncatedStreamException);
+   ASSERT_THROWS(trickle.feed(compiled.ptr() + 1, 0x40), InvalidDOSSignatureException);
+   ASSERT_SUCCESS(trickle.feed(compiled.ptr(), compiled.size()));
+   ASSERT_SUCCESS(trickle.finish());
+   ASSERT(trickled.hash == ExportIndexCache::ContentKey(compiled).hash);
+
+   // headers can't claim more than MaxHeaderExtent, however far e_lfanew points
+   auto far_header = std::vector<std::uint8_t>(compiled.ptr(), compiled.ptr() + sizeof(headers::raw::IMAGE_DOS_HEADER));
+   std::uint32_t far_lfanew = 0xFFFFFF00;
+   std::memcpy(&far_header[offsetof(headers::raw::IMAGE_DOS_HEADER, e_lfanew)], &far_lfanew, sizeof(far_lfanew));
+   ASSERT_THROWS(PE::HeaderExtent(far_header.data(), far_header.size()), OversizedHeadersException);
+   ASSERT_THROWS(trickle.feed(far_header.data(), far_header.size()), OversizedHeadersException);
+   ASSERT(trickle.buffered() == 0);
+
+   // a directory bigger than its cap is never buffered
+   Collector capped;
+   StreamParser capped_parser(capped);
+   capped_parser.add_directory(headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT, range->second - range->first - 1);
+   ASSERT_SUCCESS(capped_parser.feed(dll.ptr(), dll.size()));
+   ASSERT_SUCCESS(capped_parser.finish());
+   ASSERT(capped.directories.empty());
+   ASSERT(capped.sections.size() == record.section_count());
+
+#ifndef YAPP_WIN32
+   int pipes[2];
+   ASSERT(pipe(pipes) == 0);
+
+   // the corpus file fits in the pipe's buffer, so it can be written before anything is read
+   ASSERT(write(pipes[1], dll.ptr(), dll.size()) == static_cast<ssize_t>(dll.size()));
+   close(pipes[1]);
+
+   Collector piped;
+   StreamParser from_pipe(piped);
+   ASSERT(from_pipe.parse(StreamParser::DescriptorReader(pipes[0])) == dll.size());
+   close(pipes[0]);
+   ASSERT(piped.hash == ExportIndexCache::ContentKey(dll).hash);
+#endif
+
+   COMPLETE();
+}
+
+int test_archive() {
+   INIT();
+
+   PE dll(std::string("../test/corpus/dll.dll"));
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+
+   ZipArchive zip(std::string("../test/corpus/samples.zip"));
+   ASSERT(zip.entries().size() == 2);
+
+   auto entry = zip.find("dll.dll");
+   ASSERT(entry.has_value());
+   ASSERT(entry->encrypted());
+   ASSERT(entry->method == ZipArchive::Method::DEFLATED);
+
+   // entries inflate straight into an image of their declared size
+   auto extracted = zip.extract(*entry);
+   ASSERT(extracted.size() == dll.size());
+   ASSERT(std::memcmp(extracted.ptr(), dll.ptr(), dll.size()) == 0);
+   ASSERT(extracted.valid_nt_headers().file_header()->Machine == dll.valid_nt_headers().file_header()->Machine);
+
+   auto stored = zip.find("compiled.exe");
+   ASSERT(stored.has_value() && stored->method == ZipArchive::Method::STORED);
+   ASSERT(ExportIndexCache::ContentKey(zip.extract(*stored)).hash == ExportIndexCache::ContentKey(compiled).hash);
+
+   struct Hasher : public StreamParser::Handler
+   {
+      std::uint64_t hash = 0;
+      void on_end(std::size_t size, std::uint64_t hash) override { this->hash = hash; }
+   };
+
+   Hasher hasher;
+   StreamParser parser(hasher);
+   zip.stream(*entry, parser);
+   ASSERT(hasher.hash == ExportIndexCache::ContentKey(dll).hash);
+
+   ZipArchive wrong(std::string("../test/corpus/samples.zip"), std::string("not infected"));
+   ASSERT_THROWS(wrong.extract(*wrong.find("dll.dll")), ArchivePasswordException);
+
+   std::mutex mutex;
+   std::map<std::string, std::uint64_t> hashes;
+
+   zip.for_each([&mutex, &hashes] (const ZipArchive::Entry &entry, PE &pe, std::exception_ptr error) {
+      if (error) { return; }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      hashes[entry.name] = ExportIndexCache::ContentKey(pe).hash;
+   }, 2);
+
+   ASSERT(hashes.size() == 2);
+   ASSERT(hashes["dll.dll"] == ExportIndexCache::ContentKey(dll).hash);
+   ASSERT(hashes["compiled.exe"] == ExportIndexCache::ContentKey(compiled).hash);
+
+   std::map<std::string, bool> failed;
+
+   wrong.for_each([&mutex, &failed] (const ZipArchive::Entry &entry, PE &pe, std::exception_ptr error) {
+      std::lock_guard<std::mutex> lock(mutex);
+      failed[entry.name] = error != nullptr;
+   });
+
+   ASSERT(failed.size() == 2 && failed["dll.dll"] && failed["compiled.exe"]);
+
+   GzipFile gzip(std::string("../test/corpus/dll.dll.gz"));
+   ASSERT(gzip.name() == "dll.dll");
+   ASSERT(gzip.declared_size() == dll.size());
+
+   auto inflated = gzip.extract();
+   ASSERT(std::memcmp(inflated.ptr(), dll.ptr(), dll.size()) == 0);
+
+   // declared sizes are checked before they're allocated
+   ASSERT_THROWS(gzip.extract(dll.size() - 1), ArchiveEntryTooLargeException);
+   ASSERT_THROWS(zip.extract(*entry, dll.size() - 1), ArchiveEntryTooLargeException);
+
+   auto bomb = Memory<std::uint8_t>(std::string("../test/corpus/dll.dll.gz"));
+   std::uint32_t bomb_size = 0xFFFFFFF0;
+   std::memcpy(bomb.ptr() + bomb.size() - 4, &bomb_size, sizeof(bomb_size));
+   ASSERT_THROWS(GzipFile(bomb).extract(0xFFFFFFFF), InvalidArchiveException);
+
+   gzip.stream(parser);
+   ASSERT(hasher.hash == ExportIndexCache::ContentKey(dll).hash);
+
+   ASSERT_THROWS(GzipFile(Memory<std::uint8_t>(dll.ptr(), dll.size())), InvalidArchiveException);
+   ASSERT_THROWS(ZipArchive(Memory<std::uint8_t>(dll.ptr(), dll.size())), InvalidArchiveException);
+
+   COMPLETE();
+}
+
+int test_parse_budget() {
+   INIT();
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   PE dll(std::string("../test/corpus/dll.dll"));
+
+   {
+      // every limit is generous enough for the corpus files
+      auto budget = ParseBudget().timeout(std::chrono::seconds(60)).max_bytes(0x10000).max_elements(64);
+      ParseBudget::Scope scope(budget);
+
+      ASSERT(ImportResolver::ImportList(compiled).size() == 2);
+      ASSERT(ExportIndex(dll).exports().size() == 1);
+      ASSERT(budget.elements() > 0);
+      ASSERT(budget.bytes_touched() > 0);
+   }
+
+   ASSERT(ParseBudget::Current() == nullptr);
+
+   {
+      auto budget = ParseBudget().max_elements(ParseBudget::Structure::IMPORT_THUNKS, 0);
+      ParseBudget::Scope scope(budget);
+
+      ASSERT_THROWS(ImportResolver::ImportList(compiled), BudgetExceededException);
+      ASSERT_SUCCESS(ExportIndex(dll));
+
+      // the innermost scope wins, and the outer one is restored when it ends
+      {
+         auto unlimited = ParseBudget();
+         ParseBudget::Scope inner(unlimited);
+
+         ASSERT(ImportResolver::ImportList(compiled).size() == 2);
+      }
+
+      ASSERT(ParseBudget::Current() == &budget);
+   }
+
+   auto outcome = [] (ParseBudget &budget, const PE &pe) -> std::optional<BudgetExceededException> {
+      ParseBudget::Scope scope(budget);
+
+      try {
+         ExportIndex index(pe);
+      }
+      catch (BudgetExceededException &exception) {
+         return exception;
+      }
+
+      return std::nullopt;
+   };
+
+   auto short_strings = ParseBudget().max_elements(ParseBudget::Structure::STRINGS, 3);
+   auto few_bytes = ParseBudget().max_bytes(4);
+   auto expired = ParseBudget().deadline(ParseBudget::Clock::now() - std::chrono::seconds(1));
+
+   auto strings = outcome(short_strings, dll);
+   ASSERT(strings.has_value() && strings->limit == BudgetExceededException::ELEMENTS);
+   ASSERT(strings->structure == BudgetExceededException::STRINGS);
+
+   auto bytes = outcome(few_bytes, dll);
+   ASSERT(bytes.has_value() && bytes->limit == BudgetExceededException::BYTES);
+
+   auto deadline = outcome(expired, dll);
+   ASSERT(deadline.has_value() && deadline->limit == BudgetExceededException::DEADLINE);
+
+   // a string with no terminator is given up on at the limit rather than scanned in full
+   auto unterminated = std::vector<std::uint8_t>(0x100000, 'A');
+   unterminated[4] = 0;
+   ASSERT(ParseBudget::ReadString(Memory<std::uint8_t>(unterminated), 0) == "AAAA");
+   ASSERT_THROWS(ParseBudget::ReadString(Memory<std::uint8_t>(unterminated), 5), OutOfBoundsException);
+
+   {
+      auto budget = ParseBudget().max_elements(ParseBudget::Structure::STRINGS, 16);
+      ParseBudget::Scope scope(budget);
+
+      ASSERT_THROWS(ParseBudget::ReadString(Memory<std::uint8_t>(unterminated), 5), BudgetExceededException);
+      ASSERT(budget.bytes_touched() <= ParseBudget::StringChunk);
+   }
+
+   COMPLETE();
+}
+
+int test_async_parse() {
+   INIT();
+
+   for (auto backend : {AsyncParser::Backend::THREAD_POOL, AsyncParser::Backend::AUTO})
+   {
+      AsyncParser parser(4, backend);
+      ASSERT(parser.backend() != AsyncParser::Backend::AUTO);
+      ASSERT_THROWS(parser.open("../test/corpus/no_such_file.exe"), OpenFileFailureException);
+
+      auto &compiled = parser.open("../test/corpus/compiled.exe");
+      auto &dll = parser.open("../test/corpus/dll.dll");
+      auto &text = parser.open("../test/framework.hpp");
+
+      // nothing is read until it's asked for
+      ASSERT(compiled.bytes_loaded() == 0);
+      ASSERT(!compiled.loaded(0, 1));
+      ASSERT(compiled.loaded(compiled.size(), 1));
+
+      std::vector<Import> imports;
+      std::string module;
+      std::exception_ptr text_error;
+
+      parser.imports(compiled, [&imports] (std::vector<Import> &result, std::exception_ptr error) {
+         if (!error) { imports = result; }
+      });
+      parser.directory(dll, headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT, [&module] (PE &pe, std::exception_ptr error) {
+         if (!error) { module = ExportIndex(pe).module(); }
+      });
+      parser.headers(text, [&text_error] (PE &, std::exception_ptr error) { text_error = error; });
+
+      ASSERT_SUCCESS(parser.run());
+
+      auto expected = ImportResolver::ImportList(PE(std::string("../test/corpus/compiled.exe")));
+      ASSERT(!expected.empty());
+      ASSERT(imports.size() == expected.size());
+      ASSERT(imports[0].module == expected[0].module && imports[0].name == expected[0].name);
+
+      ASSERT(module == "dll.dll");
+      ASSERT_THROWS(std::rethrow_exception(text_error), InvalidDOSSignatureException);
+
+      // each file is smaller than a page, so it's read once no matter how many loads ask for it
+      ASSERT(compiled.loaded(0, compiled.size()));
+      ASSERT(compiled.bytes_loaded() == compiled.size());
+      ASSERT(parser.reads() == 3);
+      ASSERT(parser.bytes_read() == compiled.size() + dll.size() + text.size());
+
+      // a load of what's already there still completes from the loop
+      bool called = false;
+      compiled.load(0, 2, [&called] (std::exception_ptr) { called = true; });
+      ASSERT(!called);
+      ASSERT_SUCCESS(parser.run());
+      ASSERT(called);
+      ASSERT(parser.reads() == 3);
+
+      ASSERT_SUCCESS(parser.close(text));
+   }
+
+   // each image is charged to its own budget, not to the one installed around the loop
+   {
+      AsyncParser parser(4, AsyncParser::Backend::THREAD_POOL);
+      auto &limited = parser.open("../test/corpus/compiled.exe");
+      auto &unlimited = parser.open("../test/corpus/compiled.exe");
+
+      auto no_thunks = ParseBudget().max_elements(ParseBudget::Structure::IMPORT_THUNKS, 0);
+      auto loop_budget = ParseBudget();
+      limited.set_budget(&no_thunks);
+
+      std::exception_ptr limited_error;
+      std::size_t imported = 0;
+
+      parser.imports(limited, [&limited_error] (std::vector<Import> &, std::exception_ptr error) { limited_error = error; });
+      parser.imports(unlimited, [&imported] (std::vector<Import> &result, std::exception_ptr) { imported = result.size(); });
+
+      ParseBudget::Scope scope(loop_budget);
+      ASSERT_SUCCESS(parser.run());
+
+      ASSERT_THROWS(std::rethrow_exception(limited_error), BudgetExceededException);
+      ASSERT(imported == 2);
+      ASSERT(loop_budget.elements() > 0);
+   }
+
+   COMPLETE();
+}
+
+int test_instrumentation() {
+   INIT();
+
+   auto pe = PE(std::string("../test/corpus/compiled.exe"));
+   auto before = Instrumentation::Take();
+
+   auto imports = ImportResolver::ImportList(pe);
+   ASSERT_THROWS(pe.rva_to_offset(RVA(0xFFFFFFF0)), InvalidRVAException);
+   ASSERT(pe.read(0, 2).size() == 2);
+
+   auto delta = Instrumentation::Take() - before;
+
+   if (Instrumentation::Enabled)
+   {
+      ASSERT(delta.counter(Instrumentation::ADDRESS_TRANSLATIONS) > 0);
+      ASSERT(delta.counter(Instrumentation::BYTES_READ) == 2);
+      ASSERT(delta.counter(Instrumentation::EXCEPTIONS) >= 1);
+      ASSERT(delta.exceptions_of<InvalidRVAException>() == 1);
+      ASSERT(delta.directories[headers::raw::IMAGE_DIRECTORY_ENTRY_IMPORT].calls == 1);
+   }
+   else
+   {
+      // without YAPP_INSTRUMENT, nothing on the hot paths counts
+      ASSERT(delta.counter(Instrumentation::ADDRESS_TRANSLATIONS) == 0);
+      ASSERT(delta.counter(Instrumentation::EXCEPTIONS) == 0);
+      ASSERT(delta.exceptions.empty());
+   }
+
+   Instrumentation::Reset();
+   ASSERT(Instrumentation::Take().counter(Instrumentation::EXCEPTIONS) == 0);
+
+   COMPLETE();
+}
+
+int test_memory_manager() {
+   INIT();
+
+   auto &manager = MemoryManager::GetInstance();
+   auto before = manager.statistics();
+
+   {
+      auto pe = PE(std::string("../test/corpus/compiled.exe"));
+      auto section_table = pe.section_table();
+      auto nt_headers = pe.valid_nt_headers();
+
+      ASSERT(manager.statistics().live_entries > before.live_entries);
+      ASSERT(manager.statistics().relationships > before.relationships);
+   }
+
+   // once the image and its views are gone, so is everything tracked for them
+   auto after = manager.statistics();
+   ASSERT(after.live_entries == before.live_entries);
+   ASSERT(after.relationships == before.relationships);
+   ASSERT(after.parents == before.parents);
+   ASSERT(after.peak_live_entries > before.live_entries);
+
+   // a view registered but never constructed leaves nothing behind once it's invalidated
+   std::uint8_t buffer[16] = {0};
+   auto memory = Memory<std::uint8_t>(buffer, sizeof(buffer));
+   manager.relationship(buffer, sizeof(buffer), buffer + 4, 4);
+   ASSERT(manager.statistics().relationships == before.relationships + 1);
+   ASSERT(!manager.is_valid(buffer + 4, 4));
+
+   manager.invalidate(buffer + 4, 4);
+   ASSERT(manager.statistics().relationships == before.relationships);
+   ASSERT(manager.statistics().parents == before.parents);
+
+   // consistent use leaves nothing dead to reclaim
+   ASSERT(manager.reclaim() == 0);
+
+   COMPLETE();
+}
+
+int test_memory_iterators() {
+   INIT();
+
+   std::uint32_t values[8] = {8, 3, 5, 1, 7, 2, 6, 4};
+   auto memory = Memory<std::uint32_t>(values, (std::size_t)8);
+   const auto &const_memory = memory;
+
+   ASSERT(memory.end() - memory.begin() == 8);
+   ASSERT(memory.begin()[2] == 5);
+   ASSERT(*(memory.end() - 1) == 4);
+   ASSERT(std::distance(const_memory.begin(), const_memory.end()) == 8);
+   ASSERT(*const_memory.rbegin() == 4);
+
+   std::sort(memory.begin(), memory.end());
+   ASSERT(std::is_sorted(const_memory.begin(), const_memory.end()));
+   ASSERT(std::lower_bound(const_memory.begin(), const_memory.end(), 6) - const_memory.begin() == 5);
+   ASSERT(std::binary_search(memory.begin(), memory.end(), 3));
+
+   // spans view the same elements without copying them
+   auto span = memory.span();
+   ASSERT(span.data() == values && span.size() == 8);
+   ASSERT(span.subspan(2, 3)[0] == 3);
+   ASSERT(span.last(1)[0] == 8);
+   ASSERT(as_bytes(span).size() == sizeof(values));
+   ASSERT_THROWS(span.subspan(6, 3), OutOfBoundsException);
+
+   auto view = Memory<std::uint32_t>(span.first(4));
+   ASSERT(view.ptr() == values && view.size() == 4);
+
+   Span<const std::uint32_t> const_span = const_memory;
+   ASSERT(const_span.data() == values && const_span.size() == 8);
+
+   auto buffer = std::vector<std::uint8_t>{'M', 'Z', 0x90, 0x00};
+   auto bytes = Memory<std::uint8_t>(Span<std::uint8_t>(buffer));
+   ASSERT(std::find(bytes.span().begin(), bytes.span().end(), 0x90) - bytes.span().begin() == 2);
+   ASSERT(bytes.byte_span().size() == 4);
+
+   COMPLETE();
+}
+
+int test_header_fields() {
+   INIT();
+
+   static_assert(Fields<raw::IMAGE_OPTIONAL_HEADER64>::Get("ImageBase").offset == 24, "field offsets are constants");
+   static_assert(Fields<raw::IMAGE_SECTION_HEADER>::Get("Name").kind == Field::BYTES, "field kinds are constants");
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   auto &file_header = *compiled.valid_nt_headers().file_header();
+   auto &section = compiled.section_table().get(0);
+
+   ASSERT(Fields<raw::IMAGE_FILE_HEADER>::Read(file_header, "Machine") == compiled.machine());
+   ASSERT(Fields<raw::IMAGE_SECTION_HEADER>::Read(section, "VirtualSize") == section.Misc.VirtualSize);
+   ASSERT_THROWS(Fields<raw::IMAGE_FILE_HEADER>::Get("NoSuchField"), FieldNotFoundException);
+
+   std::stringstream dump;
+   Fields<raw::IMAGE_SECTION_HEADER>::Dump(section, dump);
+   ASSERT(dump.str().find("Name: \"" + compiled.section_table()[0].name_string() + "\"") == 0);
+
+   auto copy = section;
+   ASSERT(Fields<raw::IMAGE_SECTION_HEADER>::Equal(section, copy));
+   ASSERT(Fields<raw::IMAGE_SECTION_HEADER>::Hash(section) == Fields<raw::IMAGE_SECTION_HEADER>::Hash(copy));
+
+   copy.Characteristics ^= 1;
+   auto differences = Fields<raw::IMAGE_SECTION_HEADER>::Differences(section, copy);
+   ASSERT(differences.size() == 1 && std::string(differences[0]->name) == "Characteristics");
+   ASSERT(Fields<raw::IMAGE_SECTION_HEADER>::Hash(section) != Fields<raw::IMAGE_SECTION_HEADER>::Hash(copy));
+
+   // nested structures and arrays flatten into a column per element
+   ColumnTable table("sections");
+   table.add_fields<raw::IMAGE_SECTION_HEADER>();
+   ASSERT(table.append_fields(0, section) == table.columns().size());
+   table.end_row();
+   ASSERT(table.string(table.column_index("Name"), 0) == compiled.section_table()[0].name_string());
+   ASSERT(table.integer(table.column_index("SizeOfRawData"), 0) == section.SizeOfRawData);
+
+   ColumnTable nt_table("nt");
+   nt_table.add_fields<raw::IMAGE_FILE_HEADER>("FileHeader.");
+   ASSERT(nt_table.column_index("FileHeader.NumberOfSections") == 1);
+
+   ColumnTable optional_table("optional");
+   optional_table.add_fields<raw::IMAGE_OPTIONAL_HEADER64>();
+   ASSERT(optional_table.columns()[optional_table.column_index("DataDirectory[15].Size")].type == ColumnTable::UINT32);
+   ASSERT(optional_table.columns()[optional_table.column_index("ImageBase")].type == ColumnTable::UINT64);
+
+   COMPLETE();
+}
+
+int test_encoding() {
+   INIT();
+
+   std::uint8_t data[] = {0x00, 0x0F, 0x10, 0xAB, 0xFF, 'M', 'a', 'n'};
+   const auto memory = Memory<std::uint8_t>(data, sizeof(data));
+
+   // every byte gets two digits, including the ones below 0x10
+   ASSERT(memory.to_hex() == "000f10abff4d616e");
+   ASSERT(memory.to_hex(true) == "000F10ABFF4D616E");
+   ASSERT(memory.subsection(5, 3).to_base64() == "TWFu");
+   ASSERT(memory.to_base64() == "AA8Qq/9NYW4=");
+
+   char digits[Hex::EncodedSize(sizeof(data))];
+   ASSERT(Hex::Encode(memory, digits) == sizeof(digits));
+   ASSERT(std::string(digits, sizeof(digits)) == memory.to_hex());
+   ASSERT_THROWS(Hex::Encode(memory, Span<char>(digits, 4)), OutOfBoundsException);
+
+   std::uint8_t decoded[sizeof(data)];
+   ASSERT(Hex::Decode(Span<const char>(digits, sizeof(digits)), decoded) == sizeof(data));
+   ASSERT(std::memcmp(decoded, data, sizeof(data)) == 0);
+   ASSERT(Base64::Decode(memory.to_base64(), decoded) == sizeof(data));
+   ASSERT(std::memcmp(decoded, data, sizeof(data)) == 0);
+
+   ASSERT_THROWS(Hex::ToBytes(std::string("0g")), InvalidEncodingException);
+   ASSERT_THROWS(Hex::ToBytes(std::string("abc")), InvalidEncodingException);
+   ASSERT_THROWS(Base64::ToBytes(std::string("TW=u")), InvalidEncodingException);
+   ASSERT_THROWS(Base64::ToBytes(std::string("TWF")), InvalidEncodingException);
+
+   // long inputs run through the vector kernels, with their tails left to the scalar code
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   auto image = compiled.subsection(0, 1000);
+   auto hex = image.to_hex();
+   auto base64 = image.to_base64();
+
+   ASSERT(hex.size() == 2000 && hex.substr(0, 4) == "4d5a");
+   ASSERT(Hex::ToBytes(hex) == image.to_vec());
+   ASSERT(Base64::DecodedSize(Span<const char>(base64)) == 1000);
+   ASSERT(Base64::ToBytes(base64) == image.to_vec());
+
+   COMPLETE();
+}
+
+int test_digest() {
+   INIT();
+
+   const std::string abc = "abc";
+   auto digest = Sha256::Hash(Span<const std::uint8_t>(reinterpret_cast<const std::uint8_t *>(abc.data()), abc.size()));
+   ASSERT(Hex::ToString(digest) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+   ASSERT(Hex::ToString(Sha256::Hash(Span<const std::uint8_t>())) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+   // feeding a message in uneven pieces gives the same digest as hashing it at once
+   auto message = std::vector<std::uint8_t>(1000);
+   for (std::size_t i=0; i<message.size(); ++i) { message[i] = static_cast<std::uint8_t>(i * 7); }
+
+   auto hash = Sha256();
+   hash.update(Span<const std::uint8_t>(message.data(), 3));
+   hash.update(Span<const std::uint8_t>(message.data() + 3, 120));
+   hash.update(Span<const std::uint8_t>(message.data() + 123, message.size() - 123));
+   ASSERT(hash.finish() == Sha256::Hash(message));
+
+   COMPLETE();
+}
+
+int test_coff() {
+   INIT();
+
+   COFFObject object(std::string("../test/corpus/object.obj"));
+   ASSERT(object.machine() == headers::raw::IMAGE_FILE_MACHINE_AMD64);
+
+   // the same wrappers PE uses, without a DOS header in front of them
+   auto sections = object.section_table();
+   ASSERT(sections.size() == 4);
+   ASSERT(object.section_name(sections[0]) == ".text");
+   ASSERT(object.section_name(sections[3]) == ".rdata$long_section_name");
+   ASSERT(object.section_data(sections[2]).size() == 0);
+   ASSERT(std::memcmp(object.section_data(sections[3]).ptr(), "hello", 6) == 0);
+
+   auto symbols = object.symbol_table();
+   ASSERT(symbols.size() == 14);
+   ASSERT(symbols.next(0) == 2);
+   ASSERT(symbols[11].short_name() == "counter");
+   ASSERT(symbols[9].has_long_name());
+   ASSERT(object.symbol_name(symbols[9]) == "call_through_a_long_symbol_name");
+   ASSERT(symbols[10].is_undefined());
+
+   auto relocations = object.relocations(sections[0]);
+   ASSERT(relocations.size() == 2);
+   ASSERT(relocations[0].VirtualAddress == 0x15);
+   ASSERT(object.symbol_name(symbols[relocations[0].SymbolTableIndex]) == "external_function");
+   ASSERT(object.relocations(sections[3]).size() == 0);
+
+   std::vector<std::string_view> externals;
+
+   object.for_each_symbol([&externals] (std::size_t index, const headers::raw::IMAGE_SYMBOL &symbol, std::string_view name) {
+      if (symbol.StorageClass == headers::raw::IMAGE_SYM_CLASS_EXTERNAL) { externals.push_back(name); }
+   });
+
+   ASSERT(externals.size() == 4);
+   ASSERT(externals[1] == "call_through_a_long_symbol_name");
+
+   // names point into the object rather than being copied out of it
+   ASSERT(externals[1].data() >= reinterpret_cast<const char *>(object.ptr()));
+   ASSERT(externals[1].data() < reinterpret_cast<const char *>(object.ptr() + object.size()));
+
+   ASSERT(object.find_symbol("counter") == std::optional<std::size_t>(11));
+   ASSERT(!object.find_symbol("missing").has_value());
+
+   auto truncated = object.subsection(0, 0x110);
+   ASSERT_THROWS(COFFObject(truncated).symbol_table(), OutOfBoundsException);
+
+   PE compiled(std::string("../test/corpus/compiled.exe"));
+   ASSERT_THROWS(COFFObject(compiled).section_table(), OutOfBoundsException);
+
+   COMPLETE();
+}
+
+int test_lib_archive() {
+   INIT();
+
+   // an MSVC-style library, with both linker members and a longnames member
+   LibArchive library(std::string("../test/corpus/static.lib"));
+   ASSERT(library.members().size() == 6);
+   ASSERT(library.symbol_count() == 12);
+   ASSERT(library.members()[0].name == "objects/long_member_name.obj");
+   ASSERT(library.members()[1].name == "other.obj");
+
+   auto defining = library.find_symbol("call_through_a_long_symbol_name");
+   ASSERT(defining.has_value() && defining->name == "objects/long_member_name.obj");
+   ASSERT(!library.find_symbol("external_function").has_value());
+   ASSERT(!library.find_symbol("missing").has_value());
+
+   // members are views into the archive which the object parser takes as they are
+   auto object = library.object(*defining);
+   ASSERT(object.ptr() == library.member_data(*defining).ptr());
+   ASSERT(object.find_symbol("call_through_a_long_symbol_name") == std::optional<std::size_t>(9));
+
+   COFFObject corpus_object(std::string("../test/corpus/object.obj"));
+   ASSERT(object.size() == corpus_object.size());
+   ASSERT(std::memcmp(object.ptr(), corpus_object.ptr(), object.size()) == 0);
+
+   ASSERT(!library.import_header(library.members()[1]).has_value());
+
+   auto imported = library.find_symbol("__imp_DestroyWidget");
+   ASSERT(imported.has_value() && library.is_import(*imported));
+   ASSERT_THROWS(library.object(*imported).section_table(), InvalidObjectException);
+
+   auto import = library.import_header(*imported);
+   ASSERT(import.has_value());
+   ASSERT(import->machine == headers::raw::IMAGE_FILE_MACHINE_AMD64);
+   ASSERT(import->type == headers::raw::IMPORT_OBJECT_CODE);
+   ASSERT(import->symbol == "DestroyWidget");
+   ASSERT(import->dll == "sample.dll");
+   ASSERT(import->export_name == "DestroyWidget");
+   ASSERT(import->ordinal_or_hint == 7);
+
+   auto by_ordinal = library.import_header(*library.find_symbol("OrdinalOnly"));
+   ASSERT(by_ordinal.has_value() && by_ordinal->by_ordinal());
+   ASSERT(by_ordinal->ordinal_or_hint == 9 && by_ordinal->export_name.empty());
+
+   auto data = library.import_header(*library.find_symbol("__imp_widget_count"));
+   ASSERT(data.has_value() && data->type == headers::raw::IMPORT_OBJECT_DATA);
+
+   // a GNU-style import library, which only has the first linker member
+   LibArchive imports(std::string("../test/corpus/imports.lib"));
+   ASSERT(imports.members().size() == 7);
+   ASSERT(imports.symbol_count() == 10);
+   ASSERT(imports.members()[0].name == "sample.dll");
+
+   auto descriptor = imports.find_symbol("__IMPORT_DESCRIPTOR_sample");
+   ASSERT(descriptor.has_value() && !imports.is_import(*descriptor));
+   ASSERT(imports.object(*descriptor).machine() == headers::raw::IMAGE_FILE_MACHINE_AMD64);
+
+   auto create = imports.find_symbol("CreateWidget");
+   ASSERT(create.has_value() && imports.import_header(*create)->export_name == "CreateWidget");
+
+   ASSERT_THROWS(LibArchive(Memory<std::uint8_t>(corpus_object.ptr(), corpus_object.size())), InvalidArchiveException);
+
+   COMPLETE();
+}
+
 int test_dll() {
    INIT();
 
@@ -169,11 +1410,76 @@ main
    LOG_INFO("Testing dynamic memory operations.");
    PROCESS_RESULT(test_dynamic_memory);
 
+   LOG_INFO("Testing piece table edits.");
+   PROCESS_RESULT(test_piece_table);
+
    LOG_INFO("Testing parsing compiled.exe.");
    PROCESS_RESULT(test_compiled);
 
    LOG_INFO("Testing parsing dll.dll");
    PROCESS_RESULT(test_dll);
+
+   LOG_INFO("Testing patch overlays.");
+   PROCESS_RESULT(test_patch_overlay);
+
+   LOG_INFO("Testing section layouts.");
+   PROCESS_RESULT(test_section_layout);
+
+   LOG_INFO("Testing import resolution.");
+   PROCESS_RESULT(test_import_resolver);
+
+   LOG_INFO("Testing loader simulation.");
+   PROCESS_RESULT(test_loader);
+
+   LOG_INFO("Testing metadata cache.");
+   PROCESS_RESULT(test_metadata_cache);
+
+   LOG_INFO("Testing columnar export.");
+   PROCESS_RESULT(test_columnar);
+
+   LOG_INFO("Testing asynchronous ingestion.");
+   PROCESS_RESULT(test_ingest);
+
+#ifndef YAPP_WIN32
+   LOG_INFO("Testing the parse server.");
+   PROCESS_RESULT(test_parse_server);
+#endif
+
+   LOG_INFO("Testing stream parsing.");
+   PROCESS_RESULT(test_stream_parser);
+
+   LOG_INFO("Testing archive extraction.");
+   PROCESS_RESULT(test_archive);
+
+   LOG_INFO("Testing parse budgets.");
+   PROCESS_RESULT(test_parse_budget);
+
+   LOG_INFO("Testing asynchronous parsing.");
+   PROCESS_RESULT(test_async_parse);
+
+   LOG_INFO("Testing instrumentation.");
+   PROCESS_RESULT(test_instrumentation);
+
+   LOG_INFO("Testing the memory manager's footprint.");
+   PROCESS_RESULT(test_memory_manager);
+
+   LOG_INFO("Testing memory iterators and spans.");
+   PROCESS_RESULT(test_memory_iterators);
+
+   LOG_INFO("Testing header field tables.");
+   PROCESS_RESULT(test_header_fields);
+
+   LOG_INFO("Testing hex and base64 encoding.");
+   PROCESS_RESULT(test_encoding);
+
+   LOG_INFO("Testing SHA-256 digests.");
+   PROCESS_RESULT(test_digest);
+
+   LOG_INFO("Testing COFF objects.");
+   PROCESS_RESULT(test_coff);
+
+   LOG_INFO("Testing static and import libraries.");
+   PROCESS_RESULT(test_lib_archive);
       
    COMPLETE();
 }
@@ -0,0 +1,118 @@
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+#include <framework.hpp>
+#include <yapp.hpp>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+using namespace yapp;
+
+namespace
+{
+   /// How often the footprint is checked, in parses.
+   const std::size_t Checkpoint = 10000;
+
+   /// How far the resident set may grow after the first checkpoint.
+   const std::size_t ResidentSlack = 4 * 1024 * 1024;
+
+   std::vector<std::uint8_t>
+   read_file
+   (const std::string &filename)
+   {
+      std::ifstream stream(filename, std::ios::binary);
+      return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+   }
+
+   std::size_t
+   resident_size
+   ()
+   {
+#ifdef __linux__
+      std::ifstream statm("/proc/self/statm");
+      std::size_t pages = 0, resident = 0;
+      statm >> pages >> resident;
+
+      return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#else
+      return 0;
+#endif
+   }
+
+   /// Parse an image the way a worker would, through a view over a buffer it owns.
+   void
+   parse
+   (std::vector<std::uint8_t> &data)
+   {
+      auto pe = PE(Memory<std::uint8_t>(data.data(), data.size()));
+      auto section_table = pe.section_table();
+
+      for (std::size_t i=0; i<section_table.size(); ++i)
+         (void)pe.rva_to_offset(RVA(section_table.get(i).VirtualAddress));
+
+      (void)pe.calculate_checksum();
+      (void)ImportResolver::ImportList(pe);
+      (void)MetadataView::Build(pe);
+
+      if (pe.data_directory().has_directory(pe, headers::raw::IMAGE_DIRECTORY_ENTRY_EXPORT))
+         (void)ExportIndex(pe);
+   }
+}
+
+int test_flat_footprint(std::size_t iterations) {
+   INIT();
+
+   auto files = std::vector<std::vector<std::uint8_t>>{read_file("../test/corpus/compiled.exe"),
+                                                       read_file("../test/corpus/dll.dll"),
+                                                       read_file("../test/corpus/dllfw.dll")};
+
+   auto &manager = MemoryManager::GetInstance();
+   auto baseline = manager.statistics();
+   std::size_t first_resident = 0;
+   std::size_t last_resident = 0;
+   std::size_t growths = 0;
+
+   for (std::size_t i=0; i<iterations; ++i)
+   {
+      parse(files[i % files.size()]);
+
+      if ((i+1) % Checkpoint != 0) { continue; }
+
+      auto statistics = manager.statistics();
+
+      if (statistics.live_entries != baseline.live_entries || statistics.relationships != baseline.relationships)
+         ++growths;
+
+      last_resident = resident_size();
+      if (first_resident == 0) { first_resident = last_resident; }
+   }
+
+   LOG_INFO("Parsed " << iterations << " images; resident size went from " << first_resident << " to " << last_resident << " bytes.");
+
+   // every parse releases everything the manager tracked for it
+   ASSERT(growths == 0);
+   ASSERT(manager.statistics().live_entries == baseline.live_entries);
+   ASSERT(manager.statistics().relationships == baseline.relationships);
+   ASSERT(manager.statistics().parents == baseline.parents);
+   ASSERT(manager.statistics().peak_live_entries < baseline.live_entries + 1024);
+   ASSERT(last_resident <= first_resident + ResidentSlack);
+
+   COMPLETE();
+}
+
+int
+main
+(int argc, char *argv[])
+{
+   INIT();
+
+   std::size_t iterations = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+   LOG_INFO("Testing the memory manager's footprint over repeated parses.");
+   PROCESS_RESULT([iterations] () { return test_flat_footprint(iterations); });
+
+   COMPLETE();
+}
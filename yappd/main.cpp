@@ -0,0 +1,74 @@
+//! @file main.cpp
+//! @brief yappd, a daemon serving PE parse requests over a Unix domain socket.
+//!
+//! Usage: `yappd <socket path> [--workers N] [--cache DIRECTORY]`
+//!
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <pthread.h>
+
+#include <yapp.hpp>
+
+using namespace yapp;
+
+int
+main
+(int argc, char *argv[])
+{
+   if (argc < 2)
+   {
+      std::cerr << "usage: " << argv[0] << " <socket path> [--workers N] [--cache DIRECTORY]" << std::endl;
+      return 2;
+   }
+
+   std::string socket_path = argv[1];
+   std::string cache_directory;
+   std::size_t workers = std::thread::hardware_concurrency();
+
+   for (int i=2; i+1<argc; i+=2)
+   {
+      std::string option = argv[i];
+
+      if (option == "--workers") { workers = std::strtoul(argv[i+1], nullptr, 10); }
+      else if (option == "--cache") { cache_directory = argv[i+1]; }
+      else
+      {
+         std::cerr << "unknown option " << option << std::endl;
+         return 2;
+      }
+   }
+
+   // block the stop signals before any thread starts, so only the signal thread ever sees them
+   sigset_t signals;
+   sigemptyset(&signals);
+   sigaddset(&signals, SIGINT);
+   sigaddset(&signals, SIGTERM);
+   pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+   try {
+      ParseServer server(socket_path, workers, cache_directory);
+
+      std::thread signal_thread([&server, &signals] () {
+         int signal;
+         sigwait(&signals, &signal);
+         server.stop();
+      });
+
+      server.serve();
+
+      // serve can only return through stop, so the signal thread has already finished
+      signal_thread.join();
+
+      std::cerr << "served " << server.requests() << " requests" << std::endl;
+   }
+   catch (std::exception &exception) {
+      std::cerr << exception.what() << std::endl;
+      return 1;
+   }
+
+   return 0;
+}